@@ -9,13 +9,23 @@
 const wchar_t * PARAM_OUTFILE = L"-o";
 const wchar_t * PARAM_TMPDIR = L"-temp-directory";
 const wchar_t * PARAM_LOD = L"-lod";
+const wchar_t * PARAM_AUTO_LOD = L"-auto-lod";
 const wchar_t * PARAM_SCREENCOVERAGE = L"-screen-coverage";
+const wchar_t * PARAM_LOD_DENSITY = L"-lod-density";
+const wchar_t * PARAM_IMPOSTOR = L"-impostor";
 const wchar_t * PARAM_MAXTEXTURESIZE = L"-max-texture-size";
+const wchar_t * PARAM_MATERIAL_LODS = L"-material-lods";
 const wchar_t * PARAM_SHARE_MATERIALS = L"-share-materials";
 const wchar_t * PARAM_MIN_VERSION = L"-min-version";
 const wchar_t * PARAM_PLATFORM = L"-platform";
 const wchar_t * PARAM_REPLACE_TEXTURES = L"-replace-textures";
 const wchar_t * PARAM_COMPRESS_MESHES = L"-compress-meshes";
+const wchar_t * PARAM_QUANTIZE_MESHES = L"-quantize-meshes";
+const wchar_t * PARAM_COMPRESS_MESHES_MESHOPT = L"-compress-meshes-meshopt";
+const wchar_t * PARAM_OPTIMIZE_MESHES = L"-optimize-meshes";
+const wchar_t * PARAM_NARROW_INDICES = L"-narrow-indices";
+const wchar_t * PARAM_BATCH_MESHES = L"-batch-meshes";
+const wchar_t * PARAM_LOD_THREADS = L"-lod-threads";
 const wchar_t * PARAM_VALUE_VERSION_1709 = L"1709";
 const wchar_t * PARAM_VALUE_VERSION_1803 = L"1803";
 const wchar_t * PARAM_VALUE_VERSION_1809 = L"1809";
@@ -32,6 +42,7 @@ const wchar_t * SUFFIX_CONVERTED = L"_converted";
 const wchar_t * CLI_INDENT = L"    ";
 const size_t MAXTEXTURESIZE_DEFAULT = 512;
 const size_t MAXTEXTURESIZE_MAX = 4096;
+const double LOD_DENSITY_DEFAULT = 0.1;
 const CommandLine::Version MIN_VERSION_DEFAULT = CommandLine::Version::Version1709;
 const CommandLine::Platform PLATFORM_DEFAULT = CommandLine::Platform::Desktop;
 
@@ -42,8 +53,13 @@ enum class CommandLineParsingState
     ReadOutFile,
     ReadTmpDir,
     ReadLods,
+    ReadAutoLods,
     ReadScreenCoverage,
+    ReadLodDensity,
+    ReadImpostorViews,
     ReadMaxTextureSize,
+    ReadMaterialLods,
+    ReadLodThreads,
     ReadMinVersion,
     ReadPlatform
 };
@@ -65,11 +81,21 @@ void CommandLine::PrintHelp()
         << indent << "[" << std::wstring(PARAM_PLATFORM) << " <" << PARAM_VALUE_ALL << " | " << PARAM_VALUE_HOLOGRAPHIC << " | " << PARAM_VALUE_DESKTOP << ">] - defaults to " << PARAM_VALUE_DESKTOP << std::endl
         << indent << "[" << std::wstring(PARAM_MIN_VERSION) << " <" << PARAM_VALUE_VERSION_1709 << " | " << PARAM_VALUE_VERSION_1803 << " | " << PARAM_VALUE_VERSION_1809 << " | " << PARAM_VALUE_VERSION_LATEST << ">] - defaults to " << PARAM_VALUE_VERSION_1709 << std::endl
         << indent << "[" << std::wstring(PARAM_LOD) << " <path to each lower LOD asset in descending order of quality>]" << std::endl
-        << indent << "[" << std::wstring(PARAM_SCREENCOVERAGE) << " <LOD screen coverage values>]" << std::endl
+        << indent << "[" << std::wstring(PARAM_AUTO_LOD) << " <fraction of the triangles kept by each generated LOD in descending order of quality>] - cannot be combined with " << std::wstring(PARAM_LOD) << std::endl
+        << indent << "[" << std::wstring(PARAM_SCREENCOVERAGE) << " <LOD screen coverage values>] - computed from the bounds and triangle counts of the LODs if not present" << std::endl
+        << indent << "[" << std::wstring(PARAM_LOD_DENSITY) << " <triangles per pixel>] - density at which the computed screen coverage switches to the next LOD, defaults to 0.1" << std::endl
+        << indent << "[" << std::wstring(PARAM_IMPOSTOR) << " <view count>] - append a last LOD of textured quads rendered from this number of views (1 for a billboard, 2 for a cross), disabled if not present" << std::endl
         << indent << "[" << std::wstring(PARAM_SHARE_MATERIALS) << "] - disabled if not present" << std::endl
         << indent << "[" << std::wstring(PARAM_MAXTEXTURESIZE) << " <Max texture size in pixels>] - defaults to 512" << std::endl
+        << indent << "[" << std::wstring(PARAM_MATERIAL_LODS) << " <level count>] - number of material LODs with textures of half the size of the previous level, defaults to 0" << std::endl
         << indent << "[" << std::wstring(PARAM_REPLACE_TEXTURES) << "] - disabled if not present" << std::endl
         << indent << "[" << std::wstring(PARAM_COMPRESS_MESHES) << "] - compress meshes with Draco" << std::endl
+        << indent << "[" << std::wstring(PARAM_QUANTIZE_MESHES) << "] - store vertex attributes as 8 or 16-bit integers (KHR_mesh_quantization)" << std::endl
+        << indent << "[" << std::wstring(PARAM_COMPRESS_MESHES_MESHOPT) << "] - compress meshes and animations with EXT_meshopt_compression, which decodes faster than Draco" << std::endl
+        << indent << "[" << std::wstring(PARAM_OPTIMIZE_MESHES) << "] - reorder triangles and vertices for the vertex cache and overdraw" << std::endl
+        << indent << "[" << std::wstring(PARAM_NARROW_INDICES) << "] - store indices as 16-bit integers, splitting primitives that use more than 65535 vertices" << std::endl
+        << indent << "[" << std::wstring(PARAM_BATCH_MESHES) << "] - merge the primitives of static nodes that share a material to reduce draw calls" << std::endl
+        << indent << "[" << std::wstring(PARAM_LOD_THREADS) << " <thread count>] - number of LODs loaded and converted at the same time, defaults to one per hardware thread" << std::endl
         << std::endl
         << "Example:" << std::endl
         << indent << "WindowsMRAssetConverter FileToConvert.gltf "
@@ -88,8 +114,8 @@ void CommandLine::PrintHelp()
 void CommandLine::ParseCommandLineArguments(
     int argc, wchar_t *argv[],
     std::wstring& inputFilePath, AssetType& inputAssetType, std::wstring& outFilePath, std::wstring& tempDirectory,
-    std::vector<std::wstring>& lodFilePaths, std::vector<double>& screenCoveragePercentages, size_t& maxTextureSize,
-    bool& shareMaterials, Version& minVersion, Platform& targetPlatforms, bool& replaceTextures, bool& compressMeshes)
+    std::vector<std::wstring>& lodFilePaths, std::vector<double>& autoLodRatios, std::vector<double>& screenCoveragePercentages, size_t& maxTextureSize, size_t& materialLodCount,
+    bool& shareMaterials, Version& minVersion, Platform& targetPlatforms, bool& replaceTextures, bool& compressMeshes, bool& quantizeMeshes, bool& compressMeshesMeshopt, bool& optimizeMeshes, bool& narrowIndices, bool& batchMeshes, size_t& lodThreadCount, double& lodTrianglesPerPixel, size_t& impostorViewCount)
 {
     CommandLineParsingState state = CommandLineParsingState::Initial;
 
@@ -101,13 +127,23 @@ void CommandLine::ParseCommandLineArguments(
     outFilePath = L"";
     tempDirectory = L"";
     lodFilePaths.clear();
+    autoLodRatios.clear();
     screenCoveragePercentages.clear();
     maxTextureSize = MAXTEXTURESIZE_DEFAULT;
+    materialLodCount = 0;
     shareMaterials = false;
     minVersion = MIN_VERSION_DEFAULT;
     targetPlatforms = PLATFORM_DEFAULT;
     replaceTextures = false;
     compressMeshes = false;
+    quantizeMeshes = false;
+    compressMeshesMeshopt = false;
+    optimizeMeshes = false;
+    narrowIndices = false;
+    batchMeshes = false;
+    lodThreadCount = 0;
+    lodTrianglesPerPixel = LOD_DENSITY_DEFAULT;
+    impostorViewCount = 0;
 
     state = CommandLineParsingState::InputRead;
 
@@ -132,6 +168,11 @@ void CommandLine::ParseCommandLineArguments(
             lodFilePaths.clear();
             state = CommandLineParsingState::ReadLods;
         }
+        else if (param == PARAM_AUTO_LOD)
+        {
+            autoLodRatios.clear();
+            state = CommandLineParsingState::ReadAutoLods;
+        }
         else if (param == PARAM_SCREENCOVERAGE)
         {
             screenCoveragePercentages.clear();
@@ -142,6 +183,11 @@ void CommandLine::ParseCommandLineArguments(
             maxTextureSize = MAXTEXTURESIZE_DEFAULT;
             state = CommandLineParsingState::ReadMaxTextureSize;
         }
+        else if (param == PARAM_MATERIAL_LODS)
+        {
+            materialLodCount = 0;
+            state = CommandLineParsingState::ReadMaterialLods;
+        }
         else if (param == PARAM_SHARE_MATERIALS)
         {
             shareMaterials = true;
@@ -173,7 +219,61 @@ void CommandLine::ParseCommandLineArguments(
                 throw std::invalid_argument("Invalid min version specified with mesh compression; must be at least 1809.");
             }
             state = CommandLineParsingState::InputRead;
+        }
+        else if (param == PARAM_QUANTIZE_MESHES)
+        {
+            if (minVersion >= CommandLine::Version::Version1809)
+            {
+                quantizeMeshes = true;
+            }
+            else
+            {
+                throw std::invalid_argument("Invalid min version specified with mesh quantization; must be at least 1809.");
+            }
+            state = CommandLineParsingState::InputRead;
+        }
+        else if (param == PARAM_COMPRESS_MESHES_MESHOPT)
+        {
+            if (minVersion >= CommandLine::Version::Version1809)
+            {
+                compressMeshesMeshopt = true;
+            }
+            else
+            {
+                throw std::invalid_argument("Invalid min version specified with meshopt mesh compression; must be at least 1809.");
+            }
+            state = CommandLineParsingState::InputRead;
+        }
+        else if (param == PARAM_OPTIMIZE_MESHES)
+        {
+            optimizeMeshes = true;
+            state = CommandLineParsingState::InputRead;
         }        
+        else if (param == PARAM_NARROW_INDICES)
+        {
+            narrowIndices = true;
+            state = CommandLineParsingState::InputRead;
+        }
+        else if (param == PARAM_BATCH_MESHES)
+        {
+            batchMeshes = true;
+            state = CommandLineParsingState::InputRead;
+        }
+        else if (param == PARAM_LOD_DENSITY)
+        {
+            lodTrianglesPerPixel = LOD_DENSITY_DEFAULT;
+            state = CommandLineParsingState::ReadLodDensity;
+        }
+        else if (param == PARAM_IMPOSTOR)
+        {
+            impostorViewCount = 0;
+            state = CommandLineParsingState::ReadImpostorViews;
+        }
+        else if (param == PARAM_LOD_THREADS)
+        {
+            lodThreadCount = 0;
+            state = CommandLineParsingState::ReadLodThreads;
+        }
         else
         {
             switch (state)
@@ -189,6 +289,17 @@ void CommandLine::ParseCommandLineArguments(
             case CommandLineParsingState::ReadLods:
                 lodFilePaths.push_back(FileSystem::GetFullPath(param));
                 break;
+            case CommandLineParsingState::ReadAutoLods:
+            {
+                auto paramA = std::string(param.begin(), param.end());
+                auto ratio = std::atof(paramA.c_str());
+                if (ratio <= 0.0 || ratio > 1.0)
+                {
+                    throw std::invalid_argument("Invalid LOD triangle ratio specified; must be greater than 0 and at most 1.");
+                }
+                autoLodRatios.push_back(ratio);
+                break;
+            }
             case CommandLineParsingState::ReadScreenCoverage:
             {
                 auto paramA = std::string(param.begin(), param.end());
@@ -198,6 +309,33 @@ void CommandLine::ParseCommandLineArguments(
             case CommandLineParsingState::ReadMaxTextureSize:
                 maxTextureSize = std::min(static_cast<size_t>(std::stoul(param.c_str())), MAXTEXTURESIZE_MAX);
                 break;
+            case CommandLineParsingState::ReadMaterialLods:
+                materialLodCount = static_cast<size_t>(std::stoul(param.c_str()));
+                state = CommandLineParsingState::InputRead;
+                break;
+            case CommandLineParsingState::ReadLodDensity:
+            {
+                auto paramA = std::string(param.begin(), param.end());
+                lodTrianglesPerPixel = std::atof(paramA.c_str());
+                if (lodTrianglesPerPixel <= 0.0)
+                {
+                    throw std::invalid_argument("Invalid LOD density specified; must be greater than 0.");
+                }
+                state = CommandLineParsingState::InputRead;
+                break;
+            }
+            case CommandLineParsingState::ReadImpostorViews:
+                impostorViewCount = static_cast<size_t>(std::stoul(param.c_str()));
+                if (impostorViewCount == 0)
+                {
+                    throw std::invalid_argument("Invalid impostor view count specified; must be greater than 0.");
+                }
+                state = CommandLineParsingState::InputRead;
+                break;
+            case CommandLineParsingState::ReadLodThreads:
+                lodThreadCount = static_cast<size_t>(std::stoul(param.c_str()));
+                state = CommandLineParsingState::InputRead;
+                break;
             case CommandLineParsingState::ReadMinVersion:
                 if (_wcsicmp(param.c_str(), PARAM_VALUE_VERSION_1709) == 0 || _wcsicmp(param.c_str(), PARAM_VALUE_VERSION_RS3) == 0)
                 {
@@ -254,6 +392,17 @@ void CommandLine::ParseCommandLineArguments(
         throw std::invalid_argument("Input file not found.");
     }
 
+    if (!lodFilePaths.empty() && !autoLodRatios.empty())
+    {
+        throw std::invalid_argument("LOD files and generated LODs cannot be combined.");
+    }
+
+    // Texture coordinates are dequantized by the texture transform of each LOD's materials, which shared materials would lose
+    if (quantizeMeshes && shareMaterials)
+    {
+        throw std::invalid_argument("Mesh quantization and shared materials cannot be combined.");
+    }
+
     for (auto& lodFilePath : lodFilePaths)
     {
         if (!std::experimental::filesystem::exists(lodFilePath))
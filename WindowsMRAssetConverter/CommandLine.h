@@ -28,7 +28,7 @@ namespace CommandLine
     void ParseCommandLineArguments(
         int argc, wchar_t *argv[],
         std::wstring& inputFilePath, AssetType& inputAssetType, std::wstring& outFilePath, std::wstring& tempDirectory,
-        std::vector<std::wstring>& lodFilePaths, std::vector<double>& screenCoveragePercentages, size_t& maxTextureSize,
-        bool& sharedMaterials, Version& minVersion, Platform& targetPlatforms, bool& replaceTextures, bool& compressMeshes);
+        std::vector<std::wstring>& lodFilePaths, std::vector<double>& autoLodRatios, std::vector<double>& screenCoveragePercentages, size_t& maxTextureSize, size_t& materialLodCount,
+        bool& sharedMaterials, Version& minVersion, Platform& targetPlatforms, bool& replaceTextures, bool& compressMeshes, bool& quantizeMeshes, bool& compressMeshesMeshopt, bool& optimizeMeshes, bool& narrowIndices, bool& batchMeshes, size_t& lodThreadCount, double& lodTrianglesPerPixel, size_t& impostorViewCount);
 };
 
@@ -13,8 +13,16 @@
 #include <GLTFSpecularGlossinessUtils.h>
 #include <GLTFLODUtils.h>
 #include <SerializeBinary.h>
-#include <GLBtoGLTF.h>
 #include <GLTFMeshCompressionUtils.h>
+#include <GLTFMeshQuantizationUtils.h>
+#include <GLTFMeshOptimizationUtils.h>
+#include <GLTFMeshIndexUtils.h>
+#include <GLTFBatchingUtils.h>
+#include <GLTFMeshSimplificationUtils.h>
+#include <GLTFImpostorUtils.h>
+#include <MemoryMappedStreamReader.h>
+#include <NativeFile.h>
+#include <ParallelUtils.h>
 
 #include "CommandLine.h"
 #include "FileSystem.h"
@@ -23,33 +31,12 @@
 using namespace Microsoft::glTF;
 using namespace Microsoft::glTF::Toolkit;
 
-class GLTFStreamReader : public IStreamReader
-{
-public:
-    GLTFStreamReader(std::wstring uriBase) : m_uriBase(uriBase) {}
-
-    virtual ~GLTFStreamReader() override {}
-    virtual std::shared_ptr<std::istream> GetInputStream(const std::string& filename) const override
-    {
-        std::wstring filenameW = std::wstring(filename.begin(), filename.end());
-
-        wchar_t uriAbsoluteRaw[MAX_PATH];
-        // Note: PathCchCombine will return the last argument if it's an absolute path
-        if (FAILED(::PathCchCombine(uriAbsoluteRaw, ARRAYSIZE(uriAbsoluteRaw), m_uriBase.c_str(), filenameW.c_str())))
-        {
-            throw std::invalid_argument("Could not get the base path for the GLTF resources. Try specifying the full path.");
-        }
-
-        return std::make_shared<std::ifstream>(uriAbsoluteRaw, std::ios::binary);
-    }
-private:
-    const std::wstring m_uriBase;
-};
-
-class GLBStreamWriter : public Microsoft::glTF::IStreamWriter
+// Writes the GLB file through a stream, and lets embedded images be copied into it from file to file
+class GLBStreamWriter : public IFileStreamWriter
 {
 public:
     GLBStreamWriter(const std::wstring& filename) :
+        m_filename(filename),
         m_stream(std::make_shared<std::ofstream>(filename, std::ios_base::binary | std::ios_base::out))
     { }
 
@@ -58,17 +45,24 @@ public:
         return m_stream;
     }
 
+    std::shared_ptr<NativeFile> GetOutputFile(const std::string&) const override
+    {
+        return NativeFile::OpenWrite(m_filename);
+    }
+
 private:
+    std::wstring m_filename;
     std::shared_ptr<std::ofstream> m_stream;
 };
 
 Document ProcessTextures(
     size_t maxTextureSize, 
+    size_t materialLodCount,
     TexturePacking packing, 
     bool retainOriginalImages, 
     const std::wstring& tempDirectory,
     const Document& document, 
-    const std::shared_ptr<GLTFStreamReader>& streamReader)
+    const std::shared_ptr<MemoryMappedStreamReader>& streamReader)
 {
     Document resultDocument(document);
 
@@ -94,49 +88,257 @@ Document ProcessTextures(
     // 3. Texture Compression
     resultDocument = GLTFTextureCompressionUtils::CompressAllTexturesForWindowsMR(streamReader, resultDocument, tempDirectoryA, maxTextureSize, retainOriginalImages);
 
+    if (materialLodCount > 0)
+    {
+        std::wcout << L"Generating material LODs..." << std::endl;
+
+        // 4. Material LODs, from the mips of the compressed textures
+        resultDocument = GLTFTextureCompressionUtils::GenerateMaterialLODs(streamReader, resultDocument, tempDirectoryA, materialLodCount);
+    }
+
+    return resultDocument;
+}
+
+Document ConvertMeshesForWindowsMR(
+    const std::shared_ptr<MemoryMappedStreamReader>& streamReader,
+    const Document& document,
+    const std::string& tempDirectoryA,
+    bool meshCompression,
+    bool meshQuantization,
+    bool meshoptCompression,
+    bool meshOptimization,
+    bool indexNarrowing,
+    std::wostream& log)
+{
+    Document resultDocument(document);
+
+    if (meshOptimization)
+    {
+        log << L"Optimizing meshes..." << std::endl;
+
+        MeshOptimizationStatistics statistics;
+        resultDocument = GLTFMeshOptimizationUtils::OptimizeMeshes(streamReader, resultDocument, {}, tempDirectoryA, &statistics);
+
+        log << L"ACMR: " << statistics.Before.ACMR() << L" -> " << statistics.After.ACMR()
+            << L", ATVR: " << statistics.Before.ATVR() << L" -> " << statistics.After.ATVR() << std::endl;
+    }
+
+    if (indexNarrowing)
+    {
+        log << L"Converting indices to 16-bit..." << std::endl;
+
+        // Primitives are split in order, which keeps the optimized triangle order within each part
+        resultDocument = GLTFMeshIndexUtils::Use16BitIndices(streamReader, resultDocument, tempDirectoryA);
+    }
+
+    if (meshCompression)
+    {
+        log << L"Compressing meshes - this can take a few minutes..." << std::endl;
+
+        // Edgebreaker encoding would undo the mesh optimization
+        CompressionOptions options;
+        options.PreserveTriangleOrder = meshOptimization;
+        resultDocument = GLTFMeshCompressionUtils::CompressMeshes(streamReader, resultDocument, options, tempDirectoryA);
+    }
+
+    if (meshQuantization)
+    {
+        log << L"Quantizing meshes..." << std::endl;
+
+        // Draco compressed primitives are left as they are
+        resultDocument = GLTFMeshQuantizationUtils::QuantizeMeshes(streamReader, resultDocument, {}, tempDirectoryA);
+    }
+
+    if (meshoptCompression)
+    {
+        log << L"Compressing meshes with meshopt..." << std::endl;
+
+        // Runs last, since the other steps can't read compressed data; quantized attributes are compressed losslessly
+        resultDocument = GLTFMeshCompressionUtils::CompressMeshesMeshopt(streamReader, resultDocument, {}, tempDirectoryA);
+    }
+
     return resultDocument;
 }
 
+// Converts the main asset (index 0) and its LODs on up to threadCount threads. Each conversion writes its progress to its own log,
+// and the logs are printed in order once they are all done, so that the output doesn't depend on which conversion finished first.
+template<typename Convert>
+std::vector<Document> ConvertLODsInParallel(size_t count, size_t threadCount, std::wostream& log, Convert convert)
+{
+    std::vector<Document> documents(count);
+    std::vector<std::wostringstream> logs(count);
+
+    auto printLogs = [&]()
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            log << (i == 0 ? std::wstring(L"Main asset:") : L"LOD " + std::to_wstring(i) + L":") << std::endl << logs[i].str();
+        }
+    };
+
+    try
+    {
+        ParallelUtils::For(count, threadCount, [&](size_t i)
+        {
+            documents[i] = convert(i, logs[i]);
+        });
+    }
+    catch (...)
+    {
+        printLogs();
+        throw;
+    }
+
+    printLogs();
+    return documents;
+}
+
+Document LoadDocumentForWindowsMR(const std::wstring& inputFilePath, AssetType inputAssetType, const std::shared_ptr<MemoryMappedStreamReader>& streamReader, std::wostream& log)
+{
+    std::experimental::filesystem::path inputFilePathFS(inputFilePath);
+    std::wstring inputFileName = inputFilePathFS.filename();
+    log << L"Loading input document: " << inputFileName << L"..." << std::endl;
+
+    if (inputAssetType == AssetType::GLB)
+    {
+        // The GLB is read in place: its buffer views and images are served from the mapped binary chunk
+        return streamReader->DeserializeGLB(inputFilePathFS.filename().u8string());
+    }
+
+    auto stream = std::make_shared<std::ifstream>(inputFilePath, std::ios::in);
+    return Deserialize(*stream, KHR::GetKHRExtensionDeserializer());
+}
+
+// Renders the impostor from the loaded document, before the other steps write data that the rasterizer can't read.
+// Must run on the main thread, which is the only one where COM is initialized for the WIC calls that load and save its textures.
+Document RenderImpostor(const std::shared_ptr<MemoryMappedStreamReader>& streamReader, const Document& document, const std::string& tempDirectoryA, size_t impostorViewCount, size_t threadCount, std::wostream& log)
+{
+    log << L"Rendering impostor..." << std::endl;
+
+    ImpostorOptions options;
+    options.ViewCount = impostorViewCount;
+    options.ThreadCount = threadCount;
+    return GLTFImpostorUtils::GenerateImpostor(streamReader, document, options, tempDirectoryA);
+}
+
 Document LoadAndConvertDocumentForWindowsMR(
-    std::wstring& inputFilePath,
+    const std::wstring& inputFilePath,
     AssetType inputAssetType,
     const std::wstring& tempDirectory,
-    bool meshCompression)
+    bool meshCompression,
+    bool meshQuantization,
+    bool meshoptCompression,
+    bool meshOptimization,
+    bool indexNarrowing,
+    bool meshBatching,
+    std::wostream& log,
+    size_t threadCount = 1,
+    const std::vector<double>& autoLodRatios = {},
+    std::vector<Document>* autoLodDocuments = nullptr,
+    size_t impostorViewCount = 0,
+    Document* impostorDocument = nullptr)
 {
+    std::string tempDirectoryA(tempDirectory.begin(), tempDirectory.end());
+
+    // Get the base path from where to read all the assets
+    // Every stage shares this reader. Its mappings already serve repeated reads of a resource from memory, without the copy
+    // a CachingStreamReader would make, and let SerializeBinary write mapped resources without reading them at all.
+    auto streamReader = std::make_shared<MemoryMappedStreamReader>(FileSystem::GetBasePath(inputFilePath));
+
     // Load the document
-    std::experimental::filesystem::path inputFilePathFS(inputFilePath);
-    std::wstring inputFileName = inputFilePathFS.filename();
-    std::wcout << L"Loading input document: " << inputFileName << L"..." << std::endl;
+    Document document = LoadDocumentForWindowsMR(inputFilePath, inputAssetType, streamReader, log);
 
-    std::string tempDirectoryA(tempDirectory.begin(), tempDirectory.end());
+    if (impostorDocument != nullptr && impostorViewCount > 0)
+    {
+        *impostorDocument = RenderImpostor(streamReader, document, tempDirectoryA, impostorViewCount, threadCount, log);
+    }
 
-    if (inputAssetType == AssetType::GLB)
+    if (meshBatching)
     {
-        // Convert the GLB to GLTF in the temp directory
+        log << L"Batching static meshes..." << std::endl;
 
-        std::string inputFilePathA(inputFilePath.begin(), inputFilePath.end());
+        // Runs first, so that the merged meshes are optimized, compressed and quantized as a whole
+        BatchingStatistics statistics;
+        document = GLTFBatchingUtils::BatchStaticMeshes(streamReader, document, {}, tempDirectoryA, &statistics);
 
-        // inputGltfName is the path to the converted GLTF without extension
-        std::wstring inputGltfName = inputFilePathFS.stem();
-        std::string inputGltfNameA = std::string(inputGltfName.begin(), inputGltfName.end());
+        log << L"Draw calls: " << statistics.PrimitivesBefore << L" -> " << statistics.PrimitivesAfter << std::endl;
+    }
 
-        GLBToGLTF::UnpackGLB(inputFilePathA, tempDirectoryA, inputGltfNameA);
+    if (autoLodDocuments != nullptr && !autoLodRatios.empty())
+    {
+        log << L"Generating LODs..." << std::endl;
 
-        inputFilePath = tempDirectory + inputGltfName + EXTENSION_GLTF;
+        // Only the triangle ratio limits the simplification, since every level must have fewer triangles than the previous one
+        std::vector<SimplificationOptions> levels;
+        for (auto ratio : autoLodRatios)
+        {
+            SimplificationOptions options;
+            options.TargetRatio = static_cast<float>(ratio);
+            options.TargetError = 1.0f;
+            levels.push_back(options);
+        }
+
+        // The levels are simplified before the other steps, which write data that the simplification can't read
+        auto lods = GLTFMeshSimplificationUtils::GenerateLODs(streamReader, document, levels, tempDirectoryA);
+
+        // The main asset and the levels are then converted concurrently, each in its own temp folder
+        std::vector<std::string> tempDirectories = { tempDirectoryA };
+        for (size_t i = 0; i < lods.size(); i++)
+        {
+            auto subFolder = FileSystem::CreateSubFolder(tempDirectory, L"lod" + std::to_wstring(i + 1));
+            tempDirectories.push_back(std::string(subFolder.begin(), subFolder.end()));
+        }
+
+        auto results = ConvertLODsInParallel(tempDirectories.size(), threadCount, log, [&](size_t i, std::wostream& lodLog)
+        {
+            return ConvertMeshesForWindowsMR(streamReader, i == 0 ? document : lods[i - 1], tempDirectories[i], meshCompression, meshQuantization, meshoptCompression, meshOptimization, indexNarrowing, lodLog);
+        });
+
+        autoLodDocuments->insert(autoLodDocuments->end(), results.begin() + 1, results.end());
+        return results[0];
     }
 
-    auto stream = std::make_shared<std::ifstream>(inputFilePath, std::ios::in);
-    Document document = Deserialize(*stream, KHR::GetKHRExtensionDeserializer());
+    return ConvertMeshesForWindowsMR(streamReader, document, tempDirectoryA, meshCompression, meshQuantization, meshoptCompression, meshOptimization, indexNarrowing, log);
+}
 
-    // Get the base path from where to read all the assets
+// Merges the converted LODs into the main asset, sharing the data that is identical between them, followed by the impostor if there is one
+Document MergeLODs(const std::wstring& inputFilePath, const std::vector<Document>& lodDocuments, const std::vector<double>& screenCoveragePercentages,
+    const std::vector<std::wstring>& lodDocumentRelativePaths, bool shareMaterials, double lodTrianglesPerPixel, const Document* impostorDocument)
+{
+    auto streamReader = std::make_shared<MemoryMappedStreamReader>(FileSystem::GetBasePath(inputFilePath));
 
-    auto streamReader = std::make_shared<GLTFStreamReader>(FileSystem::GetBasePath(inputFilePath));
+    LODDeduplicationStatistics statistics;
+    auto document = GLTFLODUtils::MergeDocumentsAsLODs(streamReader, lodDocuments, screenCoveragePercentages, lodDocumentRelativePaths, shareMaterials, &statistics);
 
-    if (meshCompression)
+    for (size_t i = 0; i < statistics.DeduplicatedByteLength.size(); i++)
     {
-        std::wcout << L"Compressing meshes - this can take a few minutes..." << std::endl;
+        std::wcout << L"LOD " << (i + 1) << L": " << statistics.DeduplicatedByteLength[i] << L" bytes shared with previous LODs" << std::endl;
+    }
 
-        document = GLTFMeshCompressionUtils::CompressMeshes(streamReader, document, {}, tempDirectoryA);
+    if (impostorDocument != nullptr)
+    {
+        // The impostor has its own material, and its resources have absolute paths
+        document = GLTFLODUtils::MergeDocumentsAsLODs({ document, *impostorDocument }, screenCoveragePercentages);
+    }
+
+    if (screenCoveragePercentages.empty())
+    {
+        ScreenCoverageOptions options;
+        options.TrianglesPerPixel = lodTrianglesPerPixel;
+
+        auto screenCoverages = GLTFLODUtils::ComputeScreenCoverage(document, options);
+        document = GLTFLODUtils::SetScreenCoverage(document, screenCoverages);
+
+        for (const auto& screenCoverage : screenCoverages)
+        {
+            const auto& node = document.nodes.Get(screenCoverage.first);
+            std::wcout << L"Screen coverage of node " << std::wstring(node.name.begin(), node.name.end()) << L" (" << std::wstring(node.id.begin(), node.id.end()) << L"):";
+            for (auto value : screenCoverage.second)
+            {
+                std::wcout << L" " << value;
+            }
+            std::wcout << std::endl;
+        }
     }
 
     return document;
@@ -161,17 +363,27 @@ int wmain(int argc, wchar_t *argv[])
         std::wstring outFilePath;
         std::wstring tempDirectory;
         std::vector<std::wstring> lodFilePaths;
+        std::vector<double> autoLodRatios;
         std::vector<double> screenCoveragePercentages;
         size_t maxTextureSize;
+        size_t materialLodCount;
         bool shareMaterials;
         CommandLine::Version minVersion;
         CommandLine::Platform targetPlatforms;
         bool replaceTextures;
         bool meshCompression = false;
+        bool meshQuantization = false;
+        bool meshoptCompression = false;
+        bool meshOptimization = false;
+        bool indexNarrowing = false;
+        bool meshBatching = false;
+        size_t lodThreadCount = 0;
+        double lodTrianglesPerPixel;
+        size_t impostorViewCount;
 
         CommandLine::ParseCommandLineArguments(
-            argc, argv, inputFilePath, inputAssetType, outFilePath, tempDirectory, lodFilePaths, screenCoveragePercentages, 
-            maxTextureSize, shareMaterials, minVersion, targetPlatforms, replaceTextures, meshCompression);
+            argc, argv, inputFilePath, inputAssetType, outFilePath, tempDirectory, lodFilePaths, autoLodRatios, screenCoveragePercentages, 
+            maxTextureSize, materialLodCount, shareMaterials, minVersion, targetPlatforms, replaceTextures, meshCompression, meshQuantization, meshoptCompression, meshOptimization, indexNarrowing, meshBatching, lodThreadCount, lodTrianglesPerPixel, impostorViewCount);
 
         TexturePacking packing = TexturePacking::None;
 
@@ -215,36 +427,71 @@ int wmain(int argc, wchar_t *argv[])
         std::wcout << L"\nThis will generate an asset compatible with " << compatibleVersionsText << L"\n" << std::endl;
 
         // Load document, and perform steps:
-        // 1. Mesh Compression
-        auto document = LoadAndConvertDocumentForWindowsMR(inputFilePath, inputAssetType, tempDirectory, meshCompression);
-
-        // 2. LOD Merging
-        if (!lodFilePaths.empty())
+        // 1. Mesh Optimization, Compression and Quantization
+        Document document;
+        Document impostorDocument;
+        const Document* impostor = impostorViewCount > 0 ? &impostorDocument : nullptr;
+        if (lodFilePaths.empty())
         {
-            std::wcout << L"Merging LODs..." << std::endl;
+            std::vector<Document> autoLodDocuments;
+            document = LoadAndConvertDocumentForWindowsMR(inputFilePath, inputAssetType, tempDirectory, meshCompression, meshQuantization, meshoptCompression, meshOptimization, indexNarrowing, meshBatching, std::wcout, lodThreadCount, autoLodRatios, &autoLodDocuments, impostorViewCount, &impostorDocument);
 
-            std::vector<Document> lodDocuments;
-            std::vector<std::wstring> lodDocumentRelativePaths;
-            lodDocuments.push_back(document);
+            // 2. LOD Merging
+            if (!autoLodDocuments.empty() || impostor != nullptr)
+            {
+                std::wcout << L"Merging generated LODs..." << std::endl;
+
+                // The generated LODs share the base path of the input document, and their new buffers have absolute paths
+                std::vector<Document> lodDocuments;
+                lodDocuments.push_back(document);
+                lodDocuments.insert(lodDocuments.end(), autoLodDocuments.begin(), autoLodDocuments.end());
 
+                document = MergeLODs(inputFilePath, lodDocuments, screenCoveragePercentages, {}, shareMaterials, lodTrianglesPerPixel, impostor);
+            }
+        }
+        else
+        {
+            // The main asset and each LOD are loaded and converted concurrently, each in its own temp folder, with the same optimizations
+            std::vector<std::wstring> filePaths = { inputFilePath };
+            std::vector<std::wstring> tempDirectories = { tempDirectory };
             for (size_t i = 0; i < lodFilePaths.size(); i++)
             {
-                // Apply the same optimizations for each LOD
-                auto lod = lodFilePaths[i];
-                auto subFolder = FileSystem::CreateSubFolder(tempDirectory, L"lod" + std::to_wstring(i + 1));
+                filePaths.push_back(lodFilePaths[i]);
+                tempDirectories.push_back(FileSystem::CreateSubFolder(tempDirectory, L"lod" + std::to_wstring(i + 1)));
+            }
 
-                lodDocuments.push_back(LoadAndConvertDocumentForWindowsMR(lod, AssetTypeUtils::AssetTypeFromFilePath(lod), subFolder, meshCompression));
-            
-                lodDocumentRelativePaths.push_back(FileSystem::GetRelativePathWithTrailingSeparator(FileSystem::GetBasePath(inputFilePath), FileSystem::GetBasePath(lod)));
+            if (impostor != nullptr)
+            {
+                // Only the main asset is rendered as an impostor, on this thread rather than on a conversion thread
+                auto streamReader = std::make_shared<MemoryMappedStreamReader>(FileSystem::GetBasePath(inputFilePath));
+                auto mainDocument = LoadDocumentForWindowsMR(inputFilePath, inputAssetType, streamReader, std::wcout);
+                impostorDocument = RenderImpostor(streamReader, mainDocument, std::string(tempDirectory.begin(), tempDirectory.end()), impostorViewCount, lodThreadCount, std::wcout);
             }
 
-            document = GLTFLODUtils::MergeDocumentsAsLODs(lodDocuments, screenCoveragePercentages, lodDocumentRelativePaths, shareMaterials);
+            std::wcout << L"Loading and converting the main asset and " << lodFilePaths.size() << L" LODs..." << std::endl;
+
+            auto lodDocuments = ConvertLODsInParallel(filePaths.size(), lodThreadCount, std::wcout, [&](size_t i, std::wostream& lodLog)
+            {
+                auto assetType = i == 0 ? inputAssetType : AssetTypeUtils::AssetTypeFromFilePath(filePaths[i]);
+                return LoadAndConvertDocumentForWindowsMR(filePaths[i], assetType, tempDirectories[i], meshCompression, meshQuantization, meshoptCompression, meshOptimization, indexNarrowing, meshBatching, lodLog);
+            });
+
+            // 2. LOD Merging
+            std::wcout << L"Merging LODs..." << std::endl;
+
+            std::vector<std::wstring> lodDocumentRelativePaths;
+            for (size_t i = 1; i < filePaths.size(); i++)
+            {
+                lodDocumentRelativePaths.push_back(FileSystem::GetRelativePathWithTrailingSeparator(FileSystem::GetBasePath(inputFilePath), FileSystem::GetBasePath(filePaths[i])));
+            }
+
+            document = MergeLODs(inputFilePath, lodDocuments, screenCoveragePercentages, lodDocumentRelativePaths, shareMaterials, lodTrianglesPerPixel, impostor);
         }
 
         // 3. Texture Packing
-        // 4. Texture Compression
-        auto streamReader = std::make_shared<GLTFStreamReader>(FileSystem::GetBasePath(inputFilePath));
-        document = ProcessTextures(maxTextureSize, packing, !replaceTextures, tempDirectory, document, streamReader);
+        // 4. Texture Compression and Material LODs
+        auto streamReader = std::make_shared<MemoryMappedStreamReader>(FileSystem::GetBasePath(inputFilePath));
+        document = ProcessTextures(maxTextureSize, materialLodCount, packing, !replaceTextures, tempDirectory, document, streamReader);
 
         // 5. Make sure there's a default scene
         if (!document.HasDefaultScene())
@@ -279,6 +526,12 @@ int wmain(int argc, wchar_t *argv[])
             return accessor.componentType;
         };
 
+        // Quantized vertex attributes must keep their normalized integer types
+        if (meshQuantization)
+        {
+            accessorConversion = GLTFMeshQuantizationUtils::PreserveQuantizedAccessors(accessorConversion);
+        }
+
         SerializeBinary(document, streamReader, std::make_shared<GLBStreamWriter>(outFilePath), accessorConversion);
 
         std::wcout << L"Done!" << std::endl;
@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "AccessorUtils.h"
+
+#include "Helpers/WStringUtils.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(AccessorUtilsTests)
+    {
+        template <typename T>
+        static void CheckMinMaxMatchesScalar()
+        {
+            uint32_t randomState = 7;
+            for (auto type : { TYPE_SCALAR, TYPE_VEC2, TYPE_VEC3, TYPE_VEC4, TYPE_MAT4 })
+            {
+                // Counts around the vector widths, so that both the vectorized loop and the remainder are exercised
+                for (size_t count : { 1, 2, 7, 16, 33, 100, 1001 })
+                {
+                    Accessor accessor;
+                    accessor.type = type;
+                    accessor.count = count;
+
+                    std::vector<T> contents(count * Accessor::GetTypeCount(type));
+                    for (auto& value : contents)
+                    {
+                        randomState = randomState * 1664525u + 1013904223u;
+                        value = std::is_floating_point<T>::value ? static_cast<T>(static_cast<int32_t>(randomState) / 1000.0f) : static_cast<T>(randomState >> 8);
+                    }
+
+                    auto expected = AccessorUtils::CalculateMinMax(accessor, contents, AccessorUtils::InstructionSet::Scalar);
+                    for (auto instructionSet : { AccessorUtils::InstructionSet::SSE2, AccessorUtils::InstructionSet::AVX2 })
+                    {
+                        auto actual = AccessorUtils::CalculateMinMax(accessor, contents, instructionSet);
+                        Assert::IsTrue(expected.first == actual.first);
+                        Assert::IsTrue(expected.second == actual.second);
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(AccessorUtilsTests_CalculateMinMax_Simple)
+        {
+            Accessor accessor;
+            accessor.type = TYPE_VEC3;
+            accessor.count = 3;
+
+            std::vector<float> contents = { 1.0f, -2.0f, 3.0f, -4.0f, 5.0f, 6.0f, 7.0f, 8.0f, -9.0f };
+            auto minmax = AccessorUtils::CalculateMinMax(accessor, contents);
+
+            Assert::IsTrue(std::vector<float>({ -4.0f, -2.0f, -9.0f }) == minmax.first);
+            Assert::IsTrue(std::vector<float>({ 7.0f, 8.0f, 6.0f }) == minmax.second);
+        }
+
+        TEST_METHOD(AccessorUtilsTests_CalculateMinMax_VectorizedMatchesScalar)
+        {
+            CheckMinMaxMatchesScalar<int8_t>();
+            CheckMinMaxMatchesScalar<uint8_t>();
+            CheckMinMaxMatchesScalar<int16_t>();
+            CheckMinMaxMatchesScalar<uint16_t>();
+            CheckMinMaxMatchesScalar<uint32_t>();
+            CheckMinMaxMatchesScalar<float>();
+        }
+
+        TEST_METHOD(AccessorUtilsTests_CalculateMinMax_Empty)
+        {
+            Accessor accessor;
+            accessor.type = TYPE_VEC2;
+            accessor.count = 0;
+
+            std::vector<uint16_t> contents = { 1 };
+            Assert::ExpectException<std::invalid_argument>([&]()
+            {
+                AccessorUtils::CalculateMinMax(accessor, contents);
+            });
+        }
+
+        TEST_METHOD(AccessorUtilsTests_ConvertComponents_Normalized)
+        {
+            // Normalized unsigned bytes become floats in [0, 1]
+            std::vector<uint8_t> unsignedBytes = { 0, 51, 255 };
+            std::vector<float> floats(3);
+            float min, max;
+            AccessorUtils::ConvertComponents(COMPONENT_UNSIGNED_BYTE, unsignedBytes.data(), COMPONENT_FLOAT, floats.data(), 3, 1, true, &min, &max);
+            Assert::IsTrue(std::vector<float>({ 0.0f, 0.2f, 1.0f }) == floats);
+            Assert::AreEqual(0.0f, min);
+            Assert::AreEqual(1.0f, max);
+
+            // Normalized signed bytes become floats in [-1, 1], with -128 clamped to -1
+            std::vector<int8_t> signedBytes = { -128, 0, 127 };
+            AccessorUtils::ConvertComponents(COMPONENT_BYTE, signedBytes.data(), COMPONENT_FLOAT, floats.data(), 3, 1, true);
+            Assert::IsTrue(std::vector<float>({ -1.0f, 0.0f, 1.0f }) == floats);
+
+            // Normalized integers keep their meaning when widened
+            std::vector<uint16_t> unsignedShorts(3);
+            AccessorUtils::ConvertComponents(COMPONENT_UNSIGNED_BYTE, unsignedBytes.data(), COMPONENT_UNSIGNED_SHORT, unsignedShorts.data(), 3, 1, true);
+            Assert::IsTrue(std::vector<uint16_t>({ 0, 51 * 257, 65535 }) == unsignedShorts);
+        }
+
+        TEST_METHOD(AccessorUtilsTests_ConvertComponents_Clamped)
+        {
+            std::vector<int16_t> shorts = { -5, 6, 32767 };
+            std::vector<uint8_t> unsignedBytes(3);
+            AccessorUtils::ConvertComponents(COMPONENT_SHORT, shorts.data(), COMPONENT_UNSIGNED_BYTE, unsignedBytes.data(), 3, 1, false);
+            Assert::IsTrue(std::vector<uint8_t>({ 0, 6, 255 }) == unsignedBytes);
+
+            std::vector<float> floats = { -1.0f, 2.4f, 70000.0f };
+            std::vector<uint16_t> unsignedShorts(3);
+            AccessorUtils::ConvertComponents(COMPONENT_FLOAT, floats.data(), COMPONENT_UNSIGNED_SHORT, unsignedShorts.data(), 3, 1, false);
+            Assert::IsTrue(std::vector<uint16_t>({ 0, 2, 65535 }) == unsignedShorts);
+        }
+
+        TEST_METHOD(AccessorUtilsTests_ConvertComponents_BoundsMatchCalculateMinMax)
+        {
+            Accessor accessor;
+            accessor.type = TYPE_VEC3;
+            accessor.count = 100;
+
+            std::vector<int16_t> shorts(accessor.count * 3);
+            for (size_t i = 0; i < shorts.size(); i++)
+            {
+                shorts[i] = static_cast<int16_t>((i * 7919) % 2000) - 1000;
+            }
+
+            std::vector<float> floats(shorts.size());
+            std::vector<float> min(3), max(3);
+            AccessorUtils::ConvertComponents(COMPONENT_SHORT, shorts.data(), COMPONENT_FLOAT, floats.data(), accessor.count, 3, false, min.data(), max.data());
+
+            auto expected = AccessorUtils::CalculateMinMax(accessor, floats);
+            Assert::IsTrue(expected.first == min);
+            Assert::IsTrue(expected.second == max);
+        }
+    };
+}
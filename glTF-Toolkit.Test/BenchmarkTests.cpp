@@ -0,0 +1,493 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFSDK/IStreamWriter.h"
+#include "GLTFSDK/Constants.h"
+#include "GLTFSDK/Document.h"
+#include "GLTFSDK/Deserialize.h"
+#include "GLTFSDK/ExtensionsKHR.h"
+#include "GLTFSDK/GLBResourceReader.h"
+#include "GLTFSDK/GLTFResourceReader.h"
+#include "GLTFSDK/RapidJsonUtils.h"
+#include "GLTFSDK/Serialize.h"
+
+#include "AccessorUtils.h"
+#include "GLBtoGLTF.h"
+#include "GLTFLODUtils.h"
+#include "GLTFMeshCompressionUtils.h"
+#include "MemoryMappedStreamReader.h"
+#include "MeshoptCodec.h"
+#include "SerializeBinary.h"
+
+#include "Helpers/BenchmarkUtils.h"
+#include "Helpers/StreamMock.h"
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+
+#pragma warning(push)
+#pragma warning(disable: 4018 4081 4244 4267 4389)
+#include "draco/compression/decode.h"
+#pragma warning(pop)
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    // Benchmarks are regular test methods tagged with the "Benchmark" category, so they can be run on their own
+    // (vstest.console.exe /TestCaseFilter:"TestCategory=Benchmark"). Timings are written to the test output.
+    TEST_CLASS(BenchmarkTests)
+    {
+        static uint32_t NextRandom(uint32_t& state)
+        {
+            state = state * 1664525u + 1013904223u;
+            return state;
+        }
+
+        // Creates a document with many small position accessors that have no min and max, backed by a single in-memory buffer.
+        static Document CreateAccessorDocument(InMemoryStreamReader& streamReader, size_t accessorCount, size_t vertexCount)
+        {
+            const size_t accessorByteLength = vertexCount * 3 * sizeof(float);
+            std::string bufferContents(accessorCount * accessorByteLength, '\0');
+
+            uint32_t randomState = 1;
+            auto positions = reinterpret_cast<float*>(&bufferContents[0]);
+            for (size_t i = 0; i < accessorCount * vertexCount * 3; i++)
+            {
+                positions[i] = static_cast<float>(NextRandom(randomState) % 20000) / 100.0f - 100.0f;
+            }
+
+            Document document;
+
+            Buffer buffer;
+            buffer.id = "0";
+            buffer.uri = "benchmark.bin";
+            buffer.byteLength = bufferContents.size();
+            document.buffers.Append(std::move(buffer));
+
+            for (size_t i = 0; i < accessorCount; i++)
+            {
+                BufferView bufferView;
+                bufferView.id = std::to_string(i);
+                bufferView.bufferId = "0";
+                bufferView.byteOffset = i * accessorByteLength;
+                bufferView.byteLength = accessorByteLength;
+                document.bufferViews.Append(std::move(bufferView));
+
+                Accessor accessor;
+                accessor.id = std::to_string(i);
+                accessor.bufferViewId = std::to_string(i);
+                accessor.byteOffset = 0;
+                accessor.componentType = COMPONENT_FLOAT;
+                accessor.type = TYPE_VEC3;
+                accessor.count = vertexCount;
+                document.accessors.Append(std::move(accessor));
+            }
+
+            streamReader.Add("benchmark.bin", std::move(bufferContents));
+
+            return document;
+        }
+
+        static std::string ReadAll(const std::shared_ptr<StreamMock>& stream)
+        {
+            auto input = stream->GetInputStream(std::string());
+            return std::string(std::istreambuf_iterator<char>(*input), std::istreambuf_iterator<char>());
+        }
+
+        static std::string ReadFile(const std::experimental::filesystem::path& path)
+        {
+            std::ifstream input(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        }
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(Benchmark_SerializeBinary_ThreadCount)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+        TEST_METHOD(Benchmark_SerializeBinary_ThreadCount)
+        {
+            try
+            {
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                auto document = CreateAccessorDocument(*streamReader, 5000, 256);
+
+                std::string serialOutput;
+                for (size_t threadCount : { 1, 2, 4, 8, 16 })
+                {
+                    SerializeBinaryOptions options;
+                    options.ThreadCount = threadCount;
+
+                    std::shared_ptr<StreamMock> output;
+                    auto milliseconds = BenchmarkUtils::Measure(3, [&]()
+                    {
+                        output = std::make_shared<StreamMock>();
+                        SerializeBinary(document, streamReader, output, options);
+                    });
+                    BenchmarkUtils::Report("SerializeBinary", std::to_string(threadCount) + " threads", milliseconds);
+
+                    // The output must not depend on the number of threads
+                    auto glb = ReadAll(output);
+                    if (threadCount == 1)
+                    {
+                        serialOutput = std::move(glb);
+                    }
+                    else
+                    {
+                        Assert::IsTrue(serialOutput == glb);
+                    }
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(Benchmark_CalculateMinMax_InstructionSet)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+        TEST_METHOD(Benchmark_CalculateMinMax_InstructionSet)
+        {
+            // 10M VEC3 float positions
+            Accessor accessor;
+            accessor.type = TYPE_VEC3;
+            accessor.componentType = COMPONENT_FLOAT;
+            accessor.count = 10000000;
+
+            uint32_t randomState = 1;
+            std::vector<float> positions(accessor.count * 3);
+            for (auto& position : positions)
+            {
+                position = static_cast<float>(NextRandom(randomState) % 20000) / 100.0f - 100.0f;
+            }
+
+            auto expected = AccessorUtils::CalculateMinMax(accessor, positions, AccessorUtils::InstructionSet::Scalar);
+            for (auto instructionSet : { AccessorUtils::InstructionSet::Scalar, AccessorUtils::InstructionSet::SSE2, AccessorUtils::InstructionSet::AVX2 })
+            {
+                static const char* names[] = { "Scalar", "SSE2", "AVX2" };
+
+                std::pair<std::vector<float>, std::vector<float>> minmax;
+                auto milliseconds = BenchmarkUtils::Measure(5, [&]()
+                {
+                    minmax = AccessorUtils::CalculateMinMax(accessor, positions, instructionSet);
+                });
+                BenchmarkUtils::Report("CalculateMinMax VEC3 float", names[static_cast<int>(instructionSet)], milliseconds);
+
+                Assert::IsTrue(expected == minmax);
+            }
+        }
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(Benchmark_MeshCompression_DracoAndMeshopt)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+        TEST_METHOD(Benchmark_MeshCompression_DracoAndMeshopt)
+        {
+            try
+            {
+                const char* waterBottleJson = "Resources\\gltf\\WaterBottle\\WaterBottle.gltf";
+                auto input = TestUtils::ReadLocalAsset(TestUtils::GetAbsolutePath(waterBottleJson));
+                auto document = Deserialize(std::string(std::istreambuf_iterator<char>(*input), std::istreambuf_iterator<char>()));
+                auto streamReader = std::make_shared<TestStreamReader>(TestUtils::GetAbsolutePath(waterBottleJson));
+
+                auto outputDirectory = TestUtils::CreateOutputDirectory("BenchmarkTests");
+                GLTFResourceReader outputReader(std::make_shared<MemoryMappedStreamReader>(outputDirectory));
+
+                // Draco: one compressed bufferView per primitive
+                auto dracoDocument = GLTFMeshCompressionUtils::CompressMeshes(streamReader, document, CompressionOptions(), outputDirectory.u8string());
+                std::vector<std::vector<uint8_t>> dracoData;
+                for (const auto& mesh : dracoDocument.meshes.Elements())
+                {
+                    for (const auto& primitive : mesh.primitives)
+                    {
+                        const auto& draco = primitive.GetExtension<KHR::MeshPrimitives::DracoMeshCompression>();
+                        dracoData.push_back(outputReader.ReadBinaryData<uint8_t>(dracoDocument, dracoDocument.bufferViews.Get(draco.bufferViewId)));
+                    }
+                }
+
+                // Meshopt: one compressed bufferView per accessor, decoded with its filter
+                struct MeshoptBufferView
+                {
+                    std::vector<uint8_t> data;
+                    size_t count;
+                    size_t byteStride;
+                    bool indices;
+                    MeshoptFilter filter;
+                };
+
+                auto meshoptDocument = GLTFMeshCompressionUtils::CompressMeshesMeshopt(streamReader, document, MeshoptCompressionOptions(), outputDirectory.u8string());
+                std::vector<MeshoptBufferView> meshoptData;
+                for (const auto& bufferView : meshoptDocument.bufferViews.Elements())
+                {
+                    auto extension = bufferView.extensions.find(EXTENSION_EXT_MESHOPT_COMPRESSION);
+                    if (extension == bufferView.extensions.end())
+                    {
+                        continue;
+                    }
+
+                    auto json = RapidJsonUtils::CreateDocumentFromString(extension->second);
+                    BufferView compressedBufferView;
+                    compressedBufferView.bufferId = meshoptDocument.buffers.Get(json["buffer"].GetUint()).id;
+                    compressedBufferView.byteOffset = json["byteOffset"].GetUint();
+                    compressedBufferView.byteLength = json["byteLength"].GetUint();
+
+                    MeshoptBufferView meshoptBufferView;
+                    meshoptBufferView.data = outputReader.ReadBinaryData<uint8_t>(meshoptDocument, compressedBufferView);
+                    meshoptBufferView.count = json["count"].GetUint();
+                    meshoptBufferView.byteStride = json["byteStride"].GetUint();
+                    meshoptBufferView.indices = std::string(json["mode"].GetString()) == "INDICES";
+
+                    std::string filter = json.HasMember("filter") ? json["filter"].GetString() : "NONE";
+                    meshoptBufferView.filter =
+                        filter == "OCTAHEDRAL" ? MeshoptFilter::Octahedral :
+                        filter == "QUATERNION" ? MeshoptFilter::Quaternion :
+                        filter == "EXPONENTIAL" ? MeshoptFilter::Exponential : MeshoptFilter::None;
+                    meshoptData.push_back(std::move(meshoptBufferView));
+                }
+
+                size_t dracoSize = 0;
+                for (const auto& data : dracoData)
+                {
+                    dracoSize += data.size();
+                }
+                size_t meshoptSize = 0;
+                for (const auto& bufferView : meshoptData)
+                {
+                    meshoptSize += bufferView.data.size();
+                }
+
+                std::stringstream ss;
+                ss << "Mesh compression encoded size [Draco]: " << dracoSize << " bytes" << std::endl;
+                ss << "Mesh compression encoded size [meshopt]: " << meshoptSize << " bytes" << std::endl;
+                Logger::WriteMessage(ss.str().c_str());
+
+                auto dracoMilliseconds = BenchmarkUtils::Measure(20, [&]()
+                {
+                    for (const auto& data : dracoData)
+                    {
+                        draco::DecoderBuffer buffer;
+                        buffer.Init(reinterpret_cast<const char*>(data.data()), data.size());
+
+                        draco::Decoder decoder;
+                        auto mesh = decoder.DecodeMeshFromBuffer(&buffer);
+                        Assert::IsTrue(mesh.ok());
+                    }
+                });
+                BenchmarkUtils::Report("Mesh decompression WaterBottle", "Draco", dracoMilliseconds);
+
+                auto meshoptMilliseconds = BenchmarkUtils::Measure(20, [&]()
+                {
+                    for (const auto& bufferView : meshoptData)
+                    {
+                        std::vector<uint8_t> decoded(bufferView.count * bufferView.byteStride);
+                        if (bufferView.indices)
+                        {
+                            MeshoptCodec::DecodeIndexSequence(decoded.data(), bufferView.count, bufferView.byteStride, bufferView.data.data(), bufferView.data.size());
+                        }
+                        else
+                        {
+                            MeshoptCodec::DecodeVertexBuffer(decoded.data(), bufferView.count, bufferView.byteStride, bufferView.data.data(), bufferView.data.size());
+                            MeshoptCodec::DecodeFilter(bufferView.filter, decoded.data(), bufferView.count, bufferView.byteStride);
+                        }
+                    }
+                });
+                BenchmarkUtils::Report("Mesh decompression WaterBottle", "meshopt", meshoptMilliseconds);
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(Benchmark_MergeDocumentsAsLODs_LargeScene)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+        TEST_METHOD(Benchmark_MergeDocumentsAsLODs_LargeScene)
+        {
+            try
+            {
+                // A root node with 20K children, which share 100 meshes with 2 primitives each
+                const size_t nodeCount = 20000;
+                const size_t meshCount = 100;
+
+                Document doc;
+
+                Buffer buffer;
+                buffer.id = "0";
+                buffer.uri = "scene.bin";
+                buffer.byteLength = 1024;
+                doc.buffers.Append(std::move(buffer));
+
+                BufferView bufferView;
+                bufferView.id = "0";
+                bufferView.bufferId = "0";
+                bufferView.byteLength = 1024;
+                doc.bufferViews.Append(std::move(bufferView));
+
+                for (size_t i = 0; i < meshCount; i++)
+                {
+                    Material material;
+                    material.id = std::to_string(i);
+                    material.name = "material" + std::to_string(i);
+                    doc.materials.Append(std::move(material));
+
+                    Mesh mesh;
+                    mesh.id = std::to_string(i);
+                    for (size_t j = 0; j < 2; j++)
+                    {
+                        MeshPrimitive primitive;
+                        primitive.materialId = std::to_string(i);
+                        for (const auto& semantic : { ACCESSOR_POSITION, ACCESSOR_NORMAL, ACCESSOR_TEXCOORD_0 })
+                        {
+                            Accessor accessor;
+                            accessor.id = std::to_string(doc.accessors.Size());
+                            accessor.bufferViewId = "0";
+                            accessor.componentType = COMPONENT_FLOAT;
+                            accessor.type = semantic == ACCESSOR_TEXCOORD_0 ? TYPE_VEC2 : TYPE_VEC3;
+                            accessor.count = 3;
+                            primitive.attributes[semantic] = doc.accessors.Append(std::move(accessor)).id;
+                        }
+                        mesh.primitives.push_back(std::move(primitive));
+                    }
+                    doc.meshes.Append(std::move(mesh));
+                }
+
+                Node root;
+                root.id = "0";
+                for (size_t i = 1; i <= nodeCount; i++)
+                {
+                    Node node;
+                    node.id = std::to_string(i);
+                    node.meshId = std::to_string(i % meshCount);
+                    root.children.push_back(node.id);
+                    doc.nodes.Append(std::move(node));
+                }
+                doc.nodes.Append(std::move(root));
+
+                Scene scene;
+                scene.id = "0";
+                scene.nodes.push_back("0");
+                doc.scenes.Append(std::move(scene));
+                doc.defaultSceneId = "0";
+
+                std::vector<Document> docs(5, doc);
+
+                Document merged;
+                auto milliseconds = BenchmarkUtils::Measure(3, [&]()
+                {
+                    merged = GLTFLODUtils::MergeDocumentsAsLODs(docs);
+                });
+                BenchmarkUtils::Report("MergeDocumentsAsLODs 20K nodes", "5 LODs", milliseconds);
+
+                Assert::AreEqual(docs.size() * doc.nodes.Size(), merged.nodes.Size());
+                Assert::AreEqual(docs.size() * doc.meshes.Size(), merged.meshes.Size());
+                Assert::AreEqual(docs.size() * doc.accessors.Size(), merged.accessors.Size());
+                Assert::AreEqual(docs.size() * doc.materials.Size(), merged.materials.Size());
+
+                // The ids of the appended elements are their indices, and the references follow them
+                for (size_t i = 0; i < merged.nodes.Size(); i++)
+                {
+                    const auto& node = merged.nodes[i];
+                    Assert::IsTrue(i < doc.nodes.Size() || std::to_string(i) == node.id);
+                    if (!node.meshId.empty())
+                    {
+                        const auto& mesh = merged.meshes.Get(node.meshId);
+                        Assert::AreEqual(i / doc.nodes.Size(), merged.materials.GetIndex(mesh.primitives[0].materialId) / doc.materials.Size());
+                    }
+                }
+
+                // The root node references the root node of every LOD
+                auto lods = GLTFLODUtils::ParseDocumentNodeLODs(merged);
+                const auto& rootLods = *lods.at(merged.scenes.Front().nodes[0]);
+                Assert::AreEqual(docs.size() - 1, rootLods.size());
+                for (size_t i = 0; i < rootLods.size(); i++)
+                {
+                    Assert::AreEqual(std::to_string((i + 2) * doc.nodes.Size() - 1), rootLods[i]);
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(Benchmark_UnpackGLB_SinglePass)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+        TEST_METHOD(Benchmark_UnpackGLB_SinglePass)
+        {
+            try
+            {
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                auto document = CreateAccessorDocument(*streamReader, 2000, 4096);
+
+                auto output = std::make_shared<StreamMock>();
+                SerializeBinary(document, streamReader, output);
+
+                auto outputDirectory = TestUtils::CreateOutputDirectory("BenchmarkTests");
+                auto glbPath = outputDirectory / "unpack.glb";
+                {
+                    auto glb = ReadAll(output);
+                    std::ofstream glbFile(glbPath, std::ios::binary);
+                    glbFile.write(glb.data(), glb.size());
+                }
+
+                // Previous implementation: images, extension resources and the bin file are each read in their own pass,
+                // and held in memory before they are written
+                auto threePassMilliseconds = BenchmarkUtils::Measure(3, [&]()
+                {
+                    auto glbStream = std::make_shared<std::ifstream>(glbPath, std::ios::binary);
+                    GLBResourceReader reader(std::make_shared<StreamMock>(), glbStream);
+                    auto glbDoc = Deserialize(reader.GetJson(), KHR::GetKHRExtensionDeserializer());
+
+                    std::unordered_set<std::string> unpackedBufferViews;
+                    auto gltfDoc = GLBToGLTF::CreateGLTFDocument(glbDoc, "threepass", unpackedBufferViews);
+                    std::ofstream gltfFile(outputDirectory / "threepass.gltf");
+                    gltfFile << Serialize(gltfDoc, KHR::GetKHRExtensionSerializer());
+
+                    // the buffer chunk data follows the GLB header, the JSON chunk and the lengths and types of both chunks
+                    uint32_t jsonChunkLength = 0;
+                    glbStream->seekg(GLB2_HEADER_BYTE_SIZE, std::ios::beg);
+                    glbStream->read(reinterpret_cast<char*>(&jsonChunkLength), sizeof(jsonChunkLength));
+                    size_t bufferOffset = GLB2_HEADER_BYTE_SIZE + GLB_CHUNK_TYPE_SIZE * 4 + jsonChunkLength;
+
+                    for (const auto& image : GLBToGLTF::GetImagesData(glbStream.get(), glbDoc, "threepass", bufferOffset))
+                    {
+                        std::ofstream imageFile(outputDirectory / image.first, std::ios::binary);
+                        imageFile.write(image.second.data(), image.second.size());
+                    }
+
+                    auto binData = GLBToGLTF::SaveBin(glbStream.get(), glbDoc, bufferOffset, gltfDoc.buffers[0].byteLength, unpackedBufferViews);
+                    std::ofstream binFile(outputDirectory / "threepass.bin", std::ios::binary);
+                    binFile.write(binData.data(), binData.size());
+                });
+                BenchmarkUtils::Report("UnpackGLB 2000 x 48 KB bufferViews", "three passes", threePassMilliseconds);
+
+                auto singlePassMilliseconds = BenchmarkUtils::Measure(3, [&]()
+                {
+                    GLBToGLTF::UnpackGLB(glbPath.u8string(), outputDirectory.u8string() + "\\", "singlepass");
+                });
+                BenchmarkUtils::Report("UnpackGLB 2000 x 48 KB bufferViews", "single pass", singlePassMilliseconds);
+
+                auto threePassBin = ReadFile(outputDirectory / "threepass.bin");
+                Assert::AreEqual(document.buffers[0].byteLength, threePassBin.size());
+                Assert::IsTrue(threePassBin == ReadFile(outputDirectory / "singlepass.bin"));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
@@ -0,0 +1,160 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFSDK/Deserialize.h"
+
+#include "CachingStreamReader.h"
+#include "SerializeBinary.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(CachingStreamReaderTests)
+    {
+        const char* c_waterBottleJson = "Resources\\gltf\\WaterBottle\\WaterBottle.gltf";
+
+        static std::string ReadAll(std::istream& stream)
+        {
+            return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        }
+
+        static std::shared_ptr<InMemoryStreamReader> CreateResources()
+        {
+            auto streamReader = std::make_shared<InMemoryStreamReader>();
+            streamReader->Add("a.bin", std::string(40, 'a'));
+            streamReader->Add("b.bin", std::string(40, 'b'));
+            streamReader->Add("c.bin", std::string(40, 'c'));
+            streamReader->Add("large.bin", std::string(200, 'l'));
+            return streamReader;
+        }
+
+        TEST_METHOD(CachingStreamReaderTests_HitsAndMisses)
+        {
+            CachingStreamReader cache(CreateResources(), 100);
+
+            Assert::IsTrue(std::string(40, 'a') == ReadAll(*cache.GetInputStream("a.bin")));
+            Assert::IsTrue(std::string(40, 'a') == ReadAll(*cache.GetInputStream("a.bin")));
+            Assert::AreEqual(static_cast<size_t>(40), cache.GetResource("b.bin")->size());
+
+            auto statistics = cache.GetStatistics();
+            Assert::AreEqual(static_cast<size_t>(1), statistics.Hits);
+            Assert::AreEqual(static_cast<size_t>(2), statistics.Misses);
+            Assert::AreEqual(static_cast<size_t>(80), statistics.BytesHeld);
+        }
+
+        TEST_METHOD(CachingStreamReaderTests_EvictsLeastRecentlyUsed)
+        {
+            CachingStreamReader cache(CreateResources(), 100);
+
+            cache.GetResource("a.bin");
+            cache.GetResource("b.bin");
+            cache.GetResource("a.bin");
+
+            // Over budget: b.bin is the least recently used
+            cache.GetResource("c.bin");
+
+            auto statistics = cache.GetStatistics();
+            Assert::AreEqual(static_cast<size_t>(1), statistics.Evictions);
+            Assert::AreEqual(static_cast<size_t>(80), statistics.BytesHeld);
+
+            cache.GetResource("a.bin");
+            Assert::AreEqual(static_cast<size_t>(3), cache.GetStatistics().Misses);
+            cache.GetResource("b.bin");
+            Assert::AreEqual(static_cast<size_t>(4), cache.GetStatistics().Misses);
+
+            // Resources larger than the budget are served, but not cached
+            Assert::AreEqual(static_cast<size_t>(200), cache.GetResource("large.bin")->size());
+            Assert::IsTrue(cache.GetStatistics().BytesHeld <= 100);
+        }
+
+        TEST_METHOD(CachingStreamReaderTests_TryGetCachedDoesNotRead)
+        {
+            CachingStreamReader cache(CreateResources(), 100);
+
+            Assert::IsTrue(cache.TryGetCached("a.bin") == nullptr);
+            Assert::AreEqual(static_cast<size_t>(0), cache.GetStatistics().Misses);
+            Assert::AreEqual(static_cast<size_t>(0), cache.GetStatistics().BytesHeld);
+
+            cache.GetResource("a.bin");
+            Assert::AreEqual(static_cast<size_t>(40), cache.TryGetCached("a.bin")->size());
+
+            // Resources larger than the budget are streamed from the underlying reader, and never become resident
+            Assert::IsTrue(std::string(200, 'l') == ReadAll(*cache.GetInputStream("large.bin")));
+            Assert::IsTrue(std::string(200, 'l') == ReadAll(*cache.GetInputStream("large.bin")));
+            Assert::IsTrue(cache.TryGetCached("large.bin") == nullptr);
+
+            auto statistics = cache.GetStatistics();
+            Assert::AreEqual(static_cast<size_t>(3), statistics.Misses);
+            Assert::AreEqual(static_cast<size_t>(40), statistics.BytesHeld);
+        }
+
+        TEST_METHOD(CachingStreamReaderTests_PinnedResourcesStay)
+        {
+            CachingStreamReader cache(CreateResources(), 100);
+
+            cache.Pin("large.bin");
+            cache.Pin("a.bin");
+            cache.GetResource("b.bin");
+            cache.GetResource("c.bin");
+            cache.Clear();
+
+            auto statistics = cache.GetStatistics();
+            Assert::AreEqual(static_cast<size_t>(240), statistics.BytesPinned);
+            Assert::AreEqual(static_cast<size_t>(240), statistics.BytesHeld);
+
+            cache.GetResource("large.bin");
+            cache.GetResource("a.bin");
+            Assert::AreEqual(static_cast<size_t>(2), cache.GetStatistics().Hits);
+
+            // Once unpinned, resources over the budget are evicted
+            cache.Unpin("large.bin");
+            statistics = cache.GetStatistics();
+            Assert::AreEqual(static_cast<size_t>(40), statistics.BytesPinned);
+            Assert::AreEqual(static_cast<size_t>(40), statistics.BytesHeld);
+
+            Assert::ExpectException<std::invalid_argument>([&cache]()
+            {
+                cache.Unpin("b.bin");
+            });
+        }
+
+        TEST_METHOD(CachingStreamReaderTests_SharedBetweenSerializations)
+        {
+            try
+            {
+                auto absolutePath = TestUtils::GetAbsolutePath(c_waterBottleJson);
+                auto input = TestUtils::ReadLocalAsset(absolutePath);
+                auto doc = Deserialize(ReadAll(*input));
+
+                auto cache = std::make_shared<CachingStreamReader>(std::make_shared<TestStreamReader>(absolutePath));
+
+                auto firstOutput = std::make_shared<StreamMock>();
+                SerializeBinary(doc, cache, firstOutput);
+                auto misses = cache->GetStatistics().Misses;
+
+                // The second serialization reads nothing from disk
+                auto secondOutput = std::make_shared<StreamMock>();
+                SerializeBinary(doc, cache, secondOutput);
+                Assert::AreEqual(misses, cache->GetStatistics().Misses);
+
+                Assert::IsTrue(ReadAll(*firstOutput->GetInputStream(std::string())) == ReadAll(*secondOutput->GetInputStream(std::string())));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
@@ -132,5 +132,357 @@ namespace Microsoft::glTF::Toolkit::Test
                 Assert::Fail(WStringUtils::ToWString(ss).c_str());
             }
         }
+
+        TEST_METHOD(GLBSerializerTests_Streaming_BoundedMemory)
+        {
+            auto data = ReadLocalJson(c_waterBottleJson);
+            try
+            {
+                auto doc = Deserialize(data);
+
+                // Serialize Document to GLB and collect statistics
+                auto streamReader = std::make_shared<TestStreamReader>(TestUtils::GetAbsolutePath(c_waterBottleJson));
+                auto stream = std::make_shared<std::stringstream>(std::ios_base::app | std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+                SerializeBinaryStatistics statistics;
+                SerializeBinary(doc, streamReader, std::make_shared<InMemoryStream>(stream), nullptr, &statistics);
+
+                // The binary chunk must never be held as a whole, only the largest resource at a time
+                Assert::IsTrue(statistics.BinaryChunkByteLength > 0);
+                Assert::IsTrue(statistics.PeakBytesHeld > 0);
+                Assert::IsTrue(statistics.PeakBytesHeld < statistics.BinaryChunkByteLength);
+
+                // The GLB header must describe the whole stream
+                auto glb = stream->str();
+                uint32_t totalLength = 0;
+                memcpy(&totalLength, glb.data() + 8, sizeof(totalLength));
+                Assert::AreEqual(glb.size(), static_cast<size_t>(totalLength));
+
+                // Deserialize the GLB again
+                auto glbReader = std::make_unique<GLBResourceReader>(streamReader, stream);
+                auto outputDoc = Deserialize(glbReader->GetJson());
+
+                Assert::AreEqual(statistics.BinaryChunkByteLength, outputDoc.buffers.Elements()[0].byteLength);
+                Assert::AreEqual(doc.accessors.Size(), outputDoc.accessors.Size());
+
+                // Accessor data and bounds must survive the round trip
+                auto gltfReader = std::make_unique<GLTFResourceReader>(streamReader);
+                for (const auto& accessor : doc.accessors.Elements())
+                {
+                    if (accessor.componentType != COMPONENT_FLOAT)
+                    {
+                        continue;
+                    }
+
+                    const auto& outputAccessor = outputDoc.accessors.Get(accessor.id);
+                    Assert::IsTrue(gltfReader->ReadBinaryData<float>(doc, accessor) == glbReader->ReadBinaryData<float>(outputDoc, outputAccessor));
+                    Assert::AreEqual(static_cast<size_t>(Accessor::GetTypeCount(accessor.type)), outputAccessor.min.size());
+                    Assert::AreEqual(static_cast<size_t>(Accessor::GetTypeCount(accessor.type)), outputAccessor.max.size());
+                    if (!accessor.min.empty() && !accessor.max.empty())
+                    {
+                        Assert::IsTrue(accessor.min == outputAccessor.min);
+                        Assert::IsTrue(accessor.max == outputAccessor.max);
+                    }
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLBSerializerTests_Parallel_Deterministic)
+        {
+            auto data = ReadLocalJson(c_waterBottleJson);
+            try
+            {
+                auto doc = Deserialize(data);
+                auto streamReader = std::make_shared<TestStreamReader>(TestUtils::GetAbsolutePath(c_waterBottleJson));
+
+                auto serialize = [&](size_t threadCount)
+                {
+                    SerializeBinaryOptions options;
+                    options.ThreadCount = threadCount;
+
+                    auto stream = std::make_shared<std::stringstream>(std::ios_base::app | std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+                    SerializeBinary(doc, streamReader, std::make_shared<InMemoryStream>(stream), options);
+                    return stream->str();
+                };
+
+                // The GLB must be byte-identical whatever the number of threads
+                auto serialOutput = serialize(1);
+                Assert::IsTrue(serialOutput == serialize(4));
+                Assert::IsTrue(serialOutput == serialize(0));
+
+                // Reads through a shared resource reader are serialized, but must give the same result
+                SerializeBinaryOptions options;
+                options.ThreadCount = 4;
+                auto stream = std::make_shared<std::stringstream>(std::ios_base::app | std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+                SerializeBinary(doc, GLTFResourceReader(streamReader), std::make_shared<InMemoryStream>(stream), options);
+                Assert::IsTrue(serialOutput == stream->str());
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLBSerializerTests_ExtensionResources_UnreadableAreKept)
+        {
+            auto data = ReadLocalJson(c_waterBottleJson);
+            try
+            {
+                auto doc = Deserialize(data);
+                doc.extensions["EXT_test_resources"] = "{\"images\":[{\"uri\":\"Missing.png\"},{\"uri\":\"WaterBottle_normal.png\"}]}";
+
+                auto streamReader = std::make_shared<TestStreamReader>(TestUtils::GetAbsolutePath(c_waterBottleJson));
+                auto stream = std::make_shared<std::stringstream>(std::ios_base::app | std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+                SerializeBinary(doc, streamReader, std::make_shared<InMemoryStream>(stream));
+
+                // The GLB is complete: the resource that can't be read keeps its URI, and the other one is embedded
+                auto glb = stream->str();
+                uint32_t totalLength = 0;
+                memcpy(&totalLength, glb.data() + 8, sizeof(totalLength));
+                Assert::AreEqual(glb.size(), static_cast<size_t>(totalLength));
+
+                auto glbReader = std::make_unique<GLBResourceReader>(streamReader, stream);
+                auto outputDoc = Deserialize(glbReader->GetJson());
+                auto extensionJson = RapidJsonUtils::CreateDocumentFromString(outputDoc.extensions.at("EXT_test_resources"));
+                const auto& resources = extensionJson["images"];
+                Assert::AreEqual(std::string("Missing.png"), std::string(resources[0u]["uri"].GetString()));
+                Assert::IsFalse(resources[0u].HasMember("bufferView"));
+                Assert::IsFalse(resources[1u].HasMember("uri"));
+
+                const auto& bufferView = outputDoc.bufferViews.Get(std::to_string(resources[1u]["bufferView"].GetInt()));
+                std::vector<uint8_t> expected = GLTFResourceReader(streamReader).ReadBinaryData<uint8_t>(doc, doc.images.Get(doc.textures.Get(doc.materials.Elements()[0].normalTexture.textureId).imageId));
+                Assert::IsTrue(expected == glbReader->ReadBinaryData<uint8_t>(outputDoc, bufferView));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLBSerializerTests_Passthrough_StridedAccessors)
+        {
+            try
+            {
+                // Two VEC3 float accessors interleaved in a single bufferView with a 24-byte stride
+                const size_t vertexCount = 4;
+                std::vector<float> interleaved(vertexCount * 6);
+                for (size_t i = 0; i < interleaved.size(); i++)
+                {
+                    interleaved[i] = static_cast<float>(i);
+                }
+
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                streamReader->Add("interleaved.bin", std::string(reinterpret_cast<const char*>(interleaved.data()), interleaved.size() * sizeof(float)));
+
+                Document doc;
+
+                Buffer buffer;
+                buffer.id = "0";
+                buffer.uri = "interleaved.bin";
+                buffer.byteLength = interleaved.size() * sizeof(float);
+                doc.buffers.Append(std::move(buffer));
+
+                BufferView bufferView;
+                bufferView.id = "0";
+                bufferView.bufferId = "0";
+                bufferView.byteLength = interleaved.size() * sizeof(float);
+                bufferView.byteStride = 6 * sizeof(float);
+                doc.bufferViews.Append(std::move(bufferView));
+
+                for (size_t i = 0; i < 2; i++)
+                {
+                    Accessor accessor;
+                    accessor.id = std::to_string(i);
+                    accessor.bufferViewId = "0";
+                    accessor.byteOffset = i * 3 * sizeof(float);
+                    accessor.componentType = COMPONENT_FLOAT;
+                    accessor.type = TYPE_VEC3;
+                    accessor.count = vertexCount;
+                    doc.accessors.Append(std::move(accessor));
+                }
+
+                auto stream = std::make_shared<std::stringstream>(std::ios_base::app | std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+                SerializeBinaryStatistics statistics;
+                SerializeBinary(doc, streamReader, std::make_shared<InMemoryStream>(stream), nullptr, &statistics);
+
+                Assert::AreEqual(static_cast<size_t>(2), statistics.PassthroughAccessorCount);
+
+                auto glbReader = std::make_unique<GLBResourceReader>(streamReader, stream);
+                auto outputDoc = Deserialize(glbReader->GetJson());
+                for (size_t i = 0; i < 2; i++)
+                {
+                    const auto& outputAccessor = outputDoc.accessors.Get(std::to_string(i));
+
+                    // Each accessor gets its own, tightly packed, bufferView
+                    Assert::IsFalse(outputDoc.bufferViews.Get(outputAccessor.bufferViewId).byteStride.HasValue());
+
+                    auto contents = glbReader->ReadBinaryData<float>(outputDoc, outputAccessor);
+                    Assert::AreEqual(vertexCount * 3, contents.size());
+                    for (size_t v = 0; v < vertexCount; v++)
+                    {
+                        for (size_t c = 0; c < 3; c++)
+                        {
+                            Assert::AreEqual(interleaved[v * 6 + i * 3 + c], contents[v * 3 + c]);
+                        }
+                    }
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLBSerializerTests_Deduplicate_IdenticalAccessors)
+        {
+            try
+            {
+                // Three index accessors, the first two with identical contents
+                std::vector<uint16_t> indices = { 0, 1, 2, 2, 1, 3, 0, 1, 2, 2, 1, 3, 3, 2, 1, 1, 0, 3 };
+                const size_t accessorByteLength = 6 * sizeof(uint16_t);
+
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                streamReader->Add("indices.bin", std::string(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint16_t)));
+
+                Document doc;
+
+                Buffer buffer;
+                buffer.id = "0";
+                buffer.uri = "indices.bin";
+                buffer.byteLength = indices.size() * sizeof(uint16_t);
+                doc.buffers.Append(std::move(buffer));
+
+                for (size_t i = 0; i < 3; i++)
+                {
+                    BufferView bufferView;
+                    bufferView.id = std::to_string(i);
+                    bufferView.bufferId = "0";
+                    bufferView.byteOffset = i * accessorByteLength;
+                    bufferView.byteLength = accessorByteLength;
+                    bufferView.target = ELEMENT_ARRAY_BUFFER;
+                    doc.bufferViews.Append(std::move(bufferView));
+
+                    Accessor accessor;
+                    accessor.id = std::to_string(i);
+                    accessor.bufferViewId = std::to_string(i);
+                    accessor.componentType = COMPONENT_UNSIGNED_SHORT;
+                    accessor.type = TYPE_SCALAR;
+                    accessor.count = 6;
+                    doc.accessors.Append(std::move(accessor));
+                }
+
+                SerializeBinaryOptions options;
+                options.DeduplicateBuffers = true;
+                options.ThreadCount = 2;
+
+                auto stream = std::make_shared<std::stringstream>(std::ios_base::app | std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+                SerializeBinaryStatistics statistics;
+                SerializeBinary(doc, streamReader, std::make_shared<InMemoryStream>(stream), options, &statistics);
+
+                Assert::AreEqual(static_cast<size_t>(1), statistics.DeduplicatedBufferViewCount);
+                Assert::AreEqual(accessorByteLength, statistics.DeduplicatedByteLength);
+
+                auto glbReader = std::make_unique<GLBResourceReader>(streamReader, stream);
+                auto outputDoc = Deserialize(glbReader->GetJson());
+
+                // The duplicate shares the bufferView of the first accessor, and the bufferView ids stay contiguous
+                Assert::AreEqual(static_cast<size_t>(2), outputDoc.bufferViews.Size());
+                Assert::IsTrue(outputDoc.accessors.Get("0").bufferViewId == outputDoc.accessors.Get("1").bufferViewId);
+                Assert::IsTrue(outputDoc.accessors.Get("0").bufferViewId != outputDoc.accessors.Get("2").bufferViewId);
+
+                for (size_t i = 0; i < 3; i++)
+                {
+                    auto contents = glbReader->ReadBinaryData<uint16_t>(outputDoc, outputDoc.accessors.Get(std::to_string(i)));
+                    Assert::IsTrue(std::vector<uint16_t>(indices.begin() + i * 6, indices.begin() + (i + 1) * 6) == contents);
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLBSerializerTests_Interleave_PrimitiveAttributes)
+        {
+            try
+            {
+                // A quad with float positions and normals, normalized byte texture coordinates and short indices
+                std::vector<float> positions = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+                std::vector<float> normals = { 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1 };
+                std::vector<uint8_t> texCoords = { 0, 0, 255, 0, 0, 255, 255, 255 };
+                std::vector<uint16_t> indices = { 0, 1, 2, 2, 1, 3 };
+
+                InMemoryDocumentBuilder builder("quad.bin");
+
+                MeshPrimitive primitive;
+                primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT, ARRAY_BUFFER);
+                primitive.attributes[ACCESSOR_NORMAL] = builder.AddAccessor(normals, TYPE_VEC3, COMPONENT_FLOAT, ARRAY_BUFFER);
+                primitive.attributes[ACCESSOR_TEXCOORD_0] = builder.AddAccessor(texCoords, TYPE_VEC2, COMPONENT_UNSIGNED_BYTE, ARRAY_BUFFER, true);
+                primitive.indicesAccessorId = builder.AddAccessor(indices, TYPE_SCALAR, COMPONENT_UNSIGNED_SHORT, ELEMENT_ARRAY_BUFFER);
+
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                auto doc = builder.Build(*streamReader);
+
+                Mesh mesh;
+                mesh.id = "0";
+                mesh.primitives.push_back(std::move(primitive));
+                doc.meshes.Append(std::move(mesh));
+
+                SerializeBinaryOptions options;
+                options.InterleaveVertexAttributes = true;
+
+                auto stream = std::make_shared<std::stringstream>(std::ios_base::app | std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+                SerializeBinaryStatistics statistics;
+                SerializeBinary(doc, streamReader, std::make_shared<InMemoryStream>(stream), options, &statistics);
+
+                Assert::AreEqual(static_cast<size_t>(1), statistics.InterleavedBufferViewCount);
+
+                auto glbReader = std::make_unique<GLBResourceReader>(streamReader, stream);
+                auto outputDoc = Deserialize(glbReader->GetJson());
+                Assert::AreEqual(static_cast<size_t>(2), outputDoc.bufferViews.Size());
+
+                // The attributes share one bufferView, each element aligned to 4 bytes
+                const auto& vertexBufferView = outputDoc.bufferViews.Get(outputDoc.accessors.Get("0").bufferViewId);
+                Assert::IsTrue(vertexBufferView.byteStride.HasValue());
+                Assert::AreEqual(static_cast<size_t>(28), vertexBufferView.byteStride.Get());
+                Assert::IsTrue(vertexBufferView.target.HasValue() && vertexBufferView.target.Get() == ARRAY_BUFFER);
+                for (size_t i = 0; i < 3; i++)
+                {
+                    Assert::IsTrue(outputDoc.accessors.Get(std::to_string(i)).bufferViewId == vertexBufferView.id);
+                }
+                Assert::AreEqual(static_cast<size_t>(0), outputDoc.accessors.Get("0").byteOffset);
+                Assert::AreEqual(static_cast<size_t>(12), outputDoc.accessors.Get("1").byteOffset);
+                Assert::AreEqual(static_cast<size_t>(24), outputDoc.accessors.Get("2").byteOffset);
+
+                // Indices keep a tightly packed bufferView of their own
+                const auto& indexBufferView = outputDoc.bufferViews.Get(outputDoc.accessors.Get("3").bufferViewId);
+                Assert::IsFalse(indexBufferView.byteStride.HasValue());
+                Assert::IsTrue(indexBufferView.id != vertexBufferView.id);
+
+                Assert::IsTrue(positions == glbReader->ReadBinaryData<float>(outputDoc, outputDoc.accessors.Get("0")));
+                Assert::IsTrue(normals == glbReader->ReadBinaryData<float>(outputDoc, outputDoc.accessors.Get("1")));
+                Assert::IsTrue(texCoords == glbReader->ReadBinaryData<uint8_t>(outputDoc, outputDoc.accessors.Get("2")));
+                Assert::IsTrue(indices == glbReader->ReadBinaryData<uint16_t>(outputDoc, outputDoc.accessors.Get("3")));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
     };
 }
\ No newline at end of file
@@ -8,7 +8,11 @@
 #include <GLTFSDK/Document.h>
 #include <GLTFSDK/Deserialize.h>
 #include <GLTFSDK/Serialize.h>
+#include <GLTFSDK/IStreamWriter.h>
 #include <GLBtoGLTF.h>
+#include <NativeFile.h>
+
+#include "Helpers/TestUtils.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace Microsoft::glTF;
@@ -84,6 +88,32 @@ namespace Microsoft::glTF::Toolkit::Test
         return ss;
     }
 
+    // Keeps every output stream in memory, by name
+    class OutputStreamsMock : public IStreamWriter
+    {
+    public:
+        std::shared_ptr<std::ostream> GetOutputStream(const std::string& filename) const override
+        {
+            auto stream = std::make_shared<std::stringstream>(std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+            m_streams[filename] = stream;
+            return stream;
+        }
+
+        std::vector<char> GetContents(const std::string& filename) const
+        {
+            auto contents = m_streams.at(filename)->str();
+            return std::vector<char>(contents.begin(), contents.end());
+        }
+
+        size_t Size() const
+        {
+            return m_streams.size();
+        }
+
+    private:
+        mutable std::unordered_map<std::string, std::shared_ptr<std::stringstream>> m_streams;
+    };
+
     TEST_CLASS(GLBToGLTFTests)
     {
         TEST_METHOD(GLBtoGLTF_NoImagesJSON)
@@ -227,5 +257,78 @@ namespace Microsoft::glTF::Toolkit::Test
                 BYTE_OFFSET + 4, BYTE_OFFSET + 5, BYTE_OFFSET + 6, BYTE_OFFSET + 7 };
             Assert::IsTrue(actualData == expectedData, utf8Decode(binBufferString(actualData) + '\n' + binBufferString(expectedData)).c_str());
         }
+
+        TEST_METHOD(GLBtoGLTF_UnpackResourcesTest)
+        {
+            auto glbDoc = setupGLBDocument1();
+
+            // a fourth buffer view that overlaps the first one and is not 4-byte aligned
+            BufferView bv3; bv3.bufferId = "0"; bv3.byteOffset = 6; bv3.byteLength = 3; bv3.id = "3";
+            glbDoc.bufferViews.Append(std::move(bv3));
+
+            auto glbStream = setupGLBStream(100);
+            const size_t BYTE_OFFSET = 12;
+            std::unordered_set<std::string> unpackedBufferViews;
+            auto outputDoc = GLBToGLTF::CreateGLTFDocument(glbDoc, "name", unpackedBufferViews);
+
+            auto outputStreams = std::make_shared<OutputStreamsMock>();
+            GLBToGLTF::UnpackResources(glbStream, glbDoc, "name", BYTE_OFFSET, unpackedBufferViews, outputStreams);
+            delete glbStream;
+
+            Assert::AreEqual(static_cast<size_t>(3), outputStreams->Size());
+
+            std::vector<char> expectedImage0 = { BYTE_OFFSET + 32, BYTE_OFFSET + 33, BYTE_OFFSET + 34, BYTE_OFFSET + 35 };
+            std::vector<char> expectedImage1 = { BYTE_OFFSET + 72, BYTE_OFFSET + 73 };
+            Assert::IsTrue(outputStreams->GetContents("name_image0.png") == expectedImage0);
+            Assert::IsTrue(outputStreams->GetContents("name_image1.jpg") == expectedImage1);
+
+            // the bin file matches the byte offsets and length of the new manifest
+            std::vector<char> expectedData = { BYTE_OFFSET + 0, BYTE_OFFSET + 1, BYTE_OFFSET + 2, BYTE_OFFSET + 3,
+                BYTE_OFFSET + 4, BYTE_OFFSET + 5, BYTE_OFFSET + 6, BYTE_OFFSET + 7,
+                BYTE_OFFSET + 6, BYTE_OFFSET + 7, BYTE_OFFSET + 8 };
+            auto actualData = outputStreams->GetContents("name.bin");
+            Assert::IsTrue(actualData == expectedData, utf8Decode(binBufferString(actualData) + '\n' + binBufferString(expectedData)).c_str());
+            Assert::AreEqual(outputDoc.buffers[0].byteLength, actualData.size());
+            Assert::AreEqual(static_cast<size_t>(8), outputDoc.bufferViews.Get(outputDoc.accessors.Get("0").bufferViewId).byteLength);
+        }
+
+        TEST_METHOD(GLBtoGLTF_UnpackResourcesFromFileTest)
+        {
+            try
+            {
+                auto glbDoc = setupGLBDocument1();
+                auto glbStream = setupGLBStream(100);
+                const size_t BYTE_OFFSET = 12;
+                std::unordered_set<std::string> unpackedBufferViews;
+                GLBToGLTF::CreateGLTFDocument(glbDoc, "name", unpackedBufferViews);
+
+                auto outputDirectory = TestUtils::CreateOutputDirectory("GLBToGLTFTests");
+                {
+                    std::ofstream glbFile(outputDirectory / "input.glb", std::ios::binary);
+                    glbFile << glbStream->rdbuf();
+                }
+
+                auto outputStreams = std::make_shared<OutputStreamsMock>();
+                GLBToGLTF::UnpackResources(glbStream, glbDoc, "name", BYTE_OFFSET, unpackedBufferViews, outputStreams);
+                delete glbStream;
+
+                // the files copied from the GLB file match the streams written by the stream overload
+                auto glbFile = NativeFile::OpenRead(outputDirectory / "input.glb");
+                Assert::IsNotNull(glbFile.get());
+                GLBToGLTF::UnpackResources(*glbFile, glbDoc, "name", BYTE_OFFSET, unpackedBufferViews, std::make_shared<FileStreamWriter>(outputDirectory));
+
+                for (const auto& filename : { "name_image0.png", "name_image1.jpg", "name.bin" })
+                {
+                    std::ifstream unpackedFile(outputDirectory / filename, std::ios::binary);
+                    std::vector<char> actualData((std::istreambuf_iterator<char>(unpackedFile)), std::istreambuf_iterator<char>());
+                    auto expectedData = outputStreams->GetContents(filename);
+                    Assert::IsTrue(actualData == expectedData, utf8Decode(binBufferString(actualData) + '\n' + binBufferString(expectedData)).c_str());
+                }
+            }
+            catch (std::exception ex)
+            {
+                Assert::Fail(utf8Decode(ex.what()).c_str());
+            }
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFBatchingUtils.h"
+#include "MemoryMappedStreamReader.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(GLTFBatchingUtilsTests)
+    {
+        // A root node with one child per translation, each drawing the same triangle with positions and normals
+        static Document CreateInstances(std::shared_ptr<InMemoryStreamReader>& streamReader, const std::vector<Vector3>& translations)
+        {
+            std::vector<float> positions = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+            std::vector<float> normals = { 0, 0, 1, 0, 0, 1, 0, 0, 1 };
+            std::vector<uint16_t> indices = { 0, 1, 2 };
+
+            InMemoryDocumentBuilder builder("triangle.bin");
+
+            MeshPrimitive primitive;
+            primitive.materialId = "0";
+            primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT);
+            primitive.attributes[ACCESSOR_NORMAL] = builder.AddAccessor(normals, TYPE_VEC3, COMPONENT_FLOAT);
+            primitive.indicesAccessorId = builder.AddAccessor(indices, TYPE_SCALAR, COMPONENT_UNSIGNED_SHORT);
+
+            streamReader = std::make_shared<InMemoryStreamReader>();
+            auto doc = builder.Build(*streamReader);
+
+            Material material;
+            material.id = "0";
+            doc.materials.Append(std::move(material));
+
+            Mesh mesh;
+            mesh.id = "0";
+            mesh.primitives.push_back(std::move(primitive));
+            doc.meshes.Append(std::move(mesh));
+
+            Node root;
+            root.id = "0";
+            root.name = "root";
+            for (size_t i = 0; i < translations.size(); i++)
+            {
+                Node node;
+                node.id = std::to_string(i + 1);
+                node.meshId = "0";
+                node.translation = translations[i];
+                root.children.push_back(doc.nodes.Append(std::move(node)).id);
+            }
+            doc.nodes.Append(std::move(root));
+
+            Scene scene;
+            scene.id = "0";
+            scene.nodes.push_back("0");
+            doc.scenes.Append(std::move(scene));
+            doc.defaultSceneId = "0";
+
+            return doc;
+        }
+
+        TEST_METHOD(GLTFBatchingUtilsTests_BatchStaticMeshes)
+        {
+            try
+            {
+                std::shared_ptr<InMemoryStreamReader> streamReader;
+                auto doc = CreateInstances(streamReader, { { 0, 0, 0 }, { 10, 0, 0 }, { 0, 10, 0 } });
+
+                // A mirrored instance
+                auto mirrored = doc.nodes.Get("3");
+                mirrored.scale = { -1, 1, 1 };
+                doc.nodes.Replace(mirrored);
+
+                BatchingOptions options;
+                options.GridResolution = 0;
+
+                BatchingStatistics statistics;
+                auto outputDirectory = TestUtils::CreateOutputDirectory("GLTFBatchingUtilsTests");
+                auto batchedDoc = GLTFBatchingUtils::BatchStaticMeshes(streamReader, doc, options, outputDirectory.u8string(), &statistics);
+
+                Assert::AreEqual(static_cast<size_t>(3), statistics.PrimitivesBefore);
+                Assert::AreEqual(static_cast<size_t>(1), statistics.PrimitivesAfter);
+
+                // The root node keeps its id, and its empty children are replaced by the batch
+                const auto& root = batchedDoc.nodes.Get("0");
+                Assert::AreEqual(static_cast<size_t>(1), root.children.size());
+                Assert::AreEqual(static_cast<size_t>(2), batchedDoc.nodes.Size());
+                Assert::IsFalse(batchedDoc.meshes.Has("0"));
+                Assert::IsFalse(batchedDoc.accessors.Has("0"));
+
+                const auto& batchNode = batchedDoc.nodes.Get(root.children[0]);
+                const auto& batchMesh = batchedDoc.meshes.Get(batchNode.meshId);
+                Assert::AreEqual(static_cast<size_t>(1), batchMesh.primitives.size());
+
+                const auto& primitive = batchMesh.primitives[0];
+                Assert::AreEqual(std::string("0"), primitive.materialId);
+
+                const auto& positionAccessor = batchedDoc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+                Assert::AreEqual(static_cast<size_t>(9), positionAccessor.count);
+                Assert::AreEqual(-1.0f, positionAccessor.min[0]);
+                Assert::AreEqual(11.0f, positionAccessor.max[0]);
+                Assert::AreEqual(11.0f, positionAccessor.max[1]);
+
+                GLTFResourceReader reader(std::make_shared<MemoryMappedStreamReader>(outputDirectory));
+                auto positions = reader.ReadBinaryData<float>(batchedDoc, positionAccessor);
+                auto normals = reader.ReadBinaryData<float>(batchedDoc, batchedDoc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_NORMAL)));
+                auto indices = reader.ReadBinaryData<uint16_t>(batchedDoc, batchedDoc.accessors.Get(primitive.indicesAccessorId));
+
+                // The second instance is translated
+                Assert::AreEqual(11.0f, positions[4 * 3]);
+
+                // The mirrored instance keeps its normals facing +Z, and its winding is swapped so that it still faces them
+                Assert::AreEqual(-1.0f, positions[7 * 3]);
+                Assert::AreEqual(1.0f, normals[6 * 3 + 2]);
+                Assert::IsTrue(std::vector<uint16_t>(indices.begin(), indices.end()) == std::vector<uint16_t>{ 0, 1, 2, 3, 4, 5, 6, 8, 7 });
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLTFBatchingUtilsTests_BatchStaticMeshes_SkipsAnimatedNodes)
+        {
+            try
+            {
+                std::shared_ptr<InMemoryStreamReader> streamReader;
+                auto doc = CreateInstances(streamReader, { { 0, 0, 0 }, { 10, 0, 0 } });
+
+                Animation animation;
+                animation.id = "0";
+                AnimationChannel channel;
+                channel.id = "0";
+                channel.target.nodeId = "1";
+                channel.target.path = TARGET_TRANSLATION;
+                animation.channels.Append(std::move(channel));
+                doc.animations.Append(std::move(animation));
+
+                auto batchedDoc = GLTFBatchingUtils::BatchStaticMeshes(streamReader, doc, BatchingOptions(), TestUtils::CreateOutputDirectory("GLTFBatchingUtilsTests").u8string());
+
+                // Only one static primitive is left, so nothing is merged
+                Assert::AreEqual(doc.nodes.Size(), batchedDoc.nodes.Size());
+                Assert::AreEqual(std::string("0"), batchedDoc.nodes.Get("2").meshId);
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFImpostorUtils.h"
+#include "GLTFLODUtils.h"
+#include "GLTFTextureUtils.h"
+#include "MemoryMappedStreamReader.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(GLTFImpostorUtilsTests)
+    {
+        TEST_METHOD(GLTFImpostorUtilsTests_GenerateImpostor)
+        {
+            try
+            {
+                // A square of size 2 in the XY plane, centered on the origin and facing +Z
+                std::vector<float> positions = { -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f, -1.0f, 1.0f, 0.0f };
+                std::vector<uint16_t> indices = { 0, 1, 2, 0, 2, 3 };
+
+                InMemoryDocumentBuilder builder("square.bin");
+
+                MeshPrimitive primitive;
+                primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT);
+                primitive.indicesAccessorId = builder.AddAccessor(indices, TYPE_SCALAR, COMPONENT_UNSIGNED_SHORT);
+
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                auto doc = builder.Build(*streamReader);
+
+                Accessor positionAccessor = doc.accessors.Get(primitive.attributes[ACCESSOR_POSITION]);
+                positionAccessor.min = { -1.0f, -1.0f, 0.0f };
+                positionAccessor.max = { 1.0f, 1.0f, 0.0f };
+                doc.accessors.Replace(std::move(positionAccessor));
+
+                Mesh mesh;
+                mesh.id = "0";
+                mesh.primitives.push_back(std::move(primitive));
+                doc.meshes.Append(std::move(mesh));
+
+                Node node;
+                node.id = "0";
+                node.meshId = "0";
+                node.translation = { 5.0f, 0.0f, 0.0f };
+                doc.nodes.Append(std::move(node));
+
+                Scene scene;
+                scene.id = "0";
+                scene.nodes.push_back("0");
+                doc.scenes.Append(std::move(scene));
+                doc.defaultSceneId = "0";
+
+                ImpostorOptions options;
+                options.ViewCount = 2;
+                options.ViewResolution = 16;
+                options.TileSize = 4;
+                options.ThreadCount = 2;
+
+                auto outputDirectory = TestUtils::CreateOutputDirectory("GLTFImpostorUtilsTests");
+                auto impostor = GLTFImpostorUtils::GenerateImpostor(streamReader, doc, options, outputDirectory.u8string());
+
+                // The root node keeps its transform, with one quad per view
+                Assert::AreEqual(static_cast<size_t>(1), impostor.nodes.Size());
+                const auto& impostorNode = impostor.nodes.Get("0");
+                Assert::AreEqual(5.0f, impostorNode.translation.x);
+
+                const auto& impostorPrimitive = impostor.meshes.Get(impostorNode.meshId).primitives[0];
+                Assert::AreEqual(static_cast<size_t>(12), impostor.accessors.Get(impostorPrimitive.indicesAccessorId).count);
+                Assert::AreEqual(static_cast<size_t>(8), impostor.accessors.Get(impostorPrimitive.GetAttributeAccessorId(ACCESSOR_POSITION)).count);
+                Assert::IsTrue(impostorPrimitive.HasAttribute(ACCESSOR_TANGENT));
+
+                // The quads leave a border of one pixel around the square
+                const auto& impostorPositionAccessor = impostor.accessors.Get(impostorPrimitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+                Assert::AreEqual(16.0f / 14.0f, impostorPositionAccessor.max[1], 0.0001f);
+
+                const auto& material = impostor.materials.Get(impostorPrimitive.materialId);
+                Assert::IsTrue(material.alphaMode == ALPHA_MASK);
+                Assert::IsFalse(material.normalTexture.textureId.empty());
+
+                // The first view faces the square, and the second one only sees its edge
+                auto imageReader = std::make_shared<MemoryMappedStreamReader>(outputDirectory);
+                auto atlas = GLTFTextureUtils::LoadTexture(imageReader, impostor, material.metallicRoughness.baseColorTexture.textureId, false);
+                Assert::AreEqual(static_cast<size_t>(32), atlas.GetMetadata().width);
+                Assert::AreEqual(static_cast<size_t>(16), atlas.GetMetadata().height);
+                Assert::AreEqual(1.0f, *GLTFTextureUtils::GetChannelValue(atlas.GetPixels(), 8 * 32 + 8, Channel::Alpha));
+                Assert::AreEqual(0.0f, *GLTFTextureUtils::GetChannelValue(atlas.GetPixels(), 8 * 32 + 24, Channel::Alpha));
+
+                // The impostor is merged as the last level of detail
+                auto merged = GLTFLODUtils::MergeDocumentsAsLODs({ doc, impostor });
+                auto lods = GLTFLODUtils::ParseDocumentNodeLODs(merged);
+                Assert::AreEqual(static_cast<size_t>(1), lods.at("0")->size());
+                Assert::IsFalse(merged.nodes.Get(lods.at("0")->at(0)).meshId.empty());
+
+                // Merged after other LODs, as the converter does, the impostor is added to the existing ones
+                auto mergedLODs = GLTFLODUtils::MergeDocumentsAsLODs({ doc, doc, doc });
+                auto mergedWithImpostor = GLTFLODUtils::MergeDocumentsAsLODs({ mergedLODs, impostor });
+                auto lodsWithoutImpostor = GLTFLODUtils::ParseDocumentNodeLODs(mergedLODs);
+                auto lodsWithImpostor = GLTFLODUtils::ParseDocumentNodeLODs(mergedWithImpostor);
+                Assert::AreEqual(static_cast<size_t>(2), lodsWithoutImpostor.at("0")->size());
+                Assert::AreEqual(static_cast<size_t>(3), lodsWithImpostor.at("0")->size());
+                Assert::IsTrue(std::equal(lodsWithoutImpostor.at("0")->begin(), lodsWithoutImpostor.at("0")->end(), lodsWithImpostor.at("0")->begin()));
+
+                const auto& impostorLOD = mergedWithImpostor.nodes.Get(lodsWithImpostor.at("0")->at(2));
+                Assert::IsTrue(mergedWithImpostor.meshes.Get(impostorLOD.meshId).primitives[0].HasAttribute(ACCESSOR_TANGENT));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
@@ -17,6 +17,9 @@
 
 #include "Helpers/WStringUtils.h"
 #include "Helpers/TestUtils.h"
+#include "Helpers/StreamMock.h"
+
+#include <cmath>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace Microsoft::glTF;
@@ -252,6 +255,235 @@ namespace Microsoft::glTF::Toolkit::Test
             }
         }
 
+        // A textured triangle whose texture coordinates are the same in every LOD
+        static Document CreateTexturedTriangle(InMemoryStreamReader& streamReader, const std::string& bufferUri, const std::string& imageUri, float height)
+        {
+            std::vector<float> positions = { 0, 0, 0, 1, 0, 0, 0, height, 0 };
+            std::vector<float> texCoords = { 0, 0, 1, 0, 0, 1 };
+
+            InMemoryDocumentBuilder builder(bufferUri);
+
+            MeshPrimitive primitive;
+            primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT);
+            primitive.attributes[ACCESSOR_TEXCOORD_0] = builder.AddAccessor(texCoords, TYPE_VEC2, COMPONENT_FLOAT);
+
+            auto doc = builder.Build(streamReader);
+            streamReader.Add(imageUri, "image");
+
+            Image image;
+            image.id = "0";
+            image.uri = imageUri;
+            doc.images.Append(std::move(image));
+
+            Texture texture;
+            texture.id = "0";
+            texture.imageId = "0";
+            doc.textures.Append(std::move(texture));
+
+            Material material;
+            material.id = "0";
+            material.metallicRoughness.baseColorTexture.textureId = "0";
+            doc.materials.Append(std::move(material));
+
+            primitive.materialId = "0";
+            Mesh mesh;
+            mesh.id = "0";
+            mesh.primitives.push_back(std::move(primitive));
+            doc.meshes.Append(std::move(mesh));
+
+            Node root;
+            root.id = "0";
+            root.name = "root";
+            root.meshId = "0";
+            doc.nodes.Append(std::move(root));
+
+            Scene scene;
+            scene.id = "0";
+            scene.nodes.push_back("0");
+            doc.scenes.Append(std::move(scene));
+
+            return doc;
+        }
+
+        TEST_METHOD(GLTFLODUtils_GLTFNodeLODMergeDeduplicate)
+        {
+            try
+            {
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                std::vector<Document> docs;
+                docs.push_back(CreateTexturedTriangle(*streamReader, "lod0.bin", "lod0.png", 1.0f));
+                docs.push_back(CreateTexturedTriangle(*streamReader, "lod1.bin", "lod1.png", 2.0f));
+                docs.push_back(CreateTexturedTriangle(*streamReader, "lod2.bin", "lod2.png", 2.0f));
+
+                LODDeduplicationStatistics statistics;
+                auto merged = GLTFLODUtils::MergeDocumentsAsLODs(streamReader, docs, {}, {}, false, &statistics);
+
+                // Only the positions of the first LOD, which differ, are stored again, and the buffer views that held the rest are left out
+                Assert::AreEqual(static_cast<size_t>(3), merged.accessors.Size());
+                Assert::AreEqual(static_cast<size_t>(3), merged.bufferViews.Size());
+                Assert::AreEqual(static_cast<size_t>(2), merged.buffers.Size());
+                Assert::AreEqual(static_cast<size_t>(1), merged.images.Size());
+                Assert::AreEqual(static_cast<size_t>(3), merged.textures.Size());
+                Assert::AreEqual(static_cast<size_t>(3), merged.meshes.Size());
+
+                const auto& lod1Primitive = merged.meshes[1].primitives[0];
+                const auto& lod2Primitive = merged.meshes[2].primitives[0];
+                Assert::AreEqual(std::string("1"), lod1Primitive.GetAttributeAccessorId(ACCESSOR_TEXCOORD_0));
+                Assert::AreEqual(std::string("2"), lod1Primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+                Assert::AreEqual(std::string("2"), lod2Primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+                Assert::AreEqual(std::string("0"), merged.textures[2].imageId);
+
+                Assert::AreEqual(static_cast<size_t>(2), statistics.DeduplicatedByteLength.size());
+                Assert::AreEqual(static_cast<size_t>(24 + 5), statistics.DeduplicatedByteLength[0]);
+                Assert::AreEqual(static_cast<size_t>(36 + 24 + 5), statistics.DeduplicatedByteLength[1]);
+                Assert::AreEqual(static_cast<size_t>(3), statistics.DeduplicatedAccessorCount);
+                Assert::AreEqual(static_cast<size_t>(2), statistics.DeduplicatedImageCount);
+
+                // The last LOD reuses everything, so none of its buffers is referenced
+                for (const auto& bufferView : merged.bufferViews.Elements())
+                {
+                    Assert::AreNotEqual(std::string("lod2.bin"), merged.buffers.Get(bufferView.bufferId).uri);
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLTFLODUtils_ComputeScreenCoverage)
+        {
+            auto input = TestUtils::ReadLocalAsset(TestUtils::GetAbsolutePath(c_cubeAsset3DJson));
+            try
+            {
+                auto inputJson = std::string(std::istreambuf_iterator<char>(*input), std::istreambuf_iterator<char>());
+                auto doc = Deserialize(inputJson, KHR::GetKHRExtensionDeserializer());
+
+                // A unit cube with 12 triangles, and LODs that only draw 3 and 1 of them
+                std::vector<Document> docs(3, doc);
+                for (size_t i = 1; i < docs.size(); i++)
+                {
+                    auto indices = docs[i].accessors.Get("0");
+                    indices.count = i == 1 ? 9 : 3;
+                    docs[i].accessors.Replace(indices);
+                }
+
+                auto merged = GLTFLODUtils::MergeDocumentsAsLODs(docs);
+                auto rootId = merged.scenes.Elements()[0].nodes[0];
+
+                ScreenCoverageOptions options;
+                auto screenCoverages = GLTFLODUtils::ComputeScreenCoverage(merged, options);
+
+                Assert::AreEqual(static_cast<size_t>(1), screenCoverages.size());
+                const auto& screenCoverage = screenCoverages.at(rootId);
+                Assert::AreEqual(static_cast<size_t>(3), screenCoverage.size());
+
+                // The bounding sphere of the cube is sqrt(3) wide and its surface is 6, so 6 visible triangles reach 0.1 triangles per
+                // pixel when they cover 60 pixels, i.e. when the cube is sqrt(40) pixels wide
+                auto expected = std::sqrt(3.0) * std::sqrt(40.0) / options.ScreenHeight;
+                Assert::AreEqual(expected, screenCoverage[0], 1e-9);
+                Assert::AreEqual(expected / 2, screenCoverage[1], 1e-9);
+                Assert::AreEqual(expected / std::sqrt(12.0), screenCoverage[2], 1e-9);
+
+                // Doubling the density halves the area of the triangles
+                options.TrianglesPerPixel *= 2;
+                Assert::AreEqual(expected / std::sqrt(2.0), GLTFLODUtils::ComputeScreenCoverage(merged, options).at(rootId)[0], 1e-9);
+
+                auto result = GLTFLODUtils::SetScreenCoverage(merged, screenCoverages);
+                auto extrasJson = RapidJsonUtils::CreateDocumentFromString(result.nodes.Get(rootId).extras);
+                Assert::AreEqual(3u, extrasJson["MSFT_screencoverage"].Size());
+                Assert::AreEqual(screenCoverage[1], extrasJson["MSFT_screencoverage"][1u].GetDouble());
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLTFLODUtils_ComputeScreenCoverage_QuantizedPositions)
+        {
+            auto input = TestUtils::ReadLocalAsset(TestUtils::GetAbsolutePath(c_cubeAsset3DJson));
+            try
+            {
+                auto inputJson = std::string(std::istreambuf_iterator<char>(*input), std::istreambuf_iterator<char>());
+                auto doc = Deserialize(inputJson, KHR::GetKHRExtensionDeserializer());
+
+                // The same unit cube with normalized positions, whose bounds are stored as integers
+                auto quantizedDoc = doc;
+                auto positions = quantizedDoc.accessors.Get("1");
+                positions.componentType = COMPONENT_UNSIGNED_SHORT;
+                positions.normalized = true;
+                positions.max = { 65535.0f, 65535.0f, 65535.0f };
+                quantizedDoc.accessors.Replace(positions);
+
+                auto merged = GLTFLODUtils::MergeDocumentsAsLODs({ doc, doc });
+                auto quantizedMerged = GLTFLODUtils::MergeDocumentsAsLODs({ quantizedDoc, quantizedDoc });
+                auto rootId = merged.scenes.Elements()[0].nodes[0];
+
+                auto expected = GLTFLODUtils::ComputeScreenCoverage(merged).at(rootId);
+                auto actual = GLTFLODUtils::ComputeScreenCoverage(quantizedMerged).at(rootId);
+                Assert::AreEqual(expected.size(), actual.size());
+                for (size_t i = 0; i < expected.size(); i++)
+                {
+                    Assert::AreEqual(expected[i], actual[i], 1e-9);
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLTFLODUtils_AddMaterialLODs)
+        {
+            auto input = TestUtils::ReadLocalAsset(TestUtils::GetAbsolutePath(c_cubeAsset3DJson));
+            try
+            {
+                auto inputJson = std::string(std::istreambuf_iterator<char>(*input), std::istreambuf_iterator<char>());
+                auto doc = Deserialize(inputJson, KHR::GetKHRExtensionDeserializer());
+
+                // Three node LODs that share the first material
+                std::vector<Document> docs(3, doc);
+                auto merged = GLTFLODUtils::MergeDocumentsAsLODs(docs, std::vector<std::wstring>(), true);
+
+                // The first material has a single material LOD
+                LODMap materialLods;
+                materialLods.emplace("0", std::make_shared<std::vector<std::string>>(std::vector<std::string>{ "1" }));
+                auto result = GLTFLODUtils::AddMaterialLODs(merged, materialLods);
+
+                Assert::IsTrue(result.extensionsUsed.find(EXTENSION_MSFT_LOD) != result.extensionsUsed.end());
+
+                auto lodExtension = result.materials.Get("0").extensions.at(EXTENSION_MSFT_LOD);
+                auto lodJson = RapidJsonUtils::CreateDocumentFromString(lodExtension);
+                Assert::AreEqual(1u, lodJson[MSFT_LOD_IDS_KEY].Size());
+                Assert::AreEqual(1, lodJson[MSFT_LOD_IDS_KEY][0u].GetInt());
+
+                // The mesh of the highest LOD keeps its material, and the meshes of both lower LODs use the lowest material LOD
+                for (const auto& node : result.nodes.Elements())
+                {
+                    if (node.meshId.empty())
+                    {
+                        continue;
+                    }
+
+                    auto expectedMaterialId = node.name == "polygon" ? "0" : "1";
+                    Assert::AreEqual(std::string(expectedMaterialId), result.meshes.Get(node.meshId).primitives[0].materialId);
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
         TEST_METHOD(GLTFLODUtils_DeserialiseNodeLODExtension)
         {
             auto input = TestUtils::ReadLocalAsset(TestUtils::GetAbsolutePath(c_cubeWithLODJson));
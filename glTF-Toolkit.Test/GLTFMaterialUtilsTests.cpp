@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFMaterialUtils.h"
+
+#include "GLTFSDK/ExtensionsKHR.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(GLTFMaterialUtilsTests)
+    {
+        static Material CreateMaterial(const std::string& id, const std::string& textureId)
+        {
+            Material material;
+            material.id = id;
+            material.name = "material";
+            material.metallicRoughness.baseColorFactor = { 0.5f, 0.5f, 0.5f, 1.0f };
+            material.metallicRoughness.baseColorTexture.textureId = textureId;
+            return material;
+        }
+
+        TEST_METHOD(GLTFMaterialUtilsTests_AreEquivalent)
+        {
+            // Ids and texture ids are ignored
+            auto material = CreateMaterial("0", "0");
+            auto other = CreateMaterial("5", "7");
+            Assert::IsTrue(GLTFMaterialUtils::AreEquivalent(material, other));
+            Assert::IsTrue(MaterialSignatureHash()(MaterialSignature(material)) == MaterialSignatureHash()(MaterialSignature(other)));
+
+            // -0 and +0 compare equal, so they also hash equally
+            material.metallicRoughness.metallicFactor = -0.0f;
+            other.metallicRoughness.metallicFactor = 0.0f;
+            Assert::IsTrue(MaterialSignature(material) == MaterialSignature(other));
+
+            other.doubleSided = !material.doubleSided;
+            Assert::IsFalse(GLTFMaterialUtils::AreEquivalent(material, other));
+
+            other = CreateMaterial("1", "0");
+            other.alphaCutoff = 0.25f;
+            Assert::IsFalse(GLTFMaterialUtils::AreEquivalent(material, other));
+
+            // The specular-glossiness factors are compared when both materials have the extension
+            KHR::Materials::PBRSpecularGlossiness specularGlossiness;
+            other = CreateMaterial("1", "0");
+            other.SetExtension(std::make_unique<KHR::Materials::PBRSpecularGlossiness>(specularGlossiness));
+            Assert::IsFalse(GLTFMaterialUtils::AreEquivalent(material, other));
+
+            material.SetExtension(std::make_unique<KHR::Materials::PBRSpecularGlossiness>(specularGlossiness));
+            Assert::IsTrue(GLTFMaterialUtils::AreEquivalent(material, other));
+
+            specularGlossiness.glossinessFactor = 0.5f;
+            other.SetExtension(std::make_unique<KHR::Materials::PBRSpecularGlossiness>(specularGlossiness));
+            Assert::IsFalse(GLTFMaterialUtils::AreEquivalent(material, other));
+        }
+
+        TEST_METHOD(GLTFMaterialUtilsTests_IndexMaterials)
+        {
+            Document doc;
+            doc.materials.Append(CreateMaterial("a", "0"));
+            doc.materials.Append(CreateMaterial("b", "1"));
+
+            auto red = CreateMaterial("c", "0");
+            red.metallicRoughness.baseColorFactor = { 1.0f, 0.0f, 0.0f, 1.0f };
+            doc.materials.Append(std::move(red));
+
+            // The first of the equivalent materials is indexed
+            auto index = GLTFMaterialUtils::IndexMaterials(doc);
+            Assert::AreEqual(static_cast<size_t>(2), index.size());
+            Assert::AreEqual(std::string("a"), index.at(MaterialSignature(CreateMaterial("x", "9"))));
+
+            red = CreateMaterial("y", "");
+            red.metallicRoughness.baseColorFactor = { 1.0f, 0.0f, 0.0f, 1.0f };
+            Assert::AreEqual(std::string("c"), index.at(MaterialSignature(red)));
+        }
+    };
+}
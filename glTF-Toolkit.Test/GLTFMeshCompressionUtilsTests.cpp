@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFSDK/RapidJsonUtils.h"
+
+#include "GLTFMeshCompressionUtils.h"
+#include "GLTFMeshQuantizationUtils.h"
+#include "MeshoptCodec.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(GLTFMeshCompressionUtilsTests)
+    {
+        // An indexed quad with float positions and normals
+        static Document CreateQuad(std::shared_ptr<InMemoryStreamReader>& streamReader, const std::vector<float>& positions, const std::vector<float>& normals, const std::vector<uint16_t>& indices)
+        {
+            InMemoryDocumentBuilder builder("quad.bin");
+
+            MeshPrimitive primitive;
+            primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT, ARRAY_BUFFER);
+            primitive.attributes[ACCESSOR_NORMAL] = builder.AddAccessor(normals, TYPE_VEC3, COMPONENT_FLOAT, ARRAY_BUFFER);
+            primitive.indicesAccessorId = builder.AddAccessor(indices, TYPE_SCALAR, COMPONENT_UNSIGNED_SHORT, ELEMENT_ARRAY_BUFFER);
+
+            streamReader = std::make_shared<InMemoryStreamReader>();
+            auto doc = builder.Build(*streamReader);
+
+            Mesh mesh;
+            mesh.id = "0";
+            mesh.primitives.push_back(std::move(primitive));
+            doc.meshes.Append(std::move(mesh));
+
+            Node node;
+            node.id = "0";
+            node.meshId = "0";
+            doc.nodes.Append(std::move(node));
+
+            return doc;
+        }
+
+        // Decodes the EXT_meshopt_compression data of a bufferView, without its filter
+        static std::vector<uint8_t> DecodeBufferView(const Document& doc, const BufferView& bufferView)
+        {
+            auto extension = RapidJsonUtils::CreateDocumentFromString(bufferView.extensions.at(EXTENSION_EXT_MESHOPT_COMPRESSION));
+            const auto& buffer = doc.buffers.Get(extension["buffer"].GetUint());
+            auto byteOffset = extension["byteOffset"].GetUint();
+            auto byteLength = extension["byteLength"].GetUint();
+            auto byteStride = extension["byteStride"].GetUint();
+            auto count = extension["count"].GetUint();
+
+            std::ifstream stream(std::experimental::filesystem::u8path(buffer.uri), std::ios::binary);
+            std::vector<uint8_t> encoded(byteLength);
+            stream.seekg(byteOffset);
+            stream.read(reinterpret_cast<char*>(encoded.data()), byteLength);
+
+            std::vector<uint8_t> decoded(count * byteStride);
+            if (std::string(extension["mode"].GetString()) == "INDICES")
+            {
+                MeshoptCodec::DecodeIndexSequence(decoded.data(), count, byteStride, encoded.data(), encoded.size());
+            }
+            else
+            {
+                MeshoptCodec::DecodeVertexBuffer(decoded.data(), count, byteStride, encoded.data(), encoded.size());
+            }
+            return decoded;
+        }
+
+        TEST_METHOD(GLTFMeshCompressionUtilsTests_CompressMeshesMeshopt)
+        {
+            try
+            {
+                std::vector<float> positions = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+                std::vector<float> normals = { 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1 };
+                std::vector<uint16_t> indices = { 0, 1, 2, 2, 1, 3 };
+
+                std::shared_ptr<InMemoryStreamReader> streamReader;
+                auto doc = CreateQuad(streamReader, positions, normals, indices);
+
+                MeshoptCompressionOptions options;
+                auto compressedDoc = GLTFMeshCompressionUtils::CompressMeshesMeshopt(streamReader, doc, options, TestUtils::CreateOutputDirectory("GLTFMeshCompressionUtilsTests").u8string());
+
+                Assert::IsTrue(compressedDoc.extensionsUsed.count(EXTENSION_EXT_MESHOPT_COMPRESSION) > 0);
+                Assert::IsTrue(compressedDoc.extensionsRequired.count(EXTENSION_EXT_MESHOPT_COMPRESSION) > 0);
+                Assert::IsTrue(compressedDoc.extensionsRequired.count(EXTENSION_KHR_MESH_QUANTIZATION) > 0);
+
+                // Accessors keep their ids; the original bufferViews are replaced by ones on the fallback buffer
+                const auto& positionAccessor = compressedDoc.accessors.Get("0");
+                const auto& normalAccessor = compressedDoc.accessors.Get("1");
+                const auto& indexAccessor = compressedDoc.accessors.Get("2");
+                Assert::IsTrue(positionAccessor.componentType == COMPONENT_FLOAT);
+                Assert::IsTrue(normalAccessor.componentType == COMPONENT_SHORT && normalAccessor.normalized);
+                Assert::IsTrue(indexAccessor.componentType == COMPONENT_UNSIGNED_SHORT);
+                Assert::AreEqual(static_cast<size_t>(3), compressedDoc.bufferViews.Size());
+                Assert::AreEqual(static_cast<size_t>(3), compressedDoc.buffers.Size());
+
+                const auto& fallbackBuffer = compressedDoc.buffers.Get(compressedDoc.bufferViews.Get(positionAccessor.bufferViewId).bufferId);
+                Assert::IsTrue(fallbackBuffer.uri.empty());
+                Assert::IsTrue(fallbackBuffer.extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) > 0);
+
+                // Indices are lossless
+                auto decodedIndices = DecodeBufferView(compressedDoc, compressedDoc.bufferViews.Get(indexAccessor.bufferViewId));
+                Assert::IsTrue(std::equal(indices.begin(), indices.end(), reinterpret_cast<const uint16_t*>(decodedIndices.data())));
+
+                // Positions on a unit grid survive the exponential filter exactly
+                auto decodedPositions = DecodeBufferView(compressedDoc, compressedDoc.bufferViews.Get(positionAccessor.bufferViewId));
+                MeshoptCodec::DecodeFilter(MeshoptFilter::Exponential, decodedPositions.data(), 4, 12);
+                Assert::IsTrue(std::equal(positions.begin(), positions.end(), reinterpret_cast<const float*>(decodedPositions.data())));
+                Assert::AreEqual(1.0f, positionAccessor.max[0]);
+
+                auto decodedNormals = DecodeBufferView(compressedDoc, compressedDoc.bufferViews.Get(normalAccessor.bufferViewId));
+                MeshoptCodec::DecodeFilter(MeshoptFilter::Octahedral, decodedNormals.data(), 4, 8);
+                Assert::AreEqual(static_cast<int16_t>(32767), reinterpret_cast<const int16_t*>(decodedNormals.data())[2]);
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLTFMeshCompressionUtilsTests_CompressMeshesMeshopt_Lossless)
+        {
+            try
+            {
+                std::vector<float> positions = { 0.1f, 0.2f, 0.3f, 1.1f, 0, 0, 0, 1.7f, 0, 1, 1, 0 };
+                std::vector<float> normals = { 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1 };
+                std::vector<uint16_t> indices = { 0, 1, 2, 2, 1, 3 };
+
+                std::shared_ptr<InMemoryStreamReader> streamReader;
+                auto doc = CreateQuad(streamReader, positions, normals, indices);
+
+                // 0 disables the filters, and the data is compressed without loss
+                MeshoptCompressionOptions options;
+                options.PositionQuantizationBits = 0;
+                options.NormalQuantizationBits = 0;
+                auto compressedDoc = GLTFMeshCompressionUtils::CompressMeshesMeshopt(streamReader, doc, options, TestUtils::CreateOutputDirectory("GLTFMeshCompressionUtilsTests").u8string());
+
+                Assert::IsTrue(compressedDoc.extensionsRequired.count(EXTENSION_KHR_MESH_QUANTIZATION) == 0);
+                Assert::IsTrue(compressedDoc.accessors.Get("1").componentType == COMPONENT_FLOAT);
+
+                const auto& positionBufferView = compressedDoc.bufferViews.Get(compressedDoc.accessors.Get("0").bufferViewId);
+                Assert::IsTrue(positionBufferView.extensions.at(EXTENSION_EXT_MESHOPT_COMPRESSION).find("filter") == std::string::npos);
+
+                auto decodedPositions = DecodeBufferView(compressedDoc, positionBufferView);
+                Assert::IsTrue(std::equal(positions.begin(), positions.end(), reinterpret_cast<const float*>(decodedPositions.data())));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
@@ -0,0 +1,180 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFMeshIndexUtils.h"
+#include "MemoryMappedStreamReader.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(GLTFMeshIndexUtilsTests)
+    {
+        // A single triangle list primitive with one position per vertex and 32-bit indices
+        static Document CreateTriangles(std::shared_ptr<InMemoryStreamReader>& streamReader, const std::vector<float>& positions, const std::vector<uint32_t>& indices)
+        {
+            InMemoryDocumentBuilder builder("triangles.bin");
+
+            MeshPrimitive primitive;
+            primitive.materialId = "0";
+            primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT);
+            primitive.indicesAccessorId = builder.AddAccessor(indices, TYPE_SCALAR, COMPONENT_UNSIGNED_INT);
+
+            streamReader = std::make_shared<InMemoryStreamReader>();
+            auto doc = builder.Build(*streamReader);
+
+            Material material;
+            material.id = "0";
+            doc.materials.Append(std::move(material));
+
+            Mesh mesh;
+            mesh.id = "0";
+            mesh.primitives.push_back(std::move(primitive));
+            doc.meshes.Append(std::move(mesh));
+
+            return doc;
+        }
+
+        TEST_METHOD(GLTFMeshIndexUtilsTests_SplitIndices)
+        {
+            // A strip of 4 triangles over 6 vertices, in parts of at most 4 vertices
+            std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5 };
+            auto splits = GLTFMeshIndexUtils::SplitIndices(indices, 3, 4);
+
+            Assert::AreEqual(static_cast<size_t>(2), splits.size());
+            Assert::IsTrue(splits[0].Indices == std::vector<uint32_t>{ 0, 1, 2, 2, 1, 3 });
+            Assert::IsTrue(splits[0].Vertices == std::vector<uint32_t>{ 0, 1, 2, 3 });
+            Assert::IsTrue(splits[1].Indices == std::vector<uint32_t>{ 0, 1, 2, 2, 1, 3 });
+            Assert::IsTrue(splits[1].Vertices == std::vector<uint32_t>{ 2, 3, 4, 5 });
+
+            // Everything fits in one part, which is numbered in the order of first use
+            splits = GLTFMeshIndexUtils::SplitIndices({ 5, 3, 5, 3 }, 2);
+            Assert::AreEqual(static_cast<size_t>(1), splits.size());
+            Assert::IsTrue(splits[0].Indices == std::vector<uint32_t>{ 0, 1, 0, 1 });
+            Assert::IsTrue(splits[0].Vertices == std::vector<uint32_t>{ 5, 3 });
+        }
+
+        TEST_METHOD(GLTFMeshIndexUtilsTests_SplitIndices_DegenerateTriangles)
+        {
+            // The repeated vertex of a degenerate triangle is only counted once
+            std::vector<uint32_t> indices = { 0, 1, 2, 3, 3, 0 };
+            auto splits = GLTFMeshIndexUtils::SplitIndices(indices, 3, 4);
+
+            Assert::AreEqual(static_cast<size_t>(1), splits.size());
+            Assert::IsTrue(splits[0].Indices == std::vector<uint32_t>{ 0, 1, 2, 3, 3, 0 });
+
+            Assert::ExpectException<std::invalid_argument>([]()
+            {
+                GLTFMeshIndexUtils::SplitIndices({ 0, 1, 2, 3 }, 3);
+            });
+        }
+
+        TEST_METHOD(GLTFMeshIndexUtilsTests_Use16BitIndices_Narrow)
+        {
+            try
+            {
+                std::vector<float> positions = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+                std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+
+                std::shared_ptr<InMemoryStreamReader> streamReader;
+                auto doc = CreateTriangles(streamReader, positions, indices);
+
+                auto outputDirectory = TestUtils::CreateOutputDirectory("GLTFMeshIndexUtilsTests");
+                auto resultDoc = GLTFMeshIndexUtils::Use16BitIndices(streamReader, doc, outputDirectory.u8string());
+
+                // The index accessor keeps its id, and the positions are untouched
+                const auto& indexAccessor = resultDoc.accessors.Get("1");
+                Assert::IsTrue(indexAccessor.componentType == COMPONENT_UNSIGNED_SHORT);
+                Assert::AreEqual(static_cast<size_t>(1), resultDoc.meshes.Get("0").primitives.size());
+                Assert::AreEqual(std::string("0"), resultDoc.accessors.Get("0").bufferViewId);
+                Assert::IsFalse(resultDoc.bufferViews.Has("1"));
+
+                GLTFResourceReader reader(std::make_shared<MemoryMappedStreamReader>(outputDirectory));
+                auto resultIndices = reader.ReadBinaryData<uint16_t>(resultDoc, indexAccessor);
+                Assert::IsTrue(std::equal(indices.begin(), indices.end(), resultIndices.begin(), resultIndices.end()));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLTFMeshIndexUtilsTests_Use16BitIndices_Split)
+        {
+            try
+            {
+                // A list of triangles over 70000 vertices, each triangle adding one vertex
+                const size_t vertexCount = 70000;
+                std::vector<float> positions;
+                for (size_t i = 0; i < vertexCount; i++)
+                {
+                    positions.insert(positions.end(), { static_cast<float>(i), static_cast<float>(i % 2), 0.0f });
+                }
+
+                std::vector<uint32_t> indices;
+                for (uint32_t i = 0; i + 2 < vertexCount; i++)
+                {
+                    indices.insert(indices.end(), { i, i + 1, i + 2 });
+                }
+
+                std::shared_ptr<InMemoryStreamReader> streamReader;
+                auto doc = CreateTriangles(streamReader, positions, indices);
+
+                auto outputDirectory = TestUtils::CreateOutputDirectory("GLTFMeshIndexUtilsTests");
+                auto resultDoc = GLTFMeshIndexUtils::Use16BitIndices(streamReader, doc, outputDirectory.u8string());
+
+                // The original accessors are replaced by the ones of the two parts
+                const auto& primitives = resultDoc.meshes.Get("0").primitives;
+                Assert::AreEqual(static_cast<size_t>(2), primitives.size());
+                Assert::IsFalse(resultDoc.accessors.Has("0"));
+                Assert::IsFalse(resultDoc.accessors.Has("1"));
+                Assert::AreEqual(static_cast<size_t>(4), resultDoc.accessors.Size());
+
+                GLTFResourceReader reader(std::make_shared<MemoryMappedStreamReader>(outputDirectory));
+                std::vector<float> resultPositions;
+                for (const auto& primitive : primitives)
+                {
+                    Assert::AreEqual(std::string("0"), primitive.materialId);
+
+                    const auto& indexAccessor = resultDoc.accessors.Get(primitive.indicesAccessorId);
+                    const auto& positionAccessor = resultDoc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+                    Assert::IsTrue(indexAccessor.componentType == COMPONENT_UNSIGNED_SHORT);
+                    Assert::IsTrue(positionAccessor.count <= MAX_16BIT_INDEX_VERTEX_COUNT);
+                    Assert::AreEqual(static_cast<size_t>(3), positionAccessor.min.size());
+
+                    // Every triangle keeps its vertices, in order
+                    auto partIndices = reader.ReadBinaryData<uint16_t>(resultDoc, indexAccessor);
+                    auto partPositions = reader.ReadBinaryData<float>(resultDoc, positionAccessor);
+                    for (auto index : partIndices)
+                    {
+                        resultPositions.insert(resultPositions.end(), partPositions.begin() + index * 3, partPositions.begin() + index * 3 + 3);
+                    }
+                }
+
+                Assert::AreEqual(indices.size() * 3, resultPositions.size());
+                for (size_t i = 0; i < indices.size(); i++)
+                {
+                    Assert::AreEqual(positions[indices[i] * 3], resultPositions[i * 3]);
+                    Assert::AreEqual(positions[indices[i] * 3 + 1], resultPositions[i * 3 + 1]);
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
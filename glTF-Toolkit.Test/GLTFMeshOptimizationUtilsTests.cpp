@@ -0,0 +1,227 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+#include <array>
+
+#include "GLTFMeshOptimizationUtils.h"
+#include "MemoryMappedStreamReader.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(GLTFMeshOptimizationUtilsTests)
+    {
+        static uint32_t NextRandom(uint32_t& state)
+        {
+            state = state * 1664525u + 1013904223u;
+            return state;
+        }
+
+        // A grid of size x size vertices in the XY plane, with its triangles in random order
+        static void CreateGrid(size_t size, std::vector<float>& positions, std::vector<uint32_t>& indices)
+        {
+            positions.clear();
+            for (size_t y = 0; y < size; y++)
+            {
+                for (size_t x = 0; x < size; x++)
+                {
+                    positions.insert(positions.end(), { static_cast<float>(x), static_cast<float>(y), 0.0f });
+                }
+            }
+
+            std::vector<std::array<uint32_t, 3>> triangles;
+            for (uint32_t y = 0; y + 1 < size; y++)
+            {
+                for (uint32_t x = 0; x + 1 < size; x++)
+                {
+                    uint32_t corner = static_cast<uint32_t>(y * size + x);
+                    triangles.push_back({ corner, corner + 1, static_cast<uint32_t>(corner + size) });
+                    triangles.push_back({ static_cast<uint32_t>(corner + size), corner + 1, static_cast<uint32_t>(corner + size + 1) });
+                }
+            }
+
+            uint32_t randomState = 1;
+            for (size_t i = triangles.size() - 1; i > 0; i--)
+            {
+                std::swap(triangles[i], triangles[NextRandom(randomState) % (i + 1)]);
+            }
+
+            indices.clear();
+            for (const auto& triangle : triangles)
+            {
+                indices.insert(indices.end(), triangle.begin(), triangle.end());
+            }
+        }
+
+        // The triangles of a triangle list as sorted vertex positions, in sorted order, to compare lists regardless of order and numbering
+        static std::vector<std::vector<float>> GetTriangles(const std::vector<uint32_t>& indices, const std::vector<float>& positions)
+        {
+            std::vector<std::vector<float>> triangles;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                std::vector<std::array<float, 3>> vertices;
+                for (size_t j = 0; j < 3; j++)
+                {
+                    vertices.push_back({ positions[indices[i + j] * 3], positions[indices[i + j] * 3 + 1], positions[indices[i + j] * 3 + 2] });
+                }
+                std::sort(vertices.begin(), vertices.end());
+
+                std::vector<float> triangle;
+                for (const auto& vertex : vertices)
+                {
+                    triangle.insert(triangle.end(), vertex.begin(), vertex.end());
+                }
+                triangles.push_back(std::move(triangle));
+            }
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        }
+
+        TEST_METHOD(GLTFMeshOptimizationUtilsTests_AnalyzeVertexCache)
+        {
+            // Two triangles that share an edge transform 4 vertices
+            std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+            auto statistics = GLTFMeshOptimizationUtils::AnalyzeVertexCache(indices, 4, 16);
+            Assert::AreEqual(static_cast<size_t>(2), statistics.TriangleCount);
+            Assert::AreEqual(static_cast<size_t>(4), statistics.VertexCount);
+            Assert::AreEqual(static_cast<size_t>(4), statistics.CacheMisses);
+            Assert::AreEqual(2.0, statistics.ACMR());
+            Assert::AreEqual(1.0, statistics.ATVR());
+
+            // With a 3 entry cache, vertex 0 is evicted by vertex 3
+            indices.insert(indices.end(), { 3, 1, 0 });
+            statistics = GLTFMeshOptimizationUtils::AnalyzeVertexCache(indices, 4, 3);
+            Assert::AreEqual(static_cast<size_t>(5), statistics.CacheMisses);
+
+            Assert::ExpectException<std::invalid_argument>([]()
+            {
+                GLTFMeshOptimizationUtils::AnalyzeVertexCache({ 0, 1, 4 }, 4, 16);
+            });
+        }
+
+        TEST_METHOD(GLTFMeshOptimizationUtilsTests_OptimizeVertexCache)
+        {
+            std::vector<float> positions;
+            std::vector<uint32_t> indices;
+            CreateGrid(64, positions, indices);
+            auto vertexCount = positions.size() / 3;
+
+            auto optimized = GLTFMeshOptimizationUtils::OptimizeVertexCache(indices, vertexCount, 16);
+            Assert::IsTrue(GetTriangles(indices, positions) == GetTriangles(optimized, positions));
+
+            // A random order transforms most vertices once per triangle; a regular grid can get close to 0.5
+            auto before = GLTFMeshOptimizationUtils::AnalyzeVertexCache(indices, vertexCount, 16);
+            auto after = GLTFMeshOptimizationUtils::AnalyzeVertexCache(optimized, vertexCount, 16);
+            Assert::IsTrue(before.ACMR() > 2.0);
+            Assert::IsTrue(after.ACMR() < 0.8);
+            Assert::IsTrue(after.ATVR() < 1.6);
+        }
+
+        TEST_METHOD(GLTFMeshOptimizationUtilsTests_OptimizeOverdraw)
+        {
+            std::vector<float> positions;
+            std::vector<uint32_t> indices;
+            CreateGrid(64, positions, indices);
+            auto vertexCount = positions.size() / 3;
+
+            auto cacheOptimized = GLTFMeshOptimizationUtils::OptimizeVertexCache(indices, vertexCount, 16);
+            auto optimized = GLTFMeshOptimizationUtils::OptimizeOverdraw(cacheOptimized, positions, 16, 1.05f);
+            Assert::IsTrue(GetTriangles(indices, positions) == GetTriangles(optimized, positions));
+
+            auto before = GLTFMeshOptimizationUtils::AnalyzeVertexCache(cacheOptimized, vertexCount, 16);
+            auto after = GLTFMeshOptimizationUtils::AnalyzeVertexCache(optimized, vertexCount, 16);
+            Assert::IsTrue(after.ACMR() <= before.ACMR() * 1.1);
+        }
+
+        TEST_METHOD(GLTFMeshOptimizationUtilsTests_OptimizeVertexFetch)
+        {
+            std::vector<uint32_t> indices = { 4, 2, 0, 0, 2, 5 };
+            auto remap = GLTFMeshOptimizationUtils::OptimizeVertexFetch(indices, 6);
+
+            // Unreferenced vertices 1 and 3 come last
+            Assert::IsTrue(indices == std::vector<uint32_t>{ 0, 1, 2, 2, 1, 3 });
+            Assert::IsTrue(remap == std::vector<uint32_t>{ 2, 4, 1, 5, 0, 3 });
+        }
+
+        TEST_METHOD(GLTFMeshOptimizationUtilsTests_OptimizeMeshes)
+        {
+            try
+            {
+                std::vector<float> positions;
+                std::vector<uint32_t> indices;
+                CreateGrid(32, positions, indices);
+                auto vertexCount = positions.size() / 3;
+
+                std::vector<float> texCoords;
+                for (size_t i = 0; i < vertexCount; i++)
+                {
+                    texCoords.insert(texCoords.end(), { positions[i * 3] / 32.0f, positions[i * 3 + 1] / 32.0f });
+                }
+
+                std::vector<uint16_t> indices16(indices.begin(), indices.end());
+
+                InMemoryDocumentBuilder builder("grid.bin");
+
+                MeshPrimitive primitive;
+                primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT);
+                primitive.attributes[ACCESSOR_TEXCOORD_0] = builder.AddAccessor(texCoords, TYPE_VEC2, COMPONENT_FLOAT);
+                primitive.indicesAccessorId = builder.AddAccessor(indices16, TYPE_SCALAR, COMPONENT_UNSIGNED_SHORT);
+
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                auto doc = builder.Build(*streamReader);
+
+                Mesh mesh;
+                mesh.id = "0";
+                mesh.primitives.push_back(std::move(primitive));
+                doc.meshes.Append(std::move(mesh));
+
+                auto outputDirectory = TestUtils::CreateOutputDirectory("GLTFMeshOptimizationUtilsTests");
+
+                MeshOptimizationStatistics statistics;
+                auto optimizedDoc = GLTFMeshOptimizationUtils::OptimizeMeshes(streamReader, doc, MeshOptimizationOptions(), outputDirectory.u8string(), &statistics);
+
+                Assert::AreEqual(indices.size() / 3, statistics.Before.TriangleCount);
+                Assert::AreEqual(statistics.Before.TriangleCount, statistics.After.TriangleCount);
+                Assert::IsTrue(statistics.After.ACMR() < statistics.Before.ACMR());
+
+                // Accessors keep their ids and types, and point to new bufferViews
+                const auto& positionAccessor = optimizedDoc.accessors.Get("0");
+                const auto& texCoordAccessor = optimizedDoc.accessors.Get("1");
+                const auto& indexAccessor = optimizedDoc.accessors.Get("2");
+                Assert::IsTrue(indexAccessor.componentType == COMPONENT_UNSIGNED_SHORT);
+                Assert::AreEqual(static_cast<size_t>(3), optimizedDoc.bufferViews.Size());
+                Assert::IsFalse(optimizedDoc.bufferViews.Has(doc.accessors.Get("0").bufferViewId));
+
+                // The same triangles, with vertices in the order of first use
+                GLTFResourceReader reader(std::make_shared<MemoryMappedStreamReader>(outputDirectory));
+                auto optimizedPositions = reader.ReadBinaryData<float>(optimizedDoc, positionAccessor);
+                auto optimizedTexCoords = reader.ReadBinaryData<float>(optimizedDoc, texCoordAccessor);
+                auto optimizedIndices16 = reader.ReadBinaryData<uint16_t>(optimizedDoc, indexAccessor);
+                std::vector<uint32_t> optimizedIndices(optimizedIndices16.begin(), optimizedIndices16.end());
+                Assert::IsTrue(GetTriangles(indices, positions) == GetTriangles(optimizedIndices, optimizedPositions));
+                Assert::AreEqual(0u, optimizedIndices[0]);
+
+                for (size_t i = 0; i < vertexCount; i++)
+                {
+                    Assert::AreEqual(optimizedPositions[i * 3] / 32.0f, optimizedTexCoords[i * 2]);
+                    Assert::AreEqual(optimizedPositions[i * 3 + 1] / 32.0f, optimizedTexCoords[i * 2 + 1]);
+                }
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
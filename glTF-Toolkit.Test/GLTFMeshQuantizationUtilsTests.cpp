@@ -0,0 +1,197 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFSDK/ExtensionsKHR.h"
+
+#include "GLTFMeshQuantizationUtils.h"
+#include "MemoryMappedStreamReader.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(GLTFMeshQuantizationUtilsTests)
+    {
+        // A quad with float positions, normals and texture coordinates, textured with a single material
+        static Document CreateQuad(std::shared_ptr<InMemoryStreamReader>& streamReader, const std::vector<float>& positions, const std::vector<float>& normals, const std::vector<float>& texCoords)
+        {
+            InMemoryDocumentBuilder builder("quad.bin");
+
+            MeshPrimitive primitive;
+            primitive.materialId = "0";
+            primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT, ARRAY_BUFFER);
+            primitive.attributes[ACCESSOR_NORMAL] = builder.AddAccessor(normals, TYPE_VEC3, COMPONENT_FLOAT, ARRAY_BUFFER);
+            primitive.attributes[ACCESSOR_TEXCOORD_0] = builder.AddAccessor(texCoords, TYPE_VEC2, COMPONENT_FLOAT, ARRAY_BUFFER);
+
+            streamReader = std::make_shared<InMemoryStreamReader>();
+            auto doc = builder.Build(*streamReader);
+
+            Material material;
+            material.id = "0";
+            material.metallicRoughness.baseColorTexture.textureId = "0";
+            material.metallicRoughness.baseColorTexture.texCoord = 0;
+            doc.materials.Append(std::move(material));
+
+            Mesh mesh;
+            mesh.id = "0";
+            mesh.primitives.push_back(std::move(primitive));
+            doc.meshes.Append(std::move(mesh));
+
+            Node node;
+            node.id = "0";
+            node.meshId = "0";
+            node.translation = { 1.0f, 0.0f, 0.0f };
+            doc.nodes.Append(std::move(node));
+
+            return doc;
+        }
+
+        TEST_METHOD(GLTFMeshQuantizationUtilsTests_QuantizeMeshes_FoldsTransforms)
+        {
+            try
+            {
+                std::vector<float> positions = { 2, 1, 0, 6, 1, 0, 2, 3, 0, 6, 3, 0 };
+                std::vector<float> normals = { 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1 };
+                std::vector<float> texCoords = { 0.25f, 0.25f, 0.75f, 0.25f, 0.25f, 0.75f, 0.75f, 0.75f };
+
+                std::shared_ptr<InMemoryStreamReader> streamReader;
+                auto doc = CreateQuad(streamReader, positions, normals, texCoords);
+                auto outputDirectory = TestUtils::CreateOutputDirectory("GLTFMeshQuantizationUtilsTests").u8string();
+
+                QuantizationOptions options;
+                auto quantizedDoc = GLTFMeshQuantizationUtils::QuantizeMeshes(streamReader, doc, options, outputDirectory);
+
+                Assert::IsTrue(quantizedDoc.extensionsRequired.count(EXTENSION_KHR_MESH_QUANTIZATION) > 0);
+                Assert::IsTrue(quantizedDoc.extensionsRequired.count(KHR::TextureInfos::TEXTURETRANSFORM_NAME) > 0);
+
+                // Accessors keep their ids; the original bufferViews are replaced
+                const auto& positionAccessor = quantizedDoc.accessors.Get("0");
+                const auto& normalAccessor = quantizedDoc.accessors.Get("1");
+                const auto& texCoordAccessor = quantizedDoc.accessors.Get("2");
+                Assert::IsTrue(positionAccessor.componentType == COMPONENT_SHORT && positionAccessor.normalized);
+                Assert::IsTrue(normalAccessor.componentType == COMPONENT_BYTE && normalAccessor.normalized);
+                Assert::IsTrue(texCoordAccessor.componentType == COMPONENT_UNSIGNED_SHORT && texCoordAccessor.normalized);
+                Assert::AreEqual(static_cast<size_t>(3), quantizedDoc.bufferViews.Size());
+                Assert::IsFalse(quantizedDoc.bufferViews.Has(doc.accessors.Get("0").bufferViewId));
+
+                // Vertex attribute elements are padded to 4 bytes
+                const auto& positionBufferView = quantizedDoc.bufferViews.Get(positionAccessor.bufferViewId);
+                Assert::IsTrue(positionBufferView.byteStride.HasValue());
+                Assert::AreEqual(static_cast<size_t>(8), positionBufferView.byteStride.Get());
+
+                // The bounding box is centered on (4, 2, 0) with a half-extent of 2
+                const auto& node = quantizedDoc.nodes.Get("0");
+                Assert::AreEqual(5.0f, node.translation.x);
+                Assert::AreEqual(2.0f, node.translation.y);
+                Assert::AreEqual(0.0f, node.translation.z);
+                Assert::AreEqual(2.0f, node.scale.x);
+                Assert::AreEqual(2.0f, node.scale.z);
+
+                // Dequantized positions stay within the maximum error
+                GLTFResourceReader reader(std::make_shared<MemoryMappedStreamReader>(outputDirectory));
+                auto quantizedPositions = reader.ReadBinaryData<int16_t>(quantizedDoc, positionAccessor);
+                Assert::AreEqual(positions.size(), quantizedPositions.size());
+                for (size_t i = 0; i < positions.size(); i++)
+                {
+                    float center[] = { 4.0f, 2.0f, 0.0f };
+                    float position = center[i % 3] + 2.0f * quantizedPositions[i] / 32767.0f;
+                    Assert::IsTrue(std::abs(position - positions[i]) <= 4.0f * options.PositionMaxError);
+                }
+
+                // Texture coordinates span the whole range, and the texture transform maps them back
+                const auto& material = quantizedDoc.materials.Get("0");
+                Assert::IsTrue(material.metallicRoughness.baseColorTexture.HasExtension<KHR::TextureInfos::TextureTransform>());
+                const auto& transform = material.metallicRoughness.baseColorTexture.GetExtension<KHR::TextureInfos::TextureTransform>();
+                Assert::AreEqual(0.25f, transform.offset.x);
+                Assert::AreEqual(0.25f, transform.offset.y);
+                Assert::AreEqual(0.5f, transform.scale.x);
+                Assert::AreEqual(0.5f, transform.scale.y);
+
+                auto quantizedTexCoords = reader.ReadBinaryData<uint16_t>(quantizedDoc, texCoordAccessor);
+                Assert::AreEqual(static_cast<uint16_t>(0), quantizedTexCoords[0]);
+                Assert::AreEqual(static_cast<uint16_t>(65535), quantizedTexCoords[7]);
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLTFMeshQuantizationUtilsTests_QuantizeMeshes_RespectsErrorBounds)
+        {
+            try
+            {
+                std::vector<float> positions = { 2, 1, 0, 6, 1, 0, 2, 3, 0, 6, 3, 0 };
+                std::vector<float> normals = { 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1 };
+                std::vector<float> texCoords = { 0.25f, 0.25f, 0.75f, 0.25f, 0.25f, 0.75f, 0.75f, 0.75f };
+
+                std::shared_ptr<InMemoryStreamReader> streamReader;
+                auto doc = CreateQuad(streamReader, positions, normals, texCoords);
+
+                // Looser bounds allow 8-bit positions; tighter ones keep normals as floats; 0 disables quantization
+                QuantizationOptions options;
+                options.PositionMaxError = 1.0f / 256.0f;
+                options.NormalMaxError = 1.0f / 100000.0f;
+                options.TexCoordMaxError = 0.0f;
+                auto quantizedDoc = GLTFMeshQuantizationUtils::QuantizeMeshes(streamReader, doc, options, TestUtils::CreateOutputDirectory("GLTFMeshQuantizationUtilsTests").u8string());
+
+                Assert::IsTrue(quantizedDoc.accessors.Get("0").componentType == COMPONENT_BYTE);
+                Assert::IsTrue(quantizedDoc.accessors.Get("1") == doc.accessors.Get("1"));
+                Assert::IsTrue(quantizedDoc.accessors.Get("2") == doc.accessors.Get("2"));
+                Assert::IsTrue(quantizedDoc.extensionsRequired.count(KHR::TextureInfos::TEXTURETRANSFORM_NAME) == 0);
+                Assert::IsFalse(quantizedDoc.materials.Get("0").metallicRoughness.baseColorTexture.HasExtension<KHR::TextureInfos::TextureTransform>());
+
+                // Nodes with children keep their transform, and get a child node for the mesh
+                Node child;
+                child.id = "1";
+                doc.nodes.Append(std::move(child));
+                Node parent(doc.nodes.Get("0"));
+                parent.children.push_back("1");
+                doc.nodes.Replace(parent);
+
+                quantizedDoc = GLTFMeshQuantizationUtils::QuantizeMeshes(streamReader, doc, options, TestUtils::CreateOutputDirectory("GLTFMeshQuantizationUtilsTests").u8string());
+                Assert::AreEqual(static_cast<size_t>(3), quantizedDoc.nodes.Size());
+                Assert::IsTrue(quantizedDoc.nodes.Get("0").meshId.empty());
+                Assert::AreEqual(1.0f, quantizedDoc.nodes.Get("0").translation.x);
+                Assert::IsTrue(quantizedDoc.nodes.Get("2").meshId == "0");
+                Assert::AreEqual(4.0f, quantizedDoc.nodes.Get("2").translation.x);
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(GLTFMeshQuantizationUtilsTests_PreserveQuantizedAccessors)
+        {
+            auto strategy = GLTFMeshQuantizationUtils::PreserveQuantizedAccessors([](const Accessor&) { return COMPONENT_FLOAT; });
+
+            Accessor quantized;
+            quantized.type = TYPE_VEC3;
+            quantized.componentType = COMPONENT_SHORT;
+            quantized.normalized = true;
+            Assert::IsTrue(strategy(quantized) == COMPONENT_SHORT);
+
+            Accessor notNormalized(quantized);
+            notNormalized.normalized = false;
+            Assert::IsTrue(strategy(notNormalized) == COMPONENT_FLOAT);
+
+            Accessor scalar(quantized);
+            scalar.type = TYPE_SCALAR;
+            Assert::IsTrue(strategy(scalar) == COMPONENT_FLOAT);
+        }
+    };
+}
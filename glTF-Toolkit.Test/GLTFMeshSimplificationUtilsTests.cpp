@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFMeshSimplificationUtils.h"
+#include "MemoryMappedStreamReader.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(GLTFMeshSimplificationUtilsTests)
+    {
+        // A square grid of size x size vertices in the XY plane, whose heights are given by a function of the column and row
+        template<typename Height>
+        static void CreateGrid(size_t size, Height height, std::vector<float>& positions, std::vector<uint32_t>& indices)
+        {
+            for (size_t y = 0; y < size; y++)
+            {
+                for (size_t x = 0; x < size; x++)
+                {
+                    positions.insert(positions.end(), { static_cast<float>(x), static_cast<float>(y), height(x, y) });
+                }
+            }
+
+            for (uint32_t y = 0; y + 1 < size; y++)
+            {
+                for (uint32_t x = 0; x + 1 < size; x++)
+                {
+                    uint32_t i = static_cast<uint32_t>(y * size + x);
+                    indices.insert(indices.end(), { i, i + 1, i + static_cast<uint32_t>(size), i + static_cast<uint32_t>(size), i + 1, i + static_cast<uint32_t>(size) + 1 });
+                }
+            }
+        }
+
+        TEST_METHOD(GLTFMeshSimplificationUtilsTests_SimplifyIndices_Plane)
+        {
+            std::vector<float> positions;
+            std::vector<uint32_t> indices;
+            CreateGrid(10, [](size_t, size_t) { return 0.0f; }, positions, indices);
+
+            // A flat grid collapses to its corners without any error
+            float error = 1.0f;
+            auto result = GLTFMeshSimplificationUtils::SimplifyIndices(indices, positions, {}, {}, 0, 0.0f, &error);
+
+            Assert::AreEqual(static_cast<size_t>(6), result.size());
+            Assert::AreEqual(0.0f, error);
+            for (auto index : result)
+            {
+                Assert::IsTrue(index == 0 || index == 9 || index == 90 || index == 99);
+            }
+        }
+
+        TEST_METHOD(GLTFMeshSimplificationUtilsTests_SimplifyIndices_TargetError)
+        {
+            std::vector<float> positions;
+            std::vector<uint32_t> indices;
+            CreateGrid(9, [](size_t x, size_t) { return x == 4 ? 2.0f : 0.0f; }, positions, indices);
+
+            // A ridge along the middle column can't be flattened within the target error, so its vertices are kept
+            float error = 1.0f;
+            auto result = GLTFMeshSimplificationUtils::SimplifyIndices(indices, positions, {}, {}, 0, 0.001f, &error);
+
+            Assert::IsTrue(result.size() < indices.size());
+            Assert::IsTrue(error <= 0.001f);
+
+            std::unordered_set<uint32_t> ridgeVertices;
+            for (auto index : result)
+            {
+                if (index % 9 == 4)
+                {
+                    ridgeVertices.insert(index);
+                }
+            }
+            Assert::IsTrue(ridgeVertices.count(4) == 1 && ridgeVertices.count(76) == 1);
+
+            // A target index count stops simplification first
+            result = GLTFMeshSimplificationUtils::SimplifyIndices(indices, positions, {}, {}, indices.size() / 2, 1.0f);
+            Assert::IsTrue(result.size() <= indices.size() / 2);
+            Assert::IsTrue(result.size() >= indices.size() / 4);
+        }
+
+        TEST_METHOD(GLTFMeshSimplificationUtilsTests_SimplifyIndices_Seam)
+        {
+            // Two halves of a flat grid with their own copies of the vertices of the middle column, as if they had different texture coordinates
+            const size_t size = 9;
+            std::vector<float> positions;
+            std::vector<uint32_t> indices;
+            CreateGrid(size, [](size_t, size_t) { return 0.0f; }, positions, indices);
+
+            auto vertexCount = static_cast<uint32_t>(positions.size() / 3);
+            std::vector<float> texCoords(vertexCount * 2, 0.0f);
+            for (uint32_t y = 0; y < size; y++)
+            {
+                uint32_t seamVertex = y * size + 4;
+                positions.insert(positions.end(), positions.begin() + seamVertex * 3, positions.begin() + seamVertex * 3 + 3);
+                texCoords.insert(texCoords.end(), { 1.0f, 1.0f });
+            }
+
+            // The right half uses the copies
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                bool isRight = indices[i] % size > 4 || indices[i + 1] % size > 4 || indices[i + 2] % size > 4;
+                for (size_t j = 0; isRight && j < 3; j++)
+                {
+                    if (indices[i + j] % size == 4)
+                    {
+                        indices[i + j] = vertexCount + indices[i + j] / size;
+                    }
+                }
+            }
+
+            auto result = GLTFMeshSimplificationUtils::SimplifyIndices(indices, positions, texCoords, { 1.0f, 1.0f }, 0, 0.0f);
+            Assert::IsTrue(result.size() < indices.size());
+
+            // The halves still meet along the seam, and each one keeps its texture coordinates
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                bool isRight = false;
+                bool isLeft = false;
+                for (size_t j = 0; j < 3; j++)
+                {
+                    auto x = positions[result[i + j] * 3];
+                    isRight = isRight || x > 4.0f || (x == 4.0f && result[i + j] >= vertexCount);
+                    isLeft = isLeft || x < 4.0f || (x == 4.0f && result[i + j] < vertexCount);
+                }
+                Assert::IsTrue(isLeft != isRight);
+            }
+
+            // The seam is straight, so it collapses to its ends
+            std::unordered_set<uint32_t> seamVertices;
+            for (auto index : result)
+            {
+                if (positions[index * 3] == 4.0f)
+                {
+                    seamVertices.insert(index);
+                }
+            }
+            Assert::AreEqual(static_cast<size_t>(4), seamVertices.size());
+        }
+
+        TEST_METHOD(GLTFMeshSimplificationUtilsTests_SimplifyMeshes)
+        {
+            try
+            {
+                std::vector<float> positions;
+                std::vector<uint32_t> indices;
+                CreateGrid(10, [](size_t x, size_t y) { return static_cast<float>((x * y) % 3) * 0.01f; }, positions, indices);
+
+                InMemoryDocumentBuilder builder("grid.bin");
+
+                MeshPrimitive primitive;
+                primitive.attributes[ACCESSOR_POSITION] = builder.AddAccessor(positions, TYPE_VEC3, COMPONENT_FLOAT);
+                primitive.indicesAccessorId = builder.AddAccessor(indices, TYPE_SCALAR, COMPONENT_UNSIGNED_INT);
+
+                auto streamReader = std::make_shared<InMemoryStreamReader>();
+                auto doc = builder.Build(*streamReader);
+
+                Mesh mesh;
+                mesh.id = "0";
+                mesh.primitives.push_back(std::move(primitive));
+                doc.meshes.Append(std::move(mesh));
+
+                SimplificationOptions options;
+                options.TargetRatio = 0.25f;
+                options.TargetError = 0.05f;
+
+                SimplificationStatistics statistics;
+                auto outputDirectory = TestUtils::CreateOutputDirectory("GLTFMeshSimplificationUtilsTests");
+                auto resultDoc = GLTFMeshSimplificationUtils::SimplifyMeshes(streamReader, doc, options, outputDirectory.u8string(), &statistics);
+
+                Assert::AreEqual(indices.size() / 3, statistics.TrianglesBefore);
+                Assert::IsTrue(statistics.TrianglesAfter <= statistics.TrianglesBefore / 4);
+                Assert::IsTrue(statistics.MaxError <= options.TargetError);
+
+                // The original accessors are replaced by compacted ones, with 16-bit indices
+                Assert::IsFalse(resultDoc.accessors.Has("0"));
+                Assert::IsFalse(resultDoc.accessors.Has("1"));
+                Assert::IsFalse(resultDoc.bufferViews.Has("0"));
+
+                const auto& resultPrimitive = resultDoc.meshes.Get("0").primitives[0];
+                const auto& resultIndexAccessor = resultDoc.accessors.Get(resultPrimitive.indicesAccessorId);
+                const auto& resultPositionAccessor = resultDoc.accessors.Get(resultPrimitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+                Assert::IsTrue(resultIndexAccessor.componentType == COMPONENT_UNSIGNED_SHORT);
+                Assert::AreEqual(statistics.TrianglesAfter * 3, resultIndexAccessor.count);
+                Assert::IsTrue(resultPositionAccessor.count < positions.size() / 3);
+
+                // Vertices only slide along the borders of the grid, so its bounds are kept
+                Assert::AreEqual(0.0f, resultPositionAccessor.min[0]);
+                Assert::AreEqual(9.0f, resultPositionAccessor.max[1]);
+
+                GLTFResourceReader reader(std::make_shared<MemoryMappedStreamReader>(outputDirectory));
+                auto resultIndices = reader.ReadBinaryData<uint16_t>(resultDoc, resultIndexAccessor);
+                Assert::IsTrue(*std::max_element(resultIndices.begin(), resultIndices.end()) < resultPositionAccessor.count);
+
+                // Every level of detail is simplified from the original document
+                std::vector<SimplificationOptions> levels(2, options);
+                levels[1].TargetRatio = 0.1f;
+                levels[1].TargetError = 1.0f;
+                auto lods = GLTFMeshSimplificationUtils::GenerateLODs(streamReader, doc, levels, outputDirectory.u8string());
+
+                Assert::AreEqual(static_cast<size_t>(2), lods.size());
+                auto lod1Count = lods[0].accessors.Get(lods[0].meshes.Get("0").primitives[0].indicesAccessorId).count;
+                auto lod2Count = lods[1].accessors.Get(lods[1].meshes.Get("0").primitives[0].indicesAccessorId).count;
+                Assert::AreEqual(resultIndexAccessor.count, lod1Count);
+                Assert::IsTrue(lod2Count < lod1Count);
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
@@ -11,6 +11,8 @@
 #include "GLTFSDK/GLTFResourceWriter.h"
 
 #include "GLTFTextureCompressionUtils.h"
+#include "GLTFLODUtils.h"
+#include "MemoryMappedStreamReader.h"
 
 #include "Helpers/WStringUtils.h"
 #include "Helpers/StreamMock.h"
@@ -233,6 +235,51 @@ namespace Microsoft::glTF::Toolkit::Test
             });
         }
 
+        TEST_METHOD(GLTFTextureCompressionUtils_GenerateMaterialLODs)
+        {
+            TestUtils::LoadAndExecuteGLTFTest(c_waterBottleORMJson, [](auto doc, auto path)
+            {
+                size_t maxTextureSize = 512;
+                auto compressedDoc = GLTFTextureCompressionUtils::CompressAllTexturesForWindowsMR(std::make_shared<TestStreamReader>(path), doc, "", maxTextureSize, true);
+
+                // The compressed images have absolute paths
+                auto streamReader = std::make_shared<MemoryMappedStreamReader>(TestUtils::GetBasePath(path.c_str()));
+                auto lodDoc = GLTFTextureCompressionUtils::GenerateMaterialLODs(streamReader, compressedDoc, "", 2);
+
+                // Check that each level added a material, and a texture and image for each DDS texture
+                Assert::AreEqual(compressedDoc.materials.Size() + 2, lodDoc.materials.Size());
+                Assert::AreEqual(compressedDoc.textures.Size() + 8, lodDoc.textures.Size());
+                Assert::AreEqual(compressedDoc.images.Size() + 8, lodDoc.images.Size());
+
+                auto lodExtension = lodDoc.materials.Get("0").extensions.at(EXTENSION_MSFT_LOD);
+                rapidjson::Document lodJson;
+                lodJson.Parse(lodExtension.c_str());
+                Assert::AreEqual(2u, lodJson[MSFT_LOD_IDS_KEY].Size());
+
+                // The first material LOD samples the second mip of the base color texture, and keeps the original image for other viewers
+                const auto& material = compressedDoc.materials.Get("0");
+                const auto& lodMaterial = lodDoc.materials.Get(std::to_string(lodJson[MSFT_LOD_IDS_KEY][0u].GetInt()));
+                const auto& texture = lodDoc.textures.Get(material.metallicRoughness.baseColorTexture.textureId);
+                const auto& lodTexture = lodDoc.textures.Get(lodMaterial.metallicRoughness.baseColorTexture.textureId);
+                Assert::AreNotEqual(texture.id, lodTexture.id);
+                Assert::AreEqual(texture.imageId, lodTexture.imageId);
+
+                rapidjson::Document ddsJson;
+                ddsJson.Parse(lodTexture.extensions.at(EXTENSION_MSFT_TEXTURE_DDS).c_str());
+                const auto& lodImage = lodDoc.images.Get(std::to_string(ddsJson["source"].GetInt()));
+                Assert::IsTrue(lodImage.mimeType == "image/vnd-ms.dds");
+
+                std::string expectedSuffix = "_lod1.dds";
+                Assert::IsTrue(lodImage.uri.compare(lodImage.uri.size() - expectedSuffix.size(), expectedSuffix.size(), expectedSuffix) == 0);
+
+                DirectX::TexMetadata metadata;
+                std::wstring lodImageUri(lodImage.uri.begin(), lodImage.uri.end());
+                Assert::IsTrue(SUCCEEDED(DirectX::GetMetadataFromDDSFile(lodImageUri.c_str(), DirectX::DDS_FLAGS_NONE, metadata)));
+                Assert::AreEqual(maxTextureSize / 2, metadata.width);
+                Assert::IsTrue(DXGI_FORMAT_BC7_UNORM_SRGB == metadata.format);
+            });
+        }
+
         TEST_METHOD(GLTFTextureCompressionUtils_CompressTextureAsDDS_NotMultipleOf4)
         {
             // This asset has all textures
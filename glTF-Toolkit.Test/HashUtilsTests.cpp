@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "HashUtils.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(HashUtilsTests)
+    {
+        TEST_METHOD(HashUtilsTests_Hash64_ReferenceValues)
+        {
+            // Reference values of the XXH64 implementation
+            std::string empty;
+            std::string shortText = "abc";
+            std::string longText = "The quick brown fox jumps over the lazy dog";
+
+            Assert::IsTrue(0xEF46DB3751D8E999ULL == HashUtils::Hash64(empty.data(), empty.size()));
+            Assert::IsTrue(0x44BC2CF5AD770999ULL == HashUtils::Hash64(shortText.data(), shortText.size()));
+            Assert::IsTrue(0x0B242D361FDA71BCULL == HashUtils::Hash64(longText.data(), longText.size()));
+
+            std::vector<uint8_t> bytes(1000);
+            for (size_t i = 0; i < bytes.size(); i++)
+            {
+                bytes[i] = static_cast<uint8_t>(i * 7);
+            }
+            Assert::IsTrue(0x7C56BDF2C5D636FEULL == HashUtils::Hash64(bytes.data(), bytes.size(), 5));
+        }
+    };
+}
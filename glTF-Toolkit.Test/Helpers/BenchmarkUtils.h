@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <CppUnitTest.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    class BenchmarkUtils
+    {
+    public:
+        // Runs the action the given number of times and returns the average duration of one run, in milliseconds.
+        static double Measure(size_t iterations, const std::function<void()>& action)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < iterations; i++)
+            {
+                action();
+            }
+            auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start);
+
+            return elapsed.count() / iterations;
+        }
+
+        static void Report(const std::string& benchmark, const std::string& variant, double milliseconds)
+        {
+            std::stringstream ss;
+            ss << benchmark << " [" << variant << "]: " << milliseconds << " ms" << std::endl;
+            Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(ss.str().c_str());
+        }
+    };
+}
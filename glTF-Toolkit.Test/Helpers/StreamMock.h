@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
 #include <string>
 #include <sstream>
@@ -31,4 +32,28 @@ namespace Microsoft::glTF::Toolkit::Test
     private:
         std::shared_ptr<std::stringstream> m_stream;
     };
+
+    // Serves resources from memory, opening an independent stream for each request so it can be shared between threads.
+    class InMemoryStreamReader : public IStreamReader
+    {
+    public:
+        void Add(const std::string& uri, std::string contents)
+        {
+            m_resources[uri] = std::make_shared<const std::string>(std::move(contents));
+        }
+
+        std::shared_ptr<std::istream> GetInputStream(const std::string& uri) const override
+        {
+            auto resource = m_resources.find(uri);
+            if (resource == m_resources.end())
+            {
+                throw std::runtime_error("Unknown resource: " + uri);
+            }
+
+            return std::make_shared<std::istringstream>(*resource->second, std::ios_base::in | std::ios_base::binary);
+        }
+
+    private:
+        std::map<std::string, std::shared_ptr<const std::string>> m_resources;
+    };
 }
\ No newline at end of file
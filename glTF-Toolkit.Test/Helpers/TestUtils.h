@@ -114,6 +114,13 @@ namespace Microsoft::glTF::Toolkit::Test
             return tempStream;
         }
 
+        static std::experimental::filesystem::path CreateOutputDirectory(const std::string& name)
+        {
+            auto outputDirectory = std::experimental::filesystem::temp_directory_path() / name;
+            std::experimental::filesystem::create_directories(outputDirectory);
+            return outputDirectory;
+        }
+
         typedef std::function<void(const Document& doc, const std::string& gltfAbsolutePath)> GLTFAction;
 
         static void LoadAndExecuteGLTFTest(const char * gltfRelativePath, GLTFAction action)
@@ -159,4 +166,53 @@ namespace Microsoft::glTF::Toolkit::Test
     private:
         const std::string m_basePath;
     };
+
+    // Builds a document with a single buffer held by an InMemoryStreamReader, with one bufferView per accessor
+    class InMemoryDocumentBuilder
+    {
+    public:
+        InMemoryDocumentBuilder(std::string bufferUri) : m_bufferUri(std::move(bufferUri)) {}
+
+        // Appends the values to the buffer and returns the id of a new accessor for them
+        template<typename T>
+        std::string AddAccessor(const std::vector<T>& values, AccessorType type, ComponentType componentType, Optional<BufferViewTarget> target = {}, bool normalized = false)
+        {
+            BufferView bufferView;
+            bufferView.id = std::to_string(m_document.bufferViews.Size());
+            bufferView.bufferId = "0";
+            bufferView.byteOffset = m_contents.size();
+            bufferView.byteLength = values.size() * sizeof(T);
+            bufferView.target = target;
+
+            Accessor accessor;
+            accessor.id = std::to_string(m_document.accessors.Size());
+            accessor.bufferViewId = bufferView.id;
+            accessor.componentType = componentType;
+            accessor.normalized = normalized;
+            accessor.type = type;
+            accessor.count = values.size() / Accessor::GetTypeCount(type);
+
+            m_contents.append(reinterpret_cast<const char*>(values.data()), bufferView.byteLength);
+            m_document.bufferViews.Append(std::move(bufferView));
+            return m_document.accessors.Append(std::move(accessor)).id;
+        }
+
+        // Adds the buffer to the stream reader and returns a document with the buffer and the accessors added so far
+        Document Build(InMemoryStreamReader& streamReader)
+        {
+            Buffer buffer;
+            buffer.id = "0";
+            buffer.uri = m_bufferUri;
+            buffer.byteLength = m_contents.size();
+            m_document.buffers.Append(std::move(buffer));
+
+            streamReader.Add(m_bufferUri, m_contents);
+            return m_document;
+        }
+
+    private:
+        const std::string m_bufferUri;
+        std::string m_contents;
+        Document m_document;
+    };
 }
\ No newline at end of file
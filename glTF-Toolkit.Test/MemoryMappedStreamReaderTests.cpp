@@ -0,0 +1,162 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFSDK/Deserialize.h"
+
+#include "MemoryMappedStreamReader.h"
+#include "SerializeBinary.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(MemoryMappedStreamReaderTests)
+    {
+        const char* c_waterBottleJson = "Resources\\gltf\\WaterBottle\\WaterBottle.gltf";
+
+        static std::string ReadAll(std::istream& stream)
+        {
+            return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        }
+
+        TEST_METHOD(MemoryMappedStreamReaderTests_Stream_MatchesFile)
+        {
+            auto basePath = TestUtils::GetBasePath(TestUtils::GetAbsolutePath(c_waterBottleJson).c_str());
+            MemoryMappedStreamReader streamReader(basePath);
+
+            auto mapping = streamReader.GetMapping("WaterBottle.bin");
+            Assert::IsNotNull(mapping.get());
+
+            // The mapping is only created once
+            Assert::IsTrue(mapping == streamReader.GetMapping("WaterBottle.bin"));
+
+            std::ifstream file(basePath + "WaterBottle.bin", std::ios::binary);
+            auto expected = ReadAll(file);
+            Assert::AreEqual(expected.size(), mapping->Size());
+
+            auto stream = streamReader.GetInputStream("WaterBottle.bin");
+            Assert::IsTrue(expected == ReadAll(*stream));
+
+            // Seeking and reading a range, as GLTFResourceReader does
+            const size_t offset = 1000;
+            char bytes[16];
+            stream->clear();
+            Assert::IsTrue(static_cast<bool>(stream->seekg(offset)));
+            Assert::IsTrue(static_cast<bool>(stream->read(bytes, sizeof(bytes))));
+            Assert::IsTrue(expected.compare(offset, sizeof(bytes), bytes, sizeof(bytes)) == 0);
+
+            Assert::IsTrue(static_cast<bool>(stream->seekg(0, std::ios::end)));
+            Assert::AreEqual(static_cast<std::streamoff>(expected.size()), static_cast<std::streamoff>(stream->tellg()));
+        }
+
+        TEST_METHOD(MemoryMappedStreamReaderTests_MissingFile_FallsBackToStream)
+        {
+            auto basePath = TestUtils::GetBasePath(TestUtils::GetAbsolutePath(c_waterBottleJson).c_str());
+            MemoryMappedStreamReader streamReader(basePath);
+
+            Assert::IsNull(streamReader.GetMapping("Missing.bin").get());
+
+            auto stream = streamReader.GetInputStream("Missing.bin");
+            Assert::IsNotNull(stream.get());
+            Assert::IsTrue(stream->fail());
+        }
+
+        TEST_METHOD(MemoryMappedStreamReaderTests_SerializeBinary_MatchesStreamReader)
+        {
+            try
+            {
+                auto absolutePath = TestUtils::GetAbsolutePath(c_waterBottleJson);
+                auto input = TestUtils::ReadLocalAsset(absolutePath);
+                auto doc = Deserialize(ReadAll(*input));
+
+                auto fileOutput = std::make_shared<StreamMock>();
+                SerializeBinary(doc, std::make_shared<TestStreamReader>(absolutePath), fileOutput);
+
+                // Accessors and images are written straight from the mapped files
+                auto mappedOutput = std::make_shared<StreamMock>();
+                SerializeBinary(doc, std::make_shared<MemoryMappedStreamReader>(TestUtils::GetBasePath(absolutePath.c_str())), mappedOutput);
+
+                Assert::IsTrue(ReadAll(*fileOutput->GetInputStream(std::string())) == ReadAll(*mappedOutput->GetInputStream(std::string())));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(MemoryMappedStreamReaderTests_DeserializeGLB_ReadsInPlace)
+        {
+            try
+            {
+                auto absolutePath = TestUtils::GetAbsolutePath(c_waterBottleJson);
+                auto input = TestUtils::ReadLocalAsset(absolutePath);
+                auto doc = Deserialize(ReadAll(*input));
+                auto gltfStreamReader = std::make_shared<MemoryMappedStreamReader>(TestUtils::GetBasePath(absolutePath.c_str()));
+
+                auto glbOutput = std::make_shared<StreamMock>();
+                SerializeBinary(doc, gltfStreamReader, glbOutput);
+                auto glb = ReadAll(*glbOutput->GetInputStream(std::string()));
+
+                auto outputDirectory = TestUtils::CreateOutputDirectory("MemoryMappedStreamReaderTests");
+                {
+                    std::ofstream glbFile(outputDirectory / "WaterBottle.glb", std::ios::binary);
+                    glbFile.write(glb.data(), glb.size());
+                }
+
+                auto glbStreamReader = std::make_shared<MemoryMappedStreamReader>(outputDirectory);
+                auto glbDoc = glbStreamReader->DeserializeGLB("WaterBottle.glb");
+
+                // The GLB buffer is served as a view of the binary chunk of the mapped file
+                const auto& glbBuffer = glbDoc.buffers.Elements()[0];
+                Assert::AreEqual(std::string("WaterBottle.glb") + GLB_BINARY_CHUNK_FRAGMENT, glbBuffer.uri);
+
+                auto binaryChunk = glbStreamReader->GetMapping(glbBuffer.uri);
+                Assert::IsNotNull(binaryChunk.get());
+                Assert::IsTrue(binaryChunk->Data() == glbStreamReader->GetMapping("WaterBottle.glb")->Data() + binaryChunk->FileOffset());
+                Assert::IsTrue(binaryChunk->Size() >= glbBuffer.byteLength);
+
+                GLTFResourceReader gltfReader(gltfStreamReader);
+                GLTFResourceReader glbReader(glbStreamReader);
+                for (const auto& accessor : doc.accessors.Elements())
+                {
+                    if (accessor.componentType == COMPONENT_FLOAT)
+                    {
+                        Assert::IsTrue(gltfReader.ReadBinaryData<float>(doc, accessor) == glbReader.ReadBinaryData<float>(glbDoc, glbDoc.accessors.Get(accessor.id)));
+                    }
+                }
+
+                for (const auto& image : doc.images.Elements())
+                {
+                    Assert::IsTrue(gltfReader.ReadBinaryData(doc, image) == glbReader.ReadBinaryData(glbDoc, glbDoc.images.Get(image.id)));
+                }
+
+                // A file that isn't a GLB is reported instead of being read as one
+                {
+                    std::ofstream gltfFile(outputDirectory / "NotAGLB.glb", std::ios::binary);
+                    gltfFile << ReadAll(*TestUtils::ReadLocalAsset(absolutePath));
+                }
+                Assert::ExpectException<GLTFException>([&glbStreamReader]()
+                {
+                    glbStreamReader->DeserializeGLB("NotAGLB.glb");
+                });
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
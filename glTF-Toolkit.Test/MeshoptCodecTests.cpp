@@ -0,0 +1,254 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "MeshoptCodec.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    TEST_CLASS(MeshoptCodecTests)
+    {
+        static uint32_t NextRandom(uint32_t& state)
+        {
+            state = state * 1664525u + 1013904223u;
+            return state;
+        }
+
+        TEST_METHOD(MeshoptCodecTests_VertexBuffer_RoundTrip)
+        {
+            uint32_t randomState = 1;
+            for (size_t byteStride : { 4, 12, 16, 40, 256 })
+            {
+                // Counts that don't fill a whole group, and counts that span several blocks
+                for (size_t count : { 0, 1, 15, 17, 300, 1000 })
+                {
+                    // Small deltas with the occasional large one, to exercise every group encoding
+                    std::vector<uint8_t> vertices(count * byteStride);
+                    for (auto& byte : vertices)
+                    {
+                        byte = static_cast<uint8_t>(NextRandom(randomState) % 8 == 0 ? NextRandom(randomState) >> 24 : (NextRandom(randomState) >> 24) % 4);
+                    }
+
+                    auto encoded = MeshoptCodec::EncodeVertexBuffer(vertices.data(), count, byteStride);
+
+                    std::vector<uint8_t> decoded(count * byteStride);
+                    MeshoptCodec::DecodeVertexBuffer(decoded.data(), count, byteStride, encoded.data(), encoded.size());
+                    Assert::IsTrue(vertices == decoded);
+                }
+            }
+        }
+
+        TEST_METHOD(MeshoptCodecTests_VertexBuffer_CompressesSmoothData)
+        {
+            std::vector<float> positions;
+            for (size_t i = 0; i < 1024; i++)
+            {
+                positions.push_back(static_cast<float>(i % 32));
+                positions.push_back(static_cast<float>(i / 32));
+                positions.push_back(0.0f);
+            }
+
+            auto encoded = MeshoptCodec::EncodeVertexBuffer(reinterpret_cast<const uint8_t*>(positions.data()), 1024, 12);
+            Assert::IsTrue(encoded.size() < positions.size() * sizeof(float) / 4);
+        }
+
+        TEST_METHOD(MeshoptCodecTests_VertexBuffer_InvalidData)
+        {
+            std::vector<uint8_t> vertices(64, 1);
+            auto encoded = MeshoptCodec::EncodeVertexBuffer(vertices.data(), 16, 4);
+            std::vector<uint8_t> decoded(vertices.size());
+
+            Assert::ExpectException<std::invalid_argument>([&]()
+            {
+                MeshoptCodec::DecodeVertexBuffer(decoded.data(), 16, 4, encoded.data(), encoded.size() - 1);
+            });
+
+            Assert::ExpectException<std::invalid_argument>([&]()
+            {
+                MeshoptCodec::EncodeVertexBuffer(vertices.data(), 16, 6);
+            });
+
+            encoded[0] = 0xA1;
+            Assert::ExpectException<std::invalid_argument>([&]()
+            {
+                MeshoptCodec::DecodeVertexBuffer(decoded.data(), 16, 4, encoded.data(), encoded.size());
+            });
+        }
+
+        TEST_METHOD(MeshoptCodecTests_VertexBuffer_Golden)
+        {
+            const uint8_t vertices[] =
+            {
+                10, 0,   0, 255,
+                11, 3,   0, 255,
+                12, 6, 100, 255,
+                13, 9,   0, 255,
+            };
+
+            // Derived by hand from the EXT_meshopt_compression specification, so that the codec is checked against the format
+            // rather than against itself. Each byte of the vertex is one channel of zigzag-encoded deltas from the previous vertex,
+            // with a header byte that holds the mode of each group of 16 deltas.
+            const uint8_t expected[] =
+            {
+                0xA0,                                           // Version 0
+                0x01, 0x2A, 0x00, 0x00, 0x00,                   // Byte 0: deltas 0 1 1 1 in 2 bits
+                0x01, 0x3F, 0x00, 0x00, 0x00, 0x06, 0x06, 0x06, // Byte 1: deltas 0 3 3 3 in 2 bits, all but the first escaped
+                0x01, 0x0F, 0x00, 0x00, 0x00, 0xC8, 0xC7,       // Byte 2: deltas 0 0 100 -100 in 2 bits, the last two escaped
+                0x00,                                           // Byte 3: all deltas are 0
+                // The tail: the first vertex, padded to 32 bytes
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0xFF,
+            };
+
+            std::vector<uint8_t> decoded(sizeof(vertices));
+            MeshoptCodec::DecodeVertexBuffer(decoded.data(), 4, 4, expected, sizeof(expected));
+            Assert::IsTrue(std::equal(decoded.begin(), decoded.end(), vertices));
+
+            auto encoded = MeshoptCodec::EncodeVertexBuffer(vertices, 4, 4);
+            Assert::IsTrue(encoded == std::vector<uint8_t>(expected, expected + sizeof(expected)));
+        }
+
+        TEST_METHOD(MeshoptCodecTests_IndexSequence_RoundTrip)
+        {
+            // Runs of nearby indices, interrupted by jumps to another range
+            uint32_t randomState = 1;
+            std::vector<uint32_t> indices;
+            for (size_t i = 0; i < 3000; i++)
+            {
+                indices.push_back(i % 3 == 0 ? NextRandom(randomState) % 60000 : indices.back() + NextRandom(randomState) % 5);
+            }
+
+            auto encoded = MeshoptCodec::EncodeIndexSequence(indices.data(), indices.size());
+            Assert::IsTrue(encoded.size() < indices.size() * sizeof(uint16_t));
+
+            std::vector<uint32_t> decoded32(indices.size());
+            MeshoptCodec::DecodeIndexSequence(reinterpret_cast<uint8_t*>(decoded32.data()), indices.size(), 4, encoded.data(), encoded.size());
+            Assert::IsTrue(indices == decoded32);
+
+            std::vector<uint16_t> decoded16(indices.size());
+            MeshoptCodec::DecodeIndexSequence(reinterpret_cast<uint8_t*>(decoded16.data()), indices.size(), 2, encoded.data(), encoded.size());
+            Assert::IsTrue(std::equal(indices.begin(), indices.end(), decoded16.begin()));
+
+            Assert::ExpectException<std::invalid_argument>([&]()
+            {
+                MeshoptCodec::DecodeIndexSequence(reinterpret_cast<uint8_t*>(decoded32.data()), indices.size() - 1, 4, encoded.data(), encoded.size());
+            });
+        }
+
+        TEST_METHOD(MeshoptCodecTests_IndexSequence_Golden)
+        {
+            const uint32_t indices[] = { 0, 1, 51, 2, 49, 1000 };
+
+            // Derived by hand from the EXT_meshopt_compression specification.
+            // Each index is a varint of its zigzag-encoded delta from one of two baselines, with the baseline in the low bit.
+            const uint8_t expected[] =
+            {
+                0xD1,       // Version 1
+                0x00,       // 0: +0 from baseline 0
+                0x04,       // 1: +1 from baseline 0
+                0xCD, 0x01, // 51: +51 from baseline 1
+                0x04,       // 2: +1 from baseline 0
+                0x07,       // 49: -2 from baseline 1
+                0x98, 0x1F, // 1000: +998 from baseline 0
+                0x00, 0x00, 0x00, 0x00,
+            };
+
+            uint32_t decoded[6];
+            MeshoptCodec::DecodeIndexSequence(reinterpret_cast<uint8_t*>(decoded), 6, 4, expected, sizeof(expected));
+            Assert::IsTrue(std::equal(std::begin(indices), std::end(indices), decoded));
+
+            auto encoded = MeshoptCodec::EncodeIndexSequence(indices, 6);
+            Assert::IsTrue(encoded == std::vector<uint8_t>(expected, expected + sizeof(expected)));
+        }
+
+        TEST_METHOD(MeshoptCodecTests_FilterOctahedral)
+        {
+            std::vector<float> normals = {
+                0.0f, 0.0f, 1.0f, 1.0f,
+                0.0f, 0.0f, -1.0f, -1.0f,
+                0.6f, 0.0f, -0.8f, 1.0f,
+                0.48f, -0.6f, 0.64f, -1.0f
+            };
+
+            for (size_t byteStride : { 4, 8 })
+            {
+                int bits = byteStride == 4 ? 8 : 16;
+                float maxError = byteStride == 4 ? 0.02f : 0.0002f;
+
+                std::vector<uint8_t> filtered(4 * byteStride);
+                MeshoptCodec::EncodeFilterOctahedral(filtered.data(), 4, byteStride, bits, normals.data());
+                MeshoptCodec::DecodeFilter(MeshoptFilter::Octahedral, filtered.data(), 4, byteStride);
+
+                for (size_t i = 0; i < normals.size(); i++)
+                {
+                    float decoded = byteStride == 4 ?
+                        reinterpret_cast<const int8_t*>(filtered.data())[i] / 127.0f :
+                        reinterpret_cast<const int16_t*>(filtered.data())[i] / 32767.0f;
+                    Assert::IsTrue(std::abs(decoded - normals[i]) <= maxError);
+                }
+            }
+        }
+
+        TEST_METHOD(MeshoptCodecTests_FilterQuaternion)
+        {
+            std::vector<float> rotations = {
+                0.0f, 0.0f, 0.0f, 1.0f,
+                0.0f, 0.0f, 0.0f, -1.0f,
+                0.5f, -0.5f, 0.5f, 0.5f,
+                0.0f, 0.70710678f, 0.0f, -0.70710678f
+            };
+
+            std::vector<uint8_t> filtered(4 * 8);
+            MeshoptCodec::EncodeFilterQuaternion(filtered.data(), 4, 12, rotations.data());
+            MeshoptCodec::DecodeFilter(MeshoptFilter::Quaternion, filtered.data(), 4, 8);
+
+            // q and -q are the same rotation
+            auto decoded = reinterpret_cast<const int16_t*>(filtered.data());
+            for (size_t i = 0; i < 4; i++)
+            {
+                float dot = 0.0f;
+                for (size_t j = 0; j < 4; j++)
+                {
+                    dot += decoded[i * 4 + j] / 32767.0f * rotations[i * 4 + j];
+                }
+                Assert::IsTrue(std::abs(dot) >= 0.999f);
+            }
+
+            Assert::ExpectException<std::invalid_argument>([&]()
+            {
+                MeshoptCodec::EncodeFilterQuaternion(filtered.data(), 4, 3, rotations.data());
+            });
+        }
+
+        TEST_METHOD(MeshoptCodecTests_FilterExponential)
+        {
+            std::vector<float> values = { 0.0f, 1.0f, -1000.5f, 3.14159f, 1e-6f, 123456.0f };
+
+            std::vector<uint8_t> filtered(values.size() * sizeof(float));
+            MeshoptCodec::EncodeFilterExponential(filtered.data(), 2, 12, 16, values.data());
+            MeshoptCodec::DecodeFilter(MeshoptFilter::Exponential, filtered.data(), 2, 12);
+
+            // The error is relative to the largest component of each element
+            auto decoded = reinterpret_cast<const float*>(filtered.data());
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                float largest = i < 3 ? 1000.5f : 123456.0f;
+                Assert::IsTrue(std::abs(decoded[i] - values[i]) <= largest / 32768.0f);
+            }
+            Assert::AreEqual(0.0f, decoded[0]);
+
+            // With 24 bits, single component elements lose at most the last bit of their mantissa
+            MeshoptCodec::EncodeFilterExponential(filtered.data(), values.size(), 4, 24, values.data());
+            MeshoptCodec::DecodeFilter(MeshoptFilter::Exponential, filtered.data(), values.size(), 4);
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                Assert::IsTrue(std::abs(decoded[i] - values[i]) <= std::abs(values[i]) / 8388608.0f);
+            }
+        }
+    };
+}
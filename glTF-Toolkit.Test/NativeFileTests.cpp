@@ -0,0 +1,161 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include <CppUnitTest.h>
+
+#include "GLTFSDK/Deserialize.h"
+
+#include "MemoryMappedStreamReader.h"
+#include "NativeFile.h"
+#include "SerializeBinary.h"
+
+#include "Helpers/TestUtils.h"
+#include "Helpers/WStringUtils.h"
+#include "Helpers/StreamMock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace Microsoft::glTF::Toolkit::Test
+{
+    // Writes every output stream to the same file, like the GLB writer of the converter
+    class SingleFileStreamWriter : public IFileStreamWriter
+    {
+    public:
+        SingleFileStreamWriter(const std::experimental::filesystem::path& path) :
+            m_path(path),
+            m_stream(std::make_shared<std::ofstream>(path, std::ios::binary))
+        {
+        }
+
+        std::shared_ptr<std::ostream> GetOutputStream(const std::string&) const override
+        {
+            return m_stream;
+        }
+
+        std::shared_ptr<NativeFile> GetOutputFile(const std::string&) const override
+        {
+            return NativeFile::OpenWrite(m_path);
+        }
+
+    private:
+        std::experimental::filesystem::path m_path;
+        std::shared_ptr<std::ofstream> m_stream;
+    };
+
+    TEST_CLASS(NativeFileTests)
+    {
+        const char* c_waterBottleJson = "Resources\\gltf\\WaterBottle\\WaterBottle.gltf";
+
+        static std::string ReadAll(std::istream& stream)
+        {
+            return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        }
+
+        TEST_METHOD(NativeFileTests_CopyRange_MatchesSource)
+        {
+            try
+            {
+                auto outputDirectory = TestUtils::CreateOutputDirectory("NativeFileTests");
+
+                // Longer than the copy buffer, so that the fallback copies it in several reads
+                std::string contents(3 * 1024 * 1024 + 5, '\0');
+                for (size_t i = 0; i < contents.size(); i++)
+                {
+                    contents[i] = static_cast<char>(i * 7 + 3);
+                }
+                {
+                    std::ofstream sourceStream(outputDirectory / "source.bin", std::ios::binary);
+                    sourceStream.write(contents.data(), contents.size());
+                }
+
+                auto source = NativeFile::OpenRead(outputDirectory / "source.bin");
+                Assert::IsNotNull(source.get());
+                Assert::AreEqual(static_cast<uint64_t>(contents.size()), source->GetSize());
+
+                auto destination = NativeFile::OpenWrite(outputDirectory / "destination.bin");
+                Assert::IsNotNull(destination.get());
+                destination->Resize(0);
+
+                // Two ranges with a gap between them, the second one ending at the end of the source
+                const size_t secondOffset = 10000;
+                const size_t secondLength = contents.size() - 100;
+                NativeFile::CopyRange(*source, 0, *destination, 0, 4096);
+                NativeFile::CopyRange(*source, 100, *destination, secondOffset, secondLength);
+                Assert::AreEqual(static_cast<uint64_t>(secondOffset + secondLength), destination->GetSize());
+                destination.reset();
+
+                std::ifstream destinationStream(outputDirectory / "destination.bin", std::ios::binary);
+                auto copied = ReadAll(destinationStream);
+                Assert::AreEqual(secondOffset + secondLength, copied.size());
+                Assert::IsTrue(copied.compare(0, 4096, contents, 0, 4096) == 0);
+                Assert::IsTrue(std::all_of(copied.begin() + 4096, copied.begin() + secondOffset, [](char c) { return c == '\0'; }));
+                Assert::IsTrue(copied.compare(secondOffset, secondLength, contents, 100, secondLength) == 0);
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(NativeFileTests_SerializeBinary_FileOutput_MatchesStreamOutput)
+        {
+            try
+            {
+                auto absolutePath = TestUtils::GetAbsolutePath(c_waterBottleJson);
+                auto input = TestUtils::ReadLocalAsset(absolutePath);
+                auto doc = Deserialize(ReadAll(*input));
+                auto streamReader = std::make_shared<MemoryMappedStreamReader>(TestUtils::GetBasePath(absolutePath.c_str()));
+
+                auto streamOutput = std::make_shared<StreamMock>();
+                SerializeBinary(doc, streamReader, streamOutput);
+
+                // The textures are copied from their files into the GLB file, around the accessors written through the stream
+                auto glbPath = TestUtils::CreateOutputDirectory("NativeFileTests") / "WaterBottle.glb";
+                SerializeBinary(doc, streamReader, std::make_shared<SingleFileStreamWriter>(glbPath));
+
+                std::ifstream glbFile(glbPath, std::ios::binary);
+                Assert::IsTrue(ReadAll(*streamOutput->GetInputStream(std::string())) == ReadAll(glbFile));
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+
+        TEST_METHOD(NativeFileTests_FileStreamWriter_RejectsEmptyUri)
+        {
+            try
+            {
+                auto outputDirectory = TestUtils::CreateOutputDirectory("NativeFileTests");
+                auto streamWriter = std::make_shared<FileStreamWriter>(outputDirectory);
+
+                // Files are named after their URIs
+                *streamWriter->GetOutputStream("resource.bin") << "resource";
+                Assert::IsNotNull(streamWriter->GetOutputFile("resource.bin").get());
+
+                // An empty URI, as requested by the GLB writer, doesn't open the directory itself
+                Assert::ExpectException<GLTFException>([&streamWriter]()
+                {
+                    streamWriter->GetOutputStream(std::string());
+                });
+                Assert::ExpectException<GLTFException>([&streamWriter]()
+                {
+                    streamWriter->GetOutputFile(std::string());
+                });
+            }
+            catch (std::exception ex)
+            {
+                std::stringstream ss;
+                ss << "Received exception was unexpected. Got: " << ex.what();
+                Assert::Fail(WStringUtils::ToWString(ss).c_str());
+            }
+        }
+    };
+}
@@ -15,6 +15,21 @@ namespace Microsoft::glTF::Toolkit
     class AccessorUtils
     {
     public:
+        /// <summary>
+        /// The instruction sets that can be used to calculate the bounds of an accessor.
+        /// </summary>
+        enum class InstructionSet
+        {
+            Scalar,
+            SSE2,
+            AVX2
+        };
+
+        /// <summary>
+        /// Gets the most capable instruction set that is supported both by this build and by the processor it runs on.
+        /// </summary>
+        static InstructionSet GetSupportedInstructionSet();
+
         // Note: XML Documentation cannot be applied to templated types per https://docs.microsoft.com/en-us/cpp/ide/xml-documentation-visual-cpp
         // Calculates the min and max values for an accessor according to the glTF 2.0 specification.
         // accessor is: The accessor definition for which the min and max values will be calculated.</param>
@@ -22,6 +37,15 @@ namespace Microsoft::glTF::Toolkit
         // returns: A pair containing the min and max vectors for the accessor, in that order.
         template <typename T>
         static std::pair<std::vector<float>, std::vector<float>> CalculateMinMax(const Accessor& accessor, const std::vector<T>& accessorContents)
+        {
+            return CalculateMinMax(accessor, accessorContents, GetSupportedInstructionSet());
+        }
+
+        // Calculates the min and max values for an accessor, using the given instruction set.
+        // SCALAR, VEC2, VEC3 and VEC4 accessors of every component type are vectorized; other types always use the scalar loop.
+        // instructionSet is: The instruction set to use. If it's not supported, the most capable supported instruction set is used instead.
+        template <typename T>
+        static std::pair<std::vector<float>, std::vector<float>> CalculateMinMax(const Accessor& accessor, const std::vector<T>& accessorContents, InstructionSet instructionSet)
         {
             auto typeCount = Accessor::GetTypeCount(accessor.type);
             auto min = std::vector<float>(typeCount);
@@ -32,6 +56,13 @@ namespace Microsoft::glTF::Toolkit
                 throw std::invalid_argument("The accessor must contain data in order to calculate min and max.");
             }
 
+            auto elementCount = std::min<size_t>(accessor.count, accessorContents.size() / typeCount);
+            if (instructionSet != InstructionSet::Scalar &&
+                CalculateMinMaxVectorized(instructionSet, accessorContents.data(), elementCount, typeCount, min.data(), max.data()))
+            {
+                return std::make_pair(min, max);
+            }
+
             // Initialize min and max with the first elements of the array
             for (size_t j = 0; j < typeCount; j++)
             {
@@ -52,6 +83,41 @@ namespace Microsoft::glTF::Toolkit
 
             return std::make_pair(min, max);
         }
+
+        /// <summary>
+        /// Converts the components of an accessor to another component type, and optionally calculates the bounds of the
+        /// converted values, in a single pass. Kernels exist for every pair of glTF component types.
+        /// Normalized integer components are converted to floats in [0, 1] or [-1, 1], and rescaled when converted to another
+        /// integer type, so they keep their meaning. Other components are clamped to the range of the destination type,
+        /// and floats are rounded to the nearest integer.
+        /// </summary>
+        /// <param name="sourceComponentType">The component type of the source data.</param>
+        /// <param name="source">The source components, tightly packed.</param>
+        /// <param name="destinationComponentType">The component type to convert to.</param>
+        /// <param name="destination">Where the converted components are written; it must have room for elementCount * typeCount components.</param>
+        /// <param name="elementCount">The number of elements (e.g. vertices) to convert.</param>
+        /// <param name="typeCount">The number of components in each element.</param>
+        /// <param name="normalized">Whether the source components are normalized.</param>
+        /// <param name="min">If not null, receives the minimum of each component after conversion; it must have room for typeCount values.</param>
+        /// <param name="max">If not null, receives the maximum of each component after conversion; it must have room for typeCount values.</param>
+        static void ConvertComponents(ComponentType sourceComponentType, const void* source, ComponentType destinationComponentType, void* destination,
+                                      size_t elementCount, size_t typeCount, bool normalized, float* min = nullptr, float* max = nullptr);
+
+    private:
+        // Vectorized kernels, implemented for every glTF component type. They return false when they can't handle the
+        // accessor type, in which case the caller falls back to the scalar loop.
+        static bool CalculateMinMaxVectorized(InstructionSet instructionSet, const int8_t* data, size_t elementCount, size_t typeCount, float* min, float* max);
+        static bool CalculateMinMaxVectorized(InstructionSet instructionSet, const uint8_t* data, size_t elementCount, size_t typeCount, float* min, float* max);
+        static bool CalculateMinMaxVectorized(InstructionSet instructionSet, const int16_t* data, size_t elementCount, size_t typeCount, float* min, float* max);
+        static bool CalculateMinMaxVectorized(InstructionSet instructionSet, const uint16_t* data, size_t elementCount, size_t typeCount, float* min, float* max);
+        static bool CalculateMinMaxVectorized(InstructionSet instructionSet, const uint32_t* data, size_t elementCount, size_t typeCount, float* min, float* max);
+        static bool CalculateMinMaxVectorized(InstructionSet instructionSet, const float* data, size_t elementCount, size_t typeCount, float* min, float* max);
+
+        template <typename T>
+        static bool CalculateMinMaxVectorized(InstructionSet, const T*, size_t, size_t, float*, float*)
+        {
+            return false;
+        }
     };
 }
 
@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+#include "GLTFSDK/BufferBuilder.h"
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Writes the buffers of a BufferBuilder to files, for a URI prefix that is the absolute path of the output directory.
+    /// </summary>
+    class BufferFileStreamWriter : public IStreamWriter
+    {
+    public:
+        std::shared_ptr<std::ostream> GetOutputStream(const std::string& uri) const override
+        {
+            return std::make_shared<std::ofstream>(std::experimental::filesystem::u8path(uri), std::ios::binary);
+        }
+    };
+
+    /// <summary>
+    /// Utilities to write new vertex data with a BufferBuilder, for the utilities that rewrite the meshes of a glTF asset.
+    /// </summary>
+    class BufferBuilderUtils
+    {
+    public:
+        // glTF requires each element of a vertex attribute to be aligned to 4 bytes
+        static const size_t VertexAttributeAlignment = 4;
+
+        /// <summary>
+        /// Creates a generator of ids that aren't used in a container yet, e.g. for the buffers, bufferViews and accessors of a BufferBuilder.
+        /// </summary>
+        /// <param name="container">The container. It must outlive the generator, which checks ids against its current contents.</param>
+        /// <returns>The id generator.</returns>
+        template<typename T>
+        static BufferBuilder::FnGenId UnusedIdGenerator(const IndexedContainer<const T>& container)
+        {
+            auto next = std::make_shared<size_t>(container.Size());
+            return [&container, next](const BufferBuilder&)
+            {
+                while (container.Has(std::to_string(*next)))
+                {
+                    (*next)++;
+                }
+                return std::to_string((*next)++);
+            };
+        }
+
+        /// <summary>
+        /// Writes tightly packed vertex elements to a new bufferView, padding every element to 4 bytes.
+        /// </summary>
+        /// <param name="builder">The builder to add the bufferView to.</param>
+        /// <param name="elements">The elements, each elementSize bytes long, with no padding between them.</param>
+        /// <param name="count">The number of elements.</param>
+        /// <param name="elementSize">The size of one element in bytes.</param>
+        /// <returns>The new bufferView, with a byteStride when the elements were padded.</returns>
+        static const BufferView& AddVertexBufferView(BufferBuilder& builder, const uint8_t* elements, size_t count, size_t elementSize);
+
+        /// <summary>
+        /// Writes the given elements of a vertex accessor to a new bufferView, padding every element to 4 bytes.
+        /// </summary>
+        /// <param name="builder">The builder to add the bufferView to.</param>
+        /// <param name="accessor">The accessor the elements are read from.</param>
+        /// <param name="bytes">The tightly packed data of the accessor.</param>
+        /// <param name="vertices">The indices of the elements to copy, in their new order.</param>
+        /// <param name="calculateMinMax">Whether to calculate min and max values even if the accessor has none.</param>
+        /// <returns>An accessor based on the original one that points to the new bufferView.</returns>
+        static Accessor CopyVertices(BufferBuilder& builder, const Accessor& accessor, const std::vector<uint8_t>& bytes, const std::vector<uint32_t>& vertices, bool calculateMinMax);
+    };
+}
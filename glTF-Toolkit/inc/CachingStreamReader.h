@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>Counters describing how well a <see cref="CachingStreamReader" /> is doing.</summary>
+    struct CachingStreamReaderStatistics
+    {
+        // The number of resource requests served from the cache
+        size_t Hits = 0;
+
+        // The number of resource requests that had to read the resource from the underlying stream reader
+        size_t Misses = 0;
+
+        // The number of resources dropped from the cache to stay within its byte budget
+        size_t Evictions = 0;
+
+        // The number of bytes of resource contents currently held by the cache, pinned or not
+        size_t BytesHeld = 0;
+
+        // The number of bytes of resource contents currently held because they are pinned
+        size_t BytesPinned = 0;
+    };
+
+    /// <summary>
+    /// A stream reader that keeps the contents of the resources it reads (buffers and image files) in memory, so that
+    /// pipeline stages sharing it don't read the same bytes from disk again. Resources are evicted in least recently
+    /// used order once the cache holds more than its byte budget, except for pinned resources, which stay cached until
+    /// they are unpinned. The reader can be used from several threads at once. It is meant for stream readers that read
+    /// from their source on every request; a MemoryMappedStreamReader already serves repeated reads from memory.
+    /// </summary>
+    class CachingStreamReader : public IStreamReader
+    {
+    public:
+        /// <summary>The byte budget used when none is specified: 256 MiB.</summary>
+        static const size_t DefaultByteBudget = 256 * 1024 * 1024;
+
+        /// <summary>
+        /// Creates a cache in front of a stream reader.
+        /// </summary>
+        /// <param name="streamReader">The stream reader resources are read from on a cache miss.</param>
+        /// <param name="byteBudget">The number of bytes of unpinned resources the cache may hold. Resources larger than
+        /// the budget are served without being cached, unless they are pinned.</param>
+        CachingStreamReader(std::shared_ptr<const IStreamReader> streamReader, size_t byteBudget = DefaultByteBudget);
+
+        /// <summary>
+        /// Gets a stream over the contents of a resource, reading and caching them on a miss. A resource larger than the
+        /// byte budget is streamed from the underlying stream reader instead, so that it can be read by range.
+        /// </summary>
+        std::shared_ptr<std::istream> GetInputStream(const std::string& uri) const override;
+
+        /// <summary>
+        /// Gets the contents of a resource, reading and caching them on a miss.
+        /// </summary>
+        /// <param name="uri">The URI of the resource, as understood by the underlying stream reader.</param>
+        /// <returns>The contents of the resource, which remain valid even if the resource is later evicted.</returns>
+        std::shared_ptr<const std::vector<uint8_t>> GetResource(const std::string& uri) const;
+
+        /// <summary>
+        /// Gets the contents of a resource only if they are already cached, without reading anything on a miss.
+        /// </summary>
+        /// <param name="uri">The URI of the resource, as understood by the underlying stream reader.</param>
+        /// <returns>The contents of the resource, or null if it isn't cached.</returns>
+        std::shared_ptr<const std::vector<uint8_t>> TryGetCached(const std::string& uri) const;
+
+        /// <summary>
+        /// Keeps a resource in the cache until it is unpinned, reading it now if it isn't cached yet. Pins are counted,
+        /// so a resource pinned twice has to be unpinned twice.
+        /// </summary>
+        /// <param name="uri">The URI of a resource that a later stage is known to need.</param>
+        void Pin(const std::string& uri);
+
+        /// <summary>
+        /// Releases a pin taken with <see cref="Pin" />. Once its last pin is released, the resource can be evicted again.
+        /// </summary>
+        void Unpin(const std::string& uri);
+
+        /// <summary>
+        /// Drops every unpinned resource from the cache.
+        /// </summary>
+        void Clear();
+
+        /// <summary>
+        /// Gets the hit and miss counters and the current size of the cache.
+        /// </summary>
+        CachingStreamReaderStatistics GetStatistics() const;
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<const std::vector<uint8_t>> contents;
+            size_t pinCount = 0;
+            std::list<std::string>::iterator recentUse;
+        };
+
+        // Must be called with the mutex held
+        std::shared_ptr<const std::vector<uint8_t>> Find(const std::string& uri) const;
+
+        std::shared_ptr<std::istream> Open(const std::string& uri) const;
+        std::shared_ptr<const std::vector<uint8_t>> Read(std::istream& stream, std::streamoff length, const std::string& uri) const;
+        std::shared_ptr<const std::vector<uint8_t>> Insert(const std::string& uri, std::shared_ptr<const std::vector<uint8_t>> contents) const;
+        void Evict() const;
+
+        const std::shared_ptr<const IStreamReader> m_streamReader;
+        const size_t m_byteBudget;
+
+        // Guards every member below. The underlying stream reader is never called while it is held.
+        mutable std::mutex m_mutex;
+        mutable std::unordered_map<std::string, Entry> m_entries;
+        // Unpinned entries, most recently used first
+        mutable std::list<std::string> m_recentUses;
+        mutable size_t m_unpinnedBytes;
+        mutable CachingStreamReaderStatistics m_statistics;
+    };
+}
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "GLTFSDK.h"
+#include "NativeFile.h"
 
 namespace Microsoft::glTF::Toolkit
 {
@@ -26,6 +27,32 @@ namespace Microsoft::glTF::Toolkit
         /// </param>
         static void UnpackGLB(const std::string& glbPath, const std::string& outDirectory, const std::string& gltfName);
 
+        /// <summary>
+        /// Copies the images, the resources referenced by extensions and the remaining buffer views of a GLB file to their
+        /// unpacked files in a single forward pass over the GLB buffer, through a fixed-size copy buffer, so that the memory
+        /// used doesn't depend on the size of the asset. The files have the names and layout described by CreateGLTFDocument.
+        /// </summary>
+        /// <param name="in">A stream pointing to the GLB file.</param>
+        /// <param name="glbDoc">The manifest describing the GLB asset.</param>
+        /// <param name="name">The name that was passed to CreateGLTFDocument.</param>
+        /// <param name="bufferOffset">The offset on the input file where the GLB buffer starts.</param>
+        /// <param name="unpackedBufferViews">The buffer views that CreateGLTFDocument moved out of the bin file.</param>
+        /// <param name="streamWriter">A stream writer that opens the output stream of each unpacked file by name.</param>
+        static void UnpackResources(std::istream* in, const Microsoft::glTF::Document& glbDoc, const std::string& name, const size_t bufferOffset, const std::unordered_set<std::string>& unpackedBufferViews, std::shared_ptr<const Microsoft::glTF::IStreamWriter> streamWriter);
+
+        /// <summary>
+        /// Copies the images, the resources referenced by extensions and the remaining buffer views of a GLB file to their
+        /// unpacked files like the stream overload, but from file to file with <see cref="NativeFile::CopyRange" />,
+        /// so that on Linux their contents are copied (or shared, on file systems that support reflinks) by the kernel.
+        /// </summary>
+        /// <param name="in">The GLB file, opened natively.</param>
+        /// <param name="glbDoc">The manifest describing the GLB asset.</param>
+        /// <param name="name">The name that was passed to CreateGLTFDocument.</param>
+        /// <param name="bufferOffset">The offset on the input file where the GLB buffer starts.</param>
+        /// <param name="unpackedBufferViews">The buffer views that CreateGLTFDocument moved out of the bin file.</param>
+        /// <param name="streamWriter">A stream writer that opens the file of each unpacked resource by name.</param>
+        static void UnpackResources(const NativeFile& in, const Microsoft::glTF::Document& glbDoc, const std::string& name, const size_t bufferOffset, const std::unordered_set<std::string>& unpackedBufferViews, std::shared_ptr<const IFileStreamWriter> streamWriter);
+
         /// <summary>
         /// Extracts the contents of all buffer views from a GLB file into a 
         /// byte vector that can be saves as a bin file to be used in a glTF file.
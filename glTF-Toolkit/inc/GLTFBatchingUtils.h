@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Static batching options.
+    /// </summary>
+    struct BatchingOptions
+    {
+        // Largest number of vertices of a merged primitive; up to 65535, merged primitives use 16-bit indices
+        size_t MaxVertexCount = 65535;
+
+        // Primitives are only merged with the ones whose centers fall in the same cell of a grid that divides
+        // the largest dimension of the root node's contents into this many cells, so that merged meshes can still be culled; 0 disables the grid
+        size_t GridResolution = 4;
+    };
+
+    /// <summary>
+    /// Statistics of the primitives merged by <see cref="GLTFBatchingUtils::BatchStaticMeshes" />.
+    /// </summary>
+    struct BatchingStatistics
+    {
+        // Number of primitives drawn by the scenes before and after batching, i.e. draw calls
+        size_t PrimitivesBefore = 0;
+        size_t PrimitivesAfter = 0;
+    };
+
+    /// <summary>
+    /// Utilities to reduce the number of draw calls of the scenes in a glTF asset.
+    /// </summary>
+    class GLTFBatchingUtils
+    {
+    public:
+        /// <summary>
+        /// Merges the primitives of static nodes that share a material, a mode and the same vertex attribute layout into
+        /// new primitives, baking the node transforms into the positions, normals and tangents.
+        /// Batching happens under each root node of each scene: the merged meshes are added as new children of the root node,
+        /// in its space, so root nodes keep their ids, transforms and animations and the result can still be passed to
+        /// <see cref="GLTFLODUtils::MergeDocumentsAsLODs" />. Nodes that already have MSFT_lod levels, and their levels, are left intact.
+        /// Nodes that are animated, skinned or skin joints, and their descendants, are not static; neither are primitives
+        /// with morph targets, extensions, Draco or meshopt compressed data, or primitives that aren't point, line or triangle lists.
+        /// Nodes that are left without a mesh or children are removed, along with the meshes and accessors that are no longer used.
+        /// </summary>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+        /// <param name="doc">The document from which the scenes will be loaded.</param>
+        /// <param name="options">The batching options that will be used.</param>
+        /// <param name="outputDirectory">The output directory to which the merged vertices and indices should be saved.</param>
+        /// <param name="statistics">If not null, receives the number of primitives drawn before and after batching.</param>
+        /// <returns>A new glTF manifest with the merged meshes.</returns>
+        static Document BatchStaticMeshes(
+            std::shared_ptr<IStreamReader> streamReader,
+            const Document& doc,
+            const BatchingOptions& options,
+            const std::string& outputDirectory,
+            BatchingStatistics* statistics = nullptr);
+    };
+}
@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Impostor generation options.
+    /// </summary>
+    struct ImpostorOptions
+    {
+        // Number of views rendered around the vertical axis of each root node, each one shown on its own quad
+        // (1 for a single billboard facing +Z, 2 for a cross billboard)
+        size_t ViewCount = 2;
+
+        // Width and height, in pixels, of each view in the atlas
+        size_t ViewResolution = 256;
+
+        // Width and height, in pixels, of the tiles that are rasterized in parallel
+        size_t TileSize = 32;
+
+        // Number of threads used to rasterize the tiles, or 0 to use one thread per hardware thread
+        size_t ThreadCount = 0;
+    };
+
+    /// <summary>
+    /// Utilities to replace the geometry of a glTF asset with textured quads, for use as its lowest level of detail.
+    /// </summary>
+    class GLTFImpostorUtils
+    {
+    public:
+        /// <summary>
+        /// Renders the subtree of every root node of a glTF asset from a set of orthographic views around its vertical axis,
+        /// with a multithreaded, tile-based software rasterizer, and returns a document in which each root node only has one
+        /// quad per view, textured with an atlas of the views. The atlas stores the base color, with the coverage of the view
+        /// in its alpha channel, and a normal texture in the tangent space of the quads, so that the impostor is lit like the geometry.
+        /// The base color and normals are sampled from the base color and normal textures of the materials; primitives
+        /// that aren't triangle lists with float positions, or whose data is compressed, are not rendered.
+        /// The result has the same scenes and root nodes as the original document, so that it can be passed after it to
+        /// <see cref="GLTFLODUtils::MergeDocumentsAsLODs" /> without shared materials or a relative path.
+        /// </summary>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+        /// <param name="doc">The document from which the meshes, materials and textures will be loaded.</param>
+        /// <param name="options">The view count, resolution and threading options.</param>
+        /// <param name="outputDirectory">The output directory to which the atlases and the quads should be saved.</param>
+        /// <returns>A new glTF manifest with one impostor root node per root node of the original document.</returns>
+        static Document GenerateImpostor(
+            std::shared_ptr<IStreamReader> streamReader,
+            const Document& doc,
+            const ImpostorOptions& options,
+            const std::string& outputDirectory);
+    };
+}
@@ -11,6 +11,30 @@ namespace Microsoft::glTF::Toolkit
     extern const char* MSFT_LOD_IDS_KEY;
     typedef std::unordered_map<std::string, std::shared_ptr<std::vector<std::string>>> LODMap;
 
+    /// <summary>
+    /// Statistics of the accessors and images that <see cref="GLTFLODUtils::MergeDocumentsAsLODs" /> shared between LODs.
+    /// </summary>
+    struct LODDeduplicationStatistics
+    {
+        // The number of bytes of accessor and image data of each LOD after the primary one that reuse identical data of a previous LOD
+        std::vector<size_t> DeduplicatedByteLength;
+
+        size_t DeduplicatedAccessorCount = 0;
+        size_t DeduplicatedImageCount = 0;
+    };
+
+    /// <summary>
+    /// Options for <see cref="GLTFLODUtils::ComputeScreenCoverage" />.
+    /// </summary>
+    struct ScreenCoverageOptions
+    {
+        // The density of visible triangles, in triangles per pixel, at which a LOD is replaced by the next one
+        double TrianglesPerPixel = 0.1;
+
+        // The height of the viewport, in pixels
+        size_t ScreenHeight = 1080;
+    };
+
     /// <summary>
     /// Utilities to load and merge levels of detail (LOD) in glTF assets using the MSFT_lod extension.
     /// </summary>
@@ -46,6 +70,61 @@ namespace Microsoft::glTF::Toolkit
         /// If not specified, all resources are assumed to be in the same directory.</param>
         static Document MergeDocumentsAsLODs(const std::vector<Document>& docs, const std::vector<double>& screenCoveragePercentages, const std::vector<std::wstring>& relativePaths = std::vector<std::wstring>(), const bool& sharedMaterials = false);
 
+        /// <summary>
+        /// Inserts each LOD Document as a node LOD (at the root level) of the specified primary GLTF asset, reading the data of their
+        /// accessors and images so that the ones identical to those of a previous LOD (e.g. shared texture coordinates, skins, animations
+        /// or textures) reference the existing element instead of being stored again. Buffer views and buffers that are only used by
+        /// such elements are left out. Sparse accessors and compressed data are never shared.
+        /// </summary>
+        /// <returns>The primary GLTF Document with the inserted LOD node.</returns>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources of the primary glTF asset by URI;
+        /// the resources of the other LODs are found through their relative paths.</param>
+        /// <param name="docs">A vector of glTF documents to merge as LODs. The first element of the vector is assumed to be the primary LOD.</param>
+        /// <param name="screenCoveragePercentages">A vector with the screen coverage percentages corresponding to each LOD.</param>
+        /// <param name="relativePaths">A vector of relative path prefixes to the non-LOD0 LOD gltf documents. Used for finding resources in those LODs.
+        /// If not specified, all resources are assumed to be in the same directory.</param>
+        /// <param name="sharedMaterials">Whether the LODs use the materials of the primary LOD.</param>
+        /// <param name="statistics">If not null, receives the number of elements and bytes that were shared.</param>
+        static Document MergeDocumentsAsLODs(
+            std::shared_ptr<IStreamReader> streamReader,
+            const std::vector<Document>& docs,
+            const std::vector<double>& screenCoveragePercentages,
+            const std::vector<std::wstring>& relativePaths = std::vector<std::wstring>(),
+            const bool& sharedMaterials = false,
+            LODDeduplicationStatistics* statistics = nullptr);
+
+        /// <summary>
+        /// Computes suggested MSFT_screencoverage thresholds for the root nodes of the scenes of a glTF asset that have node LODs.
+        /// The screen coverage of a LOD is the fraction of the screen height covered by the bounding sphere of the root node at which
+        /// the visible triangles of the LOD reach the target density, assuming that half of the triangles face the camera and that they
+        /// cover the average projected area of the bounding box of the root node (a quarter of its surface area).
+        /// The bounds are calculated from the min and max of the position accessors and the node transforms.
+        /// </summary>
+        /// <param name="doc">The glTF document with node LODs, e.g. the result of <see cref="MergeDocumentsAsLODs" />.</param>
+        /// <param name="options">The target triangle density and screen size.</param>
+        /// <returns>A map that relates the ID of each root node with LODs to one decreasing screen coverage value per level of detail,
+        /// starting with the root node itself.</returns>
+        static std::unordered_map<std::string, std::vector<double>> ComputeScreenCoverage(const Document& doc, const ScreenCoverageOptions& options = {});
+
+        /// <summary>
+        /// Stores the screen coverage values of each root node in the MSFT_screencoverage member of its extras.
+        /// </summary>
+        /// <param name="doc">The glTF document with node LODs.</param>
+        /// <param name="screenCoveragePercentages">A map that relates node IDs to the screen coverage values of their levels of detail,
+        /// e.g. the result of <see cref="ComputeScreenCoverage" />.</param>
+        /// <returns>A new glTF Document with the screen coverage values.</returns>
+        static Document SetScreenCoverage(const Document& doc, const std::unordered_map<std::string, std::vector<double>>& screenCoveragePercentages);
+
+        /// <summary>
+        /// Attaches material LODs to the materials of a glTF asset with the MSFT_lod extension, and makes the meshes that are only
+        /// used by the node LODs of a given level reference the material LOD of the same level (or the lowest one, if the material
+        /// has fewer LODs).
+        /// </summary>
+        /// <returns>A new glTF Document with the material LODs.</returns>
+        /// <param name="doc">The glTF document that contains the materials and their LODs.</param>
+        /// <param name="materialLods">A map that relates material IDs to the IDs of their levels of detail, from highest to lowest.</param>
+        static Document AddMaterialLODs(const Document& doc, const LODMap& materialLods);
+
         /// <summary>
         /// Determines the highest number of Node LODs for a given glTF asset.
         /// </summary>
@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+#include <array>
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// The properties that identify a material regardless of its id and of the ids of its textures, extracted once
+    /// so that materials can be compared and hashed without reading their extensions again.
+    /// </summary>
+    struct MaterialSignature
+    {
+        explicit MaterialSignature(const Material& material);
+
+        bool operator==(const MaterialSignature& other) const;
+        bool operator!=(const MaterialSignature& other) const;
+
+        std::string name;
+        AlphaMode alphaMode;
+        bool doubleSided;
+        bool hasSpecularGlossiness;
+
+        // alphaCutoff, emissiveFactor, baseColorFactor, metallicFactor, the occlusion strength and the
+        // KHR_materials_pbrSpecularGlossiness diffuseFactor, glossinessFactor and specularFactor, which are 0 without the extension
+        std::array<float, 18> factors;
+
+        // Calculated from the other members on construction
+        size_t hash;
+    };
+
+    struct MaterialSignatureHash
+    {
+        size_t operator()(const MaterialSignature& signature) const
+        {
+            return signature.hash;
+        }
+    };
+
+    /// <summary>
+    /// Utilities to compare the materials of glTF assets.
+    /// </summary>
+    class GLTFMaterialUtils
+    {
+    public:
+        /// <summary>
+        /// Determines whether two materials, which may belong to different documents, have the same name and factors.
+        /// Their ids and the ids of their textures are not compared.
+        /// </summary>
+        /// <param name="material">The first material.</param>
+        /// <param name="other">The second material.</param>
+        /// <returns>True if the materials have the same <see cref="MaterialSignature" />.</returns>
+        static bool AreEquivalent(const Material& material, const Material& other);
+
+        /// <summary>
+        /// Indexes the materials of a document by signature, so that an equivalent material can be found in constant time.
+        /// When several materials are equivalent, the first one is indexed.
+        /// </summary>
+        /// <param name="doc">The document whose materials will be indexed.</param>
+        /// <returns>A map from each signature to the id of the first material that has it.</returns>
+        static std::unordered_map<MaterialSignature, std::string, MaterialSignatureHash> IndexMaterials(const Document& doc);
+    };
+}
@@ -17,6 +17,29 @@ namespace Microsoft::glTF::Toolkit
         int ColorQuantizationBits = 8;
         int GenericQuantizationBits = 12;
         int Speed = 3;
+
+        // Uses sequential encoding for every primitive, as for primitives with morph targets, so that the decoded triangles and
+        // vertices keep their order (e.g. after GLTFMeshOptimizationUtils::OptimizeMeshes) instead of the Edgebreaker traversal order
+        bool PreserveTriangleOrder = false;
+    };
+
+    /// <summary>
+    /// EXT_meshopt_compression options. Every accessor is compressed losslessly by the codec; the quantization bits select the
+    /// filters that are applied to floating point data beforehand, and 0 keeps that data lossless.
+    /// </summary>
+    struct MeshoptCompressionOptions
+    {
+        // Mantissa bits of positions, and of the translations and scales of animations (exponential filter)
+        int PositionQuantizationBits = 14;
+
+        // Mantissa bits of texture coordinates (exponential filter)
+        int TexCoordQuantizationBits = 12;
+
+        // Bits of the octahedral encoding of normals and tangents; up to 8 bits are stored as bytes, and up to 16 bits as shorts (octahedral filter)
+        int NormalQuantizationBits = 10;
+
+        // Bits of each component of the rotations of animations (quaternion filter)
+        int RotationQuantizationBits = 12;
     };
 
     /// <summary>
@@ -60,5 +83,24 @@ namespace Microsoft::glTF::Toolkit
             const Mesh & mesh,
             BufferBuilder* builder,
             std::unordered_set<std::string>& bufferViewsToRemove);
+
+        /// <summary>
+        /// Compresses the vertex attributes, indices and animation data of the document with the EXT_meshopt_compression extension,
+        /// which decodes faster than Draco. Every accessor keeps its id, and points to a new bufferView that holds the compressed data
+        /// in a new buffer, and falls back to a buffer without data for loaders that don't support the extension.
+        /// Sparse accessors, Draco compressed primitives and bufferViews that are already compressed are left as they are.
+        /// </summary>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+        /// <param name="doc">The document from which the meshes will be loaded.</param>
+        /// <param name="options">The compression options that will be used.</param>
+        /// <param name="outputDirectory">The output directory to which compressed data should be saved.</param>
+        /// <returns>
+        /// A new glTF manifest that uses the EXT_meshopt_compression extension to point to the compressed data.
+        /// </returns>
+        static Document CompressMeshesMeshopt(
+            std::shared_ptr<IStreamReader> streamReader,
+            const Document& doc,
+            MeshoptCompressionOptions options,
+            const std::string& outputDirectory);
     };
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+namespace Microsoft::glTF::Toolkit
+{
+    // The largest number of vertices a primitive with 16-bit indices can use; the index 65535 is reserved for primitive restart
+    const size_t MAX_16BIT_INDEX_VERTEX_COUNT = 65535;
+
+    /// <summary>
+    /// A part of an indexed primitive, split by <see cref="GLTFMeshIndexUtils::SplitIndices" />.
+    /// </summary>
+    struct PrimitiveSplit
+    {
+        // The indices of the part, numbered from 0 in the order in which they are first used
+        std::vector<uint32_t> Indices;
+
+        // The original vertex of each vertex of the part
+        std::vector<uint32_t> Vertices;
+    };
+
+    /// <summary>
+    /// Utilities to store the indices of the meshes in a glTF asset as 16-bit integers.
+    /// </summary>
+    class GLTFMeshIndexUtils
+    {
+    public:
+        /// <summary>
+        /// Stores the 32-bit index accessors whose largest index is below 65535 as 16-bit integers, and splits the indexed
+        /// point, line and triangle list primitives that use more vertices into primitives that each use at most 65535 of them,
+        /// with 16-bit indices, their own copy of the vertex attributes and morph targets, and the same material.
+        /// Draco compressed primitives, triangle strips and fans, and sparse or meshopt compressed indices are left as they are.
+        /// Accessors and bufferViews that are no longer used are removed.
+        /// </summary>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+        /// <param name="doc">The document from which the meshes will be loaded.</param>
+        /// <param name="outputDirectory">The output directory to which the new indices and vertex attributes should be saved.</param>
+        /// <returns>A new glTF manifest in which every index accessor that could be converted uses 16-bit integers.</returns>
+        static Document Use16BitIndices(
+            std::shared_ptr<IStreamReader> streamReader,
+            const Document& doc,
+            const std::string& outputDirectory);
+
+        /// <summary>
+        /// Splits a list of points, lines or triangles, in order, into parts that each use at most maxVertexCount vertices.
+        /// </summary>
+        /// <param name="indices">The list of points, lines or triangles.</param>
+        /// <param name="indicesPerElement">1 for points, 2 for lines and 3 for triangles.</param>
+        /// <param name="maxVertexCount">The largest number of vertices of a part; must be at least indicesPerElement.</param>
+        /// <returns>The parts, which keep the order of the elements.</returns>
+        static std::vector<PrimitiveSplit> SplitIndices(const std::vector<uint32_t>& indices, size_t indicesPerElement, size_t maxVertexCount = MAX_16BIT_INDEX_VERTEX_COUNT);
+    };
+}
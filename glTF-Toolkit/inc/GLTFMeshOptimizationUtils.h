@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Mesh optimization options.
+    /// </summary>
+    struct MeshOptimizationOptions
+    {
+        // Number of entries of the FIFO post-transform vertex cache that triangles are ordered for, and that statistics are measured with
+        size_t CacheSize = 16;
+
+        // Clusters of triangles are reordered to reduce overdraw as long as the ACMR stays within this factor of the cache optimized order; 0 disables it
+        float OverdrawThreshold = 1.05f;
+
+        // Reorders vertices in the order in which the triangles first use them
+        bool OptimizeVertexFetch = true;
+    };
+
+    /// <summary>
+    /// Post-transform vertex cache statistics of a set of triangle lists.
+    /// </summary>
+    struct VertexCacheStatistics
+    {
+        size_t TriangleCount = 0;
+        size_t VertexCount = 0;
+        size_t CacheMisses = 0;
+
+        // Average cache miss ratio: vertices transformed per triangle, between 0.5 (ideal) and 3
+        double ACMR() const { return TriangleCount == 0 ? 0.0 : static_cast<double>(CacheMisses) / TriangleCount; }
+
+        // Average transformed to vertex ratio: vertices transformed per vertex referenced, where 1 is ideal
+        double ATVR() const { return VertexCount == 0 ? 0.0 : static_cast<double>(CacheMisses) / VertexCount; }
+    };
+
+    /// <summary>
+    /// Statistics of the primitives optimized by <see cref="GLTFMeshOptimizationUtils::OptimizeMeshes" />.
+    /// </summary>
+    struct MeshOptimizationStatistics
+    {
+        VertexCacheStatistics Before;
+        VertexCacheStatistics After;
+    };
+
+    /// <summary>
+    /// Utilities to reorder the triangles and vertices of the meshes in a glTF asset for the GPU.
+    /// </summary>
+    class GLTFMeshOptimizationUtils
+    {
+    public:
+        /// <summary>
+        /// Reorders the triangles of every indexed triangle list primitive for the post-transform vertex cache (Tipsify),
+        /// then for overdraw, then reorders their vertices in the order of first use, remapping every attribute and morph target accessor.
+        /// Vertices are only reordered when the attribute accessors are used by no other primitives, animations or skins; vertices that
+        /// aren't referenced by any triangle are kept after the others. Draco or meshopt compressed primitives are left as they are.
+        /// Run this before <see cref="GLTFMeshCompressionUtils::CompressMeshes" />, which keeps the optimized order when its
+        /// PreserveTriangleOrder option is set, and for primitives with morph targets.
+        /// </summary>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+        /// <param name="doc">The document from which the meshes will be loaded.</param>
+        /// <param name="options">The optimization options that will be used.</param>
+        /// <param name="outputDirectory">The output directory to which reordered data should be saved.</param>
+        /// <param name="statistics">If not null, receives the vertex cache statistics of the optimized primitives before and after.</param>
+        /// <returns>A new glTF manifest that points to the reordered indices and vertex attributes.</returns>
+        static Document OptimizeMeshes(
+            std::shared_ptr<IStreamReader> streamReader,
+            const Document& doc,
+            const MeshOptimizationOptions& options,
+            const std::string& outputDirectory,
+            MeshOptimizationStatistics* statistics = nullptr);
+
+        /// <summary>
+        /// Simulates a FIFO post-transform vertex cache on a triangle list.
+        /// </summary>
+        /// <param name="indices">The triangle list.</param>
+        /// <param name="vertexCount">The number of vertices; every index must be smaller.</param>
+        /// <param name="cacheSize">The number of entries of the cache.</param>
+        /// <returns>The number of triangles, of referenced vertices and of cache misses.</returns>
+        static VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize);
+
+        /// <summary>
+        /// Reorders the triangles of a triangle list to reduce the post-transform vertex cache misses, with the Tipsify algorithm
+        /// (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007).
+        /// </summary>
+        /// <param name="indices">The triangle list.</param>
+        /// <param name="vertexCount">The number of vertices; every index must be smaller.</param>
+        /// <param name="cacheSize">The number of entries of the cache.</param>
+        /// <returns>The reordered triangle list.</returns>
+        static std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize);
+
+        /// <summary>
+        /// Reorders clusters of a cache optimized triangle list so that the clusters that face outwards are drawn first.
+        /// The clusters are split as long as their ACMR stays within the threshold factor of the original ACMR.
+        /// </summary>
+        /// <param name="indices">The cache optimized triangle list.</param>
+        /// <param name="positions">Three floats per vertex.</param>
+        /// <param name="cacheSize">The number of entries of the cache.</param>
+        /// <param name="threshold">The factor by which the ACMR can grow, e.g. 1.05.</param>
+        /// <returns>The reordered triangle list.</returns>
+        static std::vector<uint32_t> OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<float>& positions, size_t cacheSize, float threshold);
+
+        /// <summary>
+        /// Renumbers the vertices of a triangle list in the order in which the triangles first use them.
+        /// </summary>
+        /// <param name="indices">The triangle list, which receives the new vertex numbers.</param>
+        /// <param name="vertexCount">The number of vertices; every index must be smaller.</param>
+        /// <returns>The new number of each vertex; unreferenced vertices are numbered last, in their original order.</returns>
+        static std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+    };
+}
@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+#include "SerializeBinary.h"
+
+namespace Microsoft::glTF::Toolkit
+{
+    extern const char* EXTENSION_KHR_MESH_QUANTIZATION;
+
+    /// <summary>
+    /// Mesh quantization options. Each attribute is stored as the smallest normalized integer type (8 or 16 bits)
+    /// that stays within its maximum error; attributes that would need more precision, or whose maximum error is 0, stay as floats.
+    /// </summary>
+    struct QuantizationOptions
+    {
+        // Maximum position error, as a fraction of the largest dimension of the mesh bounding box
+        float PositionMaxError = 1.0f / 8192.0f;
+
+        // Maximum error of each component of the unit normals and tangents
+        float NormalMaxError = 1.0f / 200.0f;
+
+        // Maximum texture coordinate error, as a fraction of the range of the coordinates that share a material and texture coordinate set
+        float TexCoordMaxError = 1.0f / 8192.0f;
+
+        // Maximum error of each component of the vertex colors
+        float ColorMaxError = 1.0f / 500.0f;
+    };
+
+    /// <summary>
+    /// Utilities to quantize the vertex attributes of the meshes in a glTF asset, following the KHR_mesh_quantization extension.
+    /// </summary>
+    class GLTFMeshQuantizationUtils
+    {
+    public:
+        /// <summary>
+        /// Quantizes the positions, normals, tangents, texture coordinates and colors of every mesh in the document
+        /// to normalized integers.
+        /// Positions are quantized relative to the bounding box of their mesh, and the dequantization transform is folded
+        /// into the nodes that instantiate the mesh (or into a new child node, when the node has children, is animated,
+        /// is a joint or holds a camera). Texture coordinates are quantized relative to their range within a material,
+        /// and the dequantization transform is folded into the KHR_texture_transform of the textures that use them.
+        /// Attributes of skinned meshes, meshes with morph targets, Draco compressed primitives and accessors that are
+        /// shared between attributes that can't use the same transform keep their original type.
+        /// </summary>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+        /// <param name="doc">The document from which the meshes will be loaded.</param>
+        /// <param name="options">The quantization options that will be used.</param>
+        /// <param name="outputDirectory">The output directory to which quantized data should be saved.</param>
+        /// <returns>
+        /// A new glTF manifest that uses the KHR_mesh_quantization extension and points to the quantized vertex attributes.
+        /// </returns>
+        static Document QuantizeMeshes(
+            std::shared_ptr<IStreamReader> streamReader,
+            const Document& doc,
+            const QuantizationOptions& options,
+            const std::string& outputDirectory);
+
+        /// <summary>
+        /// Wraps an accessor conversion strategy so that it leaves quantized vertex attributes (normalized 8 or 16-bit
+        /// integer vectors) untouched, since converting them to floats would undo the quantization.
+        /// </summary>
+        /// <param name="accessorConversion">The strategy applied to every other accessor; if null, they keep their component type.</param>
+        /// <returns>A strategy that can be passed to <see cref="SerializeBinary" />.</returns>
+        static AccessorConversionStrategy PreserveQuantizedAccessors(const AccessorConversionStrategy& accessorConversion);
+    };
+}
@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Mesh simplification options. Each primitive is simplified until it reaches its target triangle count,
+    /// or until the next edge collapse would exceed the target error, whichever comes first.
+    /// </summary>
+    struct SimplificationOptions
+    {
+        // Fraction of the triangles of each primitive to keep
+        float TargetRatio = 0.5f;
+
+        // Largest error an edge collapse may introduce, as a fraction of the largest dimension of the primitive's bounding box
+        float TargetError = 0.01f;
+
+        // Weights of the normal and texture coordinate differences, relative to the position error
+        float NormalWeight = 0.5f;
+        float TexCoordWeight = 1.0f;
+
+        // Largest number of triangles of the whole document, shared between the primitives in proportion to their triangle count; 0 disables it
+        size_t TriangleBudget = 0;
+    };
+
+    /// <summary>
+    /// Statistics of the primitives simplified by <see cref="GLTFMeshSimplificationUtils::SimplifyMeshes" />.
+    /// </summary>
+    struct SimplificationStatistics
+    {
+        size_t TrianglesBefore = 0;
+        size_t TrianglesAfter = 0;
+
+        // Largest error of the simplified primitives, as a fraction of the size of each primitive
+        float MaxError = 0.0f;
+    };
+
+    /// <summary>
+    /// Utilities to reduce the number of triangles of the meshes in a glTF asset, and generate levels of detail.
+    /// </summary>
+    class GLTFMeshSimplificationUtils
+    {
+    public:
+        /// <summary>
+        /// Simplifies every indexed triangle list primitive with float positions, with quadric error metrics
+        /// (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997) and half-edge collapses,
+        /// so that the remaining vertices keep their original attributes, skin weights and morph targets.
+        /// The cost of a collapse adds the differences of the normals and first texture coordinates to the position error.
+        /// Mesh borders and attribute seams (e.g. UV borders) can only collapse along themselves, and vertices where
+        /// they meet are locked. Draco or meshopt compressed primitives are left as they are.
+        /// </summary>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+        /// <param name="doc">The document from which the meshes will be loaded.</param>
+        /// <param name="options">The simplification options that will be used.</param>
+        /// <param name="outputDirectory">The output directory to which the simplified primitives should be saved.</param>
+        /// <param name="statistics">If not null, receives the triangle counts and the error of the simplified primitives.</param>
+        /// <returns>A new glTF manifest that points to the simplified primitives, which only keep the vertices they use.</returns>
+        static Document SimplifyMeshes(
+            std::shared_ptr<IStreamReader> streamReader,
+            const Document& doc,
+            const SimplificationOptions& options,
+            const std::string& outputDirectory,
+            SimplificationStatistics* statistics = nullptr);
+
+        /// <summary>
+        /// Generates one simplified document per level of detail, which can be passed after the original document
+        /// to <see cref="GLTFLODUtils::MergeDocumentsAsLODs" /> without relative paths.
+        /// </summary>
+        /// <param name="streamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+        /// <param name="doc">The document from which the meshes will be loaded.</param>
+        /// <param name="levels">The simplification options of each level of detail, in descending order of quality.</param>
+        /// <param name="outputDirectory">The output directory; each level is saved to a "lodN" subdirectory.</param>
+        /// <returns>The documents of the levels of detail.</returns>
+        static std::vector<Document> GenerateLODs(
+            std::shared_ptr<IStreamReader> streamReader,
+            const Document& doc,
+            const std::vector<SimplificationOptions>& levels,
+            const std::string& outputDirectory);
+
+        /// <summary>
+        /// Simplifies a triangle list with quadric error metrics and half-edge collapses.
+        /// </summary>
+        /// <param name="indices">The triangle list.</param>
+        /// <param name="positions">Three floats per vertex.</param>
+        /// <param name="attributes">attributeCount floats per vertex, compared when collapsing edges; may be empty.</param>
+        /// <param name="attributeWeights">The weight of each of the attributeCount attribute components.</param>
+        /// <param name="targetIndexCount">The index count at which simplification stops.</param>
+        /// <param name="targetError">The largest error of a collapse, as a fraction of the largest dimension of the bounding box.</param>
+        /// <param name="resultError">If not null, receives the largest error of the collapses, as a fraction of the same dimension.</param>
+        /// <returns>The simplified triangle list, which uses a subset of the original vertices.</returns>
+        static std::vector<uint32_t> SimplifyIndices(
+            const std::vector<uint32_t>& indices,
+            const std::vector<float>& positions,
+            const std::vector<float>& attributes,
+            const std::vector<float>& attributeWeights,
+            size_t targetIndexCount,
+            float targetError,
+            float* resultError = nullptr);
+    };
+}
@@ -102,6 +102,22 @@ namespace Microsoft::glTF::Toolkit
         /// </summary>
         static Document CompressAllTexturesForWindowsMR(std::shared_ptr<IStreamReader> streamReader, const Document & doc, const std::string& outputDirectory, size_t maxTextureSize = std::numeric_limits<size_t>::max(), bool retainOriginalImages = true);
 
+        /// <summary>
+        /// Generates material LODs that sample lower resolution versions of the DDS textures of each material, and attaches them
+        /// to the materials with the MSFT_lod extension using <see cref="GLTFLODUtils::AddMaterialLODs" />, so meshes of lower node LODs
+        /// reference them.
+        /// <para>Each level halves the resolution of the previous one by dropping the top level of the mip chains that were generated
+        /// by <see cref="CompressTextureAsDDS" />, without decompressing or compressing them again. Levels that would need missing mips,
+        /// or block compressed textures whose size is not a multiple of 4, keep the textures of the previous level. Textures without the
+        /// MSFT_texture_dds extension are shared with the original material.</para>
+        /// <param name="streamReader">The stream reader that will be used to get streams to each DDS image from its URI.</param>
+        /// <param name="doc">Input glTF document, with compressed textures.</param>
+        /// <param name="outputDirectory">The output directory to which the reduced DDS files should be saved.</param>
+        /// <param name="levelCount">The number of material LODs to generate, e.g. 2 for textures of 1/2 and 1/4 of the original size.</param>
+        /// <returns>Returns a new Document with the material LODs and the textures and images they use.</returns>
+        /// </summary>
+        static Document GenerateMaterialLODs(std::shared_ptr<IStreamReader> streamReader, const Document& doc, const std::string& outputDirectory, size_t levelCount = 2);
+
         /// <summary>
         /// Compresses a DirectX::ScratchImage in place using the specified compression.
         /// </summary>
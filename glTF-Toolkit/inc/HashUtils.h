@@ -0,0 +1,27 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Utilities to hash the contents of buffers.
+    /// </summary>
+    class HashUtils
+    {
+    public:
+        /// <summary>
+        /// Calculates the 64-bit xxHash (XXH64) of a block of memory.
+        /// It is a fast, non-cryptographic hash, suitable for finding identical contents; it must not be used where collisions could be forged.
+        /// </summary>
+        /// <param name="data">The block of memory to hash.</param>
+        /// <param name="byteLength">The length of the block of memory, in bytes.</param>
+        /// <param name="seed">A seed that can be used to calculate independent hashes of the same contents.</param>
+        /// <returns>The hash of the contents.</returns>
+        static uint64_t Hash64(const void* data, size_t byteLength, uint64_t seed = 0);
+    };
+}
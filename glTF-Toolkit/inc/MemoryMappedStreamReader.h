@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+#include "NativeFile.h"
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Microsoft::glTF::Toolkit
+{
+    // Appended to the URI of a GLB file to refer to its binary chunk, e.g. "asset.glb#bin"
+    extern const char* GLB_BINARY_CHUNK_FRAGMENT;
+
+    /// <summary>
+    /// A read-only view of the whole contents of a file, mapped into memory.
+    /// </summary>
+    class MemoryMappedFile
+    {
+    public:
+        /// <summary>
+        /// Maps a file into memory.
+        /// </summary>
+        /// <param name="path">The path of the file to map.</param>
+        /// <returns>The mapped file, or null if the file could not be opened or mapped (e.g. because it is empty).</returns>
+        static std::shared_ptr<const MemoryMappedFile> Open(const std::experimental::filesystem::path& path);
+
+        /// <summary>
+        /// Gets a view of a byte range of a mapped file, which keeps the whole file mapped for as long as it is referenced.
+        /// </summary>
+        /// <param name="file">The mapped file (or view of one).</param>
+        /// <param name="byteOffset">The offset of the range in the file.</param>
+        /// <param name="byteLength">The length of the range, in bytes.</param>
+        /// <returns>The view of the range, which must lie within the file.</returns>
+        static std::shared_ptr<const MemoryMappedFile> View(std::shared_ptr<const MemoryMappedFile> file, size_t byteOffset, size_t byteLength);
+
+        ~MemoryMappedFile();
+
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        /// <summary>Gets the contents of the file.</summary>
+        const uint8_t* Data() const { return m_data; }
+
+        /// <summary>Gets the length of the file, in bytes.</summary>
+        size_t Size() const { return m_size; }
+
+        /// <summary>
+        /// Gets the mapped file, which stays open for as long as it is mapped, so that ranges of it can be copied
+        /// with <see cref="NativeFile::CopyRange" /> without reading them through the mapping.
+        /// </summary>
+        const NativeFile& File() const { return *m_file; }
+
+        /// <summary>Gets the offset of the contents in <see cref="File" />, which is only non-zero for views.</summary>
+        uint64_t FileOffset() const { return m_fileOffset; }
+
+    private:
+        MemoryMappedFile(std::shared_ptr<const NativeFile> file, const uint8_t* data, size_t size);
+
+        std::shared_ptr<const NativeFile> m_file;
+        const uint8_t* m_data;
+        size_t m_size;
+        uint64_t m_fileOffset;
+
+        // The mapping a view was taken from, which owns the mapped memory; null for the mapping itself
+        std::shared_ptr<const MemoryMappedFile> m_base;
+    };
+
+    /// <summary>
+    /// A stream reader that maps each resource file into memory the first time it is requested, and serves every
+    /// subsequent request from that mapping instead of opening, seeking and reading the file again.
+    /// Files that can't be mapped are read through a regular file stream.
+    /// </summary>
+    class MemoryMappedStreamReader : public IStreamReader
+    {
+    public:
+        /// <summary>
+        /// Creates a stream reader for the resources of a glTF asset.
+        /// </summary>
+        /// <param name="baseDirectory">The directory relative URIs are resolved against, usually the one containing the asset.</param>
+        MemoryMappedStreamReader(std::experimental::filesystem::path baseDirectory);
+
+        /// <summary>
+        /// Gets a stream over the contents of a resource. Streams of mapped files read straight from the mapping.
+        /// </summary>
+        /// <param name="uri">The URI of the resource, relative to the base directory or absolute.</param>
+        std::shared_ptr<std::istream> GetInputStream(const std::string& uri) const override;
+
+        /// <summary>
+        /// Gets the memory mapping of a resource, mapping it on first use. Readers that know about this class can use it
+        /// to access resource contents in place, without going through a stream.
+        /// </summary>
+        /// <param name="uri">The URI of the resource, relative to the base directory or absolute.</param>
+        /// <returns>The mapped file, or null if it could not be mapped; the mapping stays valid for as long as it is referenced.</returns>
+        std::shared_ptr<const MemoryMappedFile> GetMapping(const std::string& uri) const;
+
+        /// <summary>
+        /// Loads the manifest of a GLB file without unpacking its resources. The GLB buffer gets the URI of the file followed
+        /// by <see cref="GLB_BINARY_CHUNK_FRAGMENT" />, which this reader serves as a view of the binary chunk, so buffer views
+        /// and the images they hold are read in place from the mapped file.
+        /// </summary>
+        /// <param name="uri">The URI of the GLB file, relative to the base directory or absolute.</param>
+        /// <returns>The deserialized manifest.</returns>
+        Document DeserializeGLB(const std::string& uri) const;
+
+    private:
+        struct GLBChunks
+        {
+            std::shared_ptr<const MemoryMappedFile> json;
+            std::shared_ptr<const MemoryMappedFile> binary;
+        };
+
+        // Maps a GLB file and finds its chunks; must be called with the mappings locked
+        GLBChunks MapGLBChunks(const std::string& uri) const;
+
+        std::experimental::filesystem::path GetPath(const std::string& uri) const;
+
+        const std::experimental::filesystem::path m_baseDirectory;
+
+        // Files that failed to map are cached as null, so they are not tried again
+        mutable std::unordered_map<std::string, std::shared_ptr<const MemoryMappedFile>> m_mappings;
+        mutable std::mutex m_mappingsMutex;
+    };
+}
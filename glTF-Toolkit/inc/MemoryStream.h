@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <streambuf>
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// A read-only stream over a block of memory that is kept alive by the stream. Reads are plain copies out of
+    /// the block, and seeks only move the read position.
+    /// </summary>
+    class MemoryStream : public std::istream
+    {
+    public:
+        /// <summary>
+        /// Creates a stream over a block of memory.
+        /// </summary>
+        /// <param name="owner">The object that owns the memory, which is kept alive for as long as the stream exists.</param>
+        /// <param name="data">The first byte of the block.</param>
+        /// <param name="byteLength">The length of the block, in bytes.</param>
+        MemoryStream(std::shared_ptr<const void> owner, const void* data, size_t byteLength) :
+            std::istream(nullptr),
+            m_buffer(static_cast<const char*>(data), byteLength),
+            m_owner(std::move(owner))
+        {
+            rdbuf(&m_buffer);
+        }
+
+    private:
+        class Buffer : public std::streambuf
+        {
+        public:
+            Buffer(const char* data, size_t byteLength)
+            {
+                auto begin = const_cast<char*>(data);
+                setg(begin, begin, begin + byteLength);
+            }
+
+        protected:
+            pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override
+            {
+                if ((which & std::ios_base::in) == 0)
+                {
+                    return pos_type(off_type(-1));
+                }
+
+                off_type base = 0;
+                if (direction == std::ios_base::cur)
+                {
+                    base = gptr() - eback();
+                }
+                else if (direction == std::ios_base::end)
+                {
+                    base = egptr() - eback();
+                }
+
+                auto position = base + offset;
+                if (position < 0 || position > egptr() - eback())
+                {
+                    return pos_type(off_type(-1));
+                }
+
+                setg(eback(), eback() + position, egptr());
+                return pos_type(position);
+            }
+
+            pos_type seekpos(pos_type position, std::ios_base::openmode which) override
+            {
+                return seekoff(off_type(position), std::ios_base::beg, which);
+            }
+        };
+
+        Buffer m_buffer;
+        std::shared_ptr<const void> m_owner;
+    };
+}
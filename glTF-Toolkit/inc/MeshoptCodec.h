@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Microsoft::glTF::Toolkit
+{
+    extern const char* EXTENSION_EXT_MESHOPT_COMPRESSION;
+
+    /// <summary>
+    /// The filters that EXT_meshopt_compression applies to the decoded data of a bufferView.
+    /// </summary>
+    enum class MeshoptFilter
+    {
+        None,
+        Octahedral,
+        Quaternion,
+        Exponential
+    };
+
+    /// <summary>
+    /// Encoder and decoder for the bitstreams of the EXT_meshopt_compression extension: the vertex codec used by the ATTRIBUTES mode,
+    /// the index codec used by the INDICES mode, and the filters that prepare floating point data for the vertex codec.
+    /// Malformed streams and unsupported parameters throw std::invalid_argument.
+    /// </summary>
+    class MeshoptCodec
+    {
+    public:
+        /// <summary>
+        /// Encodes vertex data with the ATTRIBUTES mode codec.
+        /// </summary>
+        /// <param name="vertices">The vertex data, with one element every byteStride bytes.</param>
+        /// <param name="count">The number of elements.</param>
+        /// <param name="byteStride">The size of each element; a multiple of 4 that is at most 256.</param>
+        /// <returns>The encoded data.</returns>
+        static std::vector<uint8_t> EncodeVertexBuffer(const uint8_t* vertices, size_t count, size_t byteStride);
+
+        /// <summary>
+        /// Decodes vertex data that was encoded with the ATTRIBUTES mode codec.
+        /// </summary>
+        /// <param name="destination">Receives count * byteStride bytes of vertex data.</param>
+        /// <param name="count">The number of elements.</param>
+        /// <param name="byteStride">The size of each element.</param>
+        /// <param name="buffer">The encoded data.</param>
+        /// <param name="bufferSize">The size of the encoded data, in bytes.</param>
+        static void DecodeVertexBuffer(uint8_t* destination, size_t count, size_t byteStride, const uint8_t* buffer, size_t bufferSize);
+
+        /// <summary>
+        /// Encodes an index sequence with the INDICES mode codec.
+        /// </summary>
+        /// <param name="indices">The indices.</param>
+        /// <param name="count">The number of indices.</param>
+        /// <returns>The encoded data.</returns>
+        static std::vector<uint8_t> EncodeIndexSequence(const uint32_t* indices, size_t count);
+
+        /// <summary>
+        /// Decodes an index sequence that was encoded with the INDICES mode codec.
+        /// </summary>
+        /// <param name="destination">Receives count indices of indexSize bytes each.</param>
+        /// <param name="count">The number of indices.</param>
+        /// <param name="indexSize">The size of each index: 2 or 4 bytes.</param>
+        /// <param name="buffer">The encoded data.</param>
+        /// <param name="bufferSize">The size of the encoded data, in bytes.</param>
+        static void DecodeIndexSequence(uint8_t* destination, size_t count, size_t indexSize, const uint8_t* buffer, size_t bufferSize);
+
+        /// <summary>
+        /// Encodes unit vectors with the octahedral filter, as normalized 8-bit (byteStride 4) or 16-bit (byteStride 8) integers.
+        /// </summary>
+        /// <param name="destination">Receives count * byteStride bytes.</param>
+        /// <param name="count">The number of vectors.</param>
+        /// <param name="byteStride">4 or 8.</param>
+        /// <param name="bits">The number of bits used for the octahedral coordinates, between 1 and 2 * byteStride, i.e. at most 8 or 16.</param>
+        /// <param name="data">Four floats per vector; the fourth component (e.g. the handedness of a tangent) is stored without the octahedral mapping.</param>
+        static void EncodeFilterOctahedral(uint8_t* destination, size_t count, size_t byteStride, int bits, const float* data);
+
+        /// <summary>
+        /// Encodes unit quaternions with the quaternion filter, as normalized 16-bit integers (byteStride 8).
+        /// </summary>
+        /// <param name="destination">Receives count * 8 bytes.</param>
+        /// <param name="count">The number of quaternions.</param>
+        /// <param name="bits">The number of bits used for each component, between 4 and 16.</param>
+        /// <param name="data">Four floats per quaternion, in x, y, z, w order.</param>
+        static void EncodeFilterQuaternion(uint8_t* destination, size_t count, int bits, const float* data);
+
+        /// <summary>
+        /// Encodes floats with the exponential filter, which stores each component as a mantissa of the given number of bits
+        /// with an exponent that is shared by the components of each element.
+        /// </summary>
+        /// <param name="destination">Receives count * byteStride bytes.</param>
+        /// <param name="count">The number of elements.</param>
+        /// <param name="byteStride">The size of each element: 4 bytes per component.</param>
+        /// <param name="bits">The number of bits of each mantissa, between 1 and 24.</param>
+        /// <param name="data">byteStride / 4 floats per element.</param>
+        static void EncodeFilterExponential(uint8_t* destination, size_t count, size_t byteStride, int bits, const float* data);
+
+        /// <summary>
+        /// Decodes filtered data in place, after it has been decoded by the vertex codec.
+        /// </summary>
+        /// <param name="filter">The filter that the data was encoded with.</param>
+        /// <param name="data">The filtered data, which receives the decoded values.</param>
+        /// <param name="count">The number of elements.</param>
+        /// <param name="byteStride">The size of each element.</param>
+        static void DecodeFilter(MeshoptFilter filter, uint8_t* data, size_t count, size_t byteStride);
+
+        /// <summary>
+        /// Gets the name of a filter in the EXT_meshopt_compression extension, or nullptr for MeshoptFilter::None.
+        /// </summary>
+        static const char* GetFilterName(MeshoptFilter filter);
+    };
+}
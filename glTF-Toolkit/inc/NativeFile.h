@@ -0,0 +1,136 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+#include "GLTFSDK/IStreamWriter.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// The way <see cref="NativeFile::CopyRange" /> copied a byte range.
+    /// </summary>
+    enum class FileCopyMethod
+    {
+        // The destination shares the blocks of the source (FICLONERANGE), on file systems that support it
+        Reflink,
+
+        // The kernel copied the bytes (copy_file_range)
+        CopyFileRange,
+
+        // The kernel copied the bytes (sendfile)
+        SendFile,
+
+        // The bytes were read and written through a user-space buffer
+        ReadWrite
+    };
+
+    /// <summary>
+    /// A file opened through the operating system, whose handle (a file descriptor on POSIX systems) is available,
+    /// so that byte ranges can be copied between files without going through streams.
+    /// </summary>
+    class NativeFile
+    {
+    public:
+#ifdef _WIN32
+        // A HANDLE
+        using Handle = void*;
+#else
+        using Handle = int;
+#endif
+
+        /// <summary>
+        /// Opens an existing file for reading.
+        /// </summary>
+        /// <param name="path">The path of the file to open.</param>
+        /// <returns>The file, or null if it could not be opened.</returns>
+        static std::shared_ptr<NativeFile> OpenRead(const std::experimental::filesystem::path& path);
+
+        /// <summary>
+        /// Opens a file for writing, creating it if it doesn't exist. The contents of an existing file are kept.
+        /// </summary>
+        /// <param name="path">The path of the file to open.</param>
+        /// <returns>The file, or null if it could not be opened.</returns>
+        static std::shared_ptr<NativeFile> OpenWrite(const std::experimental::filesystem::path& path);
+
+        ~NativeFile();
+
+        NativeFile(const NativeFile&) = delete;
+        NativeFile& operator=(const NativeFile&) = delete;
+
+        /// <summary>Gets the native handle of the file, which stays owned by this object.</summary>
+        Handle GetHandle() const { return m_handle; }
+
+        /// <summary>Gets the current length of the file, in bytes.</summary>
+        uint64_t GetSize() const;
+
+        /// <summary>
+        /// Truncates or extends the file to the given length. Extended ranges read as zeros.
+        /// </summary>
+        /// <param name="byteLength">The new length of the file, in bytes.</param>
+        void Resize(uint64_t byteLength) const;
+
+        /// <summary>
+        /// Copies a byte range of a file to a range of another one without holding it in memory. On Linux, the destination
+        /// shares the blocks of the source when the file system supports reflinks and the range is block-aligned; otherwise
+        /// the bytes are copied by the kernel with copy_file_range, or sendfile. Other systems, and file systems where those
+        /// calls fail, fall back to positional reads and writes through a fixed-size buffer.
+        /// </summary>
+        /// <param name="source">The file to copy from.</param>
+        /// <param name="sourceOffset">The offset of the range in the source file.</param>
+        /// <param name="destination">The file to copy to, which must have been opened for writing.</param>
+        /// <param name="destinationOffset">The offset the range is copied to; a gap after the end of the destination reads as zeros.</param>
+        /// <param name="byteLength">The length of the range, in bytes.</param>
+        /// <returns>The method that copied the last part of the range.</returns>
+        static FileCopyMethod CopyRange(const NativeFile& source, uint64_t sourceOffset, const NativeFile& destination, uint64_t destinationOffset, uint64_t byteLength);
+
+    private:
+        NativeFile(Handle handle);
+
+        Handle m_handle;
+    };
+
+    /// <summary>
+    /// A stream writer whose output streams are files, and that can open those files natively, so that byte ranges of other
+    /// files can be copied into them with <see cref="NativeFile::CopyRange" /> instead of being written through the streams.
+    /// </summary>
+    class IFileStreamWriter : public IStreamWriter
+    {
+    public:
+        /// <summary>
+        /// Opens the file written by the output stream of a URI for writing, without truncating it.
+        /// The output stream must write the file from its beginning.
+        /// </summary>
+        /// <param name="uri">The URI passed to GetOutputStream.</param>
+        /// <returns>The file, or null if it can't be opened natively.</returns>
+        virtual std::shared_ptr<NativeFile> GetOutputFile(const std::string& uri) const = 0;
+    };
+
+    /// <summary>
+    /// A stream writer that saves each output stream to a file in a directory, named after its URI.
+    /// Empty URIs, which a GLB writer uses for its single output stream, are rejected rather than resolved to the directory itself.
+    /// </summary>
+    class FileStreamWriter : public IFileStreamWriter
+    {
+    public:
+        /// <summary>
+        /// Creates a stream writer that saves its files to a directory.
+        /// </summary>
+        /// <param name="baseDirectory">The directory relative URIs are resolved against.</param>
+        FileStreamWriter(std::experimental::filesystem::path baseDirectory);
+
+        std::shared_ptr<std::ostream> GetOutputStream(const std::string& uri) const override;
+
+        std::shared_ptr<NativeFile> GetOutputFile(const std::string& uri) const override;
+
+    private:
+        std::experimental::filesystem::path GetPath(const std::string& uri) const;
+
+        const std::experimental::filesystem::path m_baseDirectory;
+    };
+}
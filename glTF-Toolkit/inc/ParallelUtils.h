@@ -0,0 +1,222 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Utilities to run independent pieces of work on a pool of worker threads.
+    /// </summary>
+    class ParallelUtils
+    {
+    public:
+        /// <summary>
+        /// Resolves a requested thread count to the number of threads that will be used.
+        /// </summary>
+        /// <param name="requestedThreadCount">The requested number of threads, or 0 to use one thread per hardware thread.</param>
+        /// <returns>The number of threads to use, always at least 1.</returns>
+        static size_t GetThreadCount(size_t requestedThreadCount)
+        {
+            if (requestedThreadCount == 0)
+            {
+                requestedThreadCount = std::thread::hardware_concurrency();
+            }
+
+            return std::max<size_t>(requestedThreadCount, 1);
+        }
+
+        // Note: XML Documentation cannot be applied to templated types per https://docs.microsoft.com/en-us/cpp/ide/xml-documentation-visual-cpp
+        // Calls work(i) for every i in [0, count), spreading the calls over up to threadCount threads (including the calling thread).
+        // Indices are handed out in increasing order, but calls may complete in any order, so work must only write to state owned by its index.
+        // If any call throws, no further indices are started and the first exception is rethrown on the calling thread.
+        template <typename Work>
+        static void For(size_t count, size_t threadCount, Work work)
+        {
+            threadCount = std::min(GetThreadCount(threadCount), count);
+            if (threadCount <= 1)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    work(i);
+                }
+                return;
+            }
+
+            std::atomic<size_t> next(0);
+            std::atomic<bool> failed(false);
+            std::exception_ptr firstException;
+            std::mutex exceptionMutex;
+
+            auto worker = [&]()
+            {
+                for (size_t i = next++; i < count && !failed; i = next++)
+                {
+                    try
+                    {
+                        work(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(exceptionMutex);
+                        if (!failed.exchange(true))
+                        {
+                            firstException = std::current_exception();
+                        }
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount - 1);
+            for (size_t t = 1; t < threadCount; t++)
+            {
+                threads.emplace_back(worker);
+            }
+
+            worker();
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            if (firstException)
+            {
+                std::rethrow_exception(firstException);
+            }
+        }
+
+        // Calls produce(i) for every i in [0, count) on up to threadCount worker threads, and consume(i, result) on the calling thread,
+        // in increasing order of i. The workers run for the whole call, and produce at most windowSize results ahead of the last
+        // consumed one, so at most windowSize results are held at any time. A slow result only stalls the workers once the window
+        // behind it is full.
+        // If any call throws, no further indices are started and the first exception is rethrown on the calling thread.
+        template <typename Result, typename Produce, typename Consume>
+        static void ForOrdered(size_t count, size_t threadCount, size_t windowSize, Produce produce, Consume consume)
+        {
+            threadCount = std::min(GetThreadCount(threadCount), count);
+            if (threadCount <= 1)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    consume(i, produce(i));
+                }
+                return;
+            }
+
+            windowSize = std::max(windowSize, threadCount);
+            std::vector<Result> window(windowSize);
+            std::vector<bool> produced(windowSize, false);
+            size_t next = 0;
+            size_t consumed = 0;
+            bool failed = false;
+            std::exception_ptr firstException;
+            std::mutex mutex;
+            std::condition_variable resultProduced;
+            std::condition_variable resultConsumed;
+
+            // Must be called with the mutex locked
+            auto fail = [&]()
+            {
+                if (!failed)
+                {
+                    failed = true;
+                    firstException = std::current_exception();
+                }
+                resultProduced.notify_all();
+                resultConsumed.notify_all();
+            };
+
+            auto worker = [&]()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true)
+                {
+                    resultConsumed.wait(lock, [&]() { return failed || next >= count || next < consumed + windowSize; });
+                    if (failed || next >= count)
+                    {
+                        return;
+                    }
+
+                    auto i = next++;
+                    lock.unlock();
+
+                    try
+                    {
+                        Result result = produce(i);
+
+                        lock.lock();
+                        window[i % windowSize] = std::move(result);
+                        produced[i % windowSize] = true;
+                        resultProduced.notify_all();
+                    }
+                    catch (...)
+                    {
+                        if (!lock.owns_lock())
+                        {
+                            lock.lock();
+                        }
+                        fail();
+                        return;
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount);
+            for (size_t t = 0; t < threadCount; t++)
+            {
+                threads.emplace_back(worker);
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                Result result;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    resultProduced.wait(lock, [&]() { return failed || produced[i % windowSize]; });
+                    if (failed)
+                    {
+                        break;
+                    }
+
+                    result = std::move(window[i % windowSize]);
+                    window[i % windowSize] = Result();
+                    produced[i % windowSize] = false;
+                    consumed++;
+                    resultConsumed.notify_all();
+                }
+
+                try
+                {
+                    consume(i, std::move(result));
+                }
+                catch (...)
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    fail();
+                    break;
+                }
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            if (firstException)
+            {
+                std::rethrow_exception(firstException);
+            }
+        }
+    };
+}
@@ -1,5 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See LICENSE in the project root for license information.#pragma once
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
 
 #include "GLTFSDK.h"
 
@@ -17,14 +19,59 @@ namespace Microsoft::glTF::Toolkit
     /// </summary>
     typedef std::function<ComponentType(const Accessor&)> AccessorConversionStrategy;
 
+    /// <summary>Options that control how a glTF asset is serialized as GLB.</summary>
+    struct SerializeBinaryOptions
+    {
+        // Determines to which type each accessor is converted; if null, accessors keep their component type
+        AccessorConversionStrategy AccessorConversion = nullptr;
+
+        // The number of threads used to read, convert and calculate the bounds of resources; 0 uses one thread per hardware thread.
+        // Resources are always appended to the binary chunk in the same order, so the output does not depend on this value.
+        size_t ThreadCount = 1;
+
+        // Whether accessors and images with identical contents share a single bufferView. Every payload is hashed before
+        // the manifest is written, so images and accessors that are copied as they are get read once more than without deduplication.
+        bool DeduplicateBuffers = false;
+
+        // Whether the vertex attributes of each primitive are written to a single bufferView, one vertex after the other,
+        // instead of one bufferView per attribute. Indices and morph targets keep bufferViews of their own, as do attributes
+        // shared with another primitive; they are interleaved with the first primitive that uses them.
+        bool InterleaveVertexAttributes = false;
+    };
+
+    /// <summary>Statistics collected while serializing a glTF asset as GLB.</summary>
+    struct SerializeBinaryStatistics
+    {
+        // The length of the binary chunk of the GLB file, in bytes
+        size_t BinaryChunkByteLength = 0;
+
+        // The largest number of bytes of buffer, image and accessor data held in memory at any one time
+        size_t PeakBytesHeld = 0;
+
+        // The number of accessors whose bytes were copied as they are, without being decoded and converted
+        size_t PassthroughAccessorCount = 0;
+
+        // The number of accessors and images that reuse the bufferView of an identical one, when deduplicating
+        size_t DeduplicatedBufferViewCount = 0;
+
+        // The number of bytes that were not written thanks to deduplication
+        size_t DeduplicatedByteLength = 0;
+
+        // The number of bufferViews holding the interleaved vertex attributes of a primitive
+        size_t InterleavedBufferViewCount = 0;
+    };
+
     /// <summary>
     /// Serializes a glTF asset as a glTF binary (GLB) file.
+    /// The layout of the binary chunk is planned from the document before the manifest is written, and each
+    /// resource is then streamed to the output, so the binary chunk is never held in memory as a whole.
     /// </summary>
     /// <param name="Document">The glTF asset manifest to be serialized.</param>
     /// <param name="inputStreamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
     /// <param name="outputStreamFactory">A stream factory that is capable of creating an output stream where the GLB will be saved, and a temporary stream for
     /// use during the serialization process.</param>
-    void SerializeBinary(const Document& document, std::shared_ptr<const IStreamReader> inputStreamReader, std::shared_ptr<const IStreamWriter> outputStreamWriter, const AccessorConversionStrategy& accessorConversion = nullptr);
+    /// <param name="statistics">If not null, receives statistics about the serialization.</param>
+    void SerializeBinary(const Document& document, std::shared_ptr<const IStreamReader> inputStreamReader, std::shared_ptr<const IStreamWriter> outputStreamWriter, const AccessorConversionStrategy& accessorConversion = nullptr, SerializeBinaryStatistics* statistics = nullptr);
 
     /// <summary>
     /// Serializes a glTF asset as a glTF binary (GLB) file.
@@ -33,5 +80,27 @@ namespace Microsoft::glTF::Toolkit
     /// <param name="resourceReader">A resource reader that is capable of accessing the resources used in the document.</param>
     /// <param name="outputStreamFactory">A stream factory that is capable of creating an output stream where the GLB will be saved, and a temporary stream for
     /// use during the serialization process.</param>
-    void SerializeBinary(const Document& document, const GLTFResourceReader& resourceReader, std::shared_ptr<const IStreamWriter> outputStreamWriter, const AccessorConversionStrategy& accessorConversion = nullptr);
+    /// <param name="statistics">If not null, receives statistics about the serialization.</param>
+    void SerializeBinary(const Document& document, const GLTFResourceReader& resourceReader, std::shared_ptr<const IStreamWriter> outputStreamWriter, const AccessorConversionStrategy& accessorConversion = nullptr, SerializeBinaryStatistics* statistics = nullptr);
+
+    /// <summary>
+    /// Serializes a glTF asset as a glTF binary (GLB) file.
+    /// </summary>
+    /// <param name="Document">The glTF asset manifest to be serialized.</param>
+    /// <param name="inputStreamReader">A stream reader that is capable of accessing the resources used in the glTF asset by URI.</param>
+    /// <param name="outputStreamWriter">A stream writer that is capable of creating an output stream where the GLB will be saved.</param>
+    /// <param name="options">The options used to serialize the asset.</param>
+    /// <param name="statistics">If not null, receives statistics about the serialization.</param>
+    void SerializeBinary(const Document& document, std::shared_ptr<const IStreamReader> inputStreamReader, std::shared_ptr<const IStreamWriter> outputStreamWriter, const SerializeBinaryOptions& options, SerializeBinaryStatistics* statistics = nullptr);
+
+    /// <summary>
+    /// Serializes a glTF asset as a glTF binary (GLB) file.
+    /// Reads from the resource reader are never made concurrently, since it may be backed by a single stream.
+    /// </summary>
+    /// <param name="Document">The glTF asset manifest to be serialized.</param>
+    /// <param name="resourceReader">A resource reader that is capable of accessing the resources used in the document.</param>
+    /// <param name="outputStreamWriter">A stream writer that is capable of creating an output stream where the GLB will be saved.</param>
+    /// <param name="options">The options used to serialize the asset.</param>
+    /// <param name="statistics">If not null, receives statistics about the serialization.</param>
+    void SerializeBinary(const Document& document, const GLTFResourceReader& resourceReader, std::shared_ptr<const IStreamWriter> outputStreamWriter, const SerializeBinaryOptions& options, SerializeBinaryStatistics* statistics = nullptr);
 }
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+#include "GLTFSDK/IStreamWriter.h"
+#include "NativeFile.h"
+
+#include <memory>
+#include <string>
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Writes a glTF binary (GLB) file in two phases, so that the binary chunk never has to be held in memory.
+    /// First, every payload in the binary chunk is reserved with <see cref="Reserve" />, which assigns its final offset.
+    /// Once the manifest that references those offsets has been written with <see cref="WriteManifest" />,
+    /// each payload is streamed straight to the output with <see cref="WritePayload" />, in the order it was reserved.
+    /// </summary>
+    class StreamingGLBWriter
+    {
+    public:
+        /// <summary>
+        /// Creates a writer that will save the GLB file to the stream returned by the supplied stream writer.
+        /// </summary>
+        /// <param name="streamWriter">A stream writer that is capable of creating the output stream where the GLB will be saved. The stream is requested with an empty URI.</param>
+        StreamingGLBWriter(std::shared_ptr<const IStreamWriter> streamWriter);
+
+        /// <summary>
+        /// Reserves space for a payload at the end of the binary chunk.
+        /// </summary>
+        /// <param name="byteLength">The length of the payload, in bytes.</param>
+        /// <returns>The offset of the payload in the binary chunk, aligned to GLB_BUFFER_OFFSET_ALIGNMENT.</returns>
+        size_t Reserve(size_t byteLength);
+
+        /// <summary>
+        /// Gets the total length of the payloads reserved so far, in bytes.
+        /// </summary>
+        size_t GetBinaryChunkByteLength() const;
+
+        /// <summary>
+        /// Writes the GLB header, the JSON chunk and the header of the binary chunk.
+        /// No more payloads can be reserved once the manifest has been written.
+        /// </summary>
+        /// <param name="manifest">The serialized glTF manifest.</param>
+        void WriteManifest(const std::string& manifest);
+
+        /// <summary>
+        /// Writes a payload to its reserved range of the binary chunk.
+        /// Payloads must be written in increasing offset order; any gap before the payload is filled with zeros.
+        /// </summary>
+        /// <param name="byteOffset">The offset returned by <see cref="Reserve" /> for this payload.</param>
+        /// <param name="data">The payload contents.</param>
+        /// <param name="byteLength">The length of the payload, which must match the reserved length.</param>
+        void WritePayload(size_t byteOffset, const void* data, size_t byteLength);
+
+        /// <summary>
+        /// Writes a payload whose contents are a range of a file to its reserved range of the binary chunk.
+        /// If the stream writer is an <see cref="IFileStreamWriter" /> that could open the output file, the range is copied by the
+        /// operating system with <see cref="NativeFile::CopyRange" />, without reading the contents; otherwise they are written from data.
+        /// </summary>
+        /// <param name="byteOffset">The offset returned by <see cref="Reserve" /> for this payload.</param>
+        /// <param name="data">The payload contents, which must match the contents of the source range.</param>
+        /// <param name="byteLength">The length of the payload, which must match the reserved length.</param>
+        /// <param name="source">The file the payload is a range of.</param>
+        /// <param name="sourceOffset">The offset of the payload in the source file.</param>
+        void WriteFilePayload(size_t byteOffset, const void* data, size_t byteLength, const NativeFile& source, uint64_t sourceOffset);
+
+        /// <summary>
+        /// Pads the binary chunk up to its planned length and flushes the output stream.
+        /// </summary>
+        void Finish();
+
+    private:
+        void CheckPayloadRange(size_t byteOffset, size_t byteLength) const;
+        void WritePadding(size_t byteLength);
+
+        std::shared_ptr<const IStreamWriter> m_streamWriter;
+        std::shared_ptr<std::ostream> m_stream;
+        std::shared_ptr<NativeFile> m_outputFile;
+        size_t m_binaryChunkStart;
+        size_t m_binaryChunkByteLength;
+        size_t m_binaryChunkPosition;
+    };
+}
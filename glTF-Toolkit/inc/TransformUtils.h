@@ -0,0 +1,60 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "GLTFSDK.h"
+
+#include <array>
+
+namespace Microsoft::glTF::Toolkit
+{
+    /// <summary>
+    /// Utilities to compose the transforms of the nodes in a glTF asset.
+    /// </summary>
+    class TransformUtils
+    {
+    public:
+        // An affine transform, as a column-major 4x4 matrix
+        typedef std::array<double, 16> Transform;
+
+        static const Transform Identity;
+
+        /// <summary>
+        /// Composes two transforms.
+        /// </summary>
+        /// <param name="a">The outer transform, e.g. the transform of a parent node.</param>
+        /// <param name="b">The inner transform, e.g. the local transform of a child node.</param>
+        /// <returns>The transform that applies b, then a.</returns>
+        static Transform Multiply(const Transform& a, const Transform& b);
+
+        /// <summary>
+        /// Gets the transform of a node relative to its parent, from either its matrix or its translation, rotation and scale.
+        /// </summary>
+        /// <param name="node">The node.</param>
+        /// <returns>The local transform of the node.</returns>
+        static Transform GetLocalTransform(const Node& node);
+
+        /// <summary>
+        /// Transforms a point.
+        /// </summary>
+        /// <param name="transform">The transform to apply.</param>
+        /// <param name="point">The point to transform.</param>
+        /// <returns>The transformed point.</returns>
+        static std::array<double, 3> TransformPoint(const Transform& transform, const std::array<double, 3>& point);
+
+        /// <summary>
+        /// Gets the cofactor matrix of the upper 3x3 part of a transform, which transforms normals up to their scale and sign.
+        /// </summary>
+        /// <param name="transform">The transform.</param>
+        /// <returns>The cofactors, as a row-major 3x3 matrix.</returns>
+        static std::array<double, 9> GetCofactors(const Transform& transform);
+
+        /// <summary>
+        /// Gets the determinant of the upper 3x3 part of a transform, which is negative when the transform mirrors.
+        /// </summary>
+        /// <param name="transform">The transform.</param>
+        /// <returns>The determinant.</returns>
+        static double GetDeterminant(const Transform& transform);
+    };
+}
@@ -0,0 +1,510 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "AccessorUtils.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TOOLKIT_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// MSVC emits AVX2 instructions in any function, but GCC and Clang only in functions compiled for that target
+#ifdef _MSC_VER
+#define TOOLKIT_TARGET_AVX2
+#define TOOLKIT_TARGET_AVX2_FLATTEN
+#else
+#define TOOLKIT_TARGET_AVX2 __attribute__((target("avx2")))
+#define TOOLKIT_TARGET_AVX2_FLATTEN __attribute__((target("avx2"), flatten))
+#endif
+#endif
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    // Each vectorized kernel keeps a running min and max per lane. Lane j of register r always holds component
+    // (r * Lanes + j) % typeCount, so for VEC3 three registers are processed per iteration, and one for the other types.
+    const size_t MaxRegistersPerIteration = 3;
+
+    template <typename T>
+    T ScalarMin(T current, T min)
+    {
+        return current < min ? current : min;
+    }
+
+    template <typename T>
+    T ScalarMax(T current, T max)
+    {
+        return max < current ? current : max;
+    }
+
+    // Calculates the min and max of each component, in the component type itself; the caller converts the results to float.
+    // Operations provides the vector type, the number of lanes, and Load/Store/Min/Max for one component type.
+    // Min and Max take the new value first, so that, like the scalar loop, a NaN never replaces a bound.
+    template <typename Operations, typename T>
+    void CalculateMinMaxKernel(const T* data, size_t elementCount, size_t typeCount, T* min, T* max)
+    {
+        const size_t lanes = Operations::Lanes;
+        const size_t registers = (lanes % typeCount == 0) ? 1 : typeCount;
+        const size_t componentsPerIteration = registers * lanes;
+        const size_t componentCount = elementCount * typeCount;
+
+        for (size_t j = 0; j < typeCount; j++)
+        {
+            min[j] = data[j];
+            max[j] = data[j];
+        }
+
+        size_t i = 0;
+        if (componentCount >= componentsPerIteration)
+        {
+            typename Operations::Vector vectorMin[MaxRegistersPerIteration];
+            typename Operations::Vector vectorMax[MaxRegistersPerIteration];
+            for (size_t r = 0; r < registers; r++)
+            {
+                vectorMin[r] = vectorMax[r] = Operations::Load(data + r * lanes);
+            }
+
+            for (i = componentsPerIteration; i + componentsPerIteration <= componentCount; i += componentsPerIteration)
+            {
+                for (size_t r = 0; r < registers; r++)
+                {
+                    auto current = Operations::Load(data + i + r * lanes);
+                    vectorMin[r] = Operations::Min(current, vectorMin[r]);
+                    vectorMax[r] = Operations::Max(current, vectorMax[r]);
+                }
+            }
+
+            // Fold the lanes into the per-component bounds
+            T laneMin[MaxRegistersPerIteration * lanes];
+            T laneMax[MaxRegistersPerIteration * lanes];
+            for (size_t r = 0; r < registers; r++)
+            {
+                Operations::Store(laneMin + r * lanes, vectorMin[r]);
+                Operations::Store(laneMax + r * lanes, vectorMax[r]);
+            }
+
+            for (size_t k = 0; k < componentsPerIteration; k++)
+            {
+                auto component = k % typeCount;
+                min[component] = ScalarMin(laneMin[k], min[component]);
+                max[component] = ScalarMax(laneMax[k], max[component]);
+            }
+        }
+
+        // Remaining components; i is always a multiple of typeCount here
+        for (; i < componentCount; i++)
+        {
+            auto component = i % typeCount;
+            min[component] = ScalarMin(data[i], min[component]);
+            max[component] = ScalarMax(data[i], max[component]);
+        }
+    }
+
+#ifdef TOOLKIT_SIMD_X86
+    // SSE2 only has unsigned 8-bit and signed 16-bit integer min/max, so the other integer types are biased
+    // (by flipping their sign bit) into the type that has them when loaded, and back when stored.
+    template <typename T, typename Biased, int Bias>
+    struct SSE2BiasedOperations
+    {
+        typedef __m128i Vector;
+        static const size_t Lanes = 16 / sizeof(T);
+
+        static __m128i BiasVector()
+        {
+            return sizeof(T) == 1 ? _mm_set1_epi8(static_cast<char>(Bias)) : _mm_set1_epi16(static_cast<short>(Bias));
+        }
+
+        static __m128i Load(const T* data) { return _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), BiasVector()); }
+        static void Store(T* data, __m128i value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm_xor_si128(value, BiasVector())); }
+        static __m128i Min(__m128i a, __m128i b) { return sizeof(T) == 1 ? _mm_min_epu8(a, b) : _mm_min_epi16(a, b); }
+        static __m128i Max(__m128i a, __m128i b) { return sizeof(T) == 1 ? _mm_max_epu8(a, b) : _mm_max_epi16(a, b); }
+    };
+
+    typedef SSE2BiasedOperations<int8_t, uint8_t, 0x80> SSE2Int8Operations;
+    typedef SSE2BiasedOperations<uint8_t, uint8_t, 0> SSE2UInt8Operations;
+    typedef SSE2BiasedOperations<int16_t, int16_t, 0> SSE2Int16Operations;
+    typedef SSE2BiasedOperations<uint16_t, int16_t, 0x8000> SSE2UInt16Operations;
+
+    // SSE2 has no 32-bit integer min/max at all: compare as signed after biasing, and select.
+    struct SSE2UInt32Operations
+    {
+        typedef __m128i Vector;
+        static const size_t Lanes = 4;
+
+        static __m128i Load(const uint32_t* data) { return _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), _mm_set1_epi32(INT32_MIN)); }
+        static void Store(uint32_t* data, __m128i value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm_xor_si128(value, _mm_set1_epi32(INT32_MIN))); }
+
+        static __m128i Min(__m128i a, __m128i b)
+        {
+            auto aGreater = _mm_cmpgt_epi32(a, b);
+            return _mm_or_si128(_mm_and_si128(aGreater, b), _mm_andnot_si128(aGreater, a));
+        }
+
+        static __m128i Max(__m128i a, __m128i b)
+        {
+            auto aGreater = _mm_cmpgt_epi32(a, b);
+            return _mm_or_si128(_mm_and_si128(aGreater, a), _mm_andnot_si128(aGreater, b));
+        }
+    };
+
+    struct SSE2FloatOperations
+    {
+        typedef __m128 Vector;
+        static const size_t Lanes = 4;
+
+        static __m128 Load(const float* data) { return _mm_loadu_ps(data); }
+        static void Store(float* data, __m128 value) { _mm_storeu_ps(data, value); }
+        static __m128 Min(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+        static __m128 Max(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+    };
+
+    // AVX2 has min/max for every integer component type.
+    template <typename T>
+    struct AVX2IntegerOperations
+    {
+        typedef __m256i Vector;
+        static const size_t Lanes = 32 / sizeof(T);
+
+        static TOOLKIT_TARGET_AVX2 __m256i Load(const T* data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)); }
+        static TOOLKIT_TARGET_AVX2 void Store(T* data, __m256i value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), value); }
+        static TOOLKIT_TARGET_AVX2 __m256i Min(__m256i a, __m256i b);
+        static TOOLKIT_TARGET_AVX2 __m256i Max(__m256i a, __m256i b);
+    };
+
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<int8_t>::Min(__m256i a, __m256i b) { return _mm256_min_epi8(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<int8_t>::Max(__m256i a, __m256i b) { return _mm256_max_epi8(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<uint8_t>::Min(__m256i a, __m256i b) { return _mm256_min_epu8(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<uint8_t>::Max(__m256i a, __m256i b) { return _mm256_max_epu8(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<int16_t>::Min(__m256i a, __m256i b) { return _mm256_min_epi16(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<int16_t>::Max(__m256i a, __m256i b) { return _mm256_max_epi16(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<uint16_t>::Min(__m256i a, __m256i b) { return _mm256_min_epu16(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<uint16_t>::Max(__m256i a, __m256i b) { return _mm256_max_epu16(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<uint32_t>::Min(__m256i a, __m256i b) { return _mm256_min_epu32(a, b); }
+    template <> TOOLKIT_TARGET_AVX2 __m256i AVX2IntegerOperations<uint32_t>::Max(__m256i a, __m256i b) { return _mm256_max_epu32(a, b); }
+
+    struct AVX2FloatOperations
+    {
+        typedef __m256 Vector;
+        static const size_t Lanes = 8;
+
+        static TOOLKIT_TARGET_AVX2 __m256 Load(const float* data) { return _mm256_loadu_ps(data); }
+        static TOOLKIT_TARGET_AVX2 void Store(float* data, __m256 value) { _mm256_storeu_ps(data, value); }
+        static TOOLKIT_TARGET_AVX2 __m256 Min(__m256 a, __m256 b) { return _mm256_min_ps(a, b); }
+        static TOOLKIT_TARGET_AVX2 __m256 Max(__m256 a, __m256 b) { return _mm256_max_ps(a, b); }
+    };
+
+    // Every AVX2 operation is inlined into this instantiation of the kernel, so that all of it is compiled for AVX2
+    template <typename Operations, typename T>
+    TOOLKIT_TARGET_AVX2_FLATTEN void CalculateMinMaxKernelAVX2(const T* data, size_t elementCount, size_t typeCount, T* min, T* max)
+    {
+        CalculateMinMaxKernel<Operations>(data, elementCount, typeCount, min, max);
+    }
+
+    AccessorUtils::InstructionSet DetectInstructionSet()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        auto maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool sse2 = (info[3] & (1 << 26)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        // AVX registers are only usable if the OS saves them on context switches
+        bool avxEnabled = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+
+        bool avx2 = false;
+        if (maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        bool sse2 = __builtin_cpu_supports("sse2");
+        bool avxEnabled = __builtin_cpu_supports("avx");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+        if (avxEnabled && avx2)
+        {
+            return AccessorUtils::InstructionSet::AVX2;
+        }
+
+        return sse2 ? AccessorUtils::InstructionSet::SSE2 : AccessorUtils::InstructionSet::Scalar;
+    }
+#endif
+
+    template <typename SSE2Operations, typename AVX2Operations, typename T>
+    bool CalculateMinMaxWith(AccessorUtils::InstructionSet instructionSet, const T* data, size_t elementCount, size_t typeCount, float* min, float* max)
+    {
+#ifdef TOOLKIT_SIMD_X86
+        // Only the SCALAR, VEC2, VEC3 and VEC4 layouts are vectorized
+        if (typeCount < 1 || typeCount > 4 || elementCount == 0)
+        {
+            return false;
+        }
+
+        instructionSet = std::min(instructionSet, AccessorUtils::GetSupportedInstructionSet());
+
+        T componentMin[4];
+        T componentMax[4];
+        switch (instructionSet)
+        {
+        case AccessorUtils::InstructionSet::AVX2:
+            CalculateMinMaxKernelAVX2<AVX2Operations>(data, elementCount, typeCount, componentMin, componentMax);
+            break;
+        case AccessorUtils::InstructionSet::SSE2:
+            CalculateMinMaxKernel<SSE2Operations>(data, elementCount, typeCount, componentMin, componentMax);
+            break;
+        default:
+            return false;
+        }
+
+        for (size_t j = 0; j < typeCount; j++)
+        {
+            min[j] = static_cast<float>(componentMin[j]);
+            max[j] = static_cast<float>(componentMax[j]);
+        }
+
+        return true;
+#else
+        (void)instructionSet; (void)data; (void)elementCount; (void)typeCount; (void)min; (void)max;
+        return false;
+#endif
+    }
+}
+
+AccessorUtils::InstructionSet AccessorUtils::GetSupportedInstructionSet()
+{
+#ifdef TOOLKIT_SIMD_X86
+    static const InstructionSet supportedInstructionSet = DetectInstructionSet();
+    return supportedInstructionSet;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+#ifdef TOOLKIT_SIMD_X86
+#define TOOLKIT_MINMAX_OPERATIONS(SSE2Operations, AVX2Operations) SSE2Operations, AVX2Operations
+#else
+#define TOOLKIT_MINMAX_OPERATIONS(SSE2Operations, AVX2Operations) void, void
+#endif
+
+bool AccessorUtils::CalculateMinMaxVectorized(InstructionSet instructionSet, const int8_t* data, size_t elementCount, size_t typeCount, float* min, float* max)
+{
+    return CalculateMinMaxWith<TOOLKIT_MINMAX_OPERATIONS(SSE2Int8Operations, AVX2IntegerOperations<int8_t>)>(instructionSet, data, elementCount, typeCount, min, max);
+}
+
+bool AccessorUtils::CalculateMinMaxVectorized(InstructionSet instructionSet, const uint8_t* data, size_t elementCount, size_t typeCount, float* min, float* max)
+{
+    return CalculateMinMaxWith<TOOLKIT_MINMAX_OPERATIONS(SSE2UInt8Operations, AVX2IntegerOperations<uint8_t>)>(instructionSet, data, elementCount, typeCount, min, max);
+}
+
+bool AccessorUtils::CalculateMinMaxVectorized(InstructionSet instructionSet, const int16_t* data, size_t elementCount, size_t typeCount, float* min, float* max)
+{
+    return CalculateMinMaxWith<TOOLKIT_MINMAX_OPERATIONS(SSE2Int16Operations, AVX2IntegerOperations<int16_t>)>(instructionSet, data, elementCount, typeCount, min, max);
+}
+
+bool AccessorUtils::CalculateMinMaxVectorized(InstructionSet instructionSet, const uint16_t* data, size_t elementCount, size_t typeCount, float* min, float* max)
+{
+    return CalculateMinMaxWith<TOOLKIT_MINMAX_OPERATIONS(SSE2UInt16Operations, AVX2IntegerOperations<uint16_t>)>(instructionSet, data, elementCount, typeCount, min, max);
+}
+
+bool AccessorUtils::CalculateMinMaxVectorized(InstructionSet instructionSet, const uint32_t* data, size_t elementCount, size_t typeCount, float* min, float* max)
+{
+    return CalculateMinMaxWith<TOOLKIT_MINMAX_OPERATIONS(SSE2UInt32Operations, AVX2IntegerOperations<uint32_t>)>(instructionSet, data, elementCount, typeCount, min, max);
+}
+
+bool AccessorUtils::CalculateMinMaxVectorized(InstructionSet instructionSet, const float* data, size_t elementCount, size_t typeCount, float* min, float* max)
+{
+    return CalculateMinMaxWith<TOOLKIT_MINMAX_OPERATIONS(SSE2FloatOperations, AVX2FloatOperations)>(instructionSet, data, elementCount, typeCount, min, max);
+}
+
+namespace
+{
+    // Maps a normalized integer to [0, 1] (unsigned) or [-1, 1] (signed), as defined by the glTF 2.0 specification.
+    template <typename T>
+    double Normalize(T value)
+    {
+        auto normalized = static_cast<double>(value) / static_cast<double>(std::numeric_limits<T>::max());
+        if constexpr (std::is_signed<T>::value)
+        {
+            normalized = std::max(normalized, -1.0);
+        }
+
+        return normalized;
+    }
+
+    template <typename T>
+    T Denormalize(double value)
+    {
+        constexpr auto lowest = std::is_signed<T>::value ? -1.0 : 0.0;
+        auto clamped = std::min(std::max(value, lowest), 1.0);
+        return static_cast<T>(std::llround(clamped * static_cast<double>(std::numeric_limits<T>::max())));
+    }
+
+    // Clamps a value to the range of an integer type; floats are rounded to the nearest integer, and NaN becomes 0.
+    template <typename Destination, typename Source>
+    Destination ClampToInteger(Source value)
+    {
+        if constexpr (std::is_floating_point<Source>::value)
+        {
+            auto floatValue = static_cast<double>(value);
+            if (std::isnan(floatValue))
+            {
+                return 0;
+            }
+
+            floatValue = std::min(std::max(floatValue, static_cast<double>(std::numeric_limits<Destination>::lowest())), static_cast<double>(std::numeric_limits<Destination>::max()));
+            return static_cast<Destination>(std::llround(floatValue));
+        }
+        else
+        {
+            // Every glTF integer component type fits in an int64_t
+            auto integerValue = static_cast<int64_t>(value);
+            integerValue = std::min(std::max(integerValue, static_cast<int64_t>(std::numeric_limits<Destination>::lowest())), static_cast<int64_t>(std::numeric_limits<Destination>::max()));
+            return static_cast<Destination>(integerValue);
+        }
+    }
+
+    template <typename Source, typename Destination>
+    Destination ConvertComponent(Source value, bool normalized)
+    {
+        if constexpr (std::is_same<Source, Destination>::value)
+        {
+            return value;
+        }
+        else if constexpr (std::is_floating_point<Destination>::value)
+        {
+            if constexpr (std::is_integral<Source>::value)
+            {
+                if (normalized)
+                {
+                    return static_cast<Destination>(Normalize(value));
+                }
+            }
+
+            return static_cast<Destination>(value);
+        }
+        else
+        {
+            if constexpr (std::is_integral<Source>::value)
+            {
+                if (normalized)
+                {
+                    return Denormalize<Destination>(Normalize(value));
+                }
+            }
+
+            return ClampToInteger<Destination>(value);
+        }
+    }
+
+    template <typename Source, typename Destination, bool CalculateBounds>
+    void ConvertComponentsKernel(const Source* source, Destination* destination, size_t elementCount, size_t typeCount, bool normalized, float* min, float* max)
+    {
+        for (size_t i = 0; i < elementCount; i++)
+        {
+            for (size_t j = 0; j < typeCount; j++)
+            {
+                auto converted = ConvertComponent<Source, Destination>(source[i * typeCount + j], normalized);
+                destination[i * typeCount + j] = converted;
+
+                if constexpr (CalculateBounds)
+                {
+                    // Same comparisons as CalculateMinMax, on the converted value
+                    auto current = static_cast<float>(converted);
+                    min[j] = i == 0 ? current : std::min(min[j], current);
+                    max[j] = i == 0 ? current : std::max(max[j], current);
+                }
+            }
+        }
+    }
+
+    typedef void(*ConvertComponentsFunction)(const void* source, void* destination, size_t elementCount, size_t typeCount, bool normalized, float* min, float* max);
+
+    template <typename Source, typename Destination>
+    void ConvertComponents(const void* source, void* destination, size_t elementCount, size_t typeCount, bool normalized, float* min, float* max)
+    {
+        auto typedSource = static_cast<const Source*>(source);
+        auto typedDestination = static_cast<Destination*>(destination);
+
+        // Floats can't be normalized
+        normalized = normalized && std::is_integral<Source>::value;
+
+        if (min != nullptr && max != nullptr)
+        {
+            ConvertComponentsKernel<Source, Destination, true>(typedSource, typedDestination, elementCount, typeCount, normalized, min, max);
+        }
+        else
+        {
+            ConvertComponentsKernel<Source, Destination, false>(typedSource, typedDestination, elementCount, typeCount, normalized, min, max);
+        }
+    }
+
+    const size_t ComponentTypeCount = 6;
+
+    size_t GetComponentTypeIndex(ComponentType componentType)
+    {
+        switch (componentType)
+        {
+        case COMPONENT_BYTE:
+            return 0;
+        case COMPONENT_UNSIGNED_BYTE:
+            return 1;
+        case COMPONENT_SHORT:
+            return 2;
+        case COMPONENT_UNSIGNED_SHORT:
+            return 3;
+        case COMPONENT_UNSIGNED_INT:
+            return 4;
+        case COMPONENT_FLOAT:
+            return 5;
+        default:
+            throw GLTFException("Unsupported accessor ComponentType");
+        }
+    }
+
+    // One row per source component type, in the order of GetComponentTypeIndex
+    template <typename Source>
+    std::array<ConvertComponentsFunction, ComponentTypeCount> MakeConvertComponentsRow()
+    {
+        return { {
+            &ConvertComponents<Source, int8_t>,
+            &ConvertComponents<Source, uint8_t>,
+            &ConvertComponents<Source, int16_t>,
+            &ConvertComponents<Source, uint16_t>,
+            &ConvertComponents<Source, uint32_t>,
+            &ConvertComponents<Source, float>
+        } };
+    }
+
+    const std::array<std::array<ConvertComponentsFunction, ComponentTypeCount>, ComponentTypeCount> ConvertComponentsTable = { {
+        MakeConvertComponentsRow<int8_t>(),
+        MakeConvertComponentsRow<uint8_t>(),
+        MakeConvertComponentsRow<int16_t>(),
+        MakeConvertComponentsRow<uint16_t>(),
+        MakeConvertComponentsRow<uint32_t>(),
+        MakeConvertComponentsRow<float>()
+    } };
+}
+
+void AccessorUtils::ConvertComponents(ComponentType sourceComponentType, const void* source, ComponentType destinationComponentType, void* destination,
+                                      size_t elementCount, size_t typeCount, bool normalized, float* min, float* max)
+{
+    auto convert = ConvertComponentsTable[GetComponentTypeIndex(sourceComponentType)][GetComponentTypeIndex(destinationComponentType)];
+    convert(source, destination, elementCount, typeCount, normalized, min, max);
+}
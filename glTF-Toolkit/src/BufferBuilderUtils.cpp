@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "BufferBuilderUtils.h"
+#include "AccessorUtils.h"
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    template<typename T>
+    Accessor CopyVertices(BufferBuilder& builder, const Accessor& accessor, const std::vector<uint8_t>& bytes, const std::vector<uint32_t>& vertices, bool calculateMinMax)
+    {
+        auto typeCount = Accessor::GetTypeCount(accessor.type);
+        auto source = reinterpret_cast<const T*>(bytes.data());
+
+        std::vector<T> values(vertices.size() * typeCount);
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            std::copy(source + vertices[i] * typeCount, source + (vertices[i] + 1) * typeCount, values.begin() + i * typeCount);
+        }
+
+        const auto& bufferView = BufferBuilderUtils::AddVertexBufferView(builder, reinterpret_cast<const uint8_t*>(values.data()), vertices.size(), typeCount * sizeof(T));
+
+        Accessor vertexAccessor(accessor);
+        vertexAccessor.bufferViewId = bufferView.id;
+        vertexAccessor.byteOffset = 0;
+        vertexAccessor.count = vertices.size();
+        if (calculateMinMax || !accessor.min.empty())
+        {
+            auto minmax = AccessorUtils::CalculateMinMax(vertexAccessor, values);
+            vertexAccessor.min = minmax.first;
+            vertexAccessor.max = minmax.second;
+        }
+
+        return vertexAccessor;
+    }
+}
+
+const BufferView& BufferBuilderUtils::AddVertexBufferView(BufferBuilder& builder, const uint8_t* elements, size_t count, size_t elementSize)
+{
+    auto byteStride = ((elementSize + VertexAttributeAlignment - 1) / VertexAttributeAlignment) * VertexAttributeAlignment;
+    if (byteStride == elementSize)
+    {
+        return builder.AddBufferView(elements, count * elementSize, {}, BufferViewTarget::ARRAY_BUFFER);
+    }
+
+    std::vector<uint8_t> data(count * byteStride);
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(&data[i * byteStride], elements + i * elementSize, elementSize);
+    }
+    return builder.AddBufferView(data.data(), data.size(), byteStride, BufferViewTarget::ARRAY_BUFFER);
+}
+
+Accessor BufferBuilderUtils::CopyVertices(BufferBuilder& builder, const Accessor& accessor, const std::vector<uint8_t>& bytes, const std::vector<uint32_t>& vertices, bool calculateMinMax)
+{
+    switch (accessor.componentType)
+    {
+    case COMPONENT_BYTE:           return ::CopyVertices<int8_t>(builder, accessor, bytes, vertices, calculateMinMax);
+    case COMPONENT_UNSIGNED_BYTE:  return ::CopyVertices<uint8_t>(builder, accessor, bytes, vertices, calculateMinMax);
+    case COMPONENT_SHORT:          return ::CopyVertices<int16_t>(builder, accessor, bytes, vertices, calculateMinMax);
+    case COMPONENT_UNSIGNED_SHORT: return ::CopyVertices<uint16_t>(builder, accessor, bytes, vertices, calculateMinMax);
+    case COMPONENT_UNSIGNED_INT:   return ::CopyVertices<uint32_t>(builder, accessor, bytes, vertices, calculateMinMax);
+    case COMPONENT_FLOAT:          return ::CopyVertices<float>(builder, accessor, bytes, vertices, calculateMinMax);
+    default: throw GLTFException("Unknown component type.");
+    }
+}
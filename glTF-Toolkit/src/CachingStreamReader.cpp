@@ -0,0 +1,271 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "CachingStreamReader.h"
+#include "MemoryStream.h"
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    // Size of the reads made from streams that can't report their length
+    const size_t READ_CHUNK_SIZE = 64 * 1024;
+
+    // Gets the length of a stream and rewinds it, or returns -1 if the stream can't report its length
+    std::streamoff GetLength(std::istream& stream)
+    {
+        std::streamoff length = -1;
+        if (stream.seekg(0, std::ios::end))
+        {
+            length = static_cast<std::streamoff>(stream.tellg());
+        }
+        stream.clear();
+        stream.seekg(0, std::ios::beg);
+        return length;
+    }
+}
+
+CachingStreamReader::CachingStreamReader(std::shared_ptr<const IStreamReader> streamReader, size_t byteBudget) :
+    m_streamReader(std::move(streamReader)),
+    m_byteBudget(byteBudget),
+    m_unpinnedBytes(0)
+{
+    if (m_streamReader == nullptr)
+    {
+        throw std::invalid_argument("A stream reader is required to read the cached resources.");
+    }
+}
+
+std::shared_ptr<std::istream> CachingStreamReader::GetInputStream(const std::string& uri) const
+{
+    auto contents = TryGetCached(uri);
+    if (contents == nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_statistics.Misses++;
+        }
+
+        // A resource over the budget would be read whole and dropped again on every request, so it is streamed instead
+        auto stream = Open(uri);
+        auto length = GetLength(*stream);
+        if (length >= 0 && static_cast<size_t>(length) > m_byteBudget)
+        {
+            return stream;
+        }
+
+        contents = Insert(uri, Read(*stream, length, uri));
+    }
+
+    auto data = contents->data();
+    auto size = contents->size();
+    return std::make_shared<MemoryStream>(std::move(contents), data, size);
+}
+
+std::shared_ptr<const std::vector<uint8_t>> CachingStreamReader::GetResource(const std::string& uri) const
+{
+    auto contents = TryGetCached(uri);
+    if (contents != nullptr)
+    {
+        return contents;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.Misses++;
+    }
+
+    // Read without holding the lock, so that other resources can be served in the meantime
+    auto stream = Open(uri);
+    return Insert(uri, Read(*stream, GetLength(*stream), uri));
+}
+
+std::shared_ptr<const std::vector<uint8_t>> CachingStreamReader::TryGetCached(const std::string& uri) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return Find(uri);
+}
+
+void CachingStreamReader::Pin(const std::string& uri)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_entries.find(uri);
+    if (it == m_entries.end())
+    {
+        lock.unlock();
+        auto stream = Open(uri);
+        auto contents = Read(*stream, GetLength(*stream), uri);
+        lock.lock();
+
+        it = m_entries.find(uri);
+        if (it == m_entries.end())
+        {
+            Entry entry;
+            entry.contents = std::move(contents);
+            entry.pinCount = 1;
+            m_statistics.BytesHeld += entry.contents->size();
+            m_statistics.BytesPinned += entry.contents->size();
+            m_entries.emplace(uri, std::move(entry));
+            return;
+        }
+    }
+
+    auto& entry = it->second;
+    if (entry.pinCount == 0)
+    {
+        m_recentUses.erase(entry.recentUse);
+        m_unpinnedBytes -= entry.contents->size();
+        m_statistics.BytesPinned += entry.contents->size();
+    }
+    entry.pinCount++;
+}
+
+void CachingStreamReader::Unpin(const std::string& uri)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_entries.find(uri);
+    if (it == m_entries.end() || it->second.pinCount == 0)
+    {
+        throw std::invalid_argument("Resource " + uri + " is not pinned.");
+    }
+
+    auto& entry = it->second;
+    entry.pinCount--;
+    if (entry.pinCount == 0)
+    {
+        m_recentUses.push_front(uri);
+        entry.recentUse = m_recentUses.begin();
+        m_unpinnedBytes += entry.contents->size();
+        m_statistics.BytesPinned -= entry.contents->size();
+        Evict();
+    }
+}
+
+void CachingStreamReader::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (const auto& uri : m_recentUses)
+    {
+        auto it = m_entries.find(uri);
+        m_statistics.BytesHeld -= it->second.contents->size();
+        m_entries.erase(it);
+    }
+
+    m_recentUses.clear();
+    m_unpinnedBytes = 0;
+}
+
+CachingStreamReaderStatistics CachingStreamReader::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> CachingStreamReader::Find(const std::string& uri) const
+{
+    auto it = m_entries.find(uri);
+    if (it == m_entries.end())
+    {
+        return nullptr;
+    }
+
+    m_statistics.Hits++;
+    if (it->second.pinCount == 0)
+    {
+        m_recentUses.splice(m_recentUses.begin(), m_recentUses, it->second.recentUse);
+    }
+    return it->second.contents;
+}
+
+std::shared_ptr<std::istream> CachingStreamReader::Open(const std::string& uri) const
+{
+    auto stream = m_streamReader->GetInputStream(uri);
+    if (stream == nullptr || stream->fail())
+    {
+        throw GLTFException("Could not open resource " + uri + ".");
+    }
+
+    return stream;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> CachingStreamReader::Read(std::istream& stream, std::streamoff length, const std::string& uri) const
+{
+    auto contents = std::make_shared<std::vector<uint8_t>>();
+
+    // Read the whole resource at once when the stream can report its length, and in chunks otherwise
+    if (length >= 0)
+    {
+        contents->resize(static_cast<size_t>(length));
+        if (!stream.read(reinterpret_cast<char*>(contents->data()), static_cast<std::streamsize>(length)))
+        {
+            throw GLTFException("Could not read resource " + uri + ".");
+        }
+    }
+    else
+    {
+        while (stream)
+        {
+            auto byteLength = contents->size();
+            contents->resize(byteLength + READ_CHUNK_SIZE);
+            stream.read(reinterpret_cast<char*>(contents->data() + byteLength), static_cast<std::streamsize>(READ_CHUNK_SIZE));
+            contents->resize(byteLength + static_cast<size_t>(stream.gcount()));
+        }
+
+        if (stream.bad())
+        {
+            throw GLTFException("Could not read resource " + uri + ".");
+        }
+    }
+
+    return contents;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> CachingStreamReader::Insert(const std::string& uri, std::shared_ptr<const std::vector<uint8_t>> contents) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Another thread may have read the same resource concurrently
+    auto it = m_entries.find(uri);
+    if (it != m_entries.end())
+    {
+        return it->second.contents;
+    }
+
+    if (contents->size() <= m_byteBudget)
+    {
+        m_recentUses.push_front(uri);
+
+        Entry entry;
+        entry.contents = contents;
+        entry.recentUse = m_recentUses.begin();
+        m_entries.emplace(uri, std::move(entry));
+
+        m_unpinnedBytes += contents->size();
+        m_statistics.BytesHeld += contents->size();
+        Evict();
+    }
+
+    return contents;
+}
+
+void CachingStreamReader::Evict() const
+{
+    while (m_unpinnedBytes > m_byteBudget && !m_recentUses.empty())
+    {
+        auto it = m_entries.find(m_recentUses.back());
+        auto byteLength = it->second.contents->size();
+
+        m_unpinnedBytes -= byteLength;
+        m_statistics.BytesHeld -= byteLength;
+        m_statistics.Evictions++;
+
+        m_entries.erase(it);
+        m_recentUses.pop_back();
+    }
+}
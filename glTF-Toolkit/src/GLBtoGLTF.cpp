@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "GLBtoGLTF.h"
+#include "NativeFile.h"
 #include "GLTFSDK/ExtensionsKHR.h"
 
 using namespace Microsoft::glTF;
@@ -59,6 +60,167 @@ namespace
         // 28 = (GLB2_HEADER_BYTE_SIZE = 12bytes) + (uint32 = 4bytes) * 4
         return length + GLB2_HEADER_BYTE_SIZE + GLB_CHUNK_TYPE_SIZE * 4;
     }
+
+    // Size of the buffer through which the GLB buffer is copied to the unpacked files
+    constexpr size_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+    // A byte range of the GLB buffer and the position in an unpacked file to which it is copied
+    struct UnpackedRange
+    {
+        size_t byteOffset;
+        size_t byteLength;
+        std::string uri;
+        size_t outputOffset;
+    };
+
+    struct UnpackedOutput
+    {
+        std::shared_ptr<std::ostream> stream;
+        size_t position = 0;
+        size_t length = 0;
+        size_t remainingRanges = 0;
+    };
+
+    void WriteAt(UnpackedOutput& output, size_t offset, const char* data, size_t size)
+    {
+        if (offset > output.length)
+        {
+            // alignment padding between buffer views
+            static const char padding[GLB_BUFFER_OFFSET_ALIGNMENT] = {};
+            if (output.position != output.length)
+            {
+                output.stream->seekp(output.length, std::ios::beg);
+            }
+            while (output.length < offset)
+            {
+                auto paddingLength = std::min(sizeof(padding), offset - output.length);
+                output.stream->write(padding, paddingLength);
+                output.length += paddingLength;
+            }
+            output.position = output.length;
+        }
+
+        if (output.position != offset)
+        {
+            // only buffer views that overlap write behind the end of the file
+            output.stream->seekp(offset, std::ios::beg);
+        }
+
+        output.stream->write(data, size);
+        output.position = offset + size;
+        output.length = std::max(output.length, output.position);
+    }
+
+    // Gathers the buffer views that stay in the bin file, in the order in which they are written to it
+    std::vector<BufferView> GetPackedBufferViews(const Document& glbDoc, const std::unordered_set<std::string>& unpackedBufferViews)
+    {
+        const auto bufferViews = glbDoc.bufferViews.Elements();
+
+        std::vector<BufferView> usedBufferViews(bufferViews.size());
+        auto end = copy_if(bufferViews.begin(), bufferViews.end(), usedBufferViews.begin(), [&unpackedBufferViews](const auto& a)
+        {
+            return unpackedBufferViews.count(a.id) == 0;
+        });
+        usedBufferViews.resize(distance(usedBufferViews.begin(), end));
+
+        sort(usedBufferViews.begin(), usedBufferViews.end(), [](const BufferView& a, const BufferView& b)
+        {
+            return a.byteOffset < b.byteOffset;
+        });
+
+        return usedBufferViews;
+    }
+
+    // Collects anything in extensions that looks like it should be unpacked, as pairs of file names and buffer view ids
+    std::vector<std::pair<std::string, std::string>> GetExtensionResources(const Document& glbDoc, const std::string& name)
+    {
+        std::vector<std::pair<std::string, std::string>> resources;
+        for (const auto& extension : glbDoc.extensions)
+        {
+            rapidjson::Document extensionJson;
+            extensionJson.Parse(extension.second.c_str());
+            if (!extensionJson.IsObject())
+            {
+                continue;
+            }
+            for (auto& member : extensionJson.GetObject())
+            {
+                if (!member.value.IsArray())
+                {
+                    continue;
+                }
+                for (auto& possibleBuffer : member.value.GetArray())
+                {
+                    if (!possibleBuffer.IsObject() || !possibleBuffer.HasMember("bufferView"))
+                    {
+                        continue;
+                    }
+                    std::string bufferViewId = std::to_string(possibleBuffer["bufferView"].GetUint());
+                    std::string mimeType{};
+                    if (possibleBuffer.HasMember("mimeType"))
+                    {
+                        mimeType = possibleBuffer["mimeType"].GetString();
+                    }
+                    if (!glbDoc.bufferViews.Has(bufferViewId))
+                    {
+                        continue;
+                    }
+
+                    auto filename = name + "_" + extension.first + "_" + member.name.GetString() + "_" + bufferViewId + "." + GuessFileExtension(mimeType);
+                    resources.emplace_back(std::move(filename), std::move(bufferViewId));
+                }
+            }
+        }
+        return resources;
+    }
+
+    std::string GetBinUri(const std::string& name)
+    {
+        return name + "." + BUFFER_EXTENSION;
+    }
+
+    // Lists the ranges of the GLB buffer that are unpacked, sorted by their offset in the buffer
+    std::vector<UnpackedRange> GetUnpackedRanges(const Document& glbDoc, const std::string& name, const std::unordered_set<std::string>& unpackedBufferViews)
+    {
+        std::vector<UnpackedRange> ranges;
+
+        const auto images = glbDoc.images.Elements();
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            if (images[i].bufferViewId.empty())
+            {
+                continue;
+            }
+            const auto& bufferView = glbDoc.bufferViews.Get(images[i].bufferViewId);
+            ranges.push_back({ bufferView.byteOffset, bufferView.byteLength, name + "_image" + std::to_string(i) + "." + GuessFileExtension(images[i].mimeType), 0 });
+        }
+
+        for (const auto& resource : GetExtensionResources(glbDoc, name))
+        {
+            const auto& bufferView = glbDoc.bufferViews.Get(resource.second);
+            ranges.push_back({ bufferView.byteOffset, bufferView.byteLength, resource.first, 0 });
+        }
+
+        // the remaining buffer views are packed in the bin file in the same order and with the same padding as in CreateGLTFDocument
+        const auto binUri = GetBinUri(name);
+        size_t binLength = 0;
+        for (const auto& bufferView : GetPackedBufferViews(glbDoc, unpackedBufferViews))
+        {
+            if (binLength % GLB_BUFFER_OFFSET_ALIGNMENT != 0)
+            {
+                binLength += (GLB_BUFFER_OFFSET_ALIGNMENT - (binLength % GLB_BUFFER_OFFSET_ALIGNMENT));
+            }
+            ranges.push_back({ bufferView.byteOffset, bufferView.byteLength, binUri, binLength });
+            binLength += bufferView.byteLength;
+        }
+
+        std::stable_sort(ranges.begin(), ranges.end(), [](const UnpackedRange& a, const UnpackedRange& b)
+        {
+            return a.byteOffset < b.byteOffset;
+        });
+
+        return ranges;
+    }
 }
 
 std::vector<char> GLBToGLTF::SaveBin(std::istream* input, const Document& glbDoc, const size_t bufferOffset, const size_t newBufferlength, std::unordered_set<std::string>& unpackedBufferViews)
@@ -68,22 +230,8 @@ std::vector<char> GLBToGLTF::SaveBin(std::istream* input, const Document& glbDoc
         return {};
     }
 
-    const auto images = glbDoc.images.Elements();
-    const auto bufferViews = glbDoc.bufferViews.Elements();
-
-    // gather all non-image bufferViews in UsedBufferViews
-    std::vector<BufferView> usedBufferViews(bufferViews.size());
-    auto end = copy_if(bufferViews.begin(), bufferViews.end(), usedBufferViews.begin(), [unpackedBufferViews](const auto& a)
-    {
-        return unpackedBufferViews.count(a.id) == 0;
-    });
-    usedBufferViews.resize(distance(usedBufferViews.begin(), end));
-
-    // sort buffer views by offset
-    sort(usedBufferViews.begin(), usedBufferViews.end(), [](const BufferView& a, const BufferView& b)
-    {
-        return a.byteOffset < b.byteOffset;
-    });
+    // gather all non-image bufferViews, sorted by offset
+    auto usedBufferViews = GetPackedBufferViews(glbDoc, unpackedBufferViews);
 
     std::vector<char> result(newBufferlength);
     size_t vecpos = 0; // number of chunks read
@@ -178,69 +326,6 @@ std::unordered_map<std::string, std::vector<char>> GLBToGLTF::GetImagesData(std:
     return imageStream;
 }
 
-std::unordered_map<std::string, std::vector<char>> GetExtensionsData(std::istream* input, const Document& glbDoc, const std::string& name, const size_t bufferOffset)
-{
-    std::unordered_map<std::string, std::vector<char>> extensionStreams;
-    // Collect anything in extensions that looks like it should be unpacked.
-    for (const auto& extension : glbDoc.extensions)
-    {
-        rapidjson::Document extensionJson;
-        extensionJson.Parse(extension.second.c_str());
-        if (!extensionJson.IsObject())
-        {
-            continue;
-        }
-        for (auto& member : extensionJson.GetObject())
-        {
-            if (!member.value.IsArray())
-            {
-                continue;
-            }
-            for (auto& possibleBuffer : member.value.GetArray())
-            {
-                if (!possibleBuffer.IsObject())
-                {
-                    continue;
-                }
-                std::string bufferViewId{};
-                std::string mimeType{};
-                if (possibleBuffer.HasMember("bufferView"))
-                {
-                    bufferViewId = std::to_string(possibleBuffer["bufferView"].GetUint());
-                    
-                }
-                else
-                {
-                    continue;
-                }
-                if (possibleBuffer.HasMember("mimeType"))
-                {
-                    mimeType = possibleBuffer["mimeType"].GetString();
-                }
-                try
-                {
-                    auto bufferView = glbDoc.bufferViews.Get(bufferViewId);
-                    auto filename = name + "_" + extension.first + "_" + member.name.GetString() + "_" + bufferViewId + "." + GuessFileExtension(mimeType);
-
-                    size_t offset = bufferOffset + bufferView.byteOffset;
-                    input->seekg(offset, std::ios::beg);
-                    std::vector<char> result;
-                    result.resize(bufferView.byteLength);
-                    input->read(&result[0], bufferView.byteLength);
-
-                    extensionStreams[filename] = std::move(result);
-                }
-                catch (...)
-                {
-                    // Didn't work out.
-                    continue;
-                }
-            }
-        }
-    }
-    return extensionStreams;
-}
-
 // Create modified gltf from original by removing image buffer segments and updating
 // images, bufferViews and accessors fields accordingly
 Document GLBToGLTF::CreateGLTFDocument(const Document& glbDoc, const std::string& name, std::unordered_set<std::string>& unpackedBufferViews)
@@ -333,20 +418,8 @@ Document GLBToGLTF::CreateGLTFDocument(const Document& glbDoc, const std::string
         extension.second = buffer.GetString();
     }
 
-    // gather all non-image bufferViews in UsedBufferViews
-    std::vector<BufferView> usedBufferViews(bufferViews.size());
-    auto end = copy_if(bufferViews.begin(), bufferViews.end(), usedBufferViews.begin(), [&unpackedBufferViews](const auto& a)
-    {
-        return unpackedBufferViews.count(a.id) == 0;
-    });
-
-    usedBufferViews.resize(distance(usedBufferViews.begin(), end));
-
-    // group buffer views by buffer, then sort them by byteOffset to calculate their new byteOffsets
-    sort(usedBufferViews.begin(), usedBufferViews.end(), [](const auto& a, const auto& b)
-    {
-        return a.byteOffset < b.byteOffset;
-    });
+    // gather all non-image bufferViews, sorted by byteOffset to calculate their new byteOffsets
+    auto usedBufferViews = GetPackedBufferViews(glbDoc, unpackedBufferViews);
 
     int updatedBufferViewId = 0;
     size_t currentOffset = 0;
@@ -419,6 +492,156 @@ Document GLBToGLTF::CreateGLTFDocument(const Document& glbDoc, const std::string
     return gltfDoc;
 }
 
+void GLBToGLTF::UnpackResources(std::istream* input, const Document& glbDoc, const std::string& name, const size_t bufferOffset, const std::unordered_set<std::string>& unpackedBufferViews, std::shared_ptr<const IStreamWriter> streamWriter)
+{
+    const auto ranges = GetUnpackedRanges(glbDoc, name, unpackedBufferViews);
+    const auto binUri = GetBinUri(name);
+
+    // each file is opened when its first range is reached, and closed after its last one
+    std::unordered_map<std::string, UnpackedOutput> outputs;
+    for (const auto& range : ranges)
+    {
+        outputs[range.uri].remainingRanges++;
+    }
+    if (glbDoc.buffers.Size() != 0)
+    {
+        // the bin file is written even if it ends up empty
+        outputs[binUri].stream = streamWriter->GetOutputStream(binUri);
+    }
+
+    // single forward sweep over the buffer: every chunk read is written to all the ranges that contain it,
+    // so overlapping buffer views are read only once and the memory used doesn't depend on their size
+    std::vector<char> copyBuffer(COPY_BUFFER_SIZE);
+    std::vector<size_t> activeRanges;
+    size_t nextRange = 0;
+    size_t position = 0;
+    size_t inputPosition = std::numeric_limits<size_t>::max();
+
+    while (nextRange < ranges.size() || !activeRanges.empty())
+    {
+        if (activeRanges.empty())
+        {
+            // skip over buffer segments of no interest
+            position = std::max(position, ranges[nextRange].byteOffset);
+        }
+
+        while (nextRange < ranges.size() && ranges[nextRange].byteOffset <= position)
+        {
+            auto& output = outputs[ranges[nextRange].uri];
+            if (!output.stream)
+            {
+                output.stream = streamWriter->GetOutputStream(ranges[nextRange].uri);
+            }
+            activeRanges.push_back(nextRange++);
+        }
+
+        // a chunk never crosses the start or the end of a range
+        size_t chunkEnd = position + copyBuffer.size();
+        for (auto rangeIndex : activeRanges)
+        {
+            chunkEnd = std::min(chunkEnd, ranges[rangeIndex].byteOffset + ranges[rangeIndex].byteLength);
+        }
+        if (nextRange < ranges.size())
+        {
+            chunkEnd = std::min(chunkEnd, ranges[nextRange].byteOffset);
+        }
+
+        if (chunkEnd > position)
+        {
+            if (inputPosition != position)
+            {
+                input->seekg(bufferOffset + position, std::ios::beg);
+            }
+
+            const auto chunkLength = chunkEnd - position;
+            input->read(copyBuffer.data(), chunkLength);
+            if (static_cast<size_t>(input->gcount()) != chunkLength)
+            {
+                throw GLTFException("Unexpected end of the GLB buffer at offset " + std::to_string(position + input->gcount()) + ".");
+            }
+
+            for (auto rangeIndex : activeRanges)
+            {
+                const auto& range = ranges[rangeIndex];
+                WriteAt(outputs[range.uri], range.outputOffset + (position - range.byteOffset), copyBuffer.data(), chunkLength);
+            }
+
+            position = chunkEnd;
+            inputPosition = chunkEnd;
+        }
+
+        auto completedRanges = std::remove_if(activeRanges.begin(), activeRanges.end(), [&](size_t rangeIndex)
+        {
+            const auto& range = ranges[rangeIndex];
+            if (range.byteOffset + range.byteLength > position)
+            {
+                return false;
+            }
+
+            auto output = outputs.find(range.uri);
+            if (--output->second.remainingRanges == 0)
+            {
+                output->second.stream->flush();
+                outputs.erase(output);
+            }
+            return true;
+        });
+        activeRanges.erase(completedRanges, activeRanges.end());
+    }
+}
+
+void GLBToGLTF::UnpackResources(const NativeFile& input, const Document& glbDoc, const std::string& name, const size_t bufferOffset, const std::unordered_set<std::string>& unpackedBufferViews, std::shared_ptr<const IFileStreamWriter> streamWriter)
+{
+    const auto ranges = GetUnpackedRanges(glbDoc, name, unpackedBufferViews);
+    const auto binUri = GetBinUri(name);
+
+    // each file is created with its final length when its first range is reached, and closed after its last one;
+    // the padding between the buffer views of the bin file is left as a hole, which reads as zeros
+    std::unordered_map<std::string, std::pair<size_t, size_t>> outputLengths;
+    for (const auto& range : ranges)
+    {
+        auto& output = outputLengths[range.uri];
+        output.first = std::max(output.first, range.outputOffset + range.byteLength);
+        output.second++;
+    }
+
+    std::unordered_map<std::string, std::shared_ptr<NativeFile>> outputs;
+    auto OpenOutput = [&streamWriter, &outputLengths](const std::string& uri)
+    {
+        auto file = streamWriter->GetOutputFile(uri);
+        if (file == nullptr)
+        {
+            throw GLTFException("Could not open " + uri + " for writing.");
+        }
+
+        file->Resize(0);
+        file->Resize(outputLengths[uri].first);
+        return file;
+    };
+
+    if (glbDoc.buffers.Size() != 0)
+    {
+        // the bin file is written even if it ends up empty
+        outputs[binUri] = OpenOutput(binUri);
+    }
+
+    for (const auto& range : ranges)
+    {
+        auto& output = outputs[range.uri];
+        if (output == nullptr)
+        {
+            output = OpenOutput(range.uri);
+        }
+
+        NativeFile::CopyRange(input, bufferOffset + range.byteOffset, *output, range.outputOffset, range.byteLength);
+
+        if (--outputLengths[range.uri].second == 0)
+        {
+            outputs.erase(range.uri);
+        }
+    }
+}
+
 void GLBToGLTF::UnpackGLB(const std::string& glbPath, const std::string& outDirectory, const std::string& gltfName)
 {
     // read glb file into json
@@ -440,26 +663,15 @@ void GLBToGLTF::UnpackGLB(const std::string& glbPath, const std::string& outDire
     outputStream << gltfJson;
     outputStream.flush();
 
-    // write images
+    // write images, extension resources and the new buffer, copying them from file to file when the GLB can be opened natively
     size_t bufferOffset = GetGLBBufferChunkOffset(glbStream.get());
-    for (auto image : GLBToGLTF::GetImagesData(glbStream.get(), doc, gltfName, bufferOffset))
-    {
-        std::ofstream out(outDirectory + image.first, std::ios::binary);
-        out.write(&image.second[0], image.second.size());
-    }
-
-    for (auto ext : GetExtensionsData(glbStream.get(), doc, gltfName, bufferOffset))
+    auto streamWriter = std::make_shared<FileStreamWriter>(outDirectory);
+    if (auto glbFile = NativeFile::OpenRead(glbPath))
     {
-        std::ofstream out(outDirectory + ext.first, std::ios::binary);
-        out.write(&ext.second[0], ext.second.size());
+        GLBToGLTF::UnpackResources(*glbFile, doc, gltfName, bufferOffset, unpackedBufferViews, streamWriter);
     }
-
-    // get new buffer size and write new buffer
-    if (gltfDoc.buffers.Size() != 0)
+    else
     {
-        size_t newBufferSize = gltfDoc.buffers[0].byteLength;
-        auto binFileData = GLBToGLTF::SaveBin(glbStream.get(), doc, bufferOffset, newBufferSize, unpackedBufferViews);
-        std::ofstream out(outDirectory + gltfName + "." + BUFFER_EXTENSION, std::ios::binary);
-        out.write(&binFileData[0], binFileData.size());
+        GLBToGLTF::UnpackResources(glbStream.get(), doc, gltfName, bufferOffset, unpackedBufferViews, streamWriter);
     }
 }
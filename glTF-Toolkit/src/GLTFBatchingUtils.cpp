@@ -0,0 +1,775 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "GLTFBatchingUtils.h"
+#include "BufferBuilderUtils.h"
+#include "GLTFLODUtils.h"
+#include "AccessorUtils.h"
+#include "MeshoptCodec.h"
+#include "TransformUtils.h"
+
+#include "GLTFSDK/BufferBuilder.h"
+#include "GLTFSDK/ExtensionsKHR.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    typedef TransformUtils::Transform Transform;
+
+    void Normalize(float* v, size_t size)
+    {
+        double length = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            length += v[i] * v[i];
+        }
+        length = std::sqrt(length);
+        if (length > 0)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                v[i] = static_cast<float>(v[i] / length);
+            }
+        }
+    }
+
+    // Whether the data of an accessor can be read
+    bool IsPlainAccessor(const Document& doc, const Accessor& accessor)
+    {
+        return !accessor.bufferViewId.empty() && accessor.sparse.count == 0 &&
+            doc.bufferViews.Get(accessor.bufferViewId).extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) == 0;
+    }
+
+    bool IsBatchable(const Document& doc, const MeshPrimitive& primitive)
+    {
+        if ((primitive.mode != MESH_POINTS && primitive.mode != MESH_LINES && primitive.mode != MESH_TRIANGLES) ||
+            !primitive.targets.empty() || !primitive.extensions.empty() || !primitive.HasAttribute(ACCESSOR_POSITION))
+        {
+            return false;
+        }
+
+        if (!primitive.indicesAccessorId.empty() && !IsPlainAccessor(doc, doc.accessors.Get(primitive.indicesAccessorId)))
+        {
+            return false;
+        }
+
+        auto vertexCount = doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION)).count;
+        for (const auto& attribute : primitive.attributes)
+        {
+            const auto& accessor = doc.accessors.Get(attribute.second);
+            if (!IsPlainAccessor(doc, accessor) || accessor.count != vertexCount)
+            {
+                return false;
+            }
+
+            // The attributes that are transformed must be floats
+            if ((attribute.first == ACCESSOR_POSITION || attribute.first == ACCESSOR_NORMAL) && (accessor.componentType != COMPONENT_FLOAT || accessor.type != TYPE_VEC3))
+            {
+                return false;
+            }
+            if (attribute.first == ACCESSOR_TANGENT && (accessor.componentType != COMPONENT_FLOAT || accessor.type != TYPE_VEC4))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Primitives can be merged when they share a material, a mode and the format of every attribute
+    std::string GetBatchKey(const Document& doc, const MeshPrimitive& primitive)
+    {
+        std::string key = primitive.materialId + "|" + std::to_string(primitive.mode);
+
+        std::map<std::string, std::string> attributes(primitive.attributes.begin(), primitive.attributes.end());
+        for (const auto& attribute : attributes)
+        {
+            const auto& accessor = doc.accessors.Get(attribute.second);
+            key += "|" + attribute.first + ":" + std::to_string(accessor.type) + ":" + std::to_string(accessor.componentType) + (accessor.normalized ? "n" : "");
+        }
+
+        return key;
+    }
+
+    template<typename T>
+    std::vector<uint8_t> ReadBytes(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        auto values = reader.ReadBinaryData<T>(doc, accessor);
+        std::vector<uint8_t> bytes(values.size() * sizeof(T));
+        memcpy(bytes.data(), values.data(), bytes.size());
+        return bytes;
+    }
+
+    // Reads the elements of accessors, tightly packed; accessors are often shared between the instances of a mesh, so each one is only read once
+    class AccessorDataCache
+    {
+    public:
+        AccessorDataCache(const GLTFResourceReader& reader, const Document& doc) : m_reader(reader), m_doc(doc) {}
+
+        const std::vector<uint8_t>& Get(const Accessor& accessor)
+        {
+            auto it = m_data.find(accessor.id);
+            if (it == m_data.end())
+            {
+                it = m_data.emplace(accessor.id, Read(accessor)).first;
+            }
+            return it->second;
+        }
+
+    private:
+        std::vector<uint8_t> Read(const Accessor& accessor)
+        {
+            switch (accessor.componentType)
+            {
+            case COMPONENT_BYTE:           return ReadBytes<int8_t>(m_reader, m_doc, accessor);
+            case COMPONENT_UNSIGNED_BYTE:  return ReadBytes<uint8_t>(m_reader, m_doc, accessor);
+            case COMPONENT_SHORT:          return ReadBytes<int16_t>(m_reader, m_doc, accessor);
+            case COMPONENT_UNSIGNED_SHORT: return ReadBytes<uint16_t>(m_reader, m_doc, accessor);
+            case COMPONENT_UNSIGNED_INT:   return ReadBytes<uint32_t>(m_reader, m_doc, accessor);
+            case COMPONENT_FLOAT:          return ReadBytes<float>(m_reader, m_doc, accessor);
+            default: throw GLTFException("Unknown component type.");
+            }
+        }
+
+        const GLTFResourceReader& m_reader;
+        const Document& m_doc;
+        std::map<std::string, std::vector<uint8_t>> m_data;
+    };
+
+    std::vector<uint32_t> ReadIndices(AccessorDataCache& cache, const Accessor& accessor)
+    {
+        const auto& bytes = cache.Get(accessor);
+        switch (accessor.componentType)
+        {
+        case COMPONENT_UNSIGNED_BYTE:
+            return std::vector<uint32_t>(bytes.begin(), bytes.end());
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            auto indices = reinterpret_cast<const uint16_t*>(bytes.data());
+            return std::vector<uint32_t>(indices, indices + bytes.size() / sizeof(uint16_t));
+        }
+        case COMPONENT_UNSIGNED_INT:
+        {
+            auto indices = reinterpret_cast<const uint32_t*>(bytes.data());
+            return std::vector<uint32_t>(indices, indices + bytes.size() / sizeof(uint32_t));
+        }
+        default:
+            throw GLTFException("Invalid index component type.");
+        }
+    }
+
+    // A primitive drawn by a static node, with the transform from the node to its root node
+    struct PrimitiveInstance
+    {
+        std::string nodeId;
+        size_t primitiveIndex;
+        const MeshPrimitive* primitive;
+        Transform transform;
+        size_t vertexCount;
+        std::array<double, 3> center;
+    };
+
+    // Merges primitives with the same batch key into one, in the space of their root node
+    MeshPrimitive MergePrimitives(Document& resultDocument, BufferBuilder& builder, const BufferBuilder::FnGenId& generateAccessorId, AccessorDataCache& cache,
+                                  const Document& doc, const std::vector<const PrimitiveInstance*>& batch)
+    {
+        const auto& first = *batch.front()->primitive;
+
+        MeshPrimitive merged;
+        merged.mode = first.mode;
+        merged.materialId = first.materialId;
+
+        size_t vertexCount = 0;
+        for (auto instance : batch)
+        {
+            vertexCount += instance->vertexCount;
+        }
+
+        for (const auto& attribute : first.attributes)
+        {
+            const auto& firstAccessor = doc.accessors.Get(attribute.second);
+            auto typeCount = Accessor::GetTypeCount(firstAccessor.type);
+            auto elementSize = typeCount * Accessor::GetComponentTypeSize(firstAccessor.componentType);
+
+            std::vector<uint8_t> bytes(vertexCount * elementSize);
+            size_t offset = 0;
+            for (auto instance : batch)
+            {
+                const auto& accessor = doc.accessors.Get(instance->primitive->GetAttributeAccessorId(attribute.first));
+                const auto& source = cache.Get(accessor);
+                memcpy(&bytes[offset], source.data(), instance->vertexCount * elementSize);
+
+                const auto& m = instance->transform;
+                auto values = reinterpret_cast<float*>(&bytes[offset]);
+                if (attribute.first == ACCESSOR_POSITION)
+                {
+                    for (size_t i = 0; i < instance->vertexCount; i++)
+                    {
+                        auto p = values + i * 3;
+                        double x = p[0], y = p[1], z = p[2];
+                        for (size_t row = 0; row < 3; row++)
+                        {
+                            p[row] = static_cast<float>(m[row] * x + m[4 + row] * y + m[8 + row] * z + m[12 + row]);
+                        }
+                    }
+                }
+                else if (attribute.first == ACCESSOR_NORMAL)
+                {
+                    // Normals are transformed by the inverse transpose, which is the cofactor matrix divided by the determinant
+                    auto cofactors = TransformUtils::GetCofactors(m);
+                    double sign = TransformUtils::GetDeterminant(m) < 0 ? -1.0 : 1.0;
+                    for (size_t i = 0; i < instance->vertexCount; i++)
+                    {
+                        auto n = values + i * 3;
+                        double x = n[0], y = n[1], z = n[2];
+                        for (size_t row = 0; row < 3; row++)
+                        {
+                            n[row] = static_cast<float>(sign * (cofactors[row * 3] * x + cofactors[row * 3 + 1] * y + cofactors[row * 3 + 2] * z));
+                        }
+                        Normalize(n, 3);
+                    }
+                }
+                else if (attribute.first == ACCESSOR_TANGENT)
+                {
+                    // Mirroring flips the handedness of the tangent frame
+                    float sign = TransformUtils::GetDeterminant(m) < 0 ? -1.0f : 1.0f;
+                    for (size_t i = 0; i < instance->vertexCount; i++)
+                    {
+                        auto t = values + i * 4;
+                        double x = t[0], y = t[1], z = t[2];
+                        for (size_t row = 0; row < 3; row++)
+                        {
+                            t[row] = static_cast<float>(m[row] * x + m[4 + row] * y + m[8 + row] * z);
+                        }
+                        Normalize(t, 3);
+                        t[3] *= sign;
+                    }
+                }
+
+                offset += instance->vertexCount * elementSize;
+            }
+
+            const auto& bufferView = BufferBuilderUtils::AddVertexBufferView(builder, bytes.data(), bytes.size() / elementSize, elementSize);
+
+            Accessor accessor;
+            accessor.id = generateAccessorId(builder);
+            accessor.bufferViewId = bufferView.id;
+            accessor.type = firstAccessor.type;
+            accessor.componentType = firstAccessor.componentType;
+            accessor.normalized = firstAccessor.normalized;
+            accessor.count = vertexCount;
+            if (attribute.first == ACCESSOR_POSITION)
+            {
+                auto positions = reinterpret_cast<const float*>(bytes.data());
+                auto minmax = AccessorUtils::CalculateMinMax(accessor, std::vector<float>(positions, positions + vertexCount * 3));
+                accessor.min = minmax.first;
+                accessor.max = minmax.second;
+            }
+
+            merged.attributes[attribute.first] = resultDocument.accessors.Append(std::move(accessor)).id;
+        }
+
+        std::vector<uint32_t> indices;
+        uint32_t baseVertex = 0;
+        for (auto instance : batch)
+        {
+            std::vector<uint32_t> instanceIndices;
+            if (instance->primitive->indicesAccessorId.empty())
+            {
+                instanceIndices.resize(instance->vertexCount);
+                std::iota(instanceIndices.begin(), instanceIndices.end(), 0);
+            }
+            else
+            {
+                instanceIndices = ReadIndices(cache, doc.accessors.Get(instance->primitive->indicesAccessorId));
+            }
+
+            // Mirroring transforms flip the winding of the triangles, which is restored by swapping two of their vertices
+            if (merged.mode == MESH_TRIANGLES && TransformUtils::GetDeterminant(instance->transform) < 0)
+            {
+                for (size_t i = 0; i + 2 < instanceIndices.size(); i += 3)
+                {
+                    std::swap(instanceIndices[i + 1], instanceIndices[i + 2]);
+                }
+            }
+
+            for (auto index : instanceIndices)
+            {
+                if (index >= instance->vertexCount)
+                {
+                    throw GLTFException("Index " + std::to_string(index) + " is out of range.");
+                }
+                indices.push_back(baseVertex + index);
+            }
+
+            baseVertex += static_cast<uint32_t>(instance->vertexCount);
+        }
+
+        Accessor indexAccessor;
+        indexAccessor.id = generateAccessorId(builder);
+        indexAccessor.type = TYPE_SCALAR;
+        indexAccessor.count = indices.size();
+        if (vertexCount <= std::numeric_limits<uint16_t>::max())
+        {
+            std::vector<uint16_t> indices16(indices.begin(), indices.end());
+            indexAccessor.bufferViewId = builder.AddBufferView(indices16.data(), indices16.size() * sizeof(uint16_t), {}, BufferViewTarget::ELEMENT_ARRAY_BUFFER).id;
+            indexAccessor.componentType = COMPONENT_UNSIGNED_SHORT;
+        }
+        else
+        {
+            indexAccessor.bufferViewId = builder.AddBufferView(indices.data(), indices.size() * sizeof(uint32_t), {}, BufferViewTarget::ELEMENT_ARRAY_BUFFER).id;
+            indexAccessor.componentType = COMPONENT_UNSIGNED_INT;
+        }
+        merged.indicesAccessorId = resultDocument.accessors.Append(std::move(indexAccessor)).id;
+
+        return merged;
+    }
+
+    // The number of primitives drawn by the scenes of a document
+    size_t CountDrawnPrimitives(const Document& doc)
+    {
+        size_t count = 0;
+        std::vector<std::string> nodeIds;
+        for (const auto& scene : doc.scenes.Elements())
+        {
+            nodeIds.insert(nodeIds.end(), scene.nodes.begin(), scene.nodes.end());
+        }
+
+        while (!nodeIds.empty())
+        {
+            const auto& node = doc.nodes.Get(nodeIds.back());
+            nodeIds.pop_back();
+
+            if (!node.meshId.empty())
+            {
+                count += doc.meshes.Get(node.meshId).primitives.size();
+            }
+            nodeIds.insert(nodeIds.end(), node.children.begin(), node.children.end());
+        }
+
+        return count;
+    }
+
+    // The accessors that are still used by the meshes, skins and animations of a document
+    std::unordered_set<std::string> GetUsedAccessorIds(const Document& doc)
+    {
+        std::unordered_set<std::string> accessorIds;
+        for (const auto& mesh : doc.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                accessorIds.insert(primitive.indicesAccessorId);
+                for (const auto& attribute : primitive.attributes)
+                {
+                    accessorIds.insert(attribute.second);
+                }
+                for (const auto& target : primitive.targets)
+                {
+                    accessorIds.insert(target.positionsAccessorId);
+                    accessorIds.insert(target.normalsAccessorId);
+                    accessorIds.insert(target.tangentsAccessorId);
+                }
+            }
+        }
+
+        for (const auto& skin : doc.skins.Elements())
+        {
+            accessorIds.insert(skin.inverseBindMatricesAccessorId);
+        }
+
+        for (const auto& animation : doc.animations.Elements())
+        {
+            for (const auto& sampler : animation.samplers.Elements())
+            {
+                accessorIds.insert(sampler.inputAccessorId);
+                accessorIds.insert(sampler.outputAccessorId);
+            }
+        }
+
+        return accessorIds;
+    }
+}
+
+Document GLTFBatchingUtils::BatchStaticMeshes(std::shared_ptr<IStreamReader> streamReader, const Document& doc, const BatchingOptions& options, const std::string& outputDirectory,
+                                              BatchingStatistics* statistics)
+{
+    if (options.MaxVertexCount == 0)
+    {
+        throw std::invalid_argument("The maximum vertex count of a merged primitive must be positive.");
+    }
+
+    if (statistics != nullptr)
+    {
+        statistics->PrimitivesBefore = CountDrawnPrimitives(doc);
+        statistics->PrimitivesAfter = statistics->PrimitivesBefore;
+    }
+
+    Document resultDocument(doc);
+    GLTFResourceReader reader(streamReader);
+    AccessorDataCache cache(reader, doc);
+
+    auto writer = std::make_unique<GLTFResourceWriter>(std::make_shared<BufferFileStreamWriter>());
+    writer->SetUriPrefix((std::experimental::filesystem::u8path(outputDirectory) / "Batching").u8string());
+    BufferBuilder builder(std::move(writer), BufferBuilderUtils::UnusedIdGenerator(doc.buffers), BufferBuilderUtils::UnusedIdGenerator(doc.bufferViews), BufferBuilderUtils::UnusedIdGenerator(doc.accessors));
+    builder.AddBuffer();
+
+    auto GenerateAccessorId = BufferBuilderUtils::UnusedIdGenerator(resultDocument.accessors);
+    auto GenerateMeshId = BufferBuilderUtils::UnusedIdGenerator(resultDocument.meshes);
+    auto GenerateNodeId = BufferBuilderUtils::UnusedIdGenerator(resultDocument.nodes);
+
+    // Nodes that move relative to their root node can't be baked, and neither can anything under them
+    std::unordered_set<std::string> movingNodeIds;
+    for (const auto& animation : doc.animations.Elements())
+    {
+        for (const auto& channel : animation.channels.Elements())
+        {
+            movingNodeIds.insert(channel.target.nodeId);
+        }
+    }
+    for (const auto& skin : doc.skins.Elements())
+    {
+        movingNodeIds.insert(skin.jointIds.begin(), skin.jointIds.end());
+    }
+
+    // Nodes with MSFT_lod levels and the levels themselves are left intact
+    std::unordered_set<std::string> lodNodeIds;
+    for (const auto& lod : GLTFLODUtils::ParseDocumentNodeLODs(doc))
+    {
+        if (lod.second != nullptr && !lod.second->empty())
+        {
+            lodNodeIds.insert(lod.first);
+            lodNodeIds.insert(lod.second->begin(), lod.second->end());
+        }
+    }
+
+    std::unordered_map<std::string, std::string> parentIds;
+    for (const auto& node : doc.nodes.Elements())
+    {
+        for (const auto& childId : node.children)
+        {
+            parentIds[childId] = node.id;
+        }
+    }
+
+    std::unordered_map<std::string, std::set<size_t>> batchedPrimitives;
+    std::unordered_set<std::string> visitedRootIds;
+    for (const auto& scene : doc.scenes.Elements())
+    {
+        for (const auto& rootId : scene.nodes)
+        {
+            if (lodNodeIds.count(rootId) > 0 || !visitedRootIds.insert(rootId).second)
+            {
+                continue;
+            }
+
+            // The static primitives under the root node, in its space
+            std::vector<PrimitiveInstance> instances;
+            std::vector<std::pair<std::string, Transform>> stack = { { rootId, TransformUtils::Identity } };
+            while (!stack.empty())
+            {
+                auto nodeId = stack.back().first;
+                auto transform = stack.back().second;
+                stack.pop_back();
+
+                const auto& node = doc.nodes.Get(nodeId);
+                if (!node.meshId.empty() && node.skinId.empty() && TransformUtils::GetDeterminant(transform) != 0)
+                {
+                    const auto& mesh = doc.meshes.Get(node.meshId);
+                    for (size_t i = 0; i < mesh.primitives.size(); i++)
+                    {
+                        const auto& primitive = mesh.primitives[i];
+                        if (!IsBatchable(doc, primitive))
+                        {
+                            continue;
+                        }
+
+                        const auto& positionAccessor = doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+                        if (positionAccessor.count == 0 || positionAccessor.count > options.MaxVertexCount)
+                        {
+                            continue;
+                        }
+
+                        // The center of the bounding box of the primitive, which an affine transform maps to the center of the transformed box
+                        auto positions = reinterpret_cast<const float*>(cache.Get(positionAccessor).data());
+                        std::array<double, 3> localMin = { positions[0], positions[1], positions[2] };
+                        std::array<double, 3> localMax = localMin;
+                        for (size_t v = 1; v < positionAccessor.count; v++)
+                        {
+                            for (size_t j = 0; j < 3; j++)
+                            {
+                                localMin[j] = std::min<double>(localMin[j], positions[v * 3 + j]);
+                                localMax[j] = std::max<double>(localMax[j], positions[v * 3 + j]);
+                            }
+                        }
+
+                        PrimitiveInstance instance = { nodeId, i, &primitive, transform, positionAccessor.count, {} };
+                        for (size_t row = 0; row < 3; row++)
+                        {
+                            instance.center[row] = transform[12 + row];
+                            for (size_t column = 0; column < 3; column++)
+                            {
+                                instance.center[row] += transform[column * 4 + row] * (localMin[column] + localMax[column]) / 2;
+                            }
+                        }
+                        instances.push_back(instance);
+                    }
+                }
+
+                for (auto it = node.children.rbegin(); it != node.children.rend(); it++)
+                {
+                    if (movingNodeIds.count(*it) == 0 && lodNodeIds.count(*it) == 0)
+                    {
+                        stack.emplace_back(*it, TransformUtils::Multiply(transform, TransformUtils::GetLocalTransform(doc.nodes.Get(*it))));
+                    }
+                }
+            }
+
+            if (instances.size() < 2)
+            {
+                continue;
+            }
+
+            // Spatial grouping: a grid over the centers of the primitives
+            std::array<double, 3> gridMin = instances[0].center;
+            std::array<double, 3> gridMax = instances[0].center;
+            for (const auto& instance : instances)
+            {
+                for (size_t j = 0; j < 3; j++)
+                {
+                    gridMin[j] = std::min(gridMin[j], instance.center[j]);
+                    gridMax[j] = std::max(gridMax[j], instance.center[j]);
+                }
+            }
+            double cellSize = 0;
+            if (options.GridResolution > 0)
+            {
+                cellSize = std::max({ gridMax[0] - gridMin[0], gridMax[1] - gridMin[1], gridMax[2] - gridMin[2] }) / options.GridResolution;
+            }
+
+            std::map<std::array<size_t, 3>, std::map<std::string, std::vector<const PrimitiveInstance*>>> cells;
+            for (const auto& instance : instances)
+            {
+                std::array<size_t, 3> cell = {};
+                for (size_t j = 0; j < 3 && cellSize > 0; j++)
+                {
+                    cell[j] = std::min(static_cast<size_t>((instance.center[j] - gridMin[j]) / cellSize), options.GridResolution - 1);
+                }
+                cells[cell][GetBatchKey(doc, *instance.primitive)].push_back(&instance);
+            }
+
+            auto rootNode = resultDocument.nodes.Get(rootId);
+            for (const auto& cell : cells)
+            {
+                Mesh batchMesh;
+                for (const auto& group : cell.second)
+                {
+                    // Primitives are merged in order until the next one would exceed the vertex count
+                    std::vector<std::vector<const PrimitiveInstance*>> batches(1);
+                    size_t batchVertexCount = 0;
+                    for (auto instance : group.second)
+                    {
+                        if (batchVertexCount + instance->vertexCount > options.MaxVertexCount)
+                        {
+                            batches.emplace_back();
+                            batchVertexCount = 0;
+                        }
+                        batches.back().push_back(instance);
+                        batchVertexCount += instance->vertexCount;
+                    }
+
+                    for (const auto& batch : batches)
+                    {
+                        if (batch.size() < 2)
+                        {
+                            continue;
+                        }
+
+                        batchMesh.primitives.push_back(MergePrimitives(resultDocument, builder, GenerateAccessorId, cache, doc, batch));
+                        for (auto instance : batch)
+                        {
+                            batchedPrimitives[instance->nodeId].insert(instance->primitiveIndex);
+                        }
+                    }
+                }
+
+                if (batchMesh.primitives.empty())
+                {
+                    continue;
+                }
+
+                auto batchName = (rootNode.name.empty() ? "node" + rootNode.id : rootNode.name) + "_batch" + std::to_string(rootNode.children.size());
+
+                batchMesh.id = GenerateMeshId(builder);
+                batchMesh.name = batchName;
+
+                Node batchNode;
+                batchNode.id = GenerateNodeId(builder);
+                batchNode.name = batchName;
+                batchNode.meshId = resultDocument.meshes.Append(std::move(batchMesh)).id;
+
+                rootNode.children.push_back(resultDocument.nodes.Append(std::move(batchNode)).id);
+            }
+            resultDocument.nodes.Replace(rootNode);
+        }
+    }
+
+    if (batchedPrimitives.empty())
+    {
+        return doc;
+    }
+
+    // The batched nodes keep the primitives that weren't merged, in a mesh of their own when the mesh is shared
+    std::unordered_set<std::string> replacedMeshIds;
+    std::vector<std::string> emptiedNodeIds;
+    for (const auto& batched : batchedPrimitives)
+    {
+        auto node = resultDocument.nodes.Get(batched.first);
+        const auto& mesh = doc.meshes.Get(node.meshId);
+        replacedMeshIds.insert(mesh.id);
+
+        if (batched.second.size() == mesh.primitives.size())
+        {
+            node.meshId.clear();
+            emptiedNodeIds.push_back(node.id);
+        }
+        else
+        {
+            Mesh remainingMesh(mesh);
+            remainingMesh.id = GenerateMeshId(builder);
+            remainingMesh.primitives.clear();
+            for (size_t i = 0; i < mesh.primitives.size(); i++)
+            {
+                if (batched.second.count(i) == 0)
+                {
+                    remainingMesh.primitives.push_back(mesh.primitives[i]);
+                }
+            }
+            node.meshId = resultDocument.meshes.Append(std::move(remainingMesh)).id;
+        }
+
+        resultDocument.nodes.Replace(node);
+    }
+
+    // Remove the nodes that are left empty, and then their parents when they become empty
+    std::unordered_set<std::string> referencedNodeIds(movingNodeIds.begin(), movingNodeIds.end());
+    referencedNodeIds.insert(lodNodeIds.begin(), lodNodeIds.end());
+    for (const auto& skin : doc.skins.Elements())
+    {
+        referencedNodeIds.insert(skin.skeletonId);
+    }
+    for (const auto& scene : doc.scenes.Elements())
+    {
+        referencedNodeIds.insert(scene.nodes.begin(), scene.nodes.end());
+    }
+
+    while (!emptiedNodeIds.empty())
+    {
+        auto nodeId = emptiedNodeIds.back();
+        emptiedNodeIds.pop_back();
+        if (!resultDocument.nodes.Has(nodeId))
+        {
+            continue;
+        }
+
+        const auto& node = resultDocument.nodes.Get(nodeId);
+        if (!node.meshId.empty() || !node.cameraId.empty() || !node.skinId.empty() || !node.children.empty() ||
+            !node.extensions.empty() || !node.extras.empty() || referencedNodeIds.count(nodeId) > 0)
+        {
+            continue;
+        }
+
+        resultDocument.nodes.Remove(nodeId);
+
+        auto parent = parentIds.find(nodeId);
+        if (parent != parentIds.end())
+        {
+            auto parentNode = resultDocument.nodes.Get(parent->second);
+            parentNode.children.erase(std::remove(parentNode.children.begin(), parentNode.children.end(), nodeId), parentNode.children.end());
+            resultDocument.nodes.Replace(parentNode);
+            emptiedNodeIds.push_back(parentNode.id);
+        }
+    }
+
+    // Remove the meshes that no node uses anymore, then the accessors and bufferViews that only they used
+    for (const auto& node : resultDocument.nodes.Elements())
+    {
+        replacedMeshIds.erase(node.meshId);
+    }
+
+    std::unordered_set<std::string> replacedAccessorIds;
+    for (const auto& meshId : replacedMeshIds)
+    {
+        for (const auto& primitive : resultDocument.meshes.Get(meshId).primitives)
+        {
+            replacedAccessorIds.insert(primitive.indicesAccessorId);
+            for (const auto& attribute : primitive.attributes)
+            {
+                replacedAccessorIds.insert(attribute.second);
+            }
+        }
+        resultDocument.meshes.Remove(meshId);
+    }
+
+    std::unordered_set<std::string> replacedBufferViewIds;
+    auto usedAccessorIds = GetUsedAccessorIds(resultDocument);
+    for (const auto& accessorId : replacedAccessorIds)
+    {
+        if (!accessorId.empty() && usedAccessorIds.count(accessorId) == 0 && resultDocument.accessors.Has(accessorId))
+        {
+            replacedBufferViewIds.insert(resultDocument.accessors.Get(accessorId).bufferViewId);
+            resultDocument.accessors.Remove(accessorId);
+        }
+    }
+
+    for (const auto& accessor : resultDocument.accessors.Elements())
+    {
+        replacedBufferViewIds.erase(accessor.bufferViewId);
+        if (accessor.sparse.count > 0)
+        {
+            replacedBufferViewIds.erase(accessor.sparse.indicesBufferViewId);
+            replacedBufferViewIds.erase(accessor.sparse.valuesBufferViewId);
+        }
+    }
+    for (const auto& image : resultDocument.images.Elements())
+    {
+        replacedBufferViewIds.erase(image.bufferViewId);
+    }
+    for (const auto& mesh : resultDocument.meshes.Elements())
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>())
+            {
+                replacedBufferViewIds.erase(primitive.GetExtension<KHR::MeshPrimitives::DracoMeshCompression>().bufferViewId);
+            }
+        }
+    }
+    for (const auto& bufferViewId : replacedBufferViewIds)
+    {
+        if (resultDocument.bufferViews.Has(bufferViewId))
+        {
+            resultDocument.bufferViews.Remove(bufferViewId);
+        }
+    }
+
+    builder.Output(resultDocument);
+
+    if (statistics != nullptr)
+    {
+        statistics->PrimitivesAfter = CountDrawnPrimitives(resultDocument);
+    }
+
+    return resultDocument;
+}
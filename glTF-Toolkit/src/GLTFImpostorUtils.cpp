@@ -0,0 +1,911 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include <DirectXTex.h>
+
+#include "GLTFImpostorUtils.h"
+#include "BufferBuilderUtils.h"
+#include "GLTFTextureUtils.h"
+#include "AccessorUtils.h"
+#include "MeshoptCodec.h"
+#include "ParallelUtils.h"
+#include "TransformUtils.h"
+
+#include "GLTFSDK/BufferBuilder.h"
+#include "GLTFSDK/ExtensionsKHR.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    const double PI = 3.14159265358979323846;
+
+    // Background pixels up to this distance from the rendered pixels take their color and normal, so that
+    // filtering and mipmapping don't blend the edges of the impostor with the background
+    const size_t PADDING = 4;
+
+    typedef TransformUtils::Transform Transform;
+    typedef std::array<double, 3> Point;
+
+    Point Subtract(const Point& a, const Point& b)
+    {
+        return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    }
+
+    Point Cross(const Point& a, const Point& b)
+    {
+        return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+    }
+
+    double Dot(const Point& a, const Point& b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    Point Normalize(const Point& a)
+    {
+        double length = std::sqrt(Dot(a, a));
+        return length > 0 ? Point{ a[0] / length, a[1] / length, a[2] / length } : a;
+    }
+
+    // The inputs of the materials that the rasterizer evaluates; textures are in the DXGI_FORMAT_R32G32B32A32_FLOAT format
+    struct RenderMaterial
+    {
+        std::array<float, 4> baseColorFactor = { 1.0f, 1.0f, 1.0f, 1.0f };
+        const DirectX::ScratchImage* baseColorTexture = nullptr;
+        size_t baseColorTexCoord = 0;
+
+        const DirectX::ScratchImage* normalTexture = nullptr;
+        size_t normalTexCoord = 0;
+        float normalScale = 1.0f;
+
+        // Fragments whose alpha is lower are discarded
+        float alphaCutoff = 0.0f;
+        bool doubleSided = false;
+    };
+
+    // A vertex in the space of the root node
+    struct RenderVertex
+    {
+        Point position;
+        Point normal;
+        std::array<double, 4> tangent;
+        std::array<double, 2> texCoords[2];
+    };
+
+    struct RenderTriangle
+    {
+        RenderVertex vertices[3];
+        const RenderMaterial* material;
+        bool hasTangents;
+    };
+
+    // An orthographic view of a root node, whose image is centered on the center of its bounds
+    struct View
+    {
+        // The direction towards the camera, and the directions of the right and top of the image
+        Point direction;
+        Point right;
+        Point up;
+
+        Point center;
+
+        // Half of the width and height of the image, in the space of the root node
+        double halfSize;
+
+        // The position of the image in the atlas, in pixels
+        size_t x;
+        size_t y;
+    };
+
+    // A triangle in the pixels of a view, from the top left corner of the view; depth increases towards the camera
+    struct ProjectedTriangle
+    {
+        double x[3];
+        double y[3];
+        double depth[3];
+        double area;
+    };
+
+    // Whether the data of an accessor can be read
+    bool IsPlainAccessor(const Document& doc, const Accessor& accessor)
+    {
+        return !accessor.bufferViewId.empty() && accessor.sparse.count == 0 &&
+            doc.bufferViews.Get(accessor.bufferViewId).extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) == 0;
+    }
+
+    // Whether a primitive can be rendered: a triangle list with float positions, whose data can be read
+    bool CanRender(const Document& doc, const MeshPrimitive& primitive)
+    {
+        if (primitive.mode != MESH_TRIANGLES || primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>() || !primitive.HasAttribute(ACCESSOR_POSITION))
+        {
+            return false;
+        }
+
+        const auto& positionAccessor = doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+        if (positionAccessor.componentType != COMPONENT_FLOAT || positionAccessor.type != TYPE_VEC3 || !IsPlainAccessor(doc, positionAccessor))
+        {
+            return false;
+        }
+
+        return primitive.indicesAccessorId.empty() || IsPlainAccessor(doc, doc.accessors.Get(primitive.indicesAccessorId));
+    }
+
+    std::vector<uint32_t> ReadIndices(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        switch (accessor.componentType)
+        {
+        case COMPONENT_UNSIGNED_BYTE:
+        {
+            auto indices = reader.ReadBinaryData<uint8_t>(doc, accessor);
+            return std::vector<uint32_t>(indices.begin(), indices.end());
+        }
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            auto indices = reader.ReadBinaryData<uint16_t>(doc, accessor);
+            return std::vector<uint32_t>(indices.begin(), indices.end());
+        }
+        case COMPONENT_UNSIGNED_INT:
+            return reader.ReadBinaryData<uint32_t>(doc, accessor);
+        default:
+            throw GLTFException("Invalid index component type.");
+        }
+    }
+
+    // Reads a float vertex attribute, or nothing if the primitive doesn't have it or its data can't be read
+    std::vector<float> ReadAttribute(const GLTFResourceReader& reader, const Document& doc, const MeshPrimitive& primitive, const std::string& name, AccessorType type, size_t vertexCount)
+    {
+        std::string accessorId;
+        if (!primitive.TryGetAttributeAccessorId(name, accessorId))
+        {
+            return {};
+        }
+
+        const auto& accessor = doc.accessors.Get(accessorId);
+        if (accessor.componentType != COMPONENT_FLOAT || accessor.type != type || accessor.count != vertexCount || !IsPlainAccessor(doc, accessor))
+        {
+            return {};
+        }
+
+        return reader.ReadBinaryData<float>(doc, accessor);
+    }
+
+    // Reads the triangles of the meshes of a node and its descendants, transformed to the space of the root node
+    void GatherTriangles(
+        const GLTFResourceReader& reader,
+        const Document& doc,
+        const std::string& nodeId,
+        const Transform& transform,
+        const std::unordered_map<std::string, RenderMaterial>& materials,
+        const RenderMaterial& defaultMaterial,
+        std::vector<RenderTriangle>& triangles)
+    {
+        const auto& node = doc.nodes.Get(nodeId);
+        if (!node.meshId.empty())
+        {
+            auto cofactors = TransformUtils::GetCofactors(transform);
+            bool mirrored = TransformUtils::GetDeterminant(transform) < 0;
+
+            for (const auto& primitive : doc.meshes.Get(node.meshId).primitives)
+            {
+                if (!CanRender(doc, primitive))
+                {
+                    continue;
+                }
+
+                auto positions = reader.ReadBinaryData<float>(doc, doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION)));
+                auto vertexCount = positions.size() / 3;
+                auto normals = ReadAttribute(reader, doc, primitive, ACCESSOR_NORMAL, TYPE_VEC3, vertexCount);
+                auto tangents = ReadAttribute(reader, doc, primitive, ACCESSOR_TANGENT, TYPE_VEC4, vertexCount);
+                std::vector<float> texCoords[2] = {
+                    ReadAttribute(reader, doc, primitive, ACCESSOR_TEXCOORD_0, TYPE_VEC2, vertexCount),
+                    ReadAttribute(reader, doc, primitive, ACCESSOR_TEXCOORD_1, TYPE_VEC2, vertexCount)
+                };
+
+                std::vector<uint32_t> indices;
+                if (primitive.indicesAccessorId.empty())
+                {
+                    indices.resize(vertexCount);
+                    std::iota(indices.begin(), indices.end(), 0);
+                }
+                else
+                {
+                    indices = ReadIndices(reader, doc, doc.accessors.Get(primitive.indicesAccessorId));
+                }
+
+                auto material = primitive.materialId.empty() ? &defaultMaterial : &materials.at(primitive.materialId);
+
+                std::vector<RenderVertex> vertices(vertexCount);
+                for (size_t i = 0; i < vertexCount; i++)
+                {
+                    auto& vertex = vertices[i];
+                    vertex.position = TransformUtils::TransformPoint(transform, { positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2] });
+
+                    if (!normals.empty())
+                    {
+                        auto n = &normals[i * 3];
+                        for (size_t row = 0; row < 3; row++)
+                        {
+                            vertex.normal[row] = cofactors[row * 3] * n[0] + cofactors[row * 3 + 1] * n[1] + cofactors[row * 3 + 2] * n[2];
+                        }
+                        vertex.normal = Normalize(mirrored ? Point{ -vertex.normal[0], -vertex.normal[1], -vertex.normal[2] } : vertex.normal);
+                    }
+
+                    if (!tangents.empty())
+                    {
+                        auto t = &tangents[i * 4];
+                        Point tangent;
+                        for (size_t row = 0; row < 3; row++)
+                        {
+                            tangent[row] = transform[row] * t[0] + transform[4 + row] * t[1] + transform[8 + row] * t[2];
+                        }
+                        tangent = Normalize(tangent);
+
+                        // Mirroring flips the handedness of the tangent frame
+                        vertex.tangent = { tangent[0], tangent[1], tangent[2], mirrored ? -t[3] : t[3] };
+                    }
+
+                    for (size_t set = 0; set < 2; set++)
+                    {
+                        vertex.texCoords[set] = texCoords[set].empty() ? std::array<double, 2>{ 0.0, 0.0 } :
+                            std::array<double, 2>{ texCoords[set][i * 2], texCoords[set][i * 2 + 1] };
+                    }
+                }
+
+                for (size_t i = 0; i + 2 < indices.size(); i += 3)
+                {
+                    if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount)
+                    {
+                        throw GLTFException("Index out of range.");
+                    }
+
+                    // Mirroring flips the winding of the front faces
+                    RenderTriangle triangle;
+                    triangle.vertices[0] = vertices[indices[i]];
+                    triangle.vertices[1] = vertices[indices[mirrored ? i + 2 : i + 1]];
+                    triangle.vertices[2] = vertices[indices[mirrored ? i + 1 : i + 2]];
+                    triangle.material = material;
+                    triangle.hasTangents = !tangents.empty();
+
+                    // Without normals, the triangles are flat shaded
+                    if (normals.empty())
+                    {
+                        auto normal = Normalize(Cross(
+                            Subtract(triangle.vertices[1].position, triangle.vertices[0].position),
+                            Subtract(triangle.vertices[2].position, triangle.vertices[0].position)));
+                        for (auto& vertex : triangle.vertices)
+                        {
+                            vertex.normal = normal;
+                        }
+                    }
+
+                    triangles.push_back(triangle);
+                }
+            }
+        }
+
+        for (const auto& childId : node.children)
+        {
+            auto childTransform = TransformUtils::Multiply(transform, TransformUtils::GetLocalTransform(doc.nodes.Get(childId)));
+            GatherTriangles(reader, doc, childId, childTransform, materials, defaultMaterial, triangles);
+        }
+    }
+
+    // Samples a texture bilinearly, repeating it outside of [0, 1]
+    std::array<float, 4> Sample(const DirectX::ScratchImage& texture, const std::array<double, 2>& texCoord)
+    {
+        const auto& metadata = texture.GetMetadata();
+        auto pixels = texture.GetPixels();
+
+        double x = (texCoord[0] - std::floor(texCoord[0])) * metadata.width - 0.5;
+        double y = (texCoord[1] - std::floor(texCoord[1])) * metadata.height - 0.5;
+        double x0 = std::floor(x);
+        double y0 = std::floor(y);
+        double fx = x - x0;
+        double fy = y - y0;
+
+        auto Wrap = [](double coordinate, size_t size)
+        {
+            auto wrapped = static_cast<long long>(coordinate) % static_cast<long long>(size);
+            return static_cast<size_t>(wrapped < 0 ? wrapped + static_cast<long long>(size) : wrapped);
+        };
+        size_t columns[2] = { Wrap(x0, metadata.width), Wrap(x0 + 1, metadata.width) };
+        size_t rows[2] = { Wrap(y0, metadata.height), Wrap(y0 + 1, metadata.height) };
+
+        std::array<float, 4> result = {};
+        for (size_t j = 0; j < 2; j++)
+        {
+            for (size_t i = 0; i < 2; i++)
+            {
+                auto weight = static_cast<float>((i == 0 ? 1 - fx : fx) * (j == 0 ? 1 - fy : fy));
+                auto offset = rows[j] * metadata.width + columns[i];
+                result[0] += weight * *GLTFTextureUtils::GetChannelValue(pixels, offset, Channel::Red);
+                result[1] += weight * *GLTFTextureUtils::GetChannelValue(pixels, offset, Channel::Green);
+                result[2] += weight * *GLTFTextureUtils::GetChannelValue(pixels, offset, Channel::Blue);
+                result[3] += weight * *GLTFTextureUtils::GetChannelValue(pixels, offset, Channel::Alpha);
+            }
+        }
+        return result;
+    }
+
+    // Evaluates the material of a triangle at the given barycentric coordinates, and returns the linear base color and
+    // the normal in the space of the view, or false if the fragment is discarded by the alpha cutoff
+    bool Shade(const RenderTriangle& triangle, bool backFacing, const std::array<double, 3>& weights, const View& view, std::array<float, 4>& color, Point& normal)
+    {
+        const auto& material = *triangle.material;
+        auto Interpolate = [&weights](const auto& a, const auto& b, const auto& c, size_t component)
+        {
+            return weights[0] * a[component] + weights[1] * b[component] + weights[2] * c[component];
+        };
+        auto InterpolateTexCoord = [&](size_t set)
+        {
+            const auto& v = triangle.vertices;
+            return std::array<double, 2>{ Interpolate(v[0].texCoords[set], v[1].texCoords[set], v[2].texCoords[set], 0), Interpolate(v[0].texCoords[set], v[1].texCoords[set], v[2].texCoords[set], 1) };
+        };
+
+        color = material.baseColorFactor;
+        if (material.baseColorTexture != nullptr)
+        {
+            auto texel = Sample(*material.baseColorTexture, InterpolateTexCoord(material.baseColorTexCoord));
+            for (size_t i = 0; i < 4; i++)
+            {
+                color[i] *= texel[i];
+            }
+        }
+
+        if (color[3] < material.alphaCutoff)
+        {
+            return false;
+        }
+        color[3] = 1.0f;
+
+        const auto& v = triangle.vertices;
+        Point n = Normalize({ Interpolate(v[0].normal, v[1].normal, v[2].normal, 0), Interpolate(v[0].normal, v[1].normal, v[2].normal, 1), Interpolate(v[0].normal, v[1].normal, v[2].normal, 2) });
+        if (backFacing)
+        {
+            n = { -n[0], -n[1], -n[2] };
+        }
+
+        if (material.normalTexture != nullptr && triangle.hasTangents)
+        {
+            Point t = { Interpolate(v[0].tangent, v[1].tangent, v[2].tangent, 0), Interpolate(v[0].tangent, v[1].tangent, v[2].tangent, 1), Interpolate(v[0].tangent, v[1].tangent, v[2].tangent, 2) };
+            double tn = Dot(t, n);
+            t = Normalize({ t[0] - n[0] * tn, t[1] - n[1] * tn, t[2] - n[2] * tn });
+            auto b = Cross(n, t);
+            double handedness = v[0].tangent[3] < 0 ? -1.0 : 1.0;
+
+            auto texel = Sample(*material.normalTexture, InterpolateTexCoord(material.normalTexCoord));
+            double x = (texel[0] * 2.0 - 1.0) * material.normalScale;
+            double y = (texel[1] * 2.0 - 1.0) * material.normalScale;
+            double z = texel[2] * 2.0 - 1.0;
+            for (size_t i = 0; i < 3; i++)
+            {
+                n[i] = t[i] * x + b[i] * handedness * y + n[i] * z;
+            }
+            n = Normalize(n);
+        }
+
+        normal = { Dot(n, view.right), Dot(n, view.up), Dot(n, view.direction) };
+        return true;
+    }
+
+    double Edge(double ax, double ay, double bx, double by, double px, double py)
+    {
+        return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+    }
+}
+
+Document GLTFImpostorUtils::GenerateImpostor(
+    std::shared_ptr<IStreamReader> streamReader,
+    const Document& doc,
+    const ImpostorOptions& options,
+    const std::string& outputDirectory)
+{
+    if (options.ViewCount == 0 || options.ViewResolution < 4 || options.TileSize == 0)
+    {
+        throw std::invalid_argument("An impostor needs at least one view, of at least 4x4 pixels, and a tile size greater than 0.");
+    }
+
+    GLTFResourceReader reader(streamReader);
+
+    // Textures that can't be decoded (e.g. block compressed ones) are left out, and the factors of their materials used alone
+    std::map<std::string, DirectX::ScratchImage> baseColorTextures;
+    std::map<std::string, DirectX::ScratchImage> normalTextures;
+    auto LoadTexture = [&](std::map<std::string, DirectX::ScratchImage>& textures, const std::string& textureId, bool treatAsLinear) -> const DirectX::ScratchImage*
+    {
+        if (textures.count(textureId) == 0)
+        {
+            try
+            {
+                textures.emplace(textureId, GLTFTextureUtils::LoadTexture(streamReader, doc, textureId, treatAsLinear));
+            }
+            catch (const GLTFException&)
+            {
+                return nullptr;
+            }
+        }
+        return &textures.at(textureId);
+    };
+
+    std::unordered_map<std::string, RenderMaterial> materials;
+    for (const auto& material : doc.materials.Elements())
+    {
+        RenderMaterial renderMaterial;
+        const auto& baseColorFactor = material.metallicRoughness.baseColorFactor;
+        renderMaterial.baseColorFactor = { baseColorFactor.r, baseColorFactor.g, baseColorFactor.b, baseColorFactor.a };
+
+        const auto& baseColorTexture = material.metallicRoughness.baseColorTexture;
+        if (!baseColorTexture.textureId.empty() && baseColorTexture.texCoord < 2)
+        {
+            renderMaterial.baseColorTexture = LoadTexture(baseColorTextures, baseColorTexture.textureId, false);
+            renderMaterial.baseColorTexCoord = baseColorTexture.texCoord;
+        }
+
+        if (!material.normalTexture.textureId.empty() && material.normalTexture.texCoord < 2)
+        {
+            renderMaterial.normalTexture = LoadTexture(normalTextures, material.normalTexture.textureId, true);
+            renderMaterial.normalTexCoord = material.normalTexture.texCoord;
+            renderMaterial.normalScale = material.normalTexture.scale;
+        }
+
+        switch (material.alphaMode)
+        {
+        case ALPHA_MASK:
+            renderMaterial.alphaCutoff = material.alphaCutoff;
+            break;
+        case ALPHA_BLEND:
+            renderMaterial.alphaCutoff = 0.5f;
+            break;
+        default:
+            break;
+        }
+        renderMaterial.doubleSided = material.doubleSided;
+
+        materials.emplace(material.id, renderMaterial);
+    }
+    RenderMaterial defaultMaterial;
+
+    Document resultDocument;
+    resultDocument.asset = doc.asset;
+
+    // The impostor has the same scenes and root nodes as the original document, so that they can be merged as LODs
+    std::vector<std::string> rootNodeIds;
+    for (const auto& scene : doc.scenes.Elements())
+    {
+        Scene resultScene;
+        resultScene.id = scene.id;
+        resultScene.name = scene.name;
+        resultScene.nodes = scene.nodes;
+        resultDocument.scenes.Append(std::move(resultScene));
+
+        for (const auto& rootNodeId : scene.nodes)
+        {
+            if (std::find(rootNodeIds.begin(), rootNodeIds.end(), rootNodeId) == rootNodeIds.end())
+            {
+                rootNodeIds.push_back(rootNodeId);
+            }
+        }
+    }
+    resultDocument.defaultSceneId = doc.defaultSceneId;
+
+    auto columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(options.ViewCount))));
+    auto rows = (options.ViewCount + columns - 1) / columns;
+    auto resolution = options.ViewResolution;
+    auto atlasWidth = columns * resolution;
+    auto atlasHeight = rows * resolution;
+    auto tilesPerRow = (resolution + options.TileSize - 1) / options.TileSize;
+    auto tilesPerView = tilesPerRow * tilesPerRow;
+
+    // The quads of every root node, written once all of them are rendered
+    struct Quads
+    {
+        std::string nodeId;
+        std::string materialId;
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> tangents;
+        std::vector<float> texCoords;
+        std::vector<uint16_t> indices;
+    };
+    std::vector<Quads> impostors;
+
+    for (const auto& rootNodeId : rootNodeIds)
+    {
+        const auto& rootNode = doc.nodes.Get(rootNodeId);
+
+        // The impostor replaces the root node, so it keeps its transform and everything under it is rendered in its space
+        Node resultNode;
+        resultNode.id = rootNode.id;
+        resultNode.name = rootNode.name;
+        resultNode.matrix = rootNode.matrix;
+        resultNode.translation = rootNode.translation;
+        resultNode.rotation = rootNode.rotation;
+        resultNode.scale = rootNode.scale;
+
+        std::vector<RenderTriangle> triangles;
+        GatherTriangles(reader, doc, rootNodeId, TransformUtils::Identity, materials, defaultMaterial, triangles);
+
+        // A root node without any triangles that can be rendered has an empty impostor
+        if (triangles.empty())
+        {
+            resultDocument.nodes.Append(std::move(resultNode));
+            continue;
+        }
+
+        Point min = triangles[0].vertices[0].position;
+        Point max = min;
+        for (const auto& triangle : triangles)
+        {
+            for (const auto& vertex : triangle.vertices)
+            {
+                for (size_t i = 0; i < 3; i++)
+                {
+                    min[i] = std::min(min[i], vertex.position[i]);
+                    max[i] = std::max(max[i], vertex.position[i]);
+                }
+            }
+        }
+        Point center = { (min[0] + max[0]) / 2, (min[1] + max[1]) / 2, (min[2] + max[2]) / 2 };
+
+        // The views are spread over half a turn around the vertical axis, since every quad can be seen from both sides
+        std::vector<View> views(options.ViewCount);
+        for (size_t v = 0; v < views.size(); v++)
+        {
+            auto& view = views[v];
+            double angle = PI * v / views.size();
+            view.direction = { std::sin(angle), 0.0, std::cos(angle) };
+            view.right = { std::cos(angle), 0.0, -std::sin(angle) };
+            view.up = { 0.0, 1.0, 0.0 };
+            view.center = center;
+            view.x = (v % columns) * resolution;
+            view.y = (v / columns) * resolution;
+
+            view.halfSize = 0.0;
+            for (const auto& triangle : triangles)
+            {
+                for (const auto& vertex : triangle.vertices)
+                {
+                    auto offset = Subtract(vertex.position, center);
+                    view.halfSize = std::max({ view.halfSize, std::abs(Dot(offset, view.right)), std::abs(Dot(offset, view.up)) });
+                }
+            }
+
+            // A border of one pixel is left around the image, so that the quad isn't clipped by filtering
+            view.halfSize = view.halfSize > 0 ? view.halfSize * resolution / (resolution - 2) : 1.0;
+        }
+
+        // Each view projects the triangles and bins them into the tiles they overlap
+        std::vector<std::vector<ProjectedTriangle>> projections(views.size());
+        std::vector<std::vector<std::vector<uint32_t>>> bins(views.size());
+        ParallelUtils::For(views.size(), options.ThreadCount, [&](size_t v)
+        {
+            const auto& view = views[v];
+            auto& projected = projections[v];
+            auto& viewBins = bins[v];
+            projected.resize(triangles.size());
+            viewBins.resize(tilesPerView);
+
+            double scale = resolution / (2 * view.halfSize);
+            for (size_t t = 0; t < triangles.size(); t++)
+            {
+                auto& p = projected[t];
+                for (size_t i = 0; i < 3; i++)
+                {
+                    auto offset = Subtract(triangles[t].vertices[i].position, view.center);
+                    p.x[i] = (Dot(offset, view.right) + view.halfSize) * scale;
+                    p.y[i] = (view.halfSize - Dot(offset, view.up)) * scale;
+                    p.depth[i] = Dot(offset, view.direction);
+                }
+
+                // The image is flipped vertically, so counterclockwise front faces have a negative area
+                p.area = Edge(p.x[0], p.y[0], p.x[1], p.y[1], p.x[2], p.y[2]);
+                if (p.area == 0 || (p.area > 0 && !triangles[t].material->doubleSided))
+                {
+                    continue;
+                }
+
+                auto minX = std::max(0.0, std::floor(std::min({ p.x[0], p.x[1], p.x[2] })));
+                auto minY = std::max(0.0, std::floor(std::min({ p.y[0], p.y[1], p.y[2] })));
+                auto maxX = std::min(resolution - 1.0, std::floor(std::max({ p.x[0], p.x[1], p.x[2] })));
+                auto maxY = std::min(resolution - 1.0, std::floor(std::max({ p.y[0], p.y[1], p.y[2] })));
+                if (minX > maxX || minY > maxY)
+                {
+                    continue;
+                }
+
+                for (auto tileY = static_cast<size_t>(minY) / options.TileSize; tileY <= static_cast<size_t>(maxY) / options.TileSize; tileY++)
+                {
+                    for (auto tileX = static_cast<size_t>(minX) / options.TileSize; tileX <= static_cast<size_t>(maxX) / options.TileSize; tileX++)
+                    {
+                        viewBins[tileY * tilesPerRow + tileX].push_back(static_cast<uint32_t>(t));
+                    }
+                }
+            }
+        });
+
+        DirectX::ScratchImage colorImage;
+        DirectX::ScratchImage normalImage;
+        if (FAILED(colorImage.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, atlasWidth, atlasHeight, 1, 1)) ||
+            FAILED(normalImage.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, atlasWidth, atlasHeight, 1, 1)))
+        {
+            throw GLTFException("Failed to initialize the impostor atlas.");
+        }
+
+        auto colorPixels = reinterpret_cast<float*>(colorImage.GetPixels());
+        auto normalPixels = reinterpret_cast<float*>(normalImage.GetPixels());
+        for (size_t i = 0; i < atlasWidth * atlasHeight; i++)
+        {
+            std::fill(colorPixels + i * 4, colorPixels + i * 4 + 4, 0.0f);
+            normalPixels[i * 4] = 0.5f;
+            normalPixels[i * 4 + 1] = 0.5f;
+            normalPixels[i * 4 + 2] = 1.0f;
+            normalPixels[i * 4 + 3] = 1.0f;
+        }
+        std::vector<double> depths(atlasWidth * atlasHeight, std::numeric_limits<double>::lowest());
+
+        // Tiles only write to their own pixels, so all the tiles of all the views are rasterized in parallel
+        ParallelUtils::For(views.size() * tilesPerView, options.ThreadCount, [&](size_t index)
+        {
+            auto v = index / tilesPerView;
+            auto tile = index % tilesPerView;
+            const auto& view = views[v];
+            auto tileX = (tile % tilesPerRow) * options.TileSize;
+            auto tileY = (tile / tilesPerRow) * options.TileSize;
+            auto tileEndX = std::min(tileX + options.TileSize, resolution);
+            auto tileEndY = std::min(tileY + options.TileSize, resolution);
+
+            for (auto t : bins[v][tile])
+            {
+                const auto& p = projections[v][t];
+                bool backFacing = p.area > 0;
+
+                auto startX = std::max(tileX, static_cast<size_t>(std::max(0.0, std::floor(std::min({ p.x[0], p.x[1], p.x[2] })))));
+                auto startY = std::max(tileY, static_cast<size_t>(std::max(0.0, std::floor(std::min({ p.y[0], p.y[1], p.y[2] })))));
+                auto endX = std::min(tileEndX, static_cast<size_t>(std::max(0.0, std::floor(std::max({ p.x[0], p.x[1], p.x[2] })) + 1)));
+                auto endY = std::min(tileEndY, static_cast<size_t>(std::max(0.0, std::floor(std::max({ p.y[0], p.y[1], p.y[2] })) + 1)));
+
+                for (auto y = startY; y < endY; y++)
+                {
+                    for (auto x = startX; x < endX; x++)
+                    {
+                        // Pixels are sampled at their centers
+                        double sx = x + 0.5;
+                        double sy = y + 0.5;
+                        std::array<double, 3> weights = {
+                            Edge(p.x[1], p.y[1], p.x[2], p.y[2], sx, sy) / p.area,
+                            Edge(p.x[2], p.y[2], p.x[0], p.y[0], sx, sy) / p.area,
+                            Edge(p.x[0], p.y[0], p.x[1], p.y[1], sx, sy) / p.area
+                        };
+                        if (weights[0] < 0 || weights[1] < 0 || weights[2] < 0)
+                        {
+                            continue;
+                        }
+
+                        auto pixel = (view.y + y) * atlasWidth + view.x + x;
+                        double depth = weights[0] * p.depth[0] + weights[1] * p.depth[1] + weights[2] * p.depth[2];
+                        if (depth <= depths[pixel])
+                        {
+                            continue;
+                        }
+
+                        std::array<float, 4> color;
+                        Point normal;
+                        if (!Shade(triangles[t], backFacing, weights, view, color, normal))
+                        {
+                            continue;
+                        }
+
+                        depths[pixel] = depth;
+                        std::copy(color.begin(), color.end(), colorPixels + pixel * 4);
+                        for (size_t i = 0; i < 3; i++)
+                        {
+                            normalPixels[pixel * 4 + i] = static_cast<float>(normal[i] * 0.5 + 0.5);
+                        }
+                    }
+                }
+            }
+        });
+
+        // Each pass fills the background pixels next to filled ones with the average of their filled neighbors, keeping them transparent
+        ParallelUtils::For(views.size(), options.ThreadCount, [&](size_t v)
+        {
+            const auto& view = views[v];
+            std::vector<bool> filled(resolution * resolution);
+            for (size_t y = 0; y < resolution; y++)
+            {
+                for (size_t x = 0; x < resolution; x++)
+                {
+                    filled[y * resolution + x] = colorPixels[((view.y + y) * atlasWidth + view.x + x) * 4 + 3] > 0.0f;
+                }
+            }
+
+            for (size_t pass = 0; pass < PADDING; pass++)
+            {
+                std::vector<size_t> newlyFilled;
+                for (size_t y = 0; y < resolution; y++)
+                {
+                    for (size_t x = 0; x < resolution; x++)
+                    {
+                        if (filled[y * resolution + x])
+                        {
+                            continue;
+                        }
+
+                        std::array<float, 6> sum = {};
+                        size_t count = 0;
+                        for (size_t ny = (y > 0 ? y - 1 : y); ny <= std::min(y + 1, resolution - 1); ny++)
+                        {
+                            for (size_t nx = (x > 0 ? x - 1 : x); nx <= std::min(x + 1, resolution - 1); nx++)
+                            {
+                                if (filled[ny * resolution + nx])
+                                {
+                                    auto neighbor = ((view.y + ny) * atlasWidth + view.x + nx) * 4;
+                                    for (size_t i = 0; i < 3; i++)
+                                    {
+                                        sum[i] += colorPixels[neighbor + i];
+                                        sum[3 + i] += normalPixels[neighbor + i];
+                                    }
+                                    count++;
+                                }
+                            }
+                        }
+
+                        if (count > 0)
+                        {
+                            auto pixel = ((view.y + y) * atlasWidth + view.x + x) * 4;
+                            for (size_t i = 0; i < 3; i++)
+                            {
+                                colorPixels[pixel + i] = sum[i] / count;
+                                normalPixels[pixel + i] = sum[3 + i] / count;
+                            }
+                            newlyFilled.push_back(y * resolution + x);
+                        }
+                    }
+                }
+
+                for (auto i : newlyFilled)
+                {
+                    filled[i] = true;
+                }
+            }
+        });
+
+        DirectX::ScratchImage convertedColor;
+        if (FAILED(DirectX::Convert(*colorImage.GetImage(0, 0, 0), DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, convertedColor)))
+        {
+            throw GLTFException("Failed to convert texture to DXGI_FORMAT_B8G8R8A8_UNORM_SRGB for processing.");
+        }
+        DirectX::ScratchImage convertedNormal;
+        if (FAILED(DirectX::Convert(*normalImage.GetImage(0, 0, 0), DXGI_FORMAT_B8G8R8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, convertedNormal)))
+        {
+            throw GLTFException("Failed to convert texture to DXGI_FORMAT_B8G8R8A8_UNORM for processing.");
+        }
+
+        auto colorPath = GLTFTextureUtils::SaveAsPng(&convertedColor, "impostor_" + rootNodeId + ".png", outputDirectory, &GUID_WICPixelFormat32bppBGRA);
+        auto normalPath = GLTFTextureUtils::SaveAsPng(&convertedNormal, "impostor_normal_" + rootNodeId + ".png", outputDirectory, &GUID_WICPixelFormat32bppBGRA);
+
+        Texture colorTexture;
+        colorTexture.imageId = GLTFTextureUtils::AddImageToDocument(resultDocument, colorPath);
+        Texture normalTexture;
+        normalTexture.imageId = GLTFTextureUtils::AddImageToDocument(resultDocument, normalPath);
+
+        // The atlas has the base color and normals of the original materials; the other properties aren't rendered
+        Material material;
+        material.name = "impostor_" + rootNodeId;
+        material.metallicRoughness.baseColorTexture.textureId = resultDocument.textures.Append(std::move(colorTexture), AppendIdPolicy::GenerateOnEmpty).id;
+        material.metallicRoughness.metallicFactor = 0.0f;
+        material.metallicRoughness.roughnessFactor = 1.0f;
+        material.normalTexture.textureId = resultDocument.textures.Append(std::move(normalTexture), AppendIdPolicy::GenerateOnEmpty).id;
+        material.alphaMode = ALPHA_MASK;
+        material.alphaCutoff = 0.5f;
+        material.doubleSided = true;
+
+        Quads quads;
+        quads.nodeId = rootNodeId;
+        quads.materialId = resultDocument.materials.Append(std::move(material), AppendIdPolicy::GenerateOnEmpty).id;
+
+        // Each view is shown on a quad through the center of the bounds, facing its camera, with the tangent frame of its image
+        for (size_t v = 0; v < views.size(); v++)
+        {
+            const auto& view = views[v];
+            double left = static_cast<double>(view.x) / atlasWidth;
+            double top = static_cast<double>(view.y) / atlasHeight;
+            double right = static_cast<double>(view.x + resolution) / atlasWidth;
+            double bottom = static_cast<double>(view.y + resolution) / atlasHeight;
+
+            const double corners[4][4] = {
+                { -1.0, -1.0, left, bottom },
+                { 1.0, -1.0, right, bottom },
+                { 1.0, 1.0, right, top },
+                { -1.0, 1.0, left, top }
+            };
+
+            auto first = static_cast<uint16_t>(quads.positions.size() / 3);
+            for (const auto& corner : corners)
+            {
+                for (size_t i = 0; i < 3; i++)
+                {
+                    quads.positions.push_back(static_cast<float>(view.center[i] + (view.right[i] * corner[0] + view.up[i] * corner[1]) * view.halfSize));
+                    quads.normals.push_back(static_cast<float>(view.direction[i]));
+                    quads.tangents.push_back(static_cast<float>(view.right[i]));
+                }
+                quads.tangents.push_back(1.0f);
+                quads.texCoords.push_back(static_cast<float>(corner[2]));
+                quads.texCoords.push_back(static_cast<float>(corner[3]));
+            }
+            quads.indices.insert(quads.indices.end(), {
+                first, static_cast<uint16_t>(first + 1), static_cast<uint16_t>(first + 2),
+                first, static_cast<uint16_t>(first + 2), static_cast<uint16_t>(first + 3) });
+        }
+
+        resultDocument.nodes.Append(std::move(resultNode));
+        impostors.push_back(std::move(quads));
+    }
+
+    if (impostors.empty())
+    {
+        return resultDocument;
+    }
+
+    auto writer = std::make_unique<GLTFResourceWriter>(std::make_shared<BufferFileStreamWriter>());
+    writer->SetUriPrefix((std::experimental::filesystem::u8path(outputDirectory) / "Impostor").u8string());
+    BufferBuilder builder(std::move(writer));
+    builder.AddBuffer();
+
+    auto AddAccessor = [&](const void* data, size_t count, AccessorType type, ComponentType componentType, BufferViewTarget target)
+    {
+        size_t componentSize = componentType == COMPONENT_FLOAT ? sizeof(float) : sizeof(uint16_t);
+
+        Accessor accessor;
+        accessor.bufferViewId = builder.AddBufferView(data, count * Accessor::GetTypeCount(type) * componentSize, {}, target).id;
+        accessor.type = type;
+        accessor.componentType = componentType;
+        accessor.count = count;
+        return accessor;
+    };
+
+    for (const auto& quads : impostors)
+    {
+        auto vertexCount = quads.positions.size() / 3;
+
+        auto positionAccessor = AddAccessor(quads.positions.data(), vertexCount, TYPE_VEC3, COMPONENT_FLOAT, BufferViewTarget::ARRAY_BUFFER);
+        auto minmax = AccessorUtils::CalculateMinMax(positionAccessor, quads.positions);
+        positionAccessor.min = minmax.first;
+        positionAccessor.max = minmax.second;
+
+        MeshPrimitive primitive;
+        primitive.materialId = quads.materialId;
+        primitive.attributes[ACCESSOR_POSITION] = resultDocument.accessors.Append(std::move(positionAccessor), AppendIdPolicy::GenerateOnEmpty).id;
+        primitive.attributes[ACCESSOR_NORMAL] = resultDocument.accessors.Append(
+            AddAccessor(quads.normals.data(), vertexCount, TYPE_VEC3, COMPONENT_FLOAT, BufferViewTarget::ARRAY_BUFFER), AppendIdPolicy::GenerateOnEmpty).id;
+        primitive.attributes[ACCESSOR_TANGENT] = resultDocument.accessors.Append(
+            AddAccessor(quads.tangents.data(), vertexCount, TYPE_VEC4, COMPONENT_FLOAT, BufferViewTarget::ARRAY_BUFFER), AppendIdPolicy::GenerateOnEmpty).id;
+        primitive.attributes[ACCESSOR_TEXCOORD_0] = resultDocument.accessors.Append(
+            AddAccessor(quads.texCoords.data(), vertexCount, TYPE_VEC2, COMPONENT_FLOAT, BufferViewTarget::ARRAY_BUFFER), AppendIdPolicy::GenerateOnEmpty).id;
+        primitive.indicesAccessorId = resultDocument.accessors.Append(
+            AddAccessor(quads.indices.data(), quads.indices.size(), TYPE_SCALAR, COMPONENT_UNSIGNED_SHORT, BufferViewTarget::ELEMENT_ARRAY_BUFFER), AppendIdPolicy::GenerateOnEmpty).id;
+
+        Mesh mesh;
+        mesh.name = "impostor_" + quads.nodeId;
+        mesh.primitives.push_back(std::move(primitive));
+        auto meshId = resultDocument.meshes.Append(std::move(mesh), AppendIdPolicy::GenerateOnEmpty).id;
+
+        Node node(resultDocument.nodes.Get(quads.nodeId));
+        node.meshId = meshId;
+        resultDocument.nodes.Replace(std::move(node));
+    }
+
+    builder.Output(resultDocument);
+
+    return resultDocument;
+}
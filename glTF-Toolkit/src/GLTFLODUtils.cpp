@@ -6,6 +6,10 @@
 #include "GLTFTextureCompressionUtils.h"
 #include "GLTFTexturePackingUtils.h"
 #include "GLTFLODUtils.h"
+#include "GLTFMaterialUtils.h"
+#include "HashUtils.h"
+#include "MeshoptCodec.h"
+#include "TransformUtils.h"
 
 #include "GLTFSDK/GLTF.h"
 #include "GLTFSDK/Constants.h"
@@ -14,6 +18,8 @@
 #include "GLTFSDK/ExtensionsKHR.h"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <iostream>
 #include <set>
 #include <codecvt>
@@ -27,34 +33,295 @@ const char* Microsoft::glTF::Toolkit::MSFT_LOD_IDS_KEY = "ids";
 
 namespace
 {
-    inline void AddIndexOffset(std::string& id, size_t offset)
+    // Maps the ids of the elements of a container of a LOD document to the ids and indices they get when they are
+    // appended to the same container of the merged document. The new ids are the merged indices, like the ones of
+    // deserialized documents, unless the merged document already uses them.
+    // If existingIds isn't empty, each non-empty entry is the id of an identical element of the merged document that
+    // replaces the LOD element; LOD elements for which dropped is true are not referenced any more, so they have no id.
+    template<typename T>
+    class IdRemap
     {
-        // an empty id string indicates that the id is not inuse and therefore should not be updated
-        id = (id.empty()) ? "" : std::to_string(std::stoi(id) + offset);
+    public:
+        IdRemap(const IndexedContainer<const T>& lodContainer, const IndexedContainer<const T>& mergedContainer,
+            const std::vector<std::string>& existingIds = {}, const std::vector<bool>& dropped = {}) :
+            m_lodContainer(lodContainer)
+        {
+            m_ids.reserve(lodContainer.Size());
+            m_indices.reserve(lodContainer.Size());
+            m_appended.reserve(lodContainer.Size());
+
+            size_t next = mergedContainer.Size();
+            size_t nextIndex = mergedContainer.Size();
+            for (size_t i = 0; i < lodContainer.Size(); i++)
+            {
+                if (!existingIds.empty() && !existingIds[i].empty())
+                {
+                    m_ids.push_back(existingIds[i]);
+                    m_indices.push_back(mergedContainer.GetIndex(existingIds[i]));
+                    m_appended.push_back(false);
+                }
+                else if (!dropped.empty() && dropped[i])
+                {
+                    m_ids.push_back(std::string());
+                    m_indices.push_back(0);
+                    m_appended.push_back(false);
+                }
+                else
+                {
+                    while (mergedContainer.Has(std::to_string(next)))
+                    {
+                        next++;
+                    }
+                    m_ids.push_back(std::to_string(next++));
+                    m_indices.push_back(nextIndex++);
+                    m_appended.push_back(true);
+                }
+            }
+        }
+
+        // An empty id indicates that the reference is not in use, and therefore is not updated
+        void operator()(std::string& id) const
+        {
+            if (!id.empty())
+            {
+                id = m_ids[m_lodContainer.GetIndex(id)];
+            }
+        }
+
+        const std::string& GetId(size_t lodIndex) const
+        {
+            return m_ids[lodIndex];
+        }
+
+        // Extensions reference elements by index rather than by id
+        size_t GetIndex(size_t lodIndex) const
+        {
+            return m_indices[lodIndex];
+        }
+
+        bool IsAppended(size_t lodIndex) const
+        {
+            return m_appended[lodIndex];
+        }
+
+    private:
+        const IndexedContainer<const T>& m_lodContainer;
+        std::vector<std::string> m_ids;
+        std::vector<size_t> m_indices;
+        std::vector<bool> m_appended;
+    };
+
+    bool IsRelativeUri(const std::string& uri)
+    {
+        return std::experimental::filesystem::path(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(uri)).is_relative();
     }
 
-    inline void AddIndexOffset(MeshPrimitive& primitive, const char* attributeName, size_t offset)
+    // Resolves the URIs of the resources of a LOD like the merged document will, i.e. relative to the primary document
+    class LODStreamReader : public IStreamReader
     {
-        // an empty id string indicates that the id is not inuse and therefore should not be updated
-        auto attributeItr = primitive.attributes.find(attributeName);
-        if (attributeItr != primitive.attributes.end())
+    public:
+        LODStreamReader(std::shared_ptr<const IStreamReader> streamReader, const std::string& relativePathUtf8) :
+            m_streamReader(std::move(streamReader)),
+            m_relativePath(relativePathUtf8)
+        { }
+
+        std::shared_ptr<std::istream> GetInputStream(const std::string& uri) const override
+        {
+            return m_streamReader->GetInputStream(IsRelativeUri(uri) ? m_relativePath + uri : uri);
+        }
+
+    private:
+        std::shared_ptr<const IStreamReader> m_streamReader;
+        std::string m_relativePath;
+    };
+
+    // Identifies the contents of an accessor or an image. Accessors must also have the same layout to be interchangeable,
+    // and index and vertex data are never shared. Elements whose contents can't be read in place have no layout.
+    struct ContentKey
+    {
+        uint64_t hash = 0;
+        size_t byteLength = 0;
+        std::string layout;
+
+        bool IsValid() const
         {
-            attributeItr->second = std::to_string(std::stoi(attributeItr->second) + offset);
+            return !layout.empty();
         }
+
+        bool operator==(const ContentKey& other) const
+        {
+            return hash == other.hash && byteLength == other.byteLength && layout == other.layout;
+        }
+    };
+
+    struct ContentKeyHash
+    {
+        size_t operator()(const ContentKey& key) const
+        {
+            return static_cast<size_t>(key.hash);
+        }
+    };
+
+    template<typename T>
+    std::vector<uint8_t> ReadBytes(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        auto values = reader.ReadBinaryData<T>(doc, accessor);
+        std::vector<uint8_t> bytes(values.size() * sizeof(T));
+        memcpy(bytes.data(), values.data(), bytes.size());
+        return bytes;
     }
 
-    inline void AddIndexOffsetPacked(rapidjson::Value& json, const char* textureId, size_t offset)
+    std::vector<uint8_t> ReadContents(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
     {
-        if (json.HasMember(textureId))
+        switch (accessor.componentType)
         {
-            if (json[textureId].HasMember(MSFT_PACKING_INDEX_KEY))
+        case COMPONENT_BYTE:           return ReadBytes<int8_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_BYTE:  return ReadBytes<uint8_t>(reader, doc, accessor);
+        case COMPONENT_SHORT:          return ReadBytes<int16_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_SHORT: return ReadBytes<uint16_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_INT:   return ReadBytes<uint32_t>(reader, doc, accessor);
+        case COMPONENT_FLOAT:          return ReadBytes<float>(reader, doc, accessor);
+        default: throw GLTFException("Unknown component type.");
+        }
+    }
+
+    std::vector<uint8_t> ReadContents(const GLTFResourceReader& reader, const Document& doc, const Image& image)
+    {
+        return reader.ReadBinaryData(doc, image);
+    }
+
+    // Calculates the key of an accessor, and reads its contents into bytes when it has one
+    ContentKey GetAccessorKey(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor, std::vector<uint8_t>& bytes)
+    {
+        // Sparse accessors and compressed buffer views aren't shared
+        if (accessor.bufferViewId.empty() || accessor.sparse.count > 0 || accessor.count == 0 || accessor.componentType == COMPONENT_UNKNOWN)
+        {
+            return ContentKey();
+        }
+
+        const auto& bufferView = doc.bufferViews.Get(accessor.bufferViewId);
+        if (bufferView.extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) > 0)
+        {
+            return ContentKey();
+        }
+
+        bytes = ReadContents(reader, doc, accessor);
+
+        ContentKey key;
+        key.hash = HashUtils::Hash64(bytes.data(), bytes.size());
+        key.byteLength = bytes.size();
+        key.layout = "accessor:" + std::to_string(accessor.type) + ":" + std::to_string(accessor.componentType) + (accessor.normalized ? "n" : "") +
+            ":" + std::to_string(accessor.count) + ":" + (bufferView.target.HasValue() ? std::to_string(bufferView.target.Get()) : "");
+        return key;
+    }
+
+    ContentKey GetImageKey(const GLTFResourceReader& reader, const Document& doc, const Image& image, std::vector<uint8_t>& bytes)
+    {
+        bytes = ReadContents(reader, doc, image);
+
+        ContentKey key;
+        key.hash = HashUtils::Hash64(bytes.data(), bytes.size());
+        key.byteLength = bytes.size();
+        key.layout = "image:" + image.mimeType;
+        return key;
+    }
+
+    // An element of the merged document, and how to read its contents again to compare them with a candidate with the same key
+    struct IndexedContent
+    {
+        std::string id;
+        std::function<std::vector<uint8_t>()> read;
+    };
+
+    // The element is read from the document of the LOD it came from, which outlives the merge
+    template<typename T>
+    IndexedContent MakeIndexedContent(std::string id, std::shared_ptr<const IStreamReader> streamReader, const Document& doc, const T& element)
+    {
+        return { std::move(id), [streamReader, &doc, element]()
+        {
+            GLTFResourceReader reader(streamReader);
+            return ReadContents(reader, doc, element);
+        } };
+    }
+
+    typedef std::unordered_map<ContentKey, IndexedContent, ContentKeyHash> ContentMap;
+
+    // The accessors and images of the merged document by contents, so that identical ones of the following LODs can reuse them
+    struct ContentIndex
+    {
+        std::shared_ptr<const IStreamReader> streamReader;
+        ContentMap accessors;
+        ContentMap images;
+        LODDeduplicationStatistics statistics;
+    };
+
+    // Calculates the key of each element of a document, and the id of the element of the merged document with the same contents
+    template<typename T, typename GetKey>
+    std::vector<ContentKey> FindIdenticalContents(const IndexedContainer<const T>& container, const ContentMap& index,
+        GetKey getKey, std::vector<std::string>& existingIds, size_t& count, size_t& byteLength)
+    {
+        std::vector<ContentKey> keys;
+        keys.reserve(container.Size());
+        existingIds.assign(container.Size(), std::string());
+
+        std::vector<uint8_t> bytes;
+        for (size_t i = 0; i < container.Size(); i++)
+        {
+            keys.push_back(getKey(container[i], bytes));
+
+            // The hash only finds candidates: an element is only replaced by one whose bytes are the same
+            auto it = keys.back().IsValid() ? index.find(keys.back()) : index.end();
+            if (it != index.end() && it->second.read() == bytes)
             {
-                auto index = json[textureId][MSFT_PACKING_INDEX_KEY].GetInt();
-                json[textureId][MSFT_PACKING_INDEX_KEY] = index + offset;
+                existingIds[i] = it->second.id;
+                byteLength += keys.back().byteLength;
+                count++;
             }
         }
+
+        return keys;
+    }
+
+    // Parses the JSON of an extension once, lets the callback update the indices it references, and serializes it once
+    template<typename Patch>
+    void PatchExtension(std::unordered_map<std::string, std::string>& extensions, const char* extensionName, Patch patch)
+    {
+        auto extensionIt = extensions.find(extensionName);
+        if (extensionIt == extensions.end() || extensionIt->second.empty())
+        {
+            return;
+        }
+
+        rapidjson::Document json = RapidJsonUtils::CreateDocumentFromString(extensionIt->second);
+        patch(json);
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        json.Accept(writer);
+
+        extensionIt->second = buffer.GetString();
+    }
+
+    template<typename T>
+    void PatchIndex(rapidjson::Value& json, const char* key, const IdRemap<T>& remap)
+    {
+        if (json.HasMember(key))
+        {
+            json[key] = static_cast<uint64_t>(remap.GetIndex(json[key].GetUint()));
+        }
     }
 
+    template<typename T>
+    void PatchPackedIndex(rapidjson::Value& json, const char* textureKey, const IdRemap<T>& remap)
+    {
+        if (json.HasMember(textureKey))
+        {
+            PatchIndex(json[textureKey], MSFT_PACKING_INDEX_KEY, remap);
+        }
+    }
+
+    typedef std::unordered_map<MaterialSignature, std::string, MaterialSignatureHash> MaterialIndex;
+
     std::vector<std::string> ParseExtensionMSFTLod(const Node& node)
     {
         std::vector<std::string> lodIds;
@@ -120,30 +387,30 @@ namespace
         return stringBuffer.GetString();
     }
 
-    Document AddGLTFNodeLOD(const Document& primary, LODMap& primaryLods, const Document& lod, const std::wstring& relativePath = L"", bool sharedMaterials = false)
+    // Appends the elements of a LOD document to the merged document in place, remapping every reference through
+    // per-container index tables, and adds the LOD's root nodes to the MSFT_lod levels of the merged document's root nodes.
+    // When the LODs share the materials of the highest LOD, sharedMaterials indexes them by signature; otherwise it is null.
+    // When contents isn't null, accessors and images identical to ones of the merged document reuse them instead of being appended.
+    void AppendGLTFNodeLOD(Document& merged, LODMap& mergedLods, const Document& lod, const std::wstring& relativePath, const MaterialIndex* sharedMaterials, ContentIndex* contents)
     {
-        Microsoft::glTF::Document gltfLod(primary);
-
-        auto primaryScenes = primary.scenes.Elements();
-        auto lodScenes = lod.scenes.Elements();
+        const auto& mergedScenes = merged.scenes.Elements();
+        const auto& lodScenes = lod.scenes.Elements();
 
         size_t MaxLODLevel = 0;
 
         // Both GLTF must have equivalent number and order of scenes and root nodes per scene otherwise merge will not be possible
         bool sceneNodeMatch = false;
-        if (primaryScenes.size() == lodScenes.size())
+        if (mergedScenes.size() == lodScenes.size())
         {
-            for (size_t sceneIdx = 0; sceneIdx < primaryScenes.size(); sceneIdx++)
+            for (size_t sceneIdx = 0; sceneIdx < mergedScenes.size(); sceneIdx++)
             {
-
-                if ((primaryScenes[sceneIdx].nodes.size() == lodScenes[sceneIdx].nodes.size()) &&
+                if ((mergedScenes[sceneIdx].nodes.size() == lodScenes[sceneIdx].nodes.size()) &&
                     (lodScenes[sceneIdx].nodes.size() == 1 ||
-                        std::equal(primaryScenes[sceneIdx].nodes.begin(), primaryScenes[sceneIdx].nodes.end(), lodScenes[sceneIdx].nodes.begin()))
+                        std::equal(mergedScenes[sceneIdx].nodes.begin(), mergedScenes[sceneIdx].nodes.end(), lodScenes[sceneIdx].nodes.begin()))
                     )
                 {
                     sceneNodeMatch = true;
-                    auto primaryRootNode = gltfLod.nodes.Get(primaryScenes[sceneIdx].nodes[0]);
-                    MaxLODLevel = std::max(MaxLODLevel, primaryLods.at(primaryRootNode.id)->size());
+                    MaxLODLevel = std::max(MaxLODLevel, mergedLods.at(mergedScenes[sceneIdx].nodes[0])->size());
                 }
                 else
                 {
@@ -155,349 +422,657 @@ namespace
 
         MaxLODLevel++;
 
-        if (!sceneNodeMatch || primaryScenes.empty())
+        if (!sceneNodeMatch || mergedScenes.empty())
         {
             // Mis-match or empty scene; either way cannot merge Lod in
-            throw new std::runtime_error("Primary Scene either empty or does not match scene node count of LOD gltf");
+            throw std::runtime_error("Primary Scene either empty or does not match scene node count of LOD gltf");
         }
 
         std::string nodeLodLabel = "_lod" + std::to_string(MaxLODLevel);
-
-        // lod merge is performed from the lowest reference back upwards
-        // e.g. buffers/samplers/extensions do not reference any other part of the gltf manifest    
-        size_t buffersOffset = gltfLod.buffers.Size();
-        size_t samplersOffset = sharedMaterials ? 0 : gltfLod.samplers.Size();
+        std::string relativePathUtf8 = std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(relativePath);
+
+        std::vector<ContentKey> accessorKeys;
+        std::vector<ContentKey> imageKeys;
+        std::vector<std::string> existingAccessors;
+        std::vector<std::string> existingImages;
+        std::vector<bool> droppedBufferViews;
+        std::vector<bool> droppedBuffers;
+        std::shared_ptr<const IStreamReader> lodStreamReader;
+        if (contents != nullptr)
         {
-            auto lodBuffers = lod.buffers.Elements();
-            for (auto buffer : lodBuffers)
+            lodStreamReader = std::make_shared<LODStreamReader>(contents->streamReader, relativePathUtf8);
+            GLTFResourceReader reader(lodStreamReader);
+            auto& statistics = contents->statistics;
+            size_t deduplicatedByteLength = 0;
+
+            accessorKeys = FindIdenticalContents(lod.accessors, contents->accessors, [&](const Accessor& accessor, std::vector<uint8_t>& bytes)
             {
-                AddIndexOffset(buffer.id, buffersOffset);
-                std::string relativePathUtf8 = std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(relativePath);
-                buffer.uri = relativePathUtf8 + buffer.uri;
-                gltfLod.buffers.Append(std::move(buffer));
-            }
+                return GetAccessorKey(reader, lod, accessor, bytes);
+            }, existingAccessors, statistics.DeduplicatedAccessorCount, deduplicatedByteLength);
 
             if (!sharedMaterials)
             {
-                auto lodSamplers = lod.samplers.Elements();
-                for (auto sampler : lodSamplers)
+                imageKeys = FindIdenticalContents(lod.images, contents->images, [&](const Image& image, std::vector<uint8_t>& bytes)
+                {
+                    return GetImageKey(reader, lod, image, bytes);
+                }, existingImages, statistics.DeduplicatedImageCount, deduplicatedByteLength);
+            }
+
+            statistics.DeduplicatedByteLength.push_back(deduplicatedByteLength);
+
+            // Buffer views and buffers that were only used by reused accessors and images are dropped; the ones nothing used are kept as before
+            enum Use { Unused, UsedByReused, UsedByAppended };
+            std::vector<Use> bufferViewUses(lod.bufferViews.Size(), Unused);
+            auto UseBufferView = [&](const std::string& bufferViewId, bool reused)
+            {
+                if (!bufferViewId.empty())
+                {
+                    auto& use = bufferViewUses[lod.bufferViews.GetIndex(bufferViewId)];
+                    use = std::max(use, reused ? UsedByReused : UsedByAppended);
+                }
+            };
+
+            for (size_t i = 0; i < lod.accessors.Size(); i++)
+            {
+                const auto& accessor = lod.accessors[i];
+                UseBufferView(accessor.bufferViewId, !existingAccessors[i].empty());
+                UseBufferView(accessor.sparse.indicesBufferViewId, false);
+                UseBufferView(accessor.sparse.valuesBufferViewId, false);
+            }
+            for (size_t i = 0; i < lod.images.Size(); i++)
+            {
+                UseBufferView(lod.images[i].bufferViewId, !existingImages.empty() && !existingImages[i].empty());
+            }
+            for (const auto& mesh : lod.meshes.Elements())
+            {
+                for (const auto& primitive : mesh.primitives)
+                {
+                    if (primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>())
+                    {
+                        UseBufferView(primitive.GetExtension<KHR::MeshPrimitives::DracoMeshCompression>().bufferViewId, false);
+                    }
+                }
+            }
+
+            std::vector<Use> bufferUses(lod.buffers.Size(), Unused);
+            droppedBufferViews.resize(lod.bufferViews.Size());
+            for (size_t i = 0; i < lod.bufferViews.Size(); i++)
+            {
+                const auto& bufferView = lod.bufferViews[i];
+                droppedBufferViews[i] = bufferViewUses[i] == UsedByReused;
+
+                auto bufferUse = droppedBufferViews[i] ? UsedByReused : UsedByAppended;
+                auto& use = bufferUses[lod.buffers.GetIndex(bufferView.bufferId)];
+                use = std::max(use, bufferUse);
+
+                auto meshoptIt = bufferView.extensions.find(EXTENSION_EXT_MESHOPT_COMPRESSION);
+                if (meshoptIt != bufferView.extensions.end())
                 {
-                    AddIndexOffset(sampler.id, samplersOffset);
-                    gltfLod.samplers.Append(std::move(sampler));
+                    auto json = RapidJsonUtils::CreateDocumentFromString(meshoptIt->second);
+                    if (json.HasMember("buffer"))
+                    {
+                        auto& meshoptUse = bufferUses[json["buffer"].GetUint()];
+                        meshoptUse = std::max(meshoptUse, bufferUse);
+                    }
                 }
             }
 
-            for (const auto& extension : lod.extensionsUsed)
+            droppedBuffers.resize(lod.buffers.Size());
+            for (size_t i = 0; i < lod.buffers.Size(); i++)
             {
-                gltfLod.extensionsUsed.insert(extension);
+                droppedBuffers[i] = bufferUses[i] == UsedByReused;
             }
-            // ensure that MSFT_LOD extension is specified as being used
-            gltfLod.extensionsUsed.insert(Toolkit::EXTENSION_MSFT_LOD);
         }
 
-        size_t accessorOffset = gltfLod.accessors.Size();
-        size_t texturesOffset = gltfLod.textures.Size();
+        // The ids and indices of the LOD's elements in the merged document, computed before anything is appended
+        IdRemap<Buffer> buffers(lod.buffers, merged.buffers, {}, droppedBuffers);
+        IdRemap<BufferView> bufferViews(lod.bufferViews, merged.bufferViews, {}, droppedBufferViews);
+        IdRemap<Accessor> accessors(lod.accessors, merged.accessors, existingAccessors);
+        IdRemap<Sampler> samplers(lod.samplers, merged.samplers);
+        IdRemap<Image> images(lod.images, merged.images, existingImages);
+        IdRemap<Texture> textures(lod.textures, merged.textures);
+        IdRemap<Material> materials(lod.materials, merged.materials);
+        IdRemap<Mesh> meshes(lod.meshes, merged.meshes);
+        IdRemap<Node> nodes(lod.nodes, merged.nodes);
+        IdRemap<Skin> skins(lod.skins, merged.skins);
+
+        // lod merge is performed from the lowest reference back upwards
+        // e.g. buffers/samplers/extensions do not reference any other part of the gltf manifest
+        for (size_t i = 0; i < lod.buffers.Size(); i++)
         {
-            // Buffer Views depend upon Buffers
-            size_t bufferViewsOffset = gltfLod.bufferViews.Size();
-            auto lodBufferViews = lod.bufferViews.Elements();
-            for (auto bufferView : lodBufferViews)
+            if (!buffers.IsAppended(i))
             {
-                AddIndexOffset(bufferView.id, bufferViewsOffset);
-                AddIndexOffset(bufferView.bufferId, buffersOffset);
-                gltfLod.bufferViews.Append(std::move(bufferView));
+                continue;
             }
 
-            // Accessors depend upon Buffer views        
-            auto lodAccessors = lod.accessors.Elements();
-            for (auto accessor : lodAccessors)
+            Buffer buffer(lod.buffers[i]);
+            buffer.id = buffers.GetId(i);
+            // EXT_meshopt_compression fallback buffers have no URI
+            if (!buffer.uri.empty())
             {
-                AddIndexOffset(accessor.id, accessorOffset);
-                AddIndexOffset(accessor.bufferViewId, bufferViewsOffset);
-                gltfLod.accessors.Append(std::move(accessor));
+                buffer.uri = relativePathUtf8 + buffer.uri;
             }
+            merged.buffers.Append(std::move(buffer));
+        }
 
-            // Images depend upon Buffer views
-            size_t imageOffset = sharedMaterials ? 0 : gltfLod.images.Size();
-            if (!sharedMaterials)
+        if (!sharedMaterials)
+        {
+            for (size_t i = 0; i < lod.samplers.Size(); i++)
             {
-                auto lodImages = lod.images.Elements();
-                for (auto image : lodImages)
-                {
+                Sampler sampler(lod.samplers[i]);
+                sampler.id = samplers.GetId(i);
+                merged.samplers.Append(std::move(sampler));
+            }
+        }
 
-                    AddIndexOffset(image.id, imageOffset);
-                    AddIndexOffset(image.bufferViewId, bufferViewsOffset);
+        for (const auto& extension : lod.extensionsUsed)
+        {
+            merged.extensionsUsed.insert(extension);
+        }
+        // ensure that MSFT_LOD extension is specified as being used
+        merged.extensionsUsed.insert(Toolkit::EXTENSION_MSFT_LOD);
 
-                    std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-                    std::wstring uri = conv.from_bytes(image.uri);
-                    if (std::experimental::filesystem::path(uri).is_relative()) {
-                        // to be able to reference images with the same name, prefix with relative path
-                        std::string relativePathUtf8 = conv.to_bytes(relativePath);
-                        image.uri = relativePathUtf8 + image.uri;
-                    }
-                    gltfLod.images.Append(std::move(image));
-                }
+        // Buffer Views depend upon Buffers
+        for (size_t i = 0; i < lod.bufferViews.Size(); i++)
+        {
+            if (!bufferViews.IsAppended(i))
+            {
+                continue;
+            }
 
-                // Textures depend upon Samplers and Images
-                auto lodTextures = lod.textures.Elements();
-                for (auto texture : lodTextures)
-                {
-                    AddIndexOffset(texture.id, texturesOffset);
-                    AddIndexOffset(texture.samplerId, samplersOffset);
-                    AddIndexOffset(texture.imageId, imageOffset);
+            BufferView bufferView(lod.bufferViews[i]);
+            bufferView.id = bufferViews.GetId(i);
+            buffers(bufferView.bufferId);
 
-                    // MSFT_texture_dds extension
-                    auto ddsExtensionIt = texture.extensions.find(EXTENSION_MSFT_TEXTURE_DDS);
-                    if (ddsExtensionIt != texture.extensions.end() && !ddsExtensionIt->second.empty())
-                    {
-                        rapidjson::Document ddsJson = RapidJsonUtils::CreateDocumentFromString(ddsExtensionIt->second);
+            // EXT_meshopt_compression extension
+            PatchExtension(bufferView.extensions, EXTENSION_EXT_MESHOPT_COMPRESSION, [&buffers](rapidjson::Document& json)
+            {
+                PatchIndex(json, "buffer", buffers);
+            });
 
-                        if (ddsJson.HasMember("source"))
-                        {
-                            auto index = ddsJson["source"].GetInt();
-                            ddsJson["source"] = index + imageOffset;
-                        }
+            merged.bufferViews.Append(std::move(bufferView));
+        }
 
-                        rapidjson::StringBuffer buffer;
-                        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-                        ddsJson.Accept(writer);
+        // Accessors depend upon Buffer views
+        for (size_t i = 0; i < lod.accessors.Size(); i++)
+        {
+            if (!accessors.IsAppended(i))
+            {
+                continue;
+            }
 
-                        ddsExtensionIt->second = buffer.GetString();
-                    }
+            Accessor accessor(lod.accessors[i]);
+            accessor.id = accessors.GetId(i);
+            bufferViews(accessor.bufferViewId);
+            if (accessor.sparse.count > 0)
+            {
+                bufferViews(accessor.sparse.indicesBufferViewId);
+                bufferViews(accessor.sparse.valuesBufferViewId);
+            }
+            merged.accessors.Append(std::move(accessor));
 
-                    gltfLod.textures.Append(std::move(texture));
-                }
+            // The following LODs can reuse the appended accessor
+            if (contents != nullptr && accessorKeys[i].IsValid())
+            {
+                contents->accessors.emplace(std::move(accessorKeys[i]), MakeIndexedContent(accessors.GetId(i), lodStreamReader, lod, lod.accessors[i]));
             }
         }
 
-        // Material Merge
-        // Note the extension KHR_materials_pbrSpecularGlossiness will be also updated
-        // Materials depend upon textures
-        size_t materialOffset = sharedMaterials ? 0 : gltfLod.materials.Size();
         if (!sharedMaterials)
         {
-            auto lodMaterials = lod.materials.Elements();
-            for (auto material : lodMaterials)
+            // Images depend upon Buffer views
+            for (size_t i = 0; i < lod.images.Size(); i++)
             {
-                // post-fix with lod level indication; 
-                // no functional reason other than making it easier to natively read gltf files with lods
-                material.name += nodeLodLabel;
-                AddIndexOffset(material.id, materialOffset);
+                if (!images.IsAppended(i))
+                {
+                    continue;
+                }
 
-                AddIndexOffset(material.normalTexture.textureId, texturesOffset);
-                AddIndexOffset(material.occlusionTexture.textureId, texturesOffset);
-                AddIndexOffset(material.emissiveTexture.textureId, texturesOffset);
+                Image image(lod.images[i]);
+                image.id = images.GetId(i);
+                bufferViews(image.bufferViewId);
 
-                AddIndexOffset(material.metallicRoughness.baseColorTexture.textureId, texturesOffset);
-                AddIndexOffset(material.metallicRoughness.metallicRoughnessTexture.textureId, texturesOffset);
+                if (!image.uri.empty() && IsRelativeUri(image.uri))
+                {
+                    // to be able to reference images with the same name, prefix with relative path
+                    image.uri = relativePathUtf8 + image.uri;
+                }
+                merged.images.Append(std::move(image));
 
-                if (material.HasExtension<KHR::Materials::PBRSpecularGlossiness>())
+                if (contents != nullptr && imageKeys[i].IsValid())
                 {
-                    AddIndexOffset(material.GetExtension<KHR::Materials::PBRSpecularGlossiness>().diffuseTexture.textureId, texturesOffset);
-                    AddIndexOffset(material.GetExtension<KHR::Materials::PBRSpecularGlossiness>().specularGlossinessTexture.textureId, texturesOffset);
+                    contents->images.emplace(std::move(imageKeys[i]), MakeIndexedContent(images.GetId(i), lodStreamReader, lod, lod.images[i]));
                 }
+            }
 
-                // MSFT_packing_occlusionRoughnessMetallic packed textures
-                auto ormExtensionIt = material.extensions.find(EXTENSION_MSFT_PACKING_ORM);
-                if (ormExtensionIt != material.extensions.end() && !ormExtensionIt->second.empty())
+            // Textures depend upon Samplers and Images
+            for (size_t i = 0; i < lod.textures.Size(); i++)
+            {
+                Texture texture(lod.textures[i]);
+                texture.id = textures.GetId(i);
+                samplers(texture.samplerId);
+                images(texture.imageId);
+
+                // MSFT_texture_dds extension
+                PatchExtension(texture.extensions, EXTENSION_MSFT_TEXTURE_DDS, [&images](rapidjson::Document& json)
                 {
-                    rapidjson::Document ormJson = RapidJsonUtils::CreateDocumentFromString(ormExtensionIt->second);
+                    PatchIndex(json, "source", images);
+                });
 
-                    AddIndexOffsetPacked(ormJson, MSFT_PACKING_ORM_ORMTEXTURE_KEY, texturesOffset);
-                    AddIndexOffsetPacked(ormJson, MSFT_PACKING_ORM_RMOTEXTURE_KEY, texturesOffset);
-                    AddIndexOffsetPacked(ormJson, MSFT_PACKING_ORM_NORMALTEXTURE_KEY, texturesOffset);
+                merged.textures.Append(std::move(texture));
+            }
+
+            // Material Merge
+            // Note the extension KHR_materials_pbrSpecularGlossiness will be also updated
+            // Materials depend upon textures
+            for (size_t i = 0; i < lod.materials.Size(); i++)
+            {
+                Material material(lod.materials[i]);
+
+                // post-fix with lod level indication;
+                // no functional reason other than making it easier to natively read gltf files with lods
+                material.name += nodeLodLabel;
+                material.id = materials.GetId(i);
 
-                    rapidjson::StringBuffer buffer;
-                    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-                    ormJson.Accept(writer);
+                textures(material.normalTexture.textureId);
+                textures(material.occlusionTexture.textureId);
+                textures(material.emissiveTexture.textureId);
 
-                    ormExtensionIt->second = buffer.GetString();
+                textures(material.metallicRoughness.baseColorTexture.textureId);
+                textures(material.metallicRoughness.metallicRoughnessTexture.textureId);
+
+                if (material.HasExtension<KHR::Materials::PBRSpecularGlossiness>())
+                {
+                    textures(material.GetExtension<KHR::Materials::PBRSpecularGlossiness>().diffuseTexture.textureId);
+                    textures(material.GetExtension<KHR::Materials::PBRSpecularGlossiness>().specularGlossinessTexture.textureId);
                 }
 
+                // MSFT_packing_occlusionRoughnessMetallic packed textures
+                PatchExtension(material.extensions, EXTENSION_MSFT_PACKING_ORM, [&textures](rapidjson::Document& json)
+                {
+                    PatchPackedIndex(json, MSFT_PACKING_ORM_ORMTEXTURE_KEY, textures);
+                    PatchPackedIndex(json, MSFT_PACKING_ORM_RMOTEXTURE_KEY, textures);
+                    PatchPackedIndex(json, MSFT_PACKING_ORM_NORMALTEXTURE_KEY, textures);
+                });
+
                 // MSFT_packing_normalRoughnessMetallic packed texture
-                auto nrmExtensionIt = material.extensions.find(EXTENSION_MSFT_PACKING_NRM);
-                if (nrmExtensionIt != material.extensions.end() && !nrmExtensionIt->second.empty())
+                PatchExtension(material.extensions, EXTENSION_MSFT_PACKING_NRM, [&textures](rapidjson::Document& json)
                 {
-                    rapidjson::Document nrmJson = RapidJsonUtils::CreateDocumentFromString(nrmExtensionIt->second);
+                    PatchPackedIndex(json, MSFT_PACKING_NRM_KEY, textures);
+                });
 
-                    AddIndexOffsetPacked(nrmJson, MSFT_PACKING_NRM_KEY, texturesOffset);
-                    
-                    rapidjson::StringBuffer buffer;
-                    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-                    nrmJson.Accept(writer);
+                merged.materials.Append(std::move(material));
+            }
+        }
 
-                    nrmExtensionIt->second = buffer.GetString();
+        // lower quality LODs can have fewer images and textures than the highest LOD, so with shared materials
+        // each LOD material is matched once with the same material from the highest LOD
+        std::vector<std::string> sharedMaterialIds(sharedMaterials ? lod.materials.Size() : 0);
+        auto GetSharedMaterialId = [&](const std::string& materialId) -> const std::string&
+        {
+            auto& sharedMaterialId = sharedMaterialIds[lod.materials.GetIndex(materialId)];
+            if (sharedMaterialId.empty())
+            {
+                auto iter = sharedMaterials->find(MaterialSignature(lod.materials.Get(materialId)));
+                if (iter == sharedMaterials->end())
+                {
+                    throw std::runtime_error("Couldn't find the shared material in the highest LOD.");
                 }
-
-                gltfLod.materials.Append(std::move(material));
+                sharedMaterialId = iter->second;
             }
-        }
+            return sharedMaterialId;
+        };
 
         // Meshs depend upon Accessors and Materials
-        size_t meshOffset = gltfLod.meshes.Size();
+        for (size_t i = 0; i < lod.meshes.Size(); i++)
         {
-            auto lodMeshes = lod.meshes.Elements();
-            for (auto mesh : lodMeshes)
+            Mesh mesh(lod.meshes[i]);
+
+            // post-fix with lod level indication;
+            // no functional reason other than making it easier to natively read gltf files with lods
+            mesh.name += nodeLodLabel;
+            mesh.id = meshes.GetId(i);
+
+            for (auto& primitive : mesh.primitives)
             {
-                // post-fix with lod level indication; 
-                // no functional reason other than making it easier to natively read gltf files with lods
-                mesh.name += nodeLodLabel;
-                AddIndexOffset(mesh.id, meshOffset);
+                accessors(primitive.indicesAccessorId);
+                for (auto& attribute : primitive.attributes)
+                {
+                    accessors(attribute.second);
+                }
 
-                for (auto &primitive : mesh.primitives)
+                for (auto& target : primitive.targets)
                 {
-                    AddIndexOffset(primitive.indicesAccessorId, accessorOffset);
-                    AddIndexOffset(primitive, ACCESSOR_POSITION, accessorOffset);
-                    AddIndexOffset(primitive, ACCESSOR_NORMAL, accessorOffset);
-                    AddIndexOffset(primitive, ACCESSOR_TEXCOORD_0, accessorOffset);
-                    AddIndexOffset(primitive, ACCESSOR_TEXCOORD_1, accessorOffset);
-                    AddIndexOffset(primitive, ACCESSOR_COLOR_0, accessorOffset);
-                    AddIndexOffset(primitive, ACCESSOR_TANGENT, accessorOffset);
-                    AddIndexOffset(primitive, ACCESSOR_JOINTS_0, accessorOffset);
-                    AddIndexOffset(primitive, ACCESSOR_WEIGHTS_0, accessorOffset);
-
-                    if (sharedMaterials)
-                    {
-                        // lower quality LODs can have fewer images and textures than the highest LOD,
-                        // so we need to find the correct material index for the same material from the highest LOD
-
-                        const Material& localMaterial = lod.materials.Get(primitive.materialId);
-
-                        // find merged material index for the given material index in this LOD
-                        auto iter = std::find_if(gltfLod.materials.Elements().begin(),
-                                gltfLod.materials.Elements().end(),
-                                [localMaterial](const Material& globalMaterial) {
-                                    // check that the materials are the same, noting that the texture and material ids will differ
-                                    return localMaterial.name == globalMaterial.name &&
-                                           localMaterial.alphaMode == globalMaterial.alphaMode &&
-                                           localMaterial.alphaCutoff == globalMaterial.alphaCutoff &&
-                                           localMaterial.emissiveFactor == globalMaterial.emissiveFactor &&
-                                           localMaterial.doubleSided == globalMaterial.doubleSided &&
-                                           localMaterial.metallicRoughness.baseColorFactor == globalMaterial.metallicRoughness.baseColorFactor &&
-                                           localMaterial.metallicRoughness.metallicFactor == globalMaterial.metallicRoughness.metallicFactor &&
-                                           localMaterial.occlusionTexture.strength == globalMaterial.occlusionTexture.strength &&
-                                           localMaterial.HasExtension<KHR::Materials::PBRSpecularGlossiness>() == globalMaterial.HasExtension<KHR::Materials::PBRSpecularGlossiness>() && 
-                                           (!localMaterial.HasExtension<KHR::Materials::PBRSpecularGlossiness>() ||
-                                             (localMaterial.GetExtension<KHR::Materials::PBRSpecularGlossiness>().diffuseFactor == globalMaterial.GetExtension<KHR::Materials::PBRSpecularGlossiness>().diffuseFactor &&
-                                              localMaterial.GetExtension<KHR::Materials::PBRSpecularGlossiness>().glossinessFactor == globalMaterial.GetExtension<KHR::Materials::PBRSpecularGlossiness>().glossinessFactor &&
-                                              localMaterial.GetExtension<KHR::Materials::PBRSpecularGlossiness>().specularFactor == globalMaterial.GetExtension<KHR::Materials::PBRSpecularGlossiness>().specularFactor)
-                                           );
-                                }
-                        );
-
-                        if (iter != gltfLod.materials.Elements().end())
-                        {
-                            size_t newMaterialIndex = std::distance(gltfLod.materials.Elements().begin(), iter);
-                            primitive.materialId = std::to_string(newMaterialIndex);
-                        }
-                        else
-                        {
-                            throw new std::runtime_error("Couldn't find the shared material in the highest LOD.");
-                        }
-                    }
-                    else
-                    {
-                        AddIndexOffset(primitive.materialId, materialOffset);
-                    }
+                    accessors(target.positionsAccessorId);
+                    accessors(target.normalsAccessorId);
+                    accessors(target.tangentsAccessorId);
+                }
+
+                if (primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>())
+                {
+                    bufferViews(primitive.GetExtension<KHR::MeshPrimitives::DracoMeshCompression>().bufferViewId);
                 }
 
-                gltfLod.meshes.Append(std::move(mesh));
+                if (sharedMaterials && !primitive.materialId.empty())
+                {
+                    primitive.materialId = GetSharedMaterialId(primitive.materialId);
+                }
+                else
+                {
+                    materials(primitive.materialId);
+                }
             }
+
+            merged.meshes.Append(std::move(mesh));
         }
 
         // Nodes depend upon Nodes and Meshes
-        size_t nodeOffset = gltfLod.nodes.Size();
+        for (size_t i = 0; i < lod.nodes.Size(); i++)
+        {
+            Node node(lod.nodes[i]);
+
+            // post-fix with lod level indication;
+            // no functional reason other than making it easier to natively read gltf files with lods
+            node.name += nodeLodLabel;
+            node.id = nodes.GetId(i);
+            meshes(node.meshId);
+            skins(node.skinId);
+
+            for (auto& child : node.children)
+            {
+                nodes(child);
+            }
+
+            merged.nodes.Append(std::move(node));
+        }
+
         // Skins depend upon Nodes
-        size_t skinOffset = gltfLod.skins.Size();
+        for (size_t i = 0; i < lod.skins.Size(); i++)
         {
-            auto nodes = lod.nodes.Elements();
-            for (auto node : nodes)
+            Skin skin(lod.skins[i]);
+
+            // post-fix with lod level indication;
+            // no functional reason other than making it easier to natively read gltf files with lods
+            skin.name += nodeLodLabel;
+            skin.id = skins.GetId(i);
+            nodes(skin.skeletonId);
+            accessors(skin.inverseBindMatricesAccessorId);
+
+            for (auto& jointId : skin.jointIds)
             {
-                // post-fix with lod level indication; 
-                // no functional reason other than making it easier to natively read gltf files with lods
-                node.name += nodeLodLabel;
-                AddIndexOffset(node.id, nodeOffset);
-                AddIndexOffset(node.meshId, meshOffset);
-                if (!node.skinId.empty())
+                nodes(jointId);
+            }
+
+            merged.skins.Append(std::move(skin));
+        }
+
+        // Animation channels depend upon Nodes and Accessors
+        for (size_t animationIndex = 0; animationIndex < merged.animations.Size() && animationIndex < lod.animations.Size(); animationIndex++)
+        {
+            const auto& lodAnimation = lod.animations[animationIndex];
+            Animation newAnimation(merged.animations[animationIndex]);
+
+            IdRemap<AnimationSampler> animationSamplers(lodAnimation.samplers, newAnimation.samplers);
+            IdRemap<AnimationChannel> animationChannels(lodAnimation.channels, newAnimation.channels);
+
+            for (size_t i = 0; i < lodAnimation.samplers.Size(); i++)
+            {
+                AnimationSampler sampler(lodAnimation.samplers[i]);
+                sampler.id = animationSamplers.GetId(i);
+                accessors(sampler.inputAccessorId);
+                accessors(sampler.outputAccessorId);
+                newAnimation.samplers.Append(std::move(sampler));
+            }
+
+            for (size_t i = 0; i < lodAnimation.channels.Size(); i++)
+            {
+                AnimationChannel channel(lodAnimation.channels[i]);
+                channel.id = animationChannels.GetId(i);
+                nodes(channel.target.nodeId);
+                animationSamplers(channel.samplerId);
+                newAnimation.channels.Append(std::move(channel));
+            }
+
+            merged.animations.Replace(std::move(newAnimation));
+        }
+
+        // update the merged GLTF root nodes lod extension to reference the new lod root node
+        // N.B. new lods are always added to the back
+        for (size_t sceneIdx = 0; sceneIdx < mergedScenes.size(); sceneIdx++)
+        {
+            for (size_t rootNodeIdx = 0; rootNodeIdx < mergedScenes[sceneIdx].nodes.size(); rootNodeIdx++)
+            {
+                auto lodRootId = lodScenes[sceneIdx].nodes[rootNodeIdx];
+                nodes(lodRootId);
+                mergedLods.at(mergedScenes[sceneIdx].nodes[rootNodeIdx])->push_back(std::move(lodRootId));
+            }
+        }
+    }
+
+    Document MergeLODs(const std::vector<Document>& docs, const std::vector<std::wstring>& relativePaths, bool sharedMaterials, ContentIndex* contents)
+    {
+        if (docs.empty())
+        {
+            throw std::invalid_argument("MergeDocumentsAsLODs passed empty vector");
+        }
+
+        // Every LOD is appended to the same document, rather than to a copy of the previous result
+        Document gltfPrimary(docs[0]);
+        LODMap lods = GLTFLODUtils::ParseDocumentNodeLODs(gltfPrimary);
+
+        // Shared materials are only ever looked up among the materials of the highest LOD, so they are indexed once
+        MaterialIndex materialIndex;
+        if (sharedMaterials)
+        {
+            materialIndex = GLTFMaterialUtils::IndexMaterials(gltfPrimary);
+        }
+
+        // The contents of the highest LOD are indexed up front, and the ones of every LOD as it is appended
+        if (contents != nullptr)
+        {
+            // Their contents are read again from docs[0], which isn't modified while the LODs are appended
+            GLTFResourceReader reader(contents->streamReader);
+            std::vector<uint8_t> bytes;
+            for (const auto& accessor : docs[0].accessors.Elements())
+            {
+                auto key = GetAccessorKey(reader, docs[0], accessor, bytes);
+                if (key.IsValid())
                 {
-                    AddIndexOffset(node.skinId, skinOffset);
+                    contents->accessors.emplace(std::move(key), MakeIndexedContent(accessor.id, contents->streamReader, docs[0], accessor));
                 }
+            }
 
-                for (auto &child : node.children)
+            // Images of the other LODs are never appended when they share the materials of the highest LOD
+            if (!sharedMaterials)
+            {
+                for (const auto& image : docs[0].images.Elements())
                 {
-                    AddIndexOffset(child, nodeOffset);
+                    contents->images.emplace(GetImageKey(reader, docs[0], image, bytes), MakeIndexedContent(image.id, contents->streamReader, docs[0], image));
                 }
-
-                gltfLod.nodes.Append(std::move(node));
             }
         }
 
+        for (size_t i = 1; i < docs.size(); i++)
+        {
+            AppendGLTFNodeLOD(gltfPrimary, lods, docs[i], (relativePaths.size() == docs.size() - 1 ? relativePaths[i - 1] : L""), sharedMaterials ? &materialIndex : nullptr, contents);
+        }
+
+        for (const auto& lod : lods)
         {
-            auto skins = lod.skins.Elements();
-            for (auto skin : skins)
+            if (lod.second == nullptr || lod.second->size() == 0)
             {
-                // post-fix with lod level indication; 
-                // no functional reason other than making it easier to natively read gltf files with lods
-                skin.name += nodeLodLabel;
-                AddIndexOffset(skin.id, skinOffset);
-                AddIndexOffset(skin.skeletonId, nodeOffset);
-                AddIndexOffset(skin.inverseBindMatricesAccessorId, accessorOffset);
+                continue;
+            }
 
-                for (auto &jointId : skin.jointIds)
-                {
-                    AddIndexOffset(jointId, nodeOffset);
-                }
+            auto node = gltfPrimary.nodes.Get(lod.first);
 
-                gltfLod.skins.Append(std::move(skin));
+            auto lodExtensionValue = SerializeExtensionMSFTLod<Node>(node, *lod.second, gltfPrimary);
+            if (!lodExtensionValue.empty())
+            {
+                // Replaces the extension of a document that already had LODs, whose ids were parsed into lods
+                node.extensions[EXTENSION_MSFT_LOD] = lodExtensionValue;
+                gltfPrimary.nodes.Replace(node);
             }
         }
 
-        // Animation channels depend upon Nodes and Accessors
+        return gltfPrimary;
+    }
+
+    void SetNodeScreenCoverage(Document& doc, const std::string& nodeId, const std::vector<double>& screenCoveragePercentages)
+    {
+        auto node = doc.nodes.Get(nodeId);
+
+        rapidjson::Document extrasJson(rapidjson::kObjectType);
+        if (!node.extras.empty())
+        {
+            extrasJson.Parse(node.extras.c_str());
+        }
+        rapidjson::Document::AllocatorType& allocator = extrasJson.GetAllocator();
+
+        rapidjson::Value screenCoverageArray = RapidJsonUtils::ToJsonArray(screenCoveragePercentages, allocator);
+
+        extrasJson.RemoveMember("MSFT_screencoverage");
+        extrasJson.AddMember("MSFT_screencoverage", screenCoverageArray, allocator);
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        extrasJson.Accept(writer);
+
+        node.extras = buffer.GetString();
+
+        doc.nodes.Replace(node);
+    }
+
+    void AddScreenCoverage(Document& merged, const std::vector<double>& screenCoveragePercentages)
+    {
+        if (screenCoveragePercentages.size() == 0)
+        {
+            return;
+        }
+
+        for (auto scene : merged.scenes.Elements())
         {
-            for (size_t animationIndex = 0; animationIndex < gltfLod.animations.Size(); animationIndex++)
+            for (auto rootNodeIndex : scene.nodes)
             {
-                const auto &baseAnimation = gltfLod.animations[animationIndex];
-                Animation newAnimation(baseAnimation);
-                const auto &lodAnimation = lod.animations[animationIndex];
+                SetNodeScreenCoverage(merged, rootNodeIndex, screenCoveragePercentages);
+            }
+        }
+    }
 
-                size_t samplerOffset = baseAnimation.samplers.Size();
-                for (const auto &sampler : lodAnimation.samplers.Elements())
-                {
-                    AnimationSampler newSampler(sampler);
-                    AddIndexOffset(newSampler.id, samplerOffset);
-                    AddIndexOffset(newSampler.inputAccessorId, accessorOffset);
-                    AddIndexOffset(newSampler.outputAccessorId, accessorOffset);
-                    newAnimation.samplers.Append(std::move(newSampler));
-                }
-                
-                size_t channelOffset = baseAnimation.channels.Size();
-                for (auto channel : lodAnimation.channels.Elements())
+    size_t GetTriangleCount(const Document& doc, const MeshPrimitive& primitive)
+    {
+        size_t vertexCount = 0;
+        if (!primitive.indicesAccessorId.empty())
+        {
+            vertexCount = doc.accessors.Get(primitive.indicesAccessorId).count;
+        }
+        else if (primitive.HasAttribute(ACCESSOR_POSITION))
+        {
+            vertexCount = doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION)).count;
+        }
+
+        switch (primitive.mode)
+        {
+        case MESH_TRIANGLES:
+            return vertexCount / 3;
+        case MESH_TRIANGLE_STRIP:
+        case MESH_TRIANGLE_FAN:
+            return vertexCount < 3 ? 0 : vertexCount - 2;
+        default:
+            return 0;
+        }
+    }
+
+    // The triangles drawn by a node and its descendants, and their axis-aligned bounds in the space of the node's parent
+    struct SubtreeContents
+    {
+        size_t triangleCount = 0;
+        std::array<double, 3> min = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+        std::array<double, 3> max = { std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
+
+        bool HasBounds() const
+        {
+            return min[0] <= max[0];
+        }
+    };
+
+    // Maps a bound of a normalized integer accessor to the value it is read as, e.g. the [-1, 1] range of quantized positions
+    double GetNormalizedBound(double value, ComponentType componentType)
+    {
+        switch (componentType)
+        {
+        case COMPONENT_BYTE:
+            return std::max(value / std::numeric_limits<int8_t>::max(), -1.0);
+        case COMPONENT_UNSIGNED_BYTE:
+            return value / std::numeric_limits<uint8_t>::max();
+        case COMPONENT_SHORT:
+            return std::max(value / std::numeric_limits<int16_t>::max(), -1.0);
+        case COMPONENT_UNSIGNED_SHORT:
+            return value / std::numeric_limits<uint16_t>::max();
+        default:
+            return value;
+        }
+    }
+
+    SubtreeContents GetSubtreeContents(const Document& doc, const std::string& rootId)
+    {
+        SubtreeContents contents;
+
+        std::vector<std::pair<std::string, TransformUtils::Transform>> stack = { { rootId, TransformUtils::GetLocalTransform(doc.nodes.Get(rootId)) } };
+        while (!stack.empty())
+        {
+            auto nodeId = std::move(stack.back().first);
+            auto transform = stack.back().second;
+            stack.pop_back();
+
+            const auto& node = doc.nodes.Get(nodeId);
+            if (!node.meshId.empty())
+            {
+                for (const auto& primitive : doc.meshes.Get(node.meshId).primitives)
                 {
-                    AddIndexOffset(channel.id, channelOffset);
-                    AddIndexOffset(channel.target.nodeId, nodeOffset);
-                    AddIndexOffset(channel.samplerId, samplerOffset);
+                    contents.triangleCount += GetTriangleCount(doc, primitive);
+
+                    if (!primitive.HasAttribute(ACCESSOR_POSITION))
+                    {
+                        continue;
+                    }
 
-                    newAnimation.channels.Append(std::move(channel));
+                    // glTF requires the min and max of positions
+                    const auto& positions = doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+                    if (positions.min.size() < 3 || positions.max.size() < 3)
+                    {
+                        continue;
+                    }
+
+                    for (size_t corner = 0; corner < 8; corner++)
+                    {
+                        std::array<double, 3> point;
+                        for (size_t axis = 0; axis < 3; axis++)
+                        {
+                            point[axis] = (corner & (1 << axis)) ? positions.max[axis] : positions.min[axis];
+                            if (positions.normalized)
+                            {
+                                point[axis] = GetNormalizedBound(point[axis], positions.componentType);
+                            }
+                        }
+
+                        point = TransformUtils::TransformPoint(transform, point);
+                        for (size_t axis = 0; axis < 3; axis++)
+                        {
+                            contents.min[axis] = std::min(contents.min[axis], point[axis]);
+                            contents.max[axis] = std::max(contents.max[axis], point[axis]);
+                        }
+                    }
                 }
-                gltfLod.animations.Replace(newAnimation);
             }
-        }
 
-        // update the primary GLTF root nodes lod extension to reference the new lod root node
-        // N.B. new lods are always added to the back
-        for (size_t sceneIdx = 0; sceneIdx < primaryScenes.size(); sceneIdx++)
-        {
-            for (size_t rootNodeIdx = 0; rootNodeIdx < primaryScenes[sceneIdx].nodes.size(); rootNodeIdx++)
+            for (const auto& childId : node.children)
             {
-                auto idx = primaryScenes[sceneIdx].nodes[rootNodeIdx];
-                Node nodeWithLods(gltfLod.nodes.Get(idx));
-                int lodRootIdx = std::stoi(lodScenes[sceneIdx].nodes[rootNodeIdx]) + static_cast<int>(nodeOffset);
-                auto primaryNodeLod = primaryLods.at(nodeWithLods.id);
-                primaryNodeLod->emplace_back(std::to_string(lodRootIdx));
+                stack.emplace_back(childId, TransformUtils::Multiply(transform, TransformUtils::GetLocalTransform(doc.nodes.Get(childId))));
             }
         }
 
-        return gltfLod;
+        return contents;
     }
 }
 
@@ -515,76 +1090,191 @@ LODMap GLTFLODUtils::ParseDocumentNodeLODs(const Document& doc)
 
 Document GLTFLODUtils::MergeDocumentsAsLODs(const std::vector<Document>& docs, const std::vector<std::wstring>& relativePaths, const bool& sharedMaterials)
 {
-    if (docs.empty())
+    return MergeLODs(docs, relativePaths, sharedMaterials, nullptr);
+}
+
+Document GLTFLODUtils::MergeDocumentsAsLODs(const std::vector<Document>& docs, const std::vector<double>& screenCoveragePercentages, const std::vector<std::wstring>& relativePaths, const bool& sharedMaterials)
+{
+    Document merged = MergeLODs(docs, relativePaths, sharedMaterials, nullptr);
+    AddScreenCoverage(merged, screenCoveragePercentages);
+    return merged;
+}
+
+Document GLTFLODUtils::MergeDocumentsAsLODs(
+    std::shared_ptr<IStreamReader> streamReader,
+    const std::vector<Document>& docs,
+    const std::vector<double>& screenCoveragePercentages,
+    const std::vector<std::wstring>& relativePaths,
+    const bool& sharedMaterials,
+    LODDeduplicationStatistics* statistics)
+{
+    ContentIndex contents;
+    contents.streamReader = streamReader;
+
+    Document merged = MergeLODs(docs, relativePaths, sharedMaterials, &contents);
+    AddScreenCoverage(merged, screenCoveragePercentages);
+
+    if (statistics != nullptr)
+    {
+        *statistics = std::move(contents.statistics);
+    }
+
+    return merged;
+}
+
+Document GLTFLODUtils::AddMaterialLODs(const Document& doc, const LODMap& materialLods)
+{
+    Document outputDoc(doc);
+
+    for (const auto& materialLod : materialLods)
     {
-        throw std::invalid_argument("MergeDocumentsAsLODs passed empty vector");
+        if (materialLod.second == nullptr || materialLod.second->empty())
+        {
+            continue;
+        }
+
+        auto material = outputDoc.materials.Get(materialLod.first);
+        material.extensions[EXTENSION_MSFT_LOD] = SerializeExtensionMSFTLod<Material>(material, *materialLod.second, outputDoc);
+        outputDoc.materials.Replace(material);
+
+        outputDoc.extensionsUsed.insert(EXTENSION_MSFT_LOD);
     }
 
-    Document gltfPrimary(docs[0]);
-    LODMap lods = ParseDocumentNodeLODs(gltfPrimary);
+    // The LOD level of a node is the position of the node LOD whose subtree contains it, and the level of a mesh is the
+    // highest level (i.e. the lowest value) of the nodes that use it, so meshes shared with a higher LOD keep their materials
+    auto nodeLods = ParseDocumentNodeLODs(outputDoc);
+    std::unordered_map<std::string, size_t> nodeLevels;
 
-    for (size_t i = 1; i < docs.size(); i++)
+    std::function<void(const std::string&, size_t)> setLevel = [&](const std::string& nodeId, size_t level)
     {
-        gltfPrimary = AddGLTFNodeLOD(gltfPrimary, lods, docs[i], (relativePaths.size() == docs.size() - 1 ? relativePaths[i - 1] : L""), sharedMaterials);
+        auto& nodeLevel = nodeLevels[nodeId];
+        nodeLevel = std::max(nodeLevel, level);
+
+        for (const auto& childId : outputDoc.nodes.Get(nodeId).children)
+        {
+            setLevel(childId, level);
+        }
+    };
+
+    for (const auto& nodeLod : nodeLods)
+    {
+        for (size_t i = 0; i < nodeLod.second->size(); i++)
+        {
+            setLevel(nodeLod.second->at(i), i + 1);
+        }
+    }
+
+    std::unordered_map<std::string, size_t> meshLevels;
+    for (const auto& node : outputDoc.nodes.Elements())
+    {
+        if (!node.meshId.empty())
+        {
+            auto nodeLevel = nodeLevels.find(node.id);
+            auto level = nodeLevel == nodeLevels.end() ? 0 : nodeLevel->second;
+
+            auto meshLevel = meshLevels.emplace(node.meshId, level).first;
+            meshLevel->second = std::min(meshLevel->second, level);
+        }
     }
 
-    for (auto lod : lods)
+    for (const auto& meshLevel : meshLevels)
     {
-        if (lod.second == nullptr || lod.second->size() == 0)
+        if (meshLevel.second == 0)
         {
             continue;
         }
 
-        auto node = gltfPrimary.nodes.Get(lod.first);
+        auto mesh = outputDoc.meshes.Get(meshLevel.first);
+        bool changed = false;
 
-        auto lodExtensionValue = SerializeExtensionMSFTLod<Node>(node, *lod.second, gltfPrimary);
-        if (!lodExtensionValue.empty())
+        for (auto& primitive : mesh.primitives)
         {
-            node.extensions.emplace(EXTENSION_MSFT_LOD, lodExtensionValue);
-            gltfPrimary.nodes.Replace(node);
+            auto materialLod = materialLods.find(primitive.materialId);
+            if (materialLod != materialLods.end() && materialLod->second != nullptr && !materialLod->second->empty())
+            {
+                primitive.materialId = materialLod->second->at(std::min(meshLevel.second, materialLod->second->size()) - 1);
+                changed = true;
+            }
+        }
+
+        if (changed)
+        {
+            outputDoc.meshes.Replace(mesh);
         }
     }
 
-    return gltfPrimary;
+    return outputDoc;
 }
 
-Document GLTFLODUtils::MergeDocumentsAsLODs(const std::vector<Document>& docs, const std::vector<double>& screenCoveragePercentages, const std::vector<std::wstring>& relativePaths, const bool& sharedMaterials)
+std::unordered_map<std::string, std::vector<double>> GLTFLODUtils::ComputeScreenCoverage(const Document& doc, const ScreenCoverageOptions& options)
 {
-    Document merged = MergeDocumentsAsLODs(docs, relativePaths, sharedMaterials);
-
-    if (screenCoveragePercentages.size() == 0)
+    if (options.TrianglesPerPixel <= 0.0 || options.ScreenHeight == 0)
     {
-        return merged;
+        throw std::invalid_argument("The triangle density and the screen height must be positive.");
     }
 
-    for (auto scene : merged.scenes.Elements())
+    std::unordered_map<std::string, std::vector<double>> screenCoverages;
+    auto lods = ParseDocumentNodeLODs(doc);
+
+    for (const auto& scene : doc.scenes.Elements())
     {
-        for (auto rootNodeIndex : scene.nodes)
+        for (const auto& rootNodeId : scene.nodes)
         {
-            auto primaryRootNode = merged.nodes.Get(rootNodeIndex);
-
-            rapidjson::Document extrasJson(rapidjson::kObjectType);
-            if (!primaryRootNode.extras.empty())
+            const auto& rootLods = *lods.at(rootNodeId);
+            if (rootLods.empty() || screenCoverages.find(rootNodeId) != screenCoverages.end())
             {
-                extrasJson.Parse(primaryRootNode.extras.c_str());
+                continue;
             }
-            rapidjson::Document::AllocatorType& allocator = extrasJson.GetAllocator();
 
-            rapidjson::Value screenCoverageArray = RapidJsonUtils::ToJsonArray(screenCoveragePercentages, allocator);
+            auto root = GetSubtreeContents(doc, rootNodeId);
+            if (!root.HasBounds())
+            {
+                continue;
+            }
 
-            extrasJson.AddMember("MSFT_screencoverage", screenCoverageArray, allocator);
+            double x = root.max[0] - root.min[0];
+            double y = root.max[1] - root.min[1];
+            double z = root.max[2] - root.min[2];
+            double diameter = std::sqrt(x * x + y * y + z * z);
+            double surfaceArea = 2.0 * (x * y + y * z + z * x);
+            if (surfaceArea <= 0.0)
+            {
+                continue;
+            }
 
-            rapidjson::StringBuffer buffer;
-            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-            extrasJson.Accept(writer);
+            // At a screen coverage c, the bounding sphere is c * ScreenHeight pixels high, so the visible triangles cover
+            // (surfaceArea / 4) * (c * ScreenHeight / diameter)^2 pixels; solving for the target density gives c.
+            auto getScreenCoverage = [&](size_t triangleCount)
+            {
+                auto coverage = diameter / options.ScreenHeight * std::sqrt(2.0 * triangleCount / (surfaceArea * options.TrianglesPerPixel));
+                return std::min(coverage, 1.0);
+            };
 
-            primaryRootNode.extras = buffer.GetString();
+            std::vector<double> screenCoverage = { getScreenCoverage(root.triangleCount) };
+            for (const auto& lodId : rootLods)
+            {
+                // LODs are only ever used below the coverage of the previous one
+                auto lod = GetSubtreeContents(doc, lodId);
+                screenCoverage.push_back(std::min(getScreenCoverage(lod.triangleCount), screenCoverage.back()));
+            }
 
-            merged.nodes.Replace(primaryRootNode);
+            screenCoverages.emplace(rootNodeId, std::move(screenCoverage));
         }
     }
 
-    return merged;
+    return screenCoverages;
+}
+
+Document GLTFLODUtils::SetScreenCoverage(const Document& doc, const std::unordered_map<std::string, std::vector<double>>& screenCoveragePercentages)
+{
+    Document outputDoc(doc);
+
+    for (const auto& screenCoverage : screenCoveragePercentages)
+    {
+        SetNodeScreenCoverage(outputDoc, screenCoverage.first, screenCoverage.second);
+    }
+
+    return outputDoc;
 }
 
 uint32_t GLTFLODUtils::NumberOfNodeLODLevels(const Document& doc, const LODMap& lods)
@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "GLTFMaterialUtils.h"
+#include "HashUtils.h"
+
+#include "GLTFSDK/ExtensionsKHR.h"
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+MaterialSignature::MaterialSignature(const Material& material) :
+    name(material.name),
+    alphaMode(material.alphaMode),
+    doubleSided(material.doubleSided),
+    hasSpecularGlossiness(material.HasExtension<KHR::Materials::PBRSpecularGlossiness>()),
+    factors()
+{
+    const auto& emissive = material.emissiveFactor;
+    const auto& baseColor = material.metallicRoughness.baseColorFactor;
+    factors = {
+        material.alphaCutoff,
+        emissive.r, emissive.g, emissive.b,
+        baseColor.r, baseColor.g, baseColor.b, baseColor.a,
+        material.metallicRoughness.metallicFactor,
+        material.occlusionTexture.strength
+    };
+
+    if (hasSpecularGlossiness)
+    {
+        const auto& specularGlossiness = material.GetExtension<KHR::Materials::PBRSpecularGlossiness>();
+        factors[10] = specularGlossiness.diffuseFactor.r;
+        factors[11] = specularGlossiness.diffuseFactor.g;
+        factors[12] = specularGlossiness.diffuseFactor.b;
+        factors[13] = specularGlossiness.diffuseFactor.a;
+        factors[14] = specularGlossiness.glossinessFactor;
+        factors[15] = specularGlossiness.specularFactor.r;
+        factors[16] = specularGlossiness.specularFactor.g;
+        factors[17] = specularGlossiness.specularFactor.b;
+    }
+
+    // Adding 0 turns -0 into +0, so that factors which compare equal also hash equally
+    std::array<float, 18> hashedFactors;
+    for (size_t i = 0; i < factors.size(); i++)
+    {
+        hashedFactors[i] = factors[i] + 0.0f;
+    }
+
+    uint64_t flags = static_cast<uint64_t>(alphaMode) << 2 | static_cast<uint64_t>(doubleSided) << 1 | static_cast<uint64_t>(hasSpecularGlossiness);
+    uint64_t seed = HashUtils::Hash64(name.data(), name.size(), flags);
+    hash = static_cast<size_t>(HashUtils::Hash64(hashedFactors.data(), sizeof(hashedFactors), seed));
+}
+
+bool MaterialSignature::operator==(const MaterialSignature& other) const
+{
+    // The factors are compared as floats rather than hashed bits, so that a NaN factor never matches
+    return hash == other.hash &&
+        alphaMode == other.alphaMode &&
+        doubleSided == other.doubleSided &&
+        hasSpecularGlossiness == other.hasSpecularGlossiness &&
+        factors == other.factors &&
+        name == other.name;
+}
+
+bool MaterialSignature::operator!=(const MaterialSignature& other) const
+{
+    return !(*this == other);
+}
+
+bool GLTFMaterialUtils::AreEquivalent(const Material& material, const Material& other)
+{
+    return MaterialSignature(material) == MaterialSignature(other);
+}
+
+std::unordered_map<MaterialSignature, std::string, MaterialSignatureHash> GLTFMaterialUtils::IndexMaterials(const Document& doc)
+{
+    std::unordered_map<MaterialSignature, std::string, MaterialSignatureHash> index;
+    index.reserve(doc.materials.Size());
+
+    for (const auto& material : doc.materials.Elements())
+    {
+        index.emplace(MaterialSignature(material), material.id);
+    }
+
+    return index;
+}
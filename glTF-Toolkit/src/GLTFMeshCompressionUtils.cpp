@@ -5,9 +5,14 @@
 #include "AccessorUtils.h"
 
 #include "GLTFMeshCompressionUtils.h"
+#include "GLTFMeshQuantizationUtils.h"
+#include "MeshoptCodec.h"
 #include "GLTFSDK/MeshPrimitiveUtils.h"
 #include "GLTFSDK/ExtensionsKHR.h"
 #include "GLTFSDK/BufferBuilder.h"
+#include "GLTFSDK/RapidJsonUtils.h"
+
+#include <map>
 
 #pragma warning(push)
 #pragma warning(disable: 4018 4081 4244 4267 4389)
@@ -219,7 +224,7 @@ Document GLTFMeshCompressionUtils::CompressMesh(
 
             dracoExtension->attributes.emplace(attribute.first, dracoMesh.attribute(attId)->unique_id());
         }
-        if (primitive.targets.size() > 0)
+        if (primitive.targets.size() > 0 || options.PreserveTriangleOrder)
         {
             // Set sequential encoding to preserve order of vertices.
             encoder.SetEncodingMethod(draco::MESH_SEQUENTIAL_ENCODING);
@@ -289,3 +294,447 @@ Document GLTFMeshCompressionUtils::CompressMeshes(std::shared_ptr<IStreamReader>
 
     return resultDocument;
 }
+
+namespace
+{
+    // How an accessor is used, which selects the EXT_meshopt_compression mode and filter it's compressed with.
+    // The vertex attribute usages come first.
+    enum class MeshoptUsage
+    {
+        Position,
+        Normal,
+        Tangent,
+        TexCoord,
+        VertexAttribute,
+        Index,
+        AnimationRotation,
+        AnimationVector,
+        Other
+    };
+
+    // The elements of compressed bufferViews are aligned to 4 bytes, as the vertex codec requires
+    const size_t MESHOPT_ELEMENT_ALIGNMENT = 4;
+    const size_t MESHOPT_MAX_STRIDE = 256;
+
+    size_t AlignMeshoptElement(size_t byteLength)
+    {
+        return (byteLength + MESHOPT_ELEMENT_ALIGNMENT - 1) / MESHOPT_ELEMENT_ALIGNMENT * MESHOPT_ELEMENT_ALIGNMENT;
+    }
+
+    bool IsVertexAttributeUsage(MeshoptUsage usage)
+    {
+        return usage <= MeshoptUsage::VertexAttribute;
+    }
+
+    std::map<std::string, std::set<MeshoptUsage>> GetMeshoptUsages(const Document& doc)
+    {
+        std::map<std::string, std::set<MeshoptUsage>> usages;
+        auto AddUsage = [&usages](const std::string& accessorId, MeshoptUsage usage)
+        {
+            if (!accessorId.empty())
+            {
+                usages[accessorId].insert(usage);
+            }
+        };
+
+        for (const auto& mesh : doc.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                // Draco compressed accessors have no bufferView, and are skipped later on
+                AddUsage(primitive.indicesAccessorId, MeshoptUsage::Index);
+
+                for (const auto& attribute : primitive.attributes)
+                {
+                    if (attribute.first == ACCESSOR_POSITION)
+                    {
+                        AddUsage(attribute.second, MeshoptUsage::Position);
+                    }
+                    else if (attribute.first == ACCESSOR_NORMAL)
+                    {
+                        AddUsage(attribute.second, MeshoptUsage::Normal);
+                    }
+                    else if (attribute.first == ACCESSOR_TANGENT)
+                    {
+                        AddUsage(attribute.second, MeshoptUsage::Tangent);
+                    }
+                    else if (attribute.first.compare(0, 9, "TEXCOORD_") == 0)
+                    {
+                        AddUsage(attribute.second, MeshoptUsage::TexCoord);
+                    }
+                    else
+                    {
+                        AddUsage(attribute.second, MeshoptUsage::VertexAttribute);
+                    }
+                }
+
+                // Morph targets hold displacements, which the filters don't suit
+                for (const auto& target : primitive.targets)
+                {
+                    AddUsage(target.positionsAccessorId, MeshoptUsage::VertexAttribute);
+                    AddUsage(target.normalsAccessorId, MeshoptUsage::VertexAttribute);
+                    AddUsage(target.tangentsAccessorId, MeshoptUsage::VertexAttribute);
+                }
+            }
+        }
+
+        for (const auto& skin : doc.skins.Elements())
+        {
+            AddUsage(skin.inverseBindMatricesAccessorId, MeshoptUsage::Other);
+        }
+
+        for (const auto& animation : doc.animations.Elements())
+        {
+            for (const auto& channel : animation.channels.Elements())
+            {
+                const auto& sampler = animation.samplers.Get(channel.samplerId);
+                AddUsage(sampler.inputAccessorId, MeshoptUsage::Other);
+
+                switch (channel.target.path)
+                {
+                case TARGET_ROTATION:
+                    AddUsage(sampler.outputAccessorId, MeshoptUsage::AnimationRotation);
+                    break;
+                case TARGET_TRANSLATION:
+                case TARGET_SCALE:
+                    AddUsage(sampler.outputAccessorId, MeshoptUsage::AnimationVector);
+                    break;
+                default:
+                    AddUsage(sampler.outputAccessorId, MeshoptUsage::Other);
+                    break;
+                }
+            }
+        }
+
+        return usages;
+    }
+
+    // Reads the elements of an accessor, each of them starting byteStride bytes after the previous one
+    template<typename T>
+    std::vector<uint8_t> ReadElements(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor, size_t byteStride)
+    {
+        auto values = reader.ReadBinaryData<T>(doc, accessor);
+        auto typeCount = Accessor::GetTypeCount(accessor.type);
+
+        std::vector<uint8_t> elements(accessor.count * byteStride, 0);
+        for (size_t i = 0; i < accessor.count; i++)
+        {
+            memcpy(&elements[i * byteStride], &values[i * typeCount], typeCount * sizeof(T));
+        }
+
+        return elements;
+    }
+
+    std::vector<uint8_t> ReadElements(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor, size_t byteStride)
+    {
+        switch (accessor.componentType)
+        {
+        case COMPONENT_BYTE: return ReadElements<int8_t>(reader, doc, accessor, byteStride);
+        case COMPONENT_UNSIGNED_BYTE: return ReadElements<uint8_t>(reader, doc, accessor, byteStride);
+        case COMPONENT_SHORT: return ReadElements<int16_t>(reader, doc, accessor, byteStride);
+        case COMPONENT_UNSIGNED_SHORT: return ReadElements<uint16_t>(reader, doc, accessor, byteStride);
+        case COMPONENT_UNSIGNED_INT: return ReadElements<uint32_t>(reader, doc, accessor, byteStride);
+        case COMPONENT_FLOAT: return ReadElements<float>(reader, doc, accessor, byteStride);
+        default: throw GLTFException("Unknown component type.");
+        }
+    }
+
+    // Reads float vectors as 4 components each, which is what the octahedral and quaternion filters expect
+    std::vector<float> ReadVectors(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        auto values = reader.ReadBinaryData<float>(doc, accessor);
+        auto typeCount = Accessor::GetTypeCount(accessor.type);
+
+        std::vector<float> vectors(accessor.count * 4, 1.0f);
+        for (size_t i = 0; i < accessor.count; i++)
+        {
+            std::copy(&values[i * typeCount], &values[i * typeCount] + typeCount, &vectors[i * 4]);
+        }
+
+        return vectors;
+    }
+
+    // A bufferView of the compressed buffer, and how to decode it
+    struct MeshoptBufferView
+    {
+        std::string accessorId;
+        size_t byteOffset;
+        size_t byteLength;
+        size_t byteStride;
+        bool indices;
+        MeshoptFilter filter;
+        Optional<BufferViewTarget> target;
+    };
+
+    std::string NextUnusedId(const IndexedContainer<const Buffer>& buffers, size_t& next)
+    {
+        while (buffers.Has(std::to_string(next)))
+        {
+            next++;
+        }
+        return std::to_string(next++);
+    }
+}
+
+Document GLTFMeshCompressionUtils::CompressMeshesMeshopt(std::shared_ptr<IStreamReader> streamReader, const Document& doc, MeshoptCompressionOptions options, const std::string& outputDirectory)
+{
+    Document resultDocument(doc);
+    GLTFResourceReader reader(streamReader);
+
+    auto usages = GetMeshoptUsages(doc);
+    std::vector<uint8_t> compressed;
+    std::vector<MeshoptBufferView> compressedBufferViews;
+    bool octahedralNormals = false;
+
+    for (const auto& accessor : doc.accessors.Elements())
+    {
+        auto usage = usages.find(accessor.id);
+        if (usage == usages.end() || accessor.bufferViewId.empty() || accessor.count == 0 || accessor.sparse.count > 0 ||
+            doc.bufferViews.Get(accessor.bufferViewId).extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) > 0)
+        {
+            continue;
+        }
+
+        const auto& kinds = usage->second;
+        size_t componentSize = Accessor::GetComponentTypeSize(accessor.componentType);
+        size_t elementSize = Accessor::GetTypeCount(accessor.type) * componentSize;
+        bool isVertexAttribute = std::all_of(kinds.begin(), kinds.end(), IsVertexAttributeUsage);
+        auto kind = kinds.size() == 1 ? *kinds.begin() : MeshoptUsage::Other;
+
+        MeshoptBufferView bufferView = {};
+        bufferView.accessorId = accessor.id;
+        bufferView.filter = MeshoptFilter::None;
+
+        Accessor compressedAccessor(accessor);
+        std::vector<uint8_t> encoded;
+
+        if (kinds.count(MeshoptUsage::Index) > 0)
+        {
+            // The index codec only handles 16 and 32-bit indices that aren't used as anything else
+            if (kind != MeshoptUsage::Index || (accessor.componentType != COMPONENT_UNSIGNED_SHORT && accessor.componentType != COMPONENT_UNSIGNED_INT))
+            {
+                continue;
+            }
+
+            std::vector<uint32_t> indices;
+            if (accessor.componentType == COMPONENT_UNSIGNED_SHORT)
+            {
+                auto indices16 = reader.ReadBinaryData<uint16_t>(doc, accessor);
+                indices.assign(indices16.begin(), indices16.end());
+            }
+            else
+            {
+                indices = reader.ReadBinaryData<uint32_t>(doc, accessor);
+            }
+
+            bufferView.indices = true;
+            bufferView.byteStride = componentSize;
+            bufferView.target = BufferViewTarget::ELEMENT_ARRAY_BUFFER;
+            encoded = MeshoptCodec::EncodeIndexSequence(indices.data(), indices.size());
+        }
+        else
+        {
+            // Matrices of 1 and 2-byte components have padded columns, and only vertex attributes can have a stride larger than their elements
+            auto byteStride = AlignMeshoptElement(elementSize);
+            bool isMatrix = accessor.type == TYPE_MAT2 || accessor.type == TYPE_MAT3 || accessor.type == TYPE_MAT4;
+            if ((isMatrix && componentSize < 4) || byteStride > MESHOPT_MAX_STRIDE || (!isVertexAttribute && byteStride != elementSize))
+            {
+                continue;
+            }
+
+            bool isFloat = accessor.componentType == COMPONENT_FLOAT;
+            int exponentialBits = 0;
+            if (isFloat && (kind == MeshoptUsage::Position || kind == MeshoptUsage::AnimationVector))
+            {
+                exponentialBits = options.PositionQuantizationBits;
+            }
+            else if (isFloat && kind == MeshoptUsage::TexCoord)
+            {
+                exponentialBits = options.TexCoordQuantizationBits;
+            }
+
+            std::vector<uint8_t> elements;
+            if (isFloat && options.NormalQuantizationBits > 0 &&
+                ((kind == MeshoptUsage::Normal && accessor.type == TYPE_VEC3) || (kind == MeshoptUsage::Tangent && accessor.type == TYPE_VEC4)))
+            {
+                byteStride = options.NormalQuantizationBits > 8 ? 8 : 4;
+                elements.resize(accessor.count * byteStride);
+                MeshoptCodec::EncodeFilterOctahedral(elements.data(), accessor.count, byteStride, std::min(options.NormalQuantizationBits, 16), ReadVectors(reader, doc, accessor).data());
+
+                bufferView.filter = MeshoptFilter::Octahedral;
+                compressedAccessor.componentType = byteStride == 4 ? COMPONENT_BYTE : COMPONENT_SHORT;
+                compressedAccessor.normalized = true;
+                compressedAccessor.min.clear();
+                compressedAccessor.max.clear();
+                octahedralNormals = true;
+            }
+            else if (isFloat && options.RotationQuantizationBits > 0 && kind == MeshoptUsage::AnimationRotation && accessor.type == TYPE_VEC4)
+            {
+                byteStride = 8;
+                elements.resize(accessor.count * byteStride);
+                MeshoptCodec::EncodeFilterQuaternion(elements.data(), accessor.count, std::min(std::max(options.RotationQuantizationBits, 4), 16), ReadVectors(reader, doc, accessor).data());
+
+                bufferView.filter = MeshoptFilter::Quaternion;
+                compressedAccessor.componentType = COMPONENT_SHORT;
+                compressedAccessor.normalized = true;
+                compressedAccessor.min.clear();
+                compressedAccessor.max.clear();
+            }
+            else if (exponentialBits > 0)
+            {
+                auto values = reader.ReadBinaryData<float>(doc, accessor);
+                elements.resize(accessor.count * byteStride);
+                MeshoptCodec::EncodeFilterExponential(elements.data(), accessor.count, byteStride, std::min(exponentialBits, 24), values.data());
+
+                // The bounds have to match the decoded values
+                std::vector<uint8_t> decoded(elements);
+                MeshoptCodec::DecodeFilter(MeshoptFilter::Exponential, decoded.data(), accessor.count, byteStride);
+                memcpy(values.data(), decoded.data(), decoded.size());
+                auto minmax = AccessorUtils::CalculateMinMax(accessor, values);
+                compressedAccessor.min = minmax.first;
+                compressedAccessor.max = minmax.second;
+
+                bufferView.filter = MeshoptFilter::Exponential;
+            }
+            else
+            {
+                elements = ReadElements(reader, doc, accessor, byteStride);
+            }
+
+            bufferView.indices = false;
+            bufferView.byteStride = byteStride;
+            if (isVertexAttribute)
+            {
+                bufferView.target = BufferViewTarget::ARRAY_BUFFER;
+            }
+            encoded = MeshoptCodec::EncodeVertexBuffer(elements.data(), accessor.count, byteStride);
+        }
+
+        bufferView.byteOffset = compressed.size();
+        bufferView.byteLength = encoded.size();
+        compressed.insert(compressed.end(), encoded.begin(), encoded.end());
+        compressed.resize(AlignMeshoptElement(compressed.size()), 0);
+
+        resultDocument.accessors.Replace(compressedAccessor);
+        compressedBufferViews.push_back(std::move(bufferView));
+    }
+
+    if (compressedBufferViews.empty())
+    {
+        return resultDocument;
+    }
+
+    // The compressed data goes to a buffer of its own, and the bufferViews that decode it to a fallback buffer without data
+    size_t nextBufferId = doc.buffers.Size();
+    Buffer compressedBuffer;
+    compressedBuffer.id = NextUnusedId(doc.buffers, nextBufferId);
+    compressedBuffer.uri = (std::experimental::filesystem::u8path(outputDirectory) / ("MeshoptCompression" + compressedBuffer.id + ".bin")).u8string();
+    compressedBuffer.byteLength = compressed.size();
+
+    std::ofstream compressedStream(std::experimental::filesystem::u8path(compressedBuffer.uri), std::ios::binary);
+    if (!compressedStream.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size())))
+    {
+        throw GLTFException("Could not write " + compressedBuffer.uri + ".");
+    }
+
+    auto compressedBufferIndex = resultDocument.buffers.Size();
+    resultDocument.buffers.Append(compressedBuffer);
+
+    Buffer fallbackBuffer;
+    fallbackBuffer.id = NextUnusedId(doc.buffers, nextBufferId);
+    fallbackBuffer.extensions[EXTENSION_EXT_MESHOPT_COMPRESSION] = "{\"fallback\":true}";
+
+    std::unordered_set<std::string> replacedBufferViewIds;
+    size_t nextBufferViewId = doc.bufferViews.Size();
+    for (const auto& compressedBufferView : compressedBufferViews)
+    {
+        Accessor accessor(resultDocument.accessors.Get(compressedBufferView.accessorId));
+
+        BufferView bufferView;
+        while (resultDocument.bufferViews.Has(std::to_string(nextBufferViewId)))
+        {
+            nextBufferViewId++;
+        }
+        bufferView.id = std::to_string(nextBufferViewId);
+        bufferView.bufferId = fallbackBuffer.id;
+        bufferView.byteOffset = fallbackBuffer.byteLength;
+        bufferView.byteLength = accessor.count * compressedBufferView.byteStride;
+        bufferView.target = compressedBufferView.target;
+        if (!compressedBufferView.indices && compressedBufferView.target.HasValue())
+        {
+            bufferView.byteStride = compressedBufferView.byteStride;
+        }
+        fallbackBuffer.byteLength = AlignMeshoptElement(bufferView.byteOffset + bufferView.byteLength);
+
+        rapidjson::Document extensionJson(rapidjson::kObjectType);
+        auto& a = extensionJson.GetAllocator();
+        extensionJson.AddMember("buffer", rapidjson::Value(static_cast<uint64_t>(compressedBufferIndex)), a);
+        extensionJson.AddMember("byteOffset", rapidjson::Value(static_cast<uint64_t>(compressedBufferView.byteOffset)), a);
+        extensionJson.AddMember("byteLength", rapidjson::Value(static_cast<uint64_t>(compressedBufferView.byteLength)), a);
+        extensionJson.AddMember("byteStride", rapidjson::Value(static_cast<uint64_t>(compressedBufferView.byteStride)), a);
+        extensionJson.AddMember("count", rapidjson::Value(static_cast<uint64_t>(accessor.count)), a);
+        extensionJson.AddMember("mode", rapidjson::StringRef(compressedBufferView.indices ? "INDICES" : "ATTRIBUTES"), a);
+        if (compressedBufferView.filter != MeshoptFilter::None)
+        {
+            extensionJson.AddMember("filter", rapidjson::StringRef(MeshoptCodec::GetFilterName(compressedBufferView.filter)), a);
+        }
+
+        rapidjson::StringBuffer extensionBuffer;
+        rapidjson::Writer<rapidjson::StringBuffer> extensionWriter(extensionBuffer);
+        extensionJson.Accept(extensionWriter);
+        bufferView.extensions[EXTENSION_EXT_MESHOPT_COMPRESSION] = extensionBuffer.GetString();
+
+        replacedBufferViewIds.insert(accessor.bufferViewId);
+        accessor.bufferViewId = bufferView.id;
+        accessor.byteOffset = 0;
+
+        resultDocument.bufferViews.Append(std::move(bufferView));
+        resultDocument.accessors.Replace(accessor);
+    }
+
+    resultDocument.buffers.Append(std::move(fallbackBuffer));
+
+    // Remove the bufferViews that only held the original data
+    for (const auto& accessor : resultDocument.accessors.Elements())
+    {
+        replacedBufferViewIds.erase(accessor.bufferViewId);
+        if (accessor.sparse.count > 0)
+        {
+            replacedBufferViewIds.erase(accessor.sparse.indicesBufferViewId);
+            replacedBufferViewIds.erase(accessor.sparse.valuesBufferViewId);
+        }
+    }
+    for (const auto& image : resultDocument.images.Elements())
+    {
+        replacedBufferViewIds.erase(image.bufferViewId);
+    }
+    for (const auto& mesh : resultDocument.meshes.Elements())
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>())
+            {
+                replacedBufferViewIds.erase(primitive.GetExtension<KHR::MeshPrimitives::DracoMeshCompression>().bufferViewId);
+            }
+        }
+    }
+    for (const auto& bufferViewId : replacedBufferViewIds)
+    {
+        if (resultDocument.bufferViews.Has(bufferViewId))
+        {
+            resultDocument.bufferViews.Remove(bufferViewId);
+        }
+    }
+
+    resultDocument.extensionsUsed.emplace(EXTENSION_EXT_MESHOPT_COMPRESSION);
+    resultDocument.extensionsRequired.emplace(EXTENSION_EXT_MESHOPT_COMPRESSION);
+
+    // Octahedral normals and tangents are stored as normalized integers
+    if (octahedralNormals)
+    {
+        resultDocument.extensionsUsed.emplace(EXTENSION_KHR_MESH_QUANTIZATION);
+        resultDocument.extensionsRequired.emplace(EXTENSION_KHR_MESH_QUANTIZATION);
+    }
+
+    return resultDocument;
+}
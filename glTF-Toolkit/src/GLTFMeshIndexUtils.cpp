@@ -0,0 +1,413 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "GLTFMeshIndexUtils.h"
+#include "BufferBuilderUtils.h"
+#include "AccessorUtils.h"
+#include "MeshoptCodec.h"
+
+#include "GLTFSDK/BufferBuilder.h"
+#include "GLTFSDK/ExtensionsKHR.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    // The number of indices of each point, line or triangle, or 0 for the modes that can't be split
+    size_t GetIndicesPerElement(MeshMode mode)
+    {
+        switch (mode)
+        {
+        case MESH_POINTS:    return 1;
+        case MESH_LINES:     return 2;
+        case MESH_TRIANGLES: return 3;
+        default:             return 0;
+        }
+    }
+
+    // Whether the data of an accessor can be read and replaced
+    bool IsPlainAccessor(const Document& doc, const Accessor& accessor)
+    {
+        return !accessor.bufferViewId.empty() && accessor.sparse.count == 0 &&
+            doc.bufferViews.Get(accessor.bufferViewId).extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) == 0;
+    }
+
+    // The accessors that hold the vertices of a primitive, and whether each one needs min and max values
+    std::vector<std::pair<std::string, bool>> GetVertexAccessorIds(const MeshPrimitive& primitive)
+    {
+        std::vector<std::pair<std::string, bool>> accessorIds;
+        for (const auto& attribute : primitive.attributes)
+        {
+            accessorIds.emplace_back(attribute.second, attribute.first == ACCESSOR_POSITION);
+        }
+
+        for (const auto& target : primitive.targets)
+        {
+            if (!target.positionsAccessorId.empty())
+            {
+                accessorIds.emplace_back(target.positionsAccessorId, true);
+            }
+            if (!target.normalsAccessorId.empty())
+            {
+                accessorIds.emplace_back(target.normalsAccessorId, false);
+            }
+            if (!target.tangentsAccessorId.empty())
+            {
+                accessorIds.emplace_back(target.tangentsAccessorId, false);
+            }
+        }
+
+        return accessorIds;
+    }
+
+    std::vector<uint32_t> ReadIndices(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        switch (accessor.componentType)
+        {
+        case COMPONENT_UNSIGNED_BYTE:
+        {
+            auto indices = reader.ReadBinaryData<uint8_t>(doc, accessor);
+            return std::vector<uint32_t>(indices.begin(), indices.end());
+        }
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            auto indices = reader.ReadBinaryData<uint16_t>(doc, accessor);
+            return std::vector<uint32_t>(indices.begin(), indices.end());
+        }
+        case COMPONENT_UNSIGNED_INT:
+            return reader.ReadBinaryData<uint32_t>(doc, accessor);
+        default:
+            throw GLTFException("Invalid index component type.");
+        }
+    }
+
+    // Writes 16-bit indices to a new bufferView, and returns an index accessor based on the original one that points to it
+    Accessor AddIndices16(BufferBuilder& builder, const Accessor& accessor, const std::vector<uint32_t>& indices)
+    {
+        std::vector<uint16_t> values(indices.begin(), indices.end());
+        const auto& bufferView = builder.AddBufferView(values.data(), values.size() * sizeof(uint16_t), {}, BufferViewTarget::ELEMENT_ARRAY_BUFFER);
+
+        Accessor indexAccessor(accessor);
+        indexAccessor.bufferViewId = bufferView.id;
+        indexAccessor.byteOffset = 0;
+        indexAccessor.componentType = COMPONENT_UNSIGNED_SHORT;
+        indexAccessor.count = indices.size();
+        if (!accessor.min.empty() && !indices.empty())
+        {
+            auto minmax = std::minmax_element(indices.begin(), indices.end());
+            indexAccessor.min = { static_cast<float>(*minmax.first) };
+            indexAccessor.max = { static_cast<float>(*minmax.second) };
+        }
+
+        return indexAccessor;
+    }
+
+    template<typename T>
+    std::vector<uint8_t> ReadVertices(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        auto values = reader.ReadBinaryData<T>(doc, accessor);
+        std::vector<uint8_t> bytes(values.size() * sizeof(T));
+        memcpy(bytes.data(), values.data(), bytes.size());
+        return bytes;
+    }
+
+    // Reads the elements of a vertex accessor, tightly packed
+    std::vector<uint8_t> ReadVertices(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        switch (accessor.componentType)
+        {
+        case COMPONENT_BYTE:           return ReadVertices<int8_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_BYTE:  return ReadVertices<uint8_t>(reader, doc, accessor);
+        case COMPONENT_SHORT:          return ReadVertices<int16_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_SHORT: return ReadVertices<uint16_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_INT:   return ReadVertices<uint32_t>(reader, doc, accessor);
+        case COMPONENT_FLOAT:          return ReadVertices<float>(reader, doc, accessor);
+        default: throw GLTFException("Unknown component type.");
+        }
+    }
+
+    // The accessors that are still used by the meshes, skins and animations of a document
+    std::unordered_set<std::string> GetUsedAccessorIds(const Document& doc)
+    {
+        std::unordered_set<std::string> accessorIds;
+        for (const auto& mesh : doc.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                accessorIds.insert(primitive.indicesAccessorId);
+                for (const auto& accessorId : GetVertexAccessorIds(primitive))
+                {
+                    accessorIds.insert(accessorId.first);
+                }
+            }
+        }
+
+        for (const auto& skin : doc.skins.Elements())
+        {
+            accessorIds.insert(skin.inverseBindMatricesAccessorId);
+        }
+
+        for (const auto& animation : doc.animations.Elements())
+        {
+            for (const auto& sampler : animation.samplers.Elements())
+            {
+                accessorIds.insert(sampler.inputAccessorId);
+                accessorIds.insert(sampler.outputAccessorId);
+            }
+        }
+
+        return accessorIds;
+    }
+}
+
+Document GLTFMeshIndexUtils::Use16BitIndices(std::shared_ptr<IStreamReader> streamReader, const Document& doc, const std::string& outputDirectory)
+{
+    Document resultDocument(doc);
+    GLTFResourceReader reader(streamReader);
+
+    auto writer = std::make_unique<GLTFResourceWriter>(std::make_shared<BufferFileStreamWriter>());
+    writer->SetUriPrefix((std::experimental::filesystem::u8path(outputDirectory) / "Indices16").u8string());
+    BufferBuilder builder(std::move(writer), BufferBuilderUtils::UnusedIdGenerator(doc.buffers), BufferBuilderUtils::UnusedIdGenerator(doc.bufferViews), BufferBuilderUtils::UnusedIdGenerator(doc.accessors));
+    builder.AddBuffer();
+
+    // The accessors of the split primitives are added to the result document directly, so that they keep the order of the primitives
+    auto GenerateAccessorId = BufferBuilderUtils::UnusedIdGenerator(resultDocument.accessors);
+
+    // Accessors are often shared between the primitives of a mesh, so each one is only read once
+    std::map<std::string, std::vector<uint32_t>> indices;
+    std::map<std::string, std::vector<uint8_t>> vertices;
+
+    std::unordered_set<std::string> narrowedAccessorIds;
+    std::unordered_set<std::string> replacedAccessorIds;
+    std::unordered_set<std::string> replacedBufferViewIds;
+    for (const auto& mesh : doc.meshes.Elements())
+    {
+        Mesh resultMesh(mesh);
+        resultMesh.primitives.clear();
+
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.indicesAccessorId.empty() || primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>() ||
+                !IsPlainAccessor(doc, doc.accessors.Get(primitive.indicesAccessorId)))
+            {
+                resultMesh.primitives.push_back(primitive);
+                continue;
+            }
+
+            const auto& indexAccessor = doc.accessors.Get(primitive.indicesAccessorId);
+            if (indices.count(indexAccessor.id) == 0)
+            {
+                indices.emplace(indexAccessor.id, ReadIndices(reader, doc, indexAccessor));
+            }
+            const auto& primitiveIndices = indices[indexAccessor.id];
+            auto maxIndex = primitiveIndices.empty() ? 0 : *std::max_element(primitiveIndices.begin(), primitiveIndices.end());
+
+            // The indices can be narrowed in place, for every primitive that uses them
+            if (maxIndex < MAX_16BIT_INDEX_VERTEX_COUNT)
+            {
+                if (indexAccessor.componentType == COMPONENT_UNSIGNED_INT && narrowedAccessorIds.insert(indexAccessor.id).second)
+                {
+                    resultDocument.accessors.Replace(AddIndices16(builder, indexAccessor, primitiveIndices));
+                    replacedBufferViewIds.insert(indexAccessor.bufferViewId);
+                }
+
+                resultMesh.primitives.push_back(primitive);
+                continue;
+            }
+
+            auto vertexAccessorIds = GetVertexAccessorIds(primitive);
+            auto indicesPerElement = GetIndicesPerElement(primitive.mode);
+            bool canSplit = indicesPerElement > 0 && primitiveIndices.size() % indicesPerElement == 0 &&
+                std::all_of(vertexAccessorIds.begin(), vertexAccessorIds.end(), [&doc](const std::pair<std::string, bool>& accessorId)
+                {
+                    return IsPlainAccessor(doc, doc.accessors.Get(accessorId.first));
+                });
+            if (!canSplit)
+            {
+                resultMesh.primitives.push_back(primitive);
+                continue;
+            }
+
+            for (const auto& accessorId : vertexAccessorIds)
+            {
+                const auto& accessor = doc.accessors.Get(accessorId.first);
+                if (maxIndex >= accessor.count)
+                {
+                    throw GLTFException("Index " + std::to_string(maxIndex) + " is out of range of accessor " + accessor.id + ".");
+                }
+
+                if (vertices.count(accessor.id) == 0)
+                {
+                    vertices.emplace(accessor.id, ReadVertices(reader, doc, accessor));
+                }
+            }
+
+            // Each part gets its own copy of the vertices it uses, and keeps the material, mode, extensions and extras
+            for (const auto& split : SplitIndices(primitiveIndices, indicesPerElement))
+            {
+                MeshPrimitive splitPrimitive(primitive);
+
+                auto splitIndexAccessor = AddIndices16(builder, indexAccessor, split.Indices);
+                splitIndexAccessor.id = GenerateAccessorId(builder);
+                splitPrimitive.indicesAccessorId = resultDocument.accessors.Append(std::move(splitIndexAccessor)).id;
+
+                auto CopyAccessor = [&](std::string& accessorId, bool calculateMinMax)
+                {
+                    const auto& accessor = doc.accessors.Get(accessorId);
+                    auto splitAccessor = BufferBuilderUtils::CopyVertices(builder, accessor, vertices[accessor.id], split.Vertices, calculateMinMax);
+                    splitAccessor.id = GenerateAccessorId(builder);
+                    accessorId = resultDocument.accessors.Append(std::move(splitAccessor)).id;
+                };
+
+                for (auto& attribute : splitPrimitive.attributes)
+                {
+                    CopyAccessor(attribute.second, attribute.first == ACCESSOR_POSITION);
+                }
+
+                for (auto& target : splitPrimitive.targets)
+                {
+                    if (!target.positionsAccessorId.empty())
+                    {
+                        CopyAccessor(target.positionsAccessorId, true);
+                    }
+                    if (!target.normalsAccessorId.empty())
+                    {
+                        CopyAccessor(target.normalsAccessorId, false);
+                    }
+                    if (!target.tangentsAccessorId.empty())
+                    {
+                        CopyAccessor(target.tangentsAccessorId, false);
+                    }
+                }
+
+                resultMesh.primitives.push_back(std::move(splitPrimitive));
+            }
+
+            replacedAccessorIds.insert(indexAccessor.id);
+            for (const auto& accessorId : vertexAccessorIds)
+            {
+                replacedAccessorIds.insert(accessorId.first);
+            }
+        }
+
+        resultDocument.meshes.Replace(resultMesh);
+    }
+
+    if (narrowedAccessorIds.empty() && replacedAccessorIds.empty())
+    {
+        return doc;
+    }
+
+    // Remove the accessors of the split primitives that nothing else uses
+    auto usedAccessorIds = GetUsedAccessorIds(resultDocument);
+    for (const auto& accessorId : replacedAccessorIds)
+    {
+        if (usedAccessorIds.count(accessorId) == 0 && resultDocument.accessors.Has(accessorId))
+        {
+            replacedBufferViewIds.insert(resultDocument.accessors.Get(accessorId).bufferViewId);
+            resultDocument.accessors.Remove(accessorId);
+        }
+    }
+
+    // Remove the bufferViews that only held the original data
+    for (const auto& accessor : resultDocument.accessors.Elements())
+    {
+        replacedBufferViewIds.erase(accessor.bufferViewId);
+        if (accessor.sparse.count > 0)
+        {
+            replacedBufferViewIds.erase(accessor.sparse.indicesBufferViewId);
+            replacedBufferViewIds.erase(accessor.sparse.valuesBufferViewId);
+        }
+    }
+    for (const auto& image : resultDocument.images.Elements())
+    {
+        replacedBufferViewIds.erase(image.bufferViewId);
+    }
+    for (const auto& mesh : resultDocument.meshes.Elements())
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>())
+            {
+                replacedBufferViewIds.erase(primitive.GetExtension<KHR::MeshPrimitives::DracoMeshCompression>().bufferViewId);
+            }
+        }
+    }
+    for (const auto& bufferViewId : replacedBufferViewIds)
+    {
+        if (resultDocument.bufferViews.Has(bufferViewId))
+        {
+            resultDocument.bufferViews.Remove(bufferViewId);
+        }
+    }
+
+    builder.Output(resultDocument);
+
+    return resultDocument;
+}
+
+std::vector<PrimitiveSplit> GLTFMeshIndexUtils::SplitIndices(const std::vector<uint32_t>& indices, size_t indicesPerElement, size_t maxVertexCount)
+{
+    if (indicesPerElement == 0 || indices.size() % indicesPerElement != 0)
+    {
+        throw std::invalid_argument("The number of indices must be a multiple of the number of indices per element.");
+    }
+
+    if (maxVertexCount < indicesPerElement)
+    {
+        throw std::invalid_argument("Every part must be able to hold at least one element.");
+    }
+
+    const auto unassigned = std::numeric_limits<size_t>::max();
+
+    auto vertexCount = indices.empty() ? 0 : static_cast<size_t>(*std::max_element(indices.begin(), indices.end())) + 1;
+
+    // The part in which each vertex was last numbered, and its number in that part
+    std::vector<size_t> vertexSplits(vertexCount, unassigned);
+    std::vector<uint32_t> localIndices(vertexCount, 0);
+
+    std::vector<PrimitiveSplit> splits;
+    for (size_t i = 0; i < indices.size(); i += indicesPerElement)
+    {
+        // Count the vertices of the element that the current part doesn't have yet
+        size_t newVertices = 0;
+        for (size_t j = 0; j < indicesPerElement; j++)
+        {
+            auto index = indices[i + j];
+            bool isNew = splits.empty() || vertexSplits[index] != splits.size() - 1;
+            for (size_t k = 0; k < j && isNew; k++)
+            {
+                isNew = indices[i + k] != index;
+            }
+            newVertices += isNew ? 1 : 0;
+        }
+
+        if (splits.empty() || splits.back().Vertices.size() + newVertices > maxVertexCount)
+        {
+            splits.emplace_back();
+        }
+
+        auto current = splits.size() - 1;
+        auto& split = splits.back();
+        for (size_t j = 0; j < indicesPerElement; j++)
+        {
+            auto index = indices[i + j];
+            if (vertexSplits[index] != current)
+            {
+                vertexSplits[index] = current;
+                localIndices[index] = static_cast<uint32_t>(split.Vertices.size());
+                split.Vertices.push_back(index);
+            }
+            split.Indices.push_back(localIndices[index]);
+        }
+    }
+
+    return splits;
+}
@@ -0,0 +1,723 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "GLTFMeshOptimizationUtils.h"
+#include "BufferBuilderUtils.h"
+#include "MeshoptCodec.h"
+
+#include "GLTFSDK/BufferBuilder.h"
+#include "GLTFSDK/ExtensionsKHR.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    // Accessors used by anything other than the vertices or indices of an optimizable primitive
+    const char* OTHER_USAGE = "";
+
+    // FIFO cache simulation: a vertex is in the cache while fewer than cacheSize vertices were added after it
+    class VertexCache
+    {
+    public:
+        VertexCache(size_t vertexCount, size_t cacheSize) : m_timestamps(vertexCount, 0), m_time(cacheSize + 1), m_cacheSize(cacheSize) {}
+
+        size_t Update(const uint32_t* triangle)
+        {
+            size_t misses = 0;
+            for (size_t i = 0; i < 3; i++)
+            {
+                if (m_time - m_timestamps[triangle[i]] > m_cacheSize)
+                {
+                    m_timestamps[triangle[i]] = m_time++;
+                    misses++;
+                }
+            }
+            return misses;
+        }
+
+        void Reset()
+        {
+            // Every vertex is now older than the cache size
+            m_time += m_cacheSize + 1;
+        }
+
+    private:
+        std::vector<size_t> m_timestamps;
+        size_t m_time;
+        size_t m_cacheSize;
+    };
+
+    void ValidateIndices(const std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        if (indices.size() % 3 != 0)
+        {
+            throw std::invalid_argument("The number of indices of a triangle list must be a multiple of 3.");
+        }
+
+        for (auto index : indices)
+        {
+            if (index >= vertexCount)
+            {
+                throw std::invalid_argument("Index " + std::to_string(index) + " is out of range.");
+            }
+        }
+    }
+
+    // The accessors that hold the vertices of a primitive, with a key that identifies the set
+    struct VertexSet
+    {
+        std::string key;
+        std::vector<std::string> accessorIds;
+        std::string positionAccessorId;
+    };
+
+    VertexSet GetVertexSet(const MeshPrimitive& primitive)
+    {
+        VertexSet vertexSet;
+
+        std::map<std::string, std::string> attributes(primitive.attributes.begin(), primitive.attributes.end());
+        for (const auto& attribute : attributes)
+        {
+            vertexSet.key += attribute.first + "=" + attribute.second + ";";
+            vertexSet.accessorIds.push_back(attribute.second);
+        }
+
+        for (size_t i = 0; i < primitive.targets.size(); i++)
+        {
+            const auto& target = primitive.targets[i];
+            for (const auto& accessorId : { target.positionsAccessorId, target.normalsAccessorId, target.tangentsAccessorId })
+            {
+                vertexSet.key += accessorId + ";";
+                if (!accessorId.empty())
+                {
+                    vertexSet.accessorIds.push_back(accessorId);
+                }
+            }
+        }
+
+        vertexSet.positionAccessorId = attributes.count(ACCESSOR_POSITION) > 0 ? attributes[ACCESSOR_POSITION] : "";
+        return vertexSet;
+    }
+
+    bool IsOptimizable(const MeshPrimitive& primitive)
+    {
+        return primitive.mode == MESH_TRIANGLES && !primitive.indicesAccessorId.empty() && primitive.HasAttribute(ACCESSOR_POSITION) &&
+            !primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>();
+    }
+
+    // Whether the data of an accessor can be read and replaced
+    bool IsPlainAccessor(const Document& doc, const Accessor& accessor)
+    {
+        return !accessor.bufferViewId.empty() && accessor.sparse.count == 0 &&
+            doc.bufferViews.Get(accessor.bufferViewId).extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) == 0;
+    }
+
+    // Maps each accessor to the vertex sets that use it (as "v:" + key), the vertex sets whose indices it holds (as "i:" + key),
+    // or OTHER_USAGE for everything else
+    std::map<std::string, std::set<std::string>> GetAccessorUsages(const Document& doc)
+    {
+        std::map<std::string, std::set<std::string>> usages;
+        auto AddUsage = [&usages](const std::string& accessorId, const std::string& usage)
+        {
+            if (!accessorId.empty())
+            {
+                usages[accessorId].insert(usage);
+            }
+        };
+
+        for (const auto& mesh : doc.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                auto vertexSet = GetVertexSet(primitive);
+                bool optimizable = IsOptimizable(primitive);
+                AddUsage(primitive.indicesAccessorId, optimizable ? "i:" + vertexSet.key : OTHER_USAGE);
+                for (const auto& accessorId : vertexSet.accessorIds)
+                {
+                    AddUsage(accessorId, optimizable ? "v:" + vertexSet.key : OTHER_USAGE);
+                }
+            }
+        }
+
+        for (const auto& skin : doc.skins.Elements())
+        {
+            AddUsage(skin.inverseBindMatricesAccessorId, OTHER_USAGE);
+        }
+
+        for (const auto& animation : doc.animations.Elements())
+        {
+            for (const auto& sampler : animation.samplers.Elements())
+            {
+                AddUsage(sampler.inputAccessorId, OTHER_USAGE);
+                AddUsage(sampler.outputAccessorId, OTHER_USAGE);
+            }
+        }
+
+        return usages;
+    }
+
+    std::vector<uint32_t> ReadIndices(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        switch (accessor.componentType)
+        {
+        case COMPONENT_UNSIGNED_BYTE:
+        {
+            auto indices = reader.ReadBinaryData<uint8_t>(doc, accessor);
+            return std::vector<uint32_t>(indices.begin(), indices.end());
+        }
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            auto indices = reader.ReadBinaryData<uint16_t>(doc, accessor);
+            return std::vector<uint32_t>(indices.begin(), indices.end());
+        }
+        case COMPONENT_UNSIGNED_INT:
+            return reader.ReadBinaryData<uint32_t>(doc, accessor);
+        default:
+            throw GLTFException("Invalid index component type.");
+        }
+    }
+
+    template<typename T>
+    const BufferView& AddIndices(BufferBuilder& builder, const std::vector<uint32_t>& indices)
+    {
+        std::vector<T> values(indices.begin(), indices.end());
+        return builder.AddBufferView(values.data(), values.size() * sizeof(T), {}, BufferViewTarget::ELEMENT_ARRAY_BUFFER);
+    }
+
+    void ReplaceIndices(Document& resultDocument, BufferBuilder& builder, const Accessor& accessor, const std::vector<uint32_t>& indices,
+                        std::unordered_set<std::string>& replacedBufferViewIds)
+    {
+        std::string bufferViewId;
+        switch (accessor.componentType)
+        {
+        case COMPONENT_UNSIGNED_BYTE:  bufferViewId = AddIndices<uint8_t>(builder, indices).id; break;
+        case COMPONENT_UNSIGNED_SHORT: bufferViewId = AddIndices<uint16_t>(builder, indices).id; break;
+        default:                       bufferViewId = AddIndices<uint32_t>(builder, indices).id; break;
+        }
+
+        replacedBufferViewIds.insert(accessor.bufferViewId);
+
+        Accessor optimizedAccessor(accessor);
+        optimizedAccessor.bufferViewId = bufferViewId;
+        optimizedAccessor.byteOffset = 0;
+        if (!accessor.min.empty() && !indices.empty())
+        {
+            auto minmax = std::minmax_element(indices.begin(), indices.end());
+            optimizedAccessor.min = { static_cast<float>(*minmax.first) };
+            optimizedAccessor.max = { static_cast<float>(*minmax.second) };
+        }
+
+        resultDocument.accessors.Replace(optimizedAccessor);
+    }
+
+    // Writes the elements of an accessor in their new order to a new bufferView, padding every element to 4 bytes
+    template<typename T>
+    void ReorderAccessor(Document& resultDocument, BufferBuilder& builder, const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor,
+                         const std::vector<uint32_t>& remap, std::unordered_set<std::string>& replacedBufferViewIds)
+    {
+        auto values = reader.ReadBinaryData<T>(doc, accessor);
+
+        auto typeCount = Accessor::GetTypeCount(accessor.type);
+        std::vector<T> reordered(values.size());
+        for (size_t i = 0; i < accessor.count; i++)
+        {
+            std::copy(values.begin() + i * typeCount, values.begin() + (i + 1) * typeCount, reordered.begin() + remap[i] * typeCount);
+        }
+
+        const auto& bufferView = BufferBuilderUtils::AddVertexBufferView(builder, reinterpret_cast<const uint8_t*>(reordered.data()), accessor.count, typeCount * sizeof(T));
+
+        replacedBufferViewIds.insert(accessor.bufferViewId);
+
+        Accessor optimizedAccessor(accessor);
+        optimizedAccessor.bufferViewId = bufferView.id;
+        optimizedAccessor.byteOffset = 0;
+
+        resultDocument.accessors.Replace(optimizedAccessor);
+    }
+
+    void ReorderAccessor(Document& resultDocument, BufferBuilder& builder, const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor,
+                         const std::vector<uint32_t>& remap, std::unordered_set<std::string>& replacedBufferViewIds)
+    {
+        switch (accessor.componentType)
+        {
+        case COMPONENT_BYTE:           ReorderAccessor<int8_t>(resultDocument, builder, reader, doc, accessor, remap, replacedBufferViewIds); break;
+        case COMPONENT_UNSIGNED_BYTE:  ReorderAccessor<uint8_t>(resultDocument, builder, reader, doc, accessor, remap, replacedBufferViewIds); break;
+        case COMPONENT_SHORT:          ReorderAccessor<int16_t>(resultDocument, builder, reader, doc, accessor, remap, replacedBufferViewIds); break;
+        case COMPONENT_UNSIGNED_SHORT: ReorderAccessor<uint16_t>(resultDocument, builder, reader, doc, accessor, remap, replacedBufferViewIds); break;
+        case COMPONENT_UNSIGNED_INT:   ReorderAccessor<uint32_t>(resultDocument, builder, reader, doc, accessor, remap, replacedBufferViewIds); break;
+        case COMPONENT_FLOAT:          ReorderAccessor<float>(resultDocument, builder, reader, doc, accessor, remap, replacedBufferViewIds); break;
+        default: throw GLTFException("Unknown component type.");
+        }
+    }
+
+    void Accumulate(VertexCacheStatistics& total, const VertexCacheStatistics& statistics)
+    {
+        total.TriangleCount += statistics.TriangleCount;
+        total.VertexCount += statistics.VertexCount;
+        total.CacheMisses += statistics.CacheMisses;
+    }
+}
+
+Document GLTFMeshOptimizationUtils::OptimizeMeshes(std::shared_ptr<IStreamReader> streamReader, const Document& doc, const MeshOptimizationOptions& options, const std::string& outputDirectory,
+                                                   MeshOptimizationStatistics* statistics)
+{
+    Document resultDocument(doc);
+    GLTFResourceReader reader(streamReader);
+
+    auto writer = std::make_unique<GLTFResourceWriter>(std::make_shared<BufferFileStreamWriter>());
+    writer->SetUriPrefix((std::experimental::filesystem::u8path(outputDirectory) / "MeshOptimization").u8string());
+    BufferBuilder builder(std::move(writer), BufferBuilderUtils::UnusedIdGenerator(doc.buffers), BufferBuilderUtils::UnusedIdGenerator(doc.bufferViews), BufferBuilderUtils::UnusedIdGenerator(doc.accessors));
+    builder.AddBuffer();
+
+    auto usages = GetAccessorUsages(doc);
+
+    // Each index accessor is optimized once, with the vertices of the first primitive that uses it
+    std::map<std::string, VertexSet> vertexSets;
+    std::map<std::string, std::vector<std::string>> indexAccessorIds;
+    std::map<std::string, std::vector<uint32_t>> indices;
+    for (const auto& mesh : doc.meshes.Elements())
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            const auto& indexUsages = usages[primitive.indicesAccessorId];
+            if (!IsOptimizable(primitive) || indices.count(primitive.indicesAccessorId) > 0 || indexUsages.count(OTHER_USAGE) > 0)
+            {
+                continue;
+            }
+
+            const auto& indexAccessor = doc.accessors.Get(primitive.indicesAccessorId);
+            const auto& positionAccessor = doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+            if (!IsPlainAccessor(doc, indexAccessor) || indexAccessor.count % 3 != 0)
+            {
+                continue;
+            }
+
+            auto vertexSet = GetVertexSet(primitive);
+            auto primitiveIndices = ReadIndices(reader, doc, indexAccessor);
+            ValidateIndices(primitiveIndices, positionAccessor.count);
+
+            if (statistics != nullptr)
+            {
+                Accumulate(statistics->Before, AnalyzeVertexCache(primitiveIndices, positionAccessor.count, options.CacheSize));
+            }
+
+            primitiveIndices = OptimizeVertexCache(primitiveIndices, positionAccessor.count, options.CacheSize);
+            if (options.OverdrawThreshold > 0.0f && positionAccessor.componentType == COMPONENT_FLOAT && positionAccessor.type == TYPE_VEC3 && positionAccessor.sparse.count == 0)
+            {
+                primitiveIndices = OptimizeOverdraw(primitiveIndices, reader.ReadBinaryData<float>(doc, positionAccessor), options.CacheSize, options.OverdrawThreshold);
+            }
+
+            vertexSets.emplace(vertexSet.key, vertexSet);
+            indexAccessorIds[vertexSet.key].push_back(indexAccessor.id);
+            indices.emplace(indexAccessor.id, std::move(primitiveIndices));
+        }
+    }
+
+    if (indices.empty())
+    {
+        return resultDocument;
+    }
+
+    // Vertices are reordered for the index accessors that use them together, when nothing else uses them
+    std::unordered_set<std::string> replacedBufferViewIds;
+    for (const auto& vertexSet : vertexSets)
+    {
+        if (!options.OptimizeVertexFetch)
+        {
+            break;
+        }
+
+        const auto& setIndexAccessorIds = indexAccessorIds[vertexSet.first];
+        auto vertexCount = doc.accessors.Get(vertexSet.second.positionAccessorId).count;
+        bool canReorder = std::all_of(vertexSet.second.accessorIds.begin(), vertexSet.second.accessorIds.end(), [&](const std::string& accessorId)
+        {
+            const auto& accessor = doc.accessors.Get(accessorId);
+            return usages[accessorId] == std::set<std::string>{ "v:" + vertexSet.first } && IsPlainAccessor(doc, accessor) && accessor.count == vertexCount;
+        });
+        canReorder = canReorder && std::all_of(setIndexAccessorIds.begin(), setIndexAccessorIds.end(), [&](const std::string& accessorId)
+        {
+            return usages[accessorId] == std::set<std::string>{ "i:" + vertexSet.first };
+        });
+        if (!canReorder)
+        {
+            continue;
+        }
+
+        // Every index accessor that uses the vertices must be renumbered consistently
+        std::vector<uint32_t> setIndices;
+        for (const auto& accessorId : setIndexAccessorIds)
+        {
+            setIndices.insert(setIndices.end(), indices[accessorId].begin(), indices[accessorId].end());
+        }
+
+        auto remap = OptimizeVertexFetch(setIndices, vertexCount);
+
+        auto it = setIndices.begin();
+        for (const auto& accessorId : setIndexAccessorIds)
+        {
+            auto& accessorIndices = indices[accessorId];
+            std::copy(it, it + accessorIndices.size(), accessorIndices.begin());
+            it += accessorIndices.size();
+        }
+
+        std::unordered_set<std::string> reorderedAccessorIds;
+        for (const auto& accessorId : vertexSet.second.accessorIds)
+        {
+            if (reorderedAccessorIds.insert(accessorId).second)
+            {
+                ReorderAccessor(resultDocument, builder, reader, doc, doc.accessors.Get(accessorId), remap, replacedBufferViewIds);
+            }
+        }
+    }
+
+    for (const auto& vertexSet : vertexSets)
+    {
+        auto vertexCount = doc.accessors.Get(vertexSet.second.positionAccessorId).count;
+        for (const auto& accessorId : indexAccessorIds[vertexSet.first])
+        {
+            ReplaceIndices(resultDocument, builder, doc.accessors.Get(accessorId), indices[accessorId], replacedBufferViewIds);
+
+            if (statistics != nullptr)
+            {
+                Accumulate(statistics->After, AnalyzeVertexCache(indices[accessorId], vertexCount, options.CacheSize));
+            }
+        }
+    }
+
+    // Remove the bufferViews that only held the original data
+    for (const auto& accessor : resultDocument.accessors.Elements())
+    {
+        replacedBufferViewIds.erase(accessor.bufferViewId);
+        if (accessor.sparse.count > 0)
+        {
+            replacedBufferViewIds.erase(accessor.sparse.indicesBufferViewId);
+            replacedBufferViewIds.erase(accessor.sparse.valuesBufferViewId);
+        }
+    }
+    for (const auto& image : resultDocument.images.Elements())
+    {
+        replacedBufferViewIds.erase(image.bufferViewId);
+    }
+    for (const auto& mesh : resultDocument.meshes.Elements())
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>())
+            {
+                replacedBufferViewIds.erase(primitive.GetExtension<KHR::MeshPrimitives::DracoMeshCompression>().bufferViewId);
+            }
+        }
+    }
+    for (const auto& bufferViewId : replacedBufferViewIds)
+    {
+        if (resultDocument.bufferViews.Has(bufferViewId))
+        {
+            resultDocument.bufferViews.Remove(bufferViewId);
+        }
+    }
+
+    builder.Output(resultDocument);
+
+    return resultDocument;
+}
+
+VertexCacheStatistics GLTFMeshOptimizationUtils::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize)
+{
+    ValidateIndices(indices, vertexCount);
+
+    VertexCacheStatistics statistics;
+    statistics.TriangleCount = indices.size() / 3;
+
+    std::vector<bool> referenced(vertexCount, false);
+    VertexCache cache(vertexCount, cacheSize);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        statistics.CacheMisses += cache.Update(&indices[i]);
+
+        for (size_t j = 0; j < 3; j++)
+        {
+            if (!referenced[indices[i + j]])
+            {
+                referenced[indices[i + j]] = true;
+                statistics.VertexCount++;
+            }
+        }
+    }
+
+    return statistics;
+}
+
+std::vector<uint32_t> GLTFMeshOptimizationUtils::OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize)
+{
+    ValidateIndices(indices, vertexCount);
+
+    auto triangleCount = indices.size() / 3;
+
+    // The triangles that use each vertex, and how many of them haven't been emitted yet
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (auto index : indices)
+    {
+        liveTriangles[index]++;
+    }
+
+    std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<size_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        adjacency[adjacencyFill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<size_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    size_t time = cacheSize + 1;
+    size_t cursor = 0;
+    int64_t fanningVertex = vertexCount > 0 ? 0 : -1;
+    while (fanningVertex >= 0)
+    {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (size_t i = adjacencyOffsets[fanningVertex]; i < adjacencyOffsets[fanningVertex + 1]; i++)
+        {
+            auto triangle = adjacency[i];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            for (size_t j = 0; j < 3; j++)
+            {
+                auto vertex = indices[triangle * 3 + j];
+                result.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+
+                if (time - cacheTimestamps[vertex] > cacheSize)
+                {
+                    cacheTimestamps[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // The next fanning vertex is the oldest candidate that will still be in the cache after its remaining triangles are emitted
+        fanningVertex = -1;
+        size_t bestPriority = 0;
+        for (auto vertex : candidates)
+        {
+            if (liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+
+            size_t priority = 0;
+            if (time - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+            {
+                priority = time - cacheTimestamps[vertex];
+            }
+            if (fanningVertex < 0 || priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanningVertex = vertex;
+            }
+        }
+
+        // Dead end: continue with a recently used vertex, or the next vertex in input order
+        while (fanningVertex < 0 && !deadEnd.empty())
+        {
+            auto vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[vertex] > 0)
+            {
+                fanningVertex = vertex;
+            }
+        }
+        while (fanningVertex < 0 && cursor < vertexCount)
+        {
+            if (liveTriangles[cursor] > 0)
+            {
+                fanningVertex = cursor;
+            }
+            cursor++;
+        }
+    }
+
+    return result;
+}
+
+std::vector<uint32_t> GLTFMeshOptimizationUtils::OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<float>& positions, size_t cacheSize, float threshold)
+{
+    auto vertexCount = positions.size() / 3;
+    ValidateIndices(indices, vertexCount);
+
+    auto triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return indices;
+    }
+
+    // Hard boundaries: the triangles that miss the cache on all three vertices usually start a new patch of the mesh
+    std::vector<size_t> hardBoundaries;
+    VertexCache cache(vertexCount, cacheSize);
+    for (size_t i = 0; i < triangleCount; i++)
+    {
+        if (cache.Update(&indices[i * 3]) == 3)
+        {
+            hardBoundaries.push_back(i);
+        }
+    }
+    if (hardBoundaries.empty() || hardBoundaries[0] != 0)
+    {
+        hardBoundaries.insert(hardBoundaries.begin(), 0);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // Soft boundaries: clusters are split as soon as their own ACMR, with a cold cache, is within the threshold of the patch ACMR
+    std::vector<size_t> boundaries;
+    for (size_t i = 0; i + 1 < hardBoundaries.size(); i++)
+    {
+        auto start = hardBoundaries[i];
+        auto end = hardBoundaries[i + 1];
+
+        cache.Reset();
+        size_t patchMisses = 0;
+        for (auto triangle = start; triangle < end; triangle++)
+        {
+            patchMisses += cache.Update(&indices[triangle * 3]);
+        }
+        auto patchThreshold = threshold * static_cast<float>(patchMisses) / static_cast<float>(end - start);
+
+        boundaries.push_back(start);
+        cache.Reset();
+        size_t misses = 0;
+        size_t triangles = 0;
+        for (auto triangle = start; triangle + 1 < end; triangle++)
+        {
+            misses += cache.Update(&indices[triangle * 3]);
+            triangles++;
+
+            if (static_cast<float>(misses) / static_cast<float>(triangles) <= patchThreshold)
+            {
+                boundaries.push_back(triangle + 1);
+                cache.Reset();
+                misses = 0;
+                triangles = 0;
+            }
+        }
+    }
+    boundaries.push_back(triangleCount);
+
+    // Clusters that face away from the center of the mesh are likely to occlude the others, so they are drawn first
+    float meshCentroid[3] = {};
+    for (auto index : indices)
+    {
+        for (size_t j = 0; j < 3; j++)
+        {
+            meshCentroid[j] += positions[index * 3 + j] / indices.size();
+        }
+    }
+
+    auto clusterCount = boundaries.size() - 1;
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; cluster++)
+    {
+        float centroid[3] = {};
+        float normal[3] = {};
+        float totalArea = 0.0f;
+        for (auto triangle = boundaries[cluster]; triangle < boundaries[cluster + 1]; triangle++)
+        {
+            const float* p0 = &positions[indices[triangle * 3 + 0] * 3];
+            const float* p1 = &positions[indices[triangle * 3 + 1] * 3];
+            const float* p2 = &positions[indices[triangle * 3 + 2] * 3];
+
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (size_t j = 0; j < 3; j++)
+            {
+                centroid[j] += (p0[j] + p1[j] + p2[j]) / 3.0f * area;
+                normal[j] += n[j];
+            }
+            totalArea += area;
+        }
+
+        float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float key = 0.0f;
+        if (totalArea > 0.0f && normalLength > 0.0f)
+        {
+            for (size_t j = 0; j < 3; j++)
+            {
+                key += (centroid[j] / totalArea - meshCentroid[j]) * normal[j] / normalLength;
+            }
+        }
+        sortKeys[cluster] = key;
+    }
+
+    std::vector<size_t> clusterOrder(clusterCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (auto cluster : clusterOrder)
+    {
+        result.insert(result.end(), indices.begin() + boundaries[cluster] * 3, indices.begin() + boundaries[cluster + 1] * 3);
+    }
+
+    return result;
+}
+
+std::vector<uint32_t> GLTFMeshOptimizationUtils::OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    const auto unassigned = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint32_t> remap(vertexCount, unassigned);
+    uint32_t next = 0;
+    for (auto& index : indices)
+    {
+        if (index >= vertexCount)
+        {
+            throw std::invalid_argument("Index " + std::to_string(index) + " is out of range.");
+        }
+
+        if (remap[index] == unassigned)
+        {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    for (auto& vertex : remap)
+    {
+        if (vertex == unassigned)
+        {
+            vertex = next++;
+        }
+    }
+
+    return remap;
+}
@@ -0,0 +1,690 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "AccessorUtils.h"
+#include "GLTFMeshQuantizationUtils.h"
+#include "BufferBuilderUtils.h"
+
+#include "GLTFSDK/BufferBuilder.h"
+#include "GLTFSDK/ExtensionsKHR.h"
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+const char* Microsoft::glTF::Toolkit::EXTENSION_KHR_MESH_QUANTIZATION = "KHR_mesh_quantization";
+
+namespace
+{
+    const char* TEXCOORD_PREFIX = "TEXCOORD_";
+    const char* COLOR_PREFIX = "COLOR_";
+
+    // The way a mesh uses an accessor. Accessors are only quantized when every use agrees on the dequantization transform.
+    enum class AttributeKind
+    {
+        Position,
+        Normal,
+        Tangent,
+        TexCoord,
+        Color,
+        Other
+    };
+
+    // The kind of attribute, and what shares its dequantization transform: the mesh for positions, and the material
+    // and texture coordinate set for texture coordinates.
+    typedef std::pair<AttributeKind, std::string> AccessorUsage;
+
+    bool StartsWith(const std::string& value, const std::string& prefix)
+    {
+        return value.compare(0, prefix.length(), prefix) == 0;
+    }
+
+    std::string TexCoordGroup(const std::string& materialId, size_t texCoord)
+    {
+        return materialId + "/" + std::to_string(texCoord);
+    }
+
+    std::map<std::string, std::set<AccessorUsage>> GetAccessorUsages(const Document& doc)
+    {
+        std::map<std::string, std::set<AccessorUsage>> usages;
+        auto AddUsage = [&usages](const std::string& accessorId, AttributeKind kind, const std::string& group)
+        {
+            if (!accessorId.empty())
+            {
+                usages[accessorId].emplace(kind, group);
+            }
+        };
+
+        for (const auto& mesh : doc.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                AddUsage(primitive.indicesAccessorId, AttributeKind::Other, "");
+
+                for (const auto& attribute : primitive.attributes)
+                {
+                    if (attribute.first == ACCESSOR_POSITION)
+                    {
+                        AddUsage(attribute.second, AttributeKind::Position, mesh.id);
+                    }
+                    else if (attribute.first == ACCESSOR_NORMAL)
+                    {
+                        AddUsage(attribute.second, AttributeKind::Normal, "");
+                    }
+                    else if (attribute.first == ACCESSOR_TANGENT)
+                    {
+                        AddUsage(attribute.second, AttributeKind::Tangent, "");
+                    }
+                    else if (StartsWith(attribute.first, TEXCOORD_PREFIX))
+                    {
+                        auto texCoord = std::stoul(attribute.first.substr(strlen(TEXCOORD_PREFIX)));
+                        AddUsage(attribute.second, AttributeKind::TexCoord, TexCoordGroup(primitive.materialId, texCoord));
+                    }
+                    else if (StartsWith(attribute.first, COLOR_PREFIX))
+                    {
+                        AddUsage(attribute.second, AttributeKind::Color, "");
+                    }
+                    else
+                    {
+                        AddUsage(attribute.second, AttributeKind::Other, "");
+                    }
+                }
+
+                for (const auto& target : primitive.targets)
+                {
+                    AddUsage(target.positionsAccessorId, AttributeKind::Other, "");
+                    AddUsage(target.normalsAccessorId, AttributeKind::Other, "");
+                    AddUsage(target.tangentsAccessorId, AttributeKind::Other, "");
+                }
+            }
+        }
+
+        for (const auto& skin : doc.skins.Elements())
+        {
+            AddUsage(skin.inverseBindMatricesAccessorId, AttributeKind::Other, "");
+        }
+
+        for (const auto& animation : doc.animations.Elements())
+        {
+            for (const auto& sampler : animation.samplers.Elements())
+            {
+                AddUsage(sampler.inputAccessorId, AttributeKind::Other, "");
+                AddUsage(sampler.outputAccessorId, AttributeKind::Other, "");
+            }
+        }
+
+        return usages;
+    }
+
+    // Whether an accessor is only used as one kind of attribute, within one group, and holds float vectors with the expected number of components
+    bool CanQuantize(const Document& doc, const std::map<std::string, std::set<AccessorUsage>>& usages, const std::string& accessorId, const AccessorUsage& usage, AccessorType type)
+    {
+        auto it = usages.find(accessorId);
+        if (it == usages.end() || it->second.size() != 1 || *it->second.begin() != usage)
+        {
+            return false;
+        }
+
+        const auto& accessor = doc.accessors.Get(accessorId);
+        return !accessor.bufferViewId.empty() && accessor.count > 0 && accessor.componentType == COMPONENT_FLOAT && accessor.type == type;
+    }
+
+    // The largest error made when rounding a value in [0, 1] (or [-1, 1]) to a normalized integer of type T,
+    // relative to the range the normalized integer covers
+    template<typename T>
+    double RoundingError()
+    {
+        return std::is_signed<T>::value ? 0.25 / std::numeric_limits<T>::max() : 0.5 / std::numeric_limits<T>::max();
+    }
+
+    // Picks the smallest normalized integer type whose rounding error stays within the maximum error, or COMPONENT_UNKNOWN if there is none.
+    // absoluteError is true when the error is measured on the decoded value rather than relative to the range.
+    ComponentType SelectComponentType(float maxError, bool isSigned, bool absoluteError)
+    {
+        // Signed values cover [-1, 1], so their error relative to the range is half the error on the decoded value
+        double scale = absoluteError && isSigned ? 2.0 : 1.0;
+
+        if (isSigned)
+        {
+            if (maxError >= RoundingError<int8_t>() * scale) return COMPONENT_BYTE;
+            if (maxError >= RoundingError<int16_t>() * scale) return COMPONENT_SHORT;
+        }
+        else
+        {
+            if (maxError >= RoundingError<uint8_t>() * scale) return COMPONENT_UNSIGNED_BYTE;
+            if (maxError >= RoundingError<uint16_t>() * scale) return COMPONENT_UNSIGNED_SHORT;
+        }
+
+        return COMPONENT_UNKNOWN;
+    }
+
+    template<typename T>
+    T Quantize(double value)
+    {
+        // Normalized signed integers never use their smallest value, so that -1 and 1 are symmetric
+        double lowest = std::is_signed<T>::value ? -1.0 : 0.0;
+        return static_cast<T>(std::lround(std::min(std::max(value, lowest), 1.0) * std::numeric_limits<T>::max()));
+    }
+
+    // Writes quantized values to a new bufferView, padding every element to 4 bytes, and replaces the original accessor with one that points to it
+    template<typename T>
+    void ReplaceAccessor(Document& resultDocument, BufferBuilder& builder, const Accessor& accessor, ComponentType componentType, const std::vector<T>& values,
+                         std::unordered_set<std::string>& replacedBufferViewIds)
+    {
+        auto elementSize = Accessor::GetTypeCount(accessor.type) * sizeof(T);
+        const auto& bufferView = BufferBuilderUtils::AddVertexBufferView(builder, reinterpret_cast<const uint8_t*>(values.data()), accessor.count, elementSize);
+
+        replacedBufferViewIds.insert(accessor.bufferViewId);
+        if (accessor.sparse.count > 0)
+        {
+            replacedBufferViewIds.insert(accessor.sparse.indicesBufferViewId);
+            replacedBufferViewIds.insert(accessor.sparse.valuesBufferViewId);
+        }
+
+        Accessor quantizedAccessor(accessor);
+        quantizedAccessor.bufferViewId = bufferView.id;
+        quantizedAccessor.byteOffset = 0;
+        quantizedAccessor.componentType = componentType;
+        quantizedAccessor.normalized = true;
+        quantizedAccessor.sparse = Sparse();
+
+        auto minmax = AccessorUtils::CalculateMinMax(quantizedAccessor, values);
+        quantizedAccessor.min = minmax.first;
+        quantizedAccessor.max = minmax.second;
+
+        resultDocument.accessors.Replace(quantizedAccessor);
+    }
+
+    // Quantizes float values with an affine transform, value = offset[i] + scale[i] * quantized, applied to each component i
+    template<typename T>
+    void QuantizeAccessor(Document& resultDocument, BufferBuilder& builder, const Accessor& accessor, ComponentType componentType, const std::vector<float>& values,
+                          const std::vector<double>& offset, const std::vector<double>& scale, std::unordered_set<std::string>& replacedBufferViewIds)
+    {
+        auto typeCount = Accessor::GetTypeCount(accessor.type);
+
+        std::vector<T> quantized(values.size());
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            auto component = i % typeCount;
+            quantized[i] = Quantize<T>((values[i] - offset[component]) / scale[component]);
+        }
+
+        ReplaceAccessor(resultDocument, builder, accessor, componentType, quantized, replacedBufferViewIds);
+    }
+
+    void QuantizeAccessor(Document& resultDocument, BufferBuilder& builder, const Accessor& accessor, ComponentType componentType, const std::vector<float>& values,
+                          const std::vector<double>& offset, const std::vector<double>& scale, std::unordered_set<std::string>& replacedBufferViewIds)
+    {
+        switch (componentType)
+        {
+        case COMPONENT_BYTE:
+            QuantizeAccessor<int8_t>(resultDocument, builder, accessor, componentType, values, offset, scale, replacedBufferViewIds);
+            break;
+        case COMPONENT_UNSIGNED_BYTE:
+            QuantizeAccessor<uint8_t>(resultDocument, builder, accessor, componentType, values, offset, scale, replacedBufferViewIds);
+            break;
+        case COMPONENT_SHORT:
+            QuantizeAccessor<int16_t>(resultDocument, builder, accessor, componentType, values, offset, scale, replacedBufferViewIds);
+            break;
+        case COMPONENT_UNSIGNED_SHORT:
+            QuantizeAccessor<uint16_t>(resultDocument, builder, accessor, componentType, values, offset, scale, replacedBufferViewIds);
+            break;
+        default:
+            throw GLTFException("Unsupported quantized component type.");
+        }
+    }
+
+    // The transform that takes the quantized positions of a mesh back to its original space: a uniform scale followed by a translation
+    struct PositionTransform
+    {
+        double center[3];
+        double scale;
+    };
+
+    Vector3 Rotate(const Quaternion& q, const Vector3& v)
+    {
+        // v' = v + 2w(q x v) + 2q x (q x v)
+        Vector3 t = { 2.0f * (q.y * v.z - q.z * v.y), 2.0f * (q.z * v.x - q.x * v.z), 2.0f * (q.x * v.y - q.y * v.x) };
+        return {
+            v.x + q.w * t.x + (q.y * t.z - q.z * t.y),
+            v.y + q.w * t.y + (q.z * t.x - q.x * t.z),
+            v.z + q.w * t.z + (q.x * t.y - q.y * t.x)
+        };
+    }
+
+    // Appends the dequantization transform to the local transform of a node: M' = M * T(center) * S(scale)
+    void FoldPositionTransform(Node& node, const PositionTransform& transform)
+    {
+        auto scale = static_cast<float>(transform.scale);
+
+        switch (node.GetTransformationType())
+        {
+        case TRANSFORMATION_MATRIX:
+        {
+            auto& m = node.matrix.values;
+            for (size_t row = 0; row < 4; row++)
+            {
+                // Matrices are column-major
+                m[12 + row] += static_cast<float>(m[row] * transform.center[0] + m[4 + row] * transform.center[1] + m[8 + row] * transform.center[2]);
+            }
+            for (size_t i = 0; i < 12; i++)
+            {
+                m[i] *= scale;
+            }
+            break;
+        }
+        case TRANSFORMATION_TRS:
+        {
+            Vector3 scaledCenter = {
+                static_cast<float>(node.scale.x * transform.center[0]),
+                static_cast<float>(node.scale.y * transform.center[1]),
+                static_cast<float>(node.scale.z * transform.center[2])
+            };
+            auto offset = Rotate(node.rotation, scaledCenter);
+            node.translation = { node.translation.x + offset.x, node.translation.y + offset.y, node.translation.z + offset.z };
+            node.scale = { node.scale.x * scale, node.scale.y * scale, node.scale.z * scale };
+            break;
+        }
+        default:
+            node.translation = { static_cast<float>(transform.center[0]), static_cast<float>(transform.center[1]), static_cast<float>(transform.center[2]) };
+            node.scale = { scale, scale, scale };
+            break;
+        }
+    }
+
+    // Composes the dequantization of a texture coordinate set, uv = min + range * quantized, with the texture transform of a texture
+    void FoldTexCoordTransform(TextureInfo& textureInfo, size_t texCoord, const std::vector<double>& min, const std::vector<double>& range)
+    {
+        if (textureInfo.textureId.empty())
+        {
+            return;
+        }
+
+        if (!textureInfo.HasExtension<KHR::TextureInfos::TextureTransform>())
+        {
+            if (textureInfo.texCoord != texCoord)
+            {
+                return;
+            }
+
+            textureInfo.SetExtension(std::make_unique<KHR::TextureInfos::TextureTransform>());
+        }
+
+        auto& transform = textureInfo.GetExtension<KHR::TextureInfos::TextureTransform>();
+        auto effectiveTexCoord = transform.texCoord.HasValue() ? transform.texCoord.Get() : textureInfo.texCoord;
+        if (effectiveTexCoord != texCoord)
+        {
+            return;
+        }
+
+        // offset' = offset + R(scale * min), scale' = scale * range
+        double x = transform.scale.x * min[0];
+        double y = transform.scale.y * min[1];
+        double c = std::cos(transform.rotation);
+        double s = std::sin(transform.rotation);
+
+        transform.offset = { static_cast<float>(transform.offset.x + c * x + s * y), static_cast<float>(transform.offset.y - s * x + c * y) };
+        transform.scale = { static_cast<float>(transform.scale.x * range[0]), static_cast<float>(transform.scale.y * range[1]) };
+    }
+
+    std::vector<TextureInfo*> GetTextureInfos(Material& material)
+    {
+        std::vector<TextureInfo*> textureInfos = {
+            &material.metallicRoughness.baseColorTexture,
+            &material.metallicRoughness.metallicRoughnessTexture,
+            &material.normalTexture,
+            &material.occlusionTexture,
+            &material.emissiveTexture
+        };
+
+        if (material.HasExtension<KHR::Materials::PBRSpecularGlossiness>())
+        {
+            auto& specularGlossiness = material.GetExtension<KHR::Materials::PBRSpecularGlossiness>();
+            textureInfos.push_back(&specularGlossiness.diffuseTexture);
+            textureInfos.push_back(&specularGlossiness.specularGlossinessTexture);
+        }
+
+        return textureInfos;
+    }
+
+    bool UsesTexCoord(const Material& material, size_t texCoord)
+    {
+        Material copy(material);
+        for (auto textureInfo : GetTextureInfos(copy))
+        {
+            if (textureInfo->textureId.empty())
+            {
+                continue;
+            }
+
+            auto effectiveTexCoord = textureInfo->texCoord;
+            if (textureInfo->HasExtension<KHR::TextureInfos::TextureTransform>())
+            {
+                const auto& transform = textureInfo->GetExtension<KHR::TextureInfos::TextureTransform>();
+                if (transform.texCoord.HasValue())
+                {
+                    effectiveTexCoord = transform.texCoord.Get();
+                }
+            }
+
+            if (effectiveTexCoord == texCoord)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+Document GLTFMeshQuantizationUtils::QuantizeMeshes(std::shared_ptr<IStreamReader> streamReader, const Document& doc, const QuantizationOptions& options, const std::string& outputDirectory)
+{
+    Document resultDocument(doc);
+    GLTFResourceReader reader(streamReader);
+
+    auto writer = std::make_unique<GLTFResourceWriter>(std::make_shared<BufferFileStreamWriter>());
+    writer->SetUriPrefix((std::experimental::filesystem::u8path(outputDirectory) / "MeshQuantization").u8string());
+    BufferBuilder builder(std::move(writer), BufferBuilderUtils::UnusedIdGenerator(doc.buffers), BufferBuilderUtils::UnusedIdGenerator(doc.bufferViews), BufferBuilderUtils::UnusedIdGenerator(doc.accessors));
+    builder.AddBuffer();
+
+    auto usages = GetAccessorUsages(doc);
+    std::unordered_set<std::string> replacedBufferViewIds;
+    bool quantizedTexCoords = false;
+
+    // Positions: one transform per mesh, so that every primitive of the mesh can be drawn with the same node transform
+    std::unordered_set<std::string> skinnedMeshIds;
+    for (const auto& node : doc.nodes.Elements())
+    {
+        if (!node.skinId.empty())
+        {
+            skinnedMeshIds.insert(node.meshId);
+        }
+    }
+
+    std::unordered_map<std::string, PositionTransform> positionTransforms;
+    for (const auto& mesh : doc.meshes.Elements())
+    {
+        if (options.PositionMaxError <= 0.0f || mesh.primitives.empty() || skinnedMeshIds.count(mesh.id) > 0)
+        {
+            continue;
+        }
+
+        auto componentType = SelectComponentType(options.PositionMaxError, true, false);
+        bool canQuantize = componentType != COMPONENT_UNKNOWN;
+        for (const auto& primitive : mesh.primitives)
+        {
+            std::string positionAccessorId;
+            canQuantize = canQuantize &&
+                !primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>() &&
+                primitive.targets.empty() &&
+                !primitive.HasAttribute(ACCESSOR_JOINTS_0) &&
+                primitive.TryGetAttributeAccessorId(ACCESSOR_POSITION, positionAccessorId) &&
+                CanQuantize(doc, usages, positionAccessorId, { AttributeKind::Position, mesh.id }, TYPE_VEC3);
+        }
+
+        if (!canQuantize)
+        {
+            continue;
+        }
+
+        std::vector<std::vector<float>> positions;
+        std::vector<double> min(3, std::numeric_limits<double>::max());
+        std::vector<double> max(3, std::numeric_limits<double>::lowest());
+        for (const auto& primitive : mesh.primitives)
+        {
+            positions.push_back(reader.ReadBinaryData<float>(doc, doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION))));
+            for (size_t i = 0; i < positions.back().size(); i++)
+            {
+                min[i % 3] = std::min(min[i % 3], static_cast<double>(positions.back()[i]));
+                max[i % 3] = std::max(max[i % 3], static_cast<double>(positions.back()[i]));
+            }
+        }
+
+        // A uniform scale keeps normals valid without renormalization
+        PositionTransform transform;
+        transform.scale = 0.0;
+        for (size_t i = 0; i < 3; i++)
+        {
+            transform.center[i] = (min[i] + max[i]) / 2.0;
+            transform.scale = std::max(transform.scale, (max[i] - min[i]) / 2.0);
+        }
+        if (transform.scale <= 0.0)
+        {
+            transform.scale = 1.0;
+        }
+
+        std::vector<double> offset(transform.center, transform.center + 3);
+        std::vector<double> scale(3, transform.scale);
+        for (size_t i = 0; i < mesh.primitives.size(); i++)
+        {
+            const auto& accessor = doc.accessors.Get(mesh.primitives[i].GetAttributeAccessorId(ACCESSOR_POSITION));
+            if (resultDocument.accessors.Get(accessor.id).componentType == COMPONENT_FLOAT)
+            {
+                QuantizeAccessor(resultDocument, builder, accessor, componentType, positions[i], offset, scale, replacedBufferViewIds);
+            }
+        }
+
+        positionTransforms.emplace(mesh.id, transform);
+    }
+
+    // Fold the position transforms into the nodes. Nodes whose transform is also seen by other nodes (their children and
+    // the meshes skinned to them) or changed by animations get a new child node holding the mesh instead.
+    if (!positionTransforms.empty())
+    {
+        std::unordered_set<std::string> sharedTransformNodeIds;
+        for (const auto& animation : doc.animations.Elements())
+        {
+            for (const auto& channel : animation.channels.Elements())
+            {
+                sharedTransformNodeIds.insert(channel.target.nodeId);
+            }
+        }
+        for (const auto& skin : doc.skins.Elements())
+        {
+            sharedTransformNodeIds.insert(skin.jointIds.begin(), skin.jointIds.end());
+        }
+
+        size_t nextNodeId = doc.nodes.Size();
+        for (const auto& originalNode : doc.nodes.Elements())
+        {
+            auto it = positionTransforms.find(originalNode.meshId);
+            if (it == positionTransforms.end())
+            {
+                continue;
+            }
+
+            Node node(originalNode);
+            if (node.children.empty() && node.cameraId.empty() && sharedTransformNodeIds.count(node.id) == 0)
+            {
+                FoldPositionTransform(node, it->second);
+            }
+            else
+            {
+                while (resultDocument.nodes.Has(std::to_string(nextNodeId)))
+                {
+                    nextNodeId++;
+                }
+
+                Node meshNode;
+                meshNode.id = std::to_string(nextNodeId);
+                meshNode.meshId = node.meshId;
+                FoldPositionTransform(meshNode, it->second);
+                resultDocument.nodes.Append(std::move(meshNode));
+
+                node.meshId.clear();
+                node.children.push_back(std::to_string(nextNodeId));
+            }
+
+            resultDocument.nodes.Replace(node);
+        }
+    }
+
+    // Normals, tangents and colors don't need a transform: they already lie within the range of normalized integers
+    for (const auto& accessor : doc.accessors.Elements())
+    {
+        std::vector<double> offset(4, 0.0);
+        std::vector<double> scale(4, 1.0);
+
+        if (options.NormalMaxError > 0.0f &&
+            (CanQuantize(doc, usages, accessor.id, { AttributeKind::Normal, "" }, TYPE_VEC3) ||
+             CanQuantize(doc, usages, accessor.id, { AttributeKind::Tangent, "" }, TYPE_VEC4)))
+        {
+            auto componentType = SelectComponentType(options.NormalMaxError, true, true);
+            if (componentType != COMPONENT_UNKNOWN)
+            {
+                QuantizeAccessor(resultDocument, builder, accessor, componentType, reader.ReadBinaryData<float>(doc, accessor), offset, scale, replacedBufferViewIds);
+            }
+        }
+        else if (options.ColorMaxError > 0.0f &&
+                 (CanQuantize(doc, usages, accessor.id, { AttributeKind::Color, "" }, TYPE_VEC3) ||
+                  CanQuantize(doc, usages, accessor.id, { AttributeKind::Color, "" }, TYPE_VEC4)))
+        {
+            auto componentType = SelectComponentType(options.ColorMaxError, false, true);
+            auto colors = reader.ReadBinaryData<float>(doc, accessor);
+
+            // HDR colors would be clamped
+            bool inRange = std::all_of(colors.begin(), colors.end(), [](float value) { return value >= 0.0f && value <= 1.0f; });
+            if (componentType != COMPONENT_UNKNOWN && inRange)
+            {
+                QuantizeAccessor(resultDocument, builder, accessor, componentType, colors, offset, scale, replacedBufferViewIds);
+            }
+        }
+    }
+
+    // Texture coordinates: one transform per material and texture coordinate set, since the transform is stored in the material's textures
+    std::map<std::pair<std::string, size_t>, std::vector<std::string>> texCoordGroups;
+    for (const auto& mesh : doc.meshes.Elements())
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            for (const auto& attribute : primitive.attributes)
+            {
+                if (StartsWith(attribute.first, TEXCOORD_PREFIX))
+                {
+                    auto texCoord = std::stoul(attribute.first.substr(strlen(TEXCOORD_PREFIX)));
+                    auto& accessorIds = texCoordGroups[{ primitive.materialId, texCoord }];
+                    if (std::find(accessorIds.begin(), accessorIds.end(), attribute.second) == accessorIds.end())
+                    {
+                        accessorIds.push_back(attribute.second);
+                    }
+                }
+            }
+        }
+    }
+
+    auto texCoordComponentType = SelectComponentType(options.TexCoordMaxError, false, false);
+    for (const auto& group : texCoordGroups)
+    {
+        const auto& materialId = group.first.first;
+        auto texCoord = group.first.second;
+
+        // Texture coordinates that no texture reads are left alone
+        if (options.TexCoordMaxError <= 0.0f || texCoordComponentType == COMPONENT_UNKNOWN ||
+            materialId.empty() || !doc.materials.Has(materialId) || !UsesTexCoord(doc.materials.Get(materialId), texCoord))
+        {
+            continue;
+        }
+
+        bool canQuantize = std::all_of(group.second.begin(), group.second.end(), [&](const std::string& accessorId)
+        {
+            return CanQuantize(doc, usages, accessorId, { AttributeKind::TexCoord, TexCoordGroup(materialId, texCoord) }, TYPE_VEC2);
+        });
+        if (!canQuantize)
+        {
+            continue;
+        }
+
+        std::vector<std::vector<float>> texCoords;
+        std::vector<double> min(2, std::numeric_limits<double>::max());
+        std::vector<double> max(2, std::numeric_limits<double>::lowest());
+        for (const auto& accessorId : group.second)
+        {
+            texCoords.push_back(reader.ReadBinaryData<float>(doc, doc.accessors.Get(accessorId)));
+            for (size_t i = 0; i < texCoords.back().size(); i++)
+            {
+                min[i % 2] = std::min(min[i % 2], static_cast<double>(texCoords.back()[i]));
+                max[i % 2] = std::max(max[i % 2], static_cast<double>(texCoords.back()[i]));
+            }
+        }
+
+        std::vector<double> range(2);
+        for (size_t i = 0; i < 2; i++)
+        {
+            range[i] = max[i] > min[i] ? max[i] - min[i] : 1.0;
+        }
+
+        for (size_t i = 0; i < group.second.size(); i++)
+        {
+            QuantizeAccessor(resultDocument, builder, doc.accessors.Get(group.second[i]), texCoordComponentType, texCoords[i], min, range, replacedBufferViewIds);
+        }
+
+        Material material(resultDocument.materials.Get(materialId));
+        for (auto textureInfo : GetTextureInfos(material))
+        {
+            FoldTexCoordTransform(*textureInfo, texCoord, min, range);
+        }
+        resultDocument.materials.Replace(material);
+        quantizedTexCoords = true;
+    }
+
+    if (replacedBufferViewIds.empty())
+    {
+        return resultDocument;
+    }
+
+    // Remove the bufferViews that only held the original attributes
+    for (const auto& accessor : resultDocument.accessors.Elements())
+    {
+        replacedBufferViewIds.erase(accessor.bufferViewId);
+        if (accessor.sparse.count > 0)
+        {
+            replacedBufferViewIds.erase(accessor.sparse.indicesBufferViewId);
+            replacedBufferViewIds.erase(accessor.sparse.valuesBufferViewId);
+        }
+    }
+    for (const auto& image : resultDocument.images.Elements())
+    {
+        replacedBufferViewIds.erase(image.bufferViewId);
+    }
+    for (const auto& bufferViewId : replacedBufferViewIds)
+    {
+        if (resultDocument.bufferViews.Has(bufferViewId))
+        {
+            resultDocument.bufferViews.Remove(bufferViewId);
+        }
+    }
+
+    builder.Output(resultDocument);
+
+    resultDocument.extensionsUsed.emplace(EXTENSION_KHR_MESH_QUANTIZATION);
+    resultDocument.extensionsRequired.emplace(EXTENSION_KHR_MESH_QUANTIZATION);
+
+    if (quantizedTexCoords)
+    {
+        resultDocument.extensionsUsed.emplace(KHR::TextureInfos::TEXTURETRANSFORM_NAME);
+        resultDocument.extensionsRequired.emplace(KHR::TextureInfos::TEXTURETRANSFORM_NAME);
+    }
+
+    return resultDocument;
+}
+
+AccessorConversionStrategy GLTFMeshQuantizationUtils::PreserveQuantizedAccessors(const AccessorConversionStrategy& accessorConversion)
+{
+    return [accessorConversion](const Accessor& accessor)
+    {
+        bool isVector = accessor.type == TYPE_VEC2 || accessor.type == TYPE_VEC3 || accessor.type == TYPE_VEC4;
+        bool isQuantized = accessor.normalized && accessor.componentType != COMPONENT_FLOAT && accessor.componentType != COMPONENT_UNSIGNED_INT;
+        if ((isVector && isQuantized) || accessorConversion == nullptr)
+        {
+            return accessor.componentType;
+        }
+
+        return accessorConversion(accessor);
+    };
+}
@@ -0,0 +1,986 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "GLTFMeshSimplificationUtils.h"
+#include "BufferBuilderUtils.h"
+#include "GLTFMeshIndexUtils.h"
+#include "AccessorUtils.h"
+#include "MeshoptCodec.h"
+
+#include "GLTFSDK/BufferBuilder.h"
+#include "GLTFSDK/ExtensionsKHR.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    // Mesh borders and attribute seams weigh more than the surface, so that collapses don't pull them inwards
+    const double BORDER_WEIGHT = 10.0;
+
+    // Collapses that would turn a remaining triangle by more than about 75 degrees are rejected, so that the surface doesn't fold
+    const double MIN_NORMAL_COSINE = 0.25;
+
+    const uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+    typedef std::array<double, 3> Point;
+
+    Point Subtract(const Point& a, const Point& b)
+    {
+        return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    }
+
+    Point Cross(const Point& a, const Point& b)
+    {
+        return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+    }
+
+    double Dot(const Point& a, const Point& b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    double Length(const Point& a)
+    {
+        return std::sqrt(Dot(a, a));
+    }
+
+    // The sum of the weighted squared distances to a set of planes: a symmetric matrix A, a vector b and a constant c,
+    // such that the sum for a point p is p'Ap + 2b'p + c
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        // Adds the plane n.p + d = 0, where n is a unit vector
+        void AddPlane(const Point& n, double d, double planeWeight)
+        {
+            a00 += planeWeight * n[0] * n[0];
+            a11 += planeWeight * n[1] * n[1];
+            a22 += planeWeight * n[2] * n[2];
+            a10 += planeWeight * n[1] * n[0];
+            a20 += planeWeight * n[2] * n[0];
+            a21 += planeWeight * n[2] * n[1];
+            b0 += planeWeight * n[0] * d;
+            b1 += planeWeight * n[1] * d;
+            b2 += planeWeight * n[2] * d;
+            c += planeWeight * d * d;
+            weight += planeWeight;
+        }
+
+        void Add(const Quadric& other)
+        {
+            a00 += other.a00; a11 += other.a11; a22 += other.a22;
+            a10 += other.a10; a20 += other.a20; a21 += other.a21;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        // The weighted mean of the squared distances to the planes
+        double Error(const Point& p) const
+        {
+            if (weight <= 0)
+            {
+                return 0;
+            }
+
+            double rx = a00 * p[0] + a10 * p[1] + a20 * p[2] + 2 * b0;
+            double ry = a10 * p[0] + a11 * p[1] + a21 * p[2] + 2 * b1;
+            double rz = a20 * p[0] + a21 * p[1] + a22 * p[2] + 2 * b2;
+            return std::max(0.0, (rx * p[0] + ry * p[1] + rz * p[2] + c) / weight);
+        }
+    };
+
+    // How a vertex may collapse: manifold vertices onto any neighbor, border and seam vertices only along their
+    // border or seam, and locked vertices (e.g. where borders and seams meet) not at all, although others may collapse onto them
+    enum class VertexKind
+    {
+        Manifold,
+        Border,
+        Seam,
+        Locked
+    };
+
+    struct Collapse
+    {
+        uint32_t From;
+        uint32_t To;
+        double Error;
+    };
+
+    // Whether the data of an accessor can be read and replaced
+    bool IsPlainAccessor(const Document& doc, const Accessor& accessor)
+    {
+        return !accessor.bufferViewId.empty() && accessor.sparse.count == 0 &&
+            doc.bufferViews.Get(accessor.bufferViewId).extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) == 0;
+    }
+
+    // The accessors that hold the vertices of a primitive, and whether each one needs min and max values
+    std::vector<std::pair<std::string, bool>> GetVertexAccessorIds(const MeshPrimitive& primitive)
+    {
+        std::vector<std::pair<std::string, bool>> accessorIds;
+        for (const auto& attribute : primitive.attributes)
+        {
+            accessorIds.emplace_back(attribute.second, attribute.first == ACCESSOR_POSITION);
+        }
+
+        for (const auto& target : primitive.targets)
+        {
+            if (!target.positionsAccessorId.empty())
+            {
+                accessorIds.emplace_back(target.positionsAccessorId, true);
+            }
+            if (!target.normalsAccessorId.empty())
+            {
+                accessorIds.emplace_back(target.normalsAccessorId, false);
+            }
+            if (!target.tangentsAccessorId.empty())
+            {
+                accessorIds.emplace_back(target.tangentsAccessorId, false);
+            }
+        }
+
+        return accessorIds;
+    }
+
+    std::vector<uint32_t> ReadIndices(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        switch (accessor.componentType)
+        {
+        case COMPONENT_UNSIGNED_BYTE:
+        {
+            auto indices = reader.ReadBinaryData<uint8_t>(doc, accessor);
+            return std::vector<uint32_t>(indices.begin(), indices.end());
+        }
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            auto indices = reader.ReadBinaryData<uint16_t>(doc, accessor);
+            return std::vector<uint32_t>(indices.begin(), indices.end());
+        }
+        case COMPONENT_UNSIGNED_INT:
+            return reader.ReadBinaryData<uint32_t>(doc, accessor);
+        default:
+            throw GLTFException("Invalid index component type.");
+        }
+    }
+
+    // Writes indices to a new bufferView, in 16 bits when every vertex can be addressed with them,
+    // and returns an index accessor based on the original one that points to it
+    Accessor AddIndices(BufferBuilder& builder, const Accessor& accessor, const std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        Accessor indexAccessor(accessor);
+        if (vertexCount <= MAX_16BIT_INDEX_VERTEX_COUNT)
+        {
+            std::vector<uint16_t> values(indices.begin(), indices.end());
+            indexAccessor.bufferViewId = builder.AddBufferView(values.data(), values.size() * sizeof(uint16_t), {}, BufferViewTarget::ELEMENT_ARRAY_BUFFER).id;
+            indexAccessor.componentType = COMPONENT_UNSIGNED_SHORT;
+        }
+        else
+        {
+            indexAccessor.bufferViewId = builder.AddBufferView(indices.data(), indices.size() * sizeof(uint32_t), {}, BufferViewTarget::ELEMENT_ARRAY_BUFFER).id;
+            indexAccessor.componentType = COMPONENT_UNSIGNED_INT;
+        }
+        indexAccessor.byteOffset = 0;
+        indexAccessor.count = indices.size();
+        if (!accessor.min.empty() && !indices.empty())
+        {
+            auto minmax = std::minmax_element(indices.begin(), indices.end());
+            indexAccessor.min = { static_cast<float>(*minmax.first) };
+            indexAccessor.max = { static_cast<float>(*minmax.second) };
+        }
+
+        return indexAccessor;
+    }
+
+    template<typename T>
+    std::vector<uint8_t> ReadVertices(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        auto values = reader.ReadBinaryData<T>(doc, accessor);
+        std::vector<uint8_t> bytes(values.size() * sizeof(T));
+        memcpy(bytes.data(), values.data(), bytes.size());
+        return bytes;
+    }
+
+    // Reads the elements of a vertex accessor, tightly packed
+    std::vector<uint8_t> ReadVertices(const GLTFResourceReader& reader, const Document& doc, const Accessor& accessor)
+    {
+        switch (accessor.componentType)
+        {
+        case COMPONENT_BYTE:           return ReadVertices<int8_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_BYTE:  return ReadVertices<uint8_t>(reader, doc, accessor);
+        case COMPONENT_SHORT:          return ReadVertices<int16_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_SHORT: return ReadVertices<uint16_t>(reader, doc, accessor);
+        case COMPONENT_UNSIGNED_INT:   return ReadVertices<uint32_t>(reader, doc, accessor);
+        case COMPONENT_FLOAT:          return ReadVertices<float>(reader, doc, accessor);
+        default: throw GLTFException("Unknown component type.");
+        }
+    }
+
+    // The accessors that are still used by the meshes, skins and animations of a document
+    std::unordered_set<std::string> GetUsedAccessorIds(const Document& doc)
+    {
+        std::unordered_set<std::string> accessorIds;
+        for (const auto& mesh : doc.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                accessorIds.insert(primitive.indicesAccessorId);
+                for (const auto& accessorId : GetVertexAccessorIds(primitive))
+                {
+                    accessorIds.insert(accessorId.first);
+                }
+            }
+        }
+
+        for (const auto& skin : doc.skins.Elements())
+        {
+            accessorIds.insert(skin.inverseBindMatricesAccessorId);
+        }
+
+        for (const auto& animation : doc.animations.Elements())
+        {
+            for (const auto& sampler : animation.samplers.Elements())
+            {
+                accessorIds.insert(sampler.inputAccessorId);
+                accessorIds.insert(sampler.outputAccessorId);
+            }
+        }
+
+        return accessorIds;
+    }
+
+
+    // Whether a primitive can be simplified: an indexed triangle list with float positions, whose data can be read and replaced
+    bool CanSimplify(const Document& doc, const MeshPrimitive& primitive)
+    {
+        if (primitive.mode != MESH_TRIANGLES || primitive.indicesAccessorId.empty() ||
+            primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>() || !primitive.HasAttribute(ACCESSOR_POSITION))
+        {
+            return false;
+        }
+
+        const auto& positionAccessor = doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+        if (positionAccessor.componentType != COMPONENT_FLOAT || positionAccessor.type != TYPE_VEC3)
+        {
+            return false;
+        }
+
+        auto vertexAccessorIds = GetVertexAccessorIds(primitive);
+        return IsPlainAccessor(doc, doc.accessors.Get(primitive.indicesAccessorId)) &&
+            std::all_of(vertexAccessorIds.begin(), vertexAccessorIds.end(), [&doc](const std::pair<std::string, bool>& accessorId)
+            {
+                return IsPlainAccessor(doc, doc.accessors.Get(accessorId.first));
+            });
+    }
+}
+
+Document GLTFMeshSimplificationUtils::SimplifyMeshes(
+    std::shared_ptr<IStreamReader> streamReader,
+    const Document& doc,
+    const SimplificationOptions& options,
+    const std::string& outputDirectory,
+    SimplificationStatistics* statistics)
+{
+    if (options.TargetRatio <= 0.0f || options.TargetRatio > 1.0f)
+    {
+        throw std::invalid_argument("The target ratio must be greater than 0 and at most 1.");
+    }
+
+    Document resultDocument(doc);
+    GLTFResourceReader reader(streamReader);
+
+    auto writer = std::make_unique<GLTFResourceWriter>(std::make_shared<BufferFileStreamWriter>());
+    writer->SetUriPrefix((std::experimental::filesystem::u8path(outputDirectory) / "Simplification").u8string());
+    BufferBuilder builder(std::move(writer), BufferBuilderUtils::UnusedIdGenerator(doc.buffers), BufferBuilderUtils::UnusedIdGenerator(doc.bufferViews), BufferBuilderUtils::UnusedIdGenerator(doc.accessors));
+    builder.AddBuffer();
+
+    // The accessors of the simplified primitives are added to the result document directly, so that they keep the order of the primitives
+    auto GenerateAccessorId = BufferBuilderUtils::UnusedIdGenerator(resultDocument.accessors);
+
+    // The triangle budget is shared between the primitives in proportion to their triangle count
+    float ratio = options.TargetRatio;
+    if (options.TriangleBudget > 0)
+    {
+        size_t triangleCount = 0;
+        for (const auto& mesh : doc.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                if (CanSimplify(doc, primitive))
+                {
+                    triangleCount += doc.accessors.Get(primitive.indicesAccessorId).count / 3;
+                }
+            }
+        }
+
+        if (triangleCount > 0)
+        {
+            ratio = std::min(ratio, static_cast<float>(options.TriangleBudget) / triangleCount);
+        }
+    }
+
+    SimplificationStatistics simplificationStatistics;
+
+    // Accessors are often shared between the primitives of a mesh, so each one is only read once
+    std::map<std::string, std::vector<uint32_t>> indices;
+    std::map<std::string, std::vector<uint8_t>> vertices;
+
+    std::unordered_set<std::string> replacedAccessorIds;
+    std::unordered_set<std::string> replacedBufferViewIds;
+    for (const auto& mesh : doc.meshes.Elements())
+    {
+        Mesh resultMesh(mesh);
+
+        for (auto& primitive : resultMesh.primitives)
+        {
+            if (!CanSimplify(doc, primitive))
+            {
+                continue;
+            }
+
+            auto vertexAccessorIds = GetVertexAccessorIds(primitive);
+            for (const auto& accessorId : vertexAccessorIds)
+            {
+                if (vertices.count(accessorId.first) == 0)
+                {
+                    vertices.emplace(accessorId.first, ReadVertices(reader, doc, doc.accessors.Get(accessorId.first)));
+                }
+            }
+
+            const auto& indexAccessor = doc.accessors.Get(primitive.indicesAccessorId);
+            if (indices.count(indexAccessor.id) == 0)
+            {
+                indices.emplace(indexAccessor.id, ReadIndices(reader, doc, indexAccessor));
+            }
+            const auto& primitiveIndices = indices[indexAccessor.id];
+
+            const auto& positionAccessor = doc.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+            const auto& positionBytes = vertices[positionAccessor.id];
+            auto positionData = reinterpret_cast<const float*>(positionBytes.data());
+            std::vector<float> positions(positionData, positionData + positionAccessor.count * 3);
+
+            // The normals and first texture coordinates, when they are floats, are interleaved and compared when collapsing edges
+            std::vector<std::pair<const float*, size_t>> attributeSources;
+            std::vector<float> attributeWeights;
+            auto AddAttribute = [&](const char* name, AccessorType type, float weight)
+            {
+                if (primitive.HasAttribute(name) && weight > 0.0f)
+                {
+                    const auto& accessor = doc.accessors.Get(primitive.GetAttributeAccessorId(name));
+                    if (accessor.componentType == COMPONENT_FLOAT && accessor.type == type && accessor.count == positionAccessor.count)
+                    {
+                        auto typeCount = Accessor::GetTypeCount(type);
+                        attributeSources.emplace_back(reinterpret_cast<const float*>(vertices[accessor.id].data()), typeCount);
+                        attributeWeights.insert(attributeWeights.end(), typeCount, weight);
+                    }
+                }
+            };
+            AddAttribute(ACCESSOR_NORMAL, TYPE_VEC3, options.NormalWeight);
+            AddAttribute(ACCESSOR_TEXCOORD_0, TYPE_VEC2, options.TexCoordWeight);
+
+            std::vector<float> attributes;
+            attributes.reserve(positionAccessor.count * attributeWeights.size());
+            for (size_t i = 0; i < positionAccessor.count; i++)
+            {
+                for (const auto& source : attributeSources)
+                {
+                    attributes.insert(attributes.end(), source.first + i * source.second, source.first + (i + 1) * source.second);
+                }
+            }
+
+            auto triangleCount = primitiveIndices.size() / 3;
+            auto targetTriangleCount = std::max<size_t>(1, static_cast<size_t>(std::ceil(triangleCount * ratio)));
+
+            float error = 0.0f;
+            auto simplifiedIndices = SimplifyIndices(primitiveIndices, positions, attributes, attributeWeights, targetTriangleCount * 3, options.TargetError, &error);
+
+            // A primitive that collapses entirely keeps its original triangles, since glTF doesn't allow empty primitives
+            if (simplifiedIndices.empty())
+            {
+                simplifiedIndices = primitiveIndices;
+            }
+
+            simplificationStatistics.TrianglesBefore += triangleCount;
+            simplificationStatistics.TrianglesAfter += simplifiedIndices.size() / 3;
+            simplificationStatistics.MaxError = std::max(simplificationStatistics.MaxError, error);
+
+            // The simplified primitive only keeps the vertices it uses, numbered in the order of first use
+            auto split = GLTFMeshIndexUtils::SplitIndices(simplifiedIndices, 3, std::numeric_limits<size_t>::max()).front();
+
+            auto simplifiedIndexAccessor = AddIndices(builder, indexAccessor, split.Indices, split.Vertices.size());
+            simplifiedIndexAccessor.id = GenerateAccessorId(builder);
+            primitive.indicesAccessorId = resultDocument.accessors.Append(std::move(simplifiedIndexAccessor)).id;
+
+            auto CopyAccessor = [&](std::string& accessorId, bool calculateMinMax)
+            {
+                const auto& accessor = doc.accessors.Get(accessorId);
+                auto simplifiedAccessor = BufferBuilderUtils::CopyVertices(builder, accessor, vertices[accessor.id], split.Vertices, calculateMinMax);
+                simplifiedAccessor.id = GenerateAccessorId(builder);
+                accessorId = resultDocument.accessors.Append(std::move(simplifiedAccessor)).id;
+            };
+
+            for (auto& attribute : primitive.attributes)
+            {
+                CopyAccessor(attribute.second, attribute.first == ACCESSOR_POSITION);
+            }
+
+            for (auto& target : primitive.targets)
+            {
+                if (!target.positionsAccessorId.empty())
+                {
+                    CopyAccessor(target.positionsAccessorId, true);
+                }
+                if (!target.normalsAccessorId.empty())
+                {
+                    CopyAccessor(target.normalsAccessorId, false);
+                }
+                if (!target.tangentsAccessorId.empty())
+                {
+                    CopyAccessor(target.tangentsAccessorId, false);
+                }
+            }
+
+            replacedAccessorIds.insert(indexAccessor.id);
+            for (const auto& accessorId : vertexAccessorIds)
+            {
+                replacedAccessorIds.insert(accessorId.first);
+            }
+        }
+
+        resultDocument.meshes.Replace(resultMesh);
+    }
+
+    if (statistics != nullptr)
+    {
+        *statistics = simplificationStatistics;
+    }
+
+    if (replacedAccessorIds.empty())
+    {
+        return doc;
+    }
+
+    // Remove the accessors of the original primitives that nothing else uses
+    auto usedAccessorIds = GetUsedAccessorIds(resultDocument);
+    for (const auto& accessorId : replacedAccessorIds)
+    {
+        if (usedAccessorIds.count(accessorId) == 0 && resultDocument.accessors.Has(accessorId))
+        {
+            replacedBufferViewIds.insert(resultDocument.accessors.Get(accessorId).bufferViewId);
+            resultDocument.accessors.Remove(accessorId);
+        }
+    }
+
+    // Remove the bufferViews that only held the original data
+    for (const auto& accessor : resultDocument.accessors.Elements())
+    {
+        replacedBufferViewIds.erase(accessor.bufferViewId);
+        if (accessor.sparse.count > 0)
+        {
+            replacedBufferViewIds.erase(accessor.sparse.indicesBufferViewId);
+            replacedBufferViewIds.erase(accessor.sparse.valuesBufferViewId);
+        }
+    }
+    for (const auto& image : resultDocument.images.Elements())
+    {
+        replacedBufferViewIds.erase(image.bufferViewId);
+    }
+    for (const auto& mesh : resultDocument.meshes.Elements())
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.HasExtension<KHR::MeshPrimitives::DracoMeshCompression>())
+            {
+                replacedBufferViewIds.erase(primitive.GetExtension<KHR::MeshPrimitives::DracoMeshCompression>().bufferViewId);
+            }
+        }
+    }
+    for (const auto& bufferViewId : replacedBufferViewIds)
+    {
+        if (resultDocument.bufferViews.Has(bufferViewId))
+        {
+            resultDocument.bufferViews.Remove(bufferViewId);
+        }
+    }
+
+    builder.Output(resultDocument);
+
+    return resultDocument;
+}
+
+std::vector<Document> GLTFMeshSimplificationUtils::GenerateLODs(
+    std::shared_ptr<IStreamReader> streamReader,
+    const Document& doc,
+    const std::vector<SimplificationOptions>& levels,
+    const std::string& outputDirectory)
+{
+    // Every level is simplified from the original document, in its own directory so that the levels' buffers don't overwrite each other
+    std::vector<Document> lods;
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        auto lodDirectory = std::experimental::filesystem::u8path(outputDirectory) / ("lod" + std::to_string(i + 1));
+        std::experimental::filesystem::create_directories(lodDirectory);
+        lods.push_back(SimplifyMeshes(streamReader, doc, levels[i], lodDirectory.u8string()));
+    }
+
+    return lods;
+}
+
+std::vector<uint32_t> GLTFMeshSimplificationUtils::SimplifyIndices(
+    const std::vector<uint32_t>& indices,
+    const std::vector<float>& positions,
+    const std::vector<float>& attributes,
+    const std::vector<float>& attributeWeights,
+    size_t targetIndexCount,
+    float targetError,
+    float* resultError)
+{
+    if (indices.size() % 3 != 0)
+    {
+        throw std::invalid_argument("The number of indices must be a multiple of 3.");
+    }
+
+    if (positions.size() % 3 != 0)
+    {
+        throw std::invalid_argument("There must be three position components per vertex.");
+    }
+
+    const auto vertexCount = positions.size() / 3;
+    const auto attributeCount = attributeWeights.size();
+    if (attributes.size() != vertexCount * attributeCount)
+    {
+        throw std::invalid_argument("There must be one attribute component per attribute weight for each vertex.");
+    }
+
+    if (std::any_of(indices.begin(), indices.end(), [vertexCount](uint32_t index) { return index >= vertexCount; }))
+    {
+        throw std::invalid_argument("Index out of range of the vertices.");
+    }
+
+    if (resultError != nullptr)
+    {
+        *resultError = 0.0f;
+    }
+
+    // Positions are scaled to fit in a unit cube, so that errors are relative to the size of the mesh
+    Point minimum = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+    Point maximum = { std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
+    for (auto index : indices)
+    {
+        for (size_t j = 0; j < 3; j++)
+        {
+            minimum[j] = std::min(minimum[j], static_cast<double>(positions[index * 3 + j]));
+            maximum[j] = std::max(maximum[j], static_cast<double>(positions[index * 3 + j]));
+        }
+    }
+
+    double extent = indices.empty() ? 0 : std::max({ maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2] });
+    double scale = extent > 0 ? 1.0 / extent : 1.0;
+
+    std::vector<Point> points(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        for (size_t j = 0; j < 3; j++)
+        {
+            points[i][j] = indices.empty() ? 0 : (positions[i * 3 + j] - minimum[j]) * scale;
+        }
+    }
+
+    // Vertices that share a position (wedges, e.g. on both sides of a UV seam) are remapped to the first one,
+    // and linked in a circular list
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint32_t> wedges(vertexCount);
+    std::map<std::array<float, 3>, uint32_t> positionVertices;
+    for (uint32_t i = 0; i < vertexCount; i++)
+    {
+        remap[i] = positionVertices.emplace(std::array<float, 3>{ positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2] }, i).first->second;
+        wedges[i] = i;
+        if (remap[i] != i)
+        {
+            wedges[i] = wedges[remap[i]];
+            wedges[remap[i]] = i;
+        }
+    }
+
+    // Triangles with repeated positions have no area, and would hide the edges of the others
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    auto AppendTriangle = [&result, &remap](uint32_t a, uint32_t b, uint32_t c)
+    {
+        if (remap[a] != remap[b] && remap[b] != remap[c] && remap[c] != remap[a])
+        {
+            result.insert(result.end(), { a, b, c });
+        }
+    };
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        AppendTriangle(indices[i], indices[i + 1], indices[i + 2]);
+    }
+
+    if (result.size() <= targetIndexCount)
+    {
+        return result;
+    }
+
+    // The triangles that use each vertex
+    std::vector<uint32_t> triangleOffsets;
+    std::vector<uint32_t> vertexTriangles;
+    auto BuildAdjacency = [&]()
+    {
+        triangleOffsets.assign(vertexCount + 1, 0);
+        for (auto index : result)
+        {
+            triangleOffsets[index + 1]++;
+        }
+        std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+
+        std::vector<uint32_t> next(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        vertexTriangles.resize(result.size());
+        for (size_t i = 0; i < result.size(); i++)
+        {
+            vertexTriangles[next[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    };
+
+    auto HasEdge = [&](uint32_t a, uint32_t b)
+    {
+        for (auto k = triangleOffsets[a]; k < triangleOffsets[a + 1]; k++)
+        {
+            auto triangle = &result[vertexTriangles[k] * 3];
+            for (size_t j = 0; j < 3; j++)
+            {
+                if (triangle[j] == a && triangle[(j + 1) % 3] == b)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    BuildAdjacency();
+
+    // Open edges have no opposite half-edge: each vertex can have one outgoing and one incoming open edge,
+    // which are linked as they collapse; a vertex with more of them is its own open neighbor, and gets locked
+    std::vector<uint32_t> openOut(vertexCount, NO_VERTEX);
+    std::vector<uint32_t> openIn(vertexCount, NO_VERTEX);
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        auto a = result[i];
+        auto b = result[i % 3 == 2 ? i - 2 : i + 1];
+        if (!HasEdge(b, a))
+        {
+            openOut[a] = openOut[a] == NO_VERTEX ? b : a;
+            openIn[b] = openIn[b] == NO_VERTEX ? a : b;
+        }
+    }
+
+    auto HasOneOpenEdgePair = [&](uint32_t v)
+    {
+        return openOut[v] != NO_VERTEX && openOut[v] != v && openIn[v] != NO_VERTEX && openIn[v] != v;
+    };
+
+    std::vector<VertexKind> kinds(vertexCount, VertexKind::Manifold);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        if (remap[v] != v)
+        {
+            continue;
+        }
+
+        auto w = wedges[v];
+        if (w == v)
+        {
+            if (openOut[v] != NO_VERTEX || openIn[v] != NO_VERTEX)
+            {
+                kinds[v] = HasOneOpenEdgePair(v) ? VertexKind::Border : VertexKind::Locked;
+            }
+        }
+        else
+        {
+            // Two wedges whose open edges are the two sides of the same edges lie on a seam; anything else is locked
+            bool isSeam = wedges[w] == v && HasOneOpenEdgePair(v) && HasOneOpenEdgePair(w) &&
+                remap[openOut[v]] == remap[openIn[w]] && remap[openIn[v]] == remap[openOut[w]];
+
+            auto wedge = v;
+            do
+            {
+                kinds[wedge] = isSeam ? VertexKind::Seam : VertexKind::Locked;
+                wedge = wedges[wedge];
+            } while (wedge != v);
+        }
+    }
+
+    // Each position accumulates the planes of its triangles, weighted by their area, and the planes
+    // through its open edges perpendicular to their triangles, so that borders and seams keep their shape
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const auto& p0 = points[result[i]];
+        const auto& p1 = points[result[i + 1]];
+        const auto& p2 = points[result[i + 2]];
+
+        auto normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+        auto area = Length(normal);
+        if (area <= 0)
+        {
+            continue;
+        }
+        normal = { normal[0] / area, normal[1] / area, normal[2] / area };
+
+        for (size_t j = 0; j < 3; j++)
+        {
+            quadrics[remap[result[i + j]]].AddPlane(normal, -Dot(normal, p0), area);
+        }
+
+        for (size_t j = 0; j < 3; j++)
+        {
+            auto a = result[i + j];
+            auto b = result[i + (j + 1) % 3];
+            if (HasEdge(b, a))
+            {
+                continue;
+            }
+
+            auto edge = Subtract(points[b], points[a]);
+            auto length = Length(edge);
+            auto edgeNormal = Cross(edge, normal);
+            auto edgeNormalLength = Length(edgeNormal);
+            if (edgeNormalLength <= 0)
+            {
+                continue;
+            }
+            edgeNormal = { edgeNormal[0] / edgeNormalLength, edgeNormal[1] / edgeNormalLength, edgeNormal[2] / edgeNormalLength };
+
+            auto d = -Dot(edgeNormal, points[a]);
+            quadrics[remap[a]].AddPlane(edgeNormal, d, length * length * BORDER_WEIGHT);
+            quadrics[remap[b]].AddPlane(edgeNormal, d, length * length * BORDER_WEIGHT);
+        }
+    }
+
+    auto AttributeError = [&](uint32_t a, uint32_t b)
+    {
+        double error = 0;
+        for (size_t k = 0; k < attributeCount; k++)
+        {
+            double difference = attributes[a * attributeCount + k] - attributes[b * attributeCount + k];
+            error += attributeWeights[k] * difference * difference;
+        }
+        return error;
+    };
+
+    // The vertex onto which the other wedge of a seam vertex collapses: the wedge of the target that is its open neighbor
+    auto SeamTarget = [&](uint32_t from, uint32_t to)
+    {
+        auto fromWedge = wedges[from];
+        if (openOut[fromWedge] != NO_VERTEX && remap[openOut[fromWedge]] == remap[to])
+        {
+            return openOut[fromWedge];
+        }
+        if (openIn[fromWedge] != NO_VERTEX && remap[openIn[fromWedge]] == remap[to])
+        {
+            return openIn[fromWedge];
+        }
+        return NO_VERTEX;
+    };
+
+    auto CanCollapse = [&](uint32_t from, uint32_t to)
+    {
+        if (remap[from] == remap[to])
+        {
+            return false;
+        }
+
+        switch (kinds[from])
+        {
+        case VertexKind::Manifold:
+            return true;
+        case VertexKind::Border:
+            return (kinds[to] == VertexKind::Border || kinds[to] == VertexKind::Locked) && (openOut[from] == to || openIn[from] == to);
+        case VertexKind::Seam:
+            return (kinds[to] == VertexKind::Seam || kinds[to] == VertexKind::Locked) && (openOut[from] == to || openIn[from] == to) &&
+                SeamTarget(from, to) != NO_VERTEX;
+        default:
+            return false;
+        }
+    };
+
+    auto CollapseError = [&](uint32_t from, uint32_t to)
+    {
+        auto error = quadrics[remap[from]].Error(points[to]) + AttributeError(from, to);
+        if (kinds[from] == VertexKind::Seam)
+        {
+            error += AttributeError(wedges[from], SeamTarget(from, to));
+        }
+        return error;
+    };
+
+    // Whether moving a vertex onto another would turn one of its remaining triangles too much
+    auto Flips = [&](uint32_t from, uint32_t to)
+    {
+        for (auto k = triangleOffsets[from]; k < triangleOffsets[from + 1]; k++)
+        {
+            auto triangle = &result[vertexTriangles[k] * 3];
+            if (remap[triangle[0]] == remap[to] || remap[triangle[1]] == remap[to] || remap[triangle[2]] == remap[to])
+            {
+                continue;
+            }
+
+            auto j = triangle[0] == from ? 0 : (triangle[1] == from ? 1 : 2);
+            const auto& b = points[triangle[(j + 1) % 3]];
+            const auto& c = points[triangle[(j + 2) % 3]];
+
+            auto before = Cross(Subtract(b, points[from]), Subtract(c, points[from]));
+            auto after = Cross(Subtract(b, points[to]), Subtract(c, points[to]));
+            if (Dot(before, after) <= MIN_NORMAL_COSINE * Length(before) * Length(after))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // The number of triangles that a collapse removes
+    auto SharedTriangles = [&](uint32_t from, uint32_t to)
+    {
+        size_t count = 0;
+        for (auto k = triangleOffsets[from]; k < triangleOffsets[from + 1]; k++)
+        {
+            auto triangle = &result[vertexTriangles[k] * 3];
+            count += (triangle[0] == to || triangle[1] == to || triangle[2] == to) ? 1 : 0;
+        }
+        return count;
+    };
+
+    // The open edge links skip the collapsed vertex
+    auto Relink = [&](uint32_t from, uint32_t to)
+    {
+        if (openOut[from] == to)
+        {
+            openIn[to] = openIn[from];
+            openOut[openIn[from]] = to;
+        }
+        else if (openIn[from] == to)
+        {
+            openOut[to] = openOut[from];
+            openIn[openOut[from]] = to;
+        }
+    };
+
+    const double maxError = static_cast<double>(targetError) * targetError;
+    double collapsedError = 0;
+
+    // Every pass collapses the cheapest edges whose positions haven't moved yet in that pass, until the target is reached
+    // or until no collapse is within the target error
+    while (result.size() > targetIndexCount)
+    {
+        std::vector<Collapse> collapses;
+        for (size_t i = 0; i < result.size(); i++)
+        {
+            auto a = result[i];
+            auto b = result[i % 3 == 2 ? i - 2 : i + 1];
+
+            bool canCollapseAB = CanCollapse(a, b);
+            bool canCollapseBA = CanCollapse(b, a);
+            if (!canCollapseAB && !canCollapseBA)
+            {
+                continue;
+            }
+
+            auto errorAB = canCollapseAB ? CollapseError(a, b) : std::numeric_limits<double>::max();
+            auto errorBA = canCollapseBA ? CollapseError(b, a) : std::numeric_limits<double>::max();
+            collapses.push_back(errorAB <= errorBA ? Collapse{ a, b, errorAB } : Collapse{ b, a, errorBA });
+        }
+
+        if (collapses.empty())
+        {
+            break;
+        }
+
+        std::stable_sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.Error < b.Error; });
+
+        std::vector<uint32_t> collapseRemap(vertexCount);
+        std::iota(collapseRemap.begin(), collapseRemap.end(), 0);
+        std::vector<bool> moved(vertexCount, false);
+
+        auto triangleCount = result.size() / 3;
+        size_t removedCount = 0;
+        size_t collapseCount = 0;
+        for (const auto& collapse : collapses)
+        {
+            if (collapse.Error > maxError)
+            {
+                break;
+            }
+
+            auto from = collapse.From;
+            auto to = collapse.To;
+            if (moved[remap[from]] || moved[remap[to]])
+            {
+                continue;
+            }
+
+            bool isSeam = kinds[from] == VertexKind::Seam;
+            auto seamTarget = isSeam ? SeamTarget(from, to) : NO_VERTEX;
+            if (Flips(from, to) || (isSeam && Flips(wedges[from], seamTarget)))
+            {
+                continue;
+            }
+
+            removedCount += SharedTriangles(from, to);
+            collapseRemap[from] = to;
+            Relink(from, to);
+            if (isSeam)
+            {
+                removedCount += SharedTriangles(wedges[from], seamTarget);
+                collapseRemap[wedges[from]] = seamTarget;
+                Relink(wedges[from], seamTarget);
+            }
+
+            quadrics[remap[to]].Add(quadrics[remap[from]]);
+            moved[remap[from]] = true;
+            moved[remap[to]] = true;
+
+            collapsedError = std::max(collapsedError, collapse.Error);
+            collapseCount++;
+
+            if ((triangleCount - std::min(triangleCount, removedCount)) * 3 <= targetIndexCount)
+            {
+                break;
+            }
+        }
+
+        if (collapseCount == 0)
+        {
+            break;
+        }
+
+        auto previous = std::move(result);
+        result.clear();
+        for (size_t i = 0; i < previous.size(); i += 3)
+        {
+            AppendTriangle(collapseRemap[previous[i]], collapseRemap[previous[i + 1]], collapseRemap[previous[i + 2]]);
+        }
+
+        BuildAdjacency();
+    }
+
+    if (resultError != nullptr)
+    {
+        *resultError = static_cast<float>(std::sqrt(collapsedError));
+    }
+
+    return result;
+}
@@ -6,6 +6,7 @@
 #include "GLTFTextureUtils.h"
 #include "GLTFTexturePackingUtils.h"
 #include "GLTFTextureCompressionUtils.h"
+#include "GLTFLODUtils.h"
 #include "DeviceResources.h"
 
 // Usings for ComPtr
@@ -20,6 +21,125 @@ using namespace Microsoft::glTF::Toolkit;
 
 const char* Microsoft::glTF::Toolkit::EXTENSION_MSFT_TEXTURE_DDS = "MSFT_texture_dds";
 
+namespace
+{
+    std::string SaveDDS(const DirectX::Image* images, size_t imageCount, const DirectX::TexMetadata& metadata, const std::string& outputDirectory, const std::string& outputImagePath)
+    {
+        std::wstring outputImagePathW(outputImagePath.begin(), outputImagePath.end());
+
+        wchar_t outputImageFullPath[MAX_PATH];
+
+        std::wstring outputDirectoryW(outputDirectory.begin(), outputDirectory.end());
+
+        if (FAILED(::PathCchCombine(outputImageFullPath, ARRAYSIZE(outputImageFullPath), outputDirectoryW.c_str(), outputImagePathW.c_str())))
+        {
+            throw GLTFException("Failed to compose output file path.");
+        }
+
+        if (FAILED(SaveToDDSFile(images, imageCount, metadata, DirectX::DDS_FLAGS::DDS_FLAGS_NONE, outputImageFullPath)))
+        {
+            throw GLTFException("Failed to save image as DDS.");
+        }
+
+        std::wstring outputImageFullPathW(outputImageFullPath);
+        return std::string(outputImageFullPathW.begin(), outputImageFullPathW.end());
+    }
+
+    std::string SerializeExtensionMSFTTextureDDS(const Document& doc, const std::string& ddsImageId)
+    {
+        // Create the JSON for the DDS extension element
+        rapidjson::Document ddsExtensionJson;
+        ddsExtensionJson.SetObject();
+
+        ddsExtensionJson.AddMember("source", rapidjson::Value(doc.images.GetIndex(ddsImageId)), ddsExtensionJson.GetAllocator());
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        ddsExtensionJson.Accept(writer);
+
+        return buffer.GetString();
+    }
+
+    // Returns the IDs of the textures to use at each level of detail instead of the texture, appending the ones that sample the
+    // mip chain of its DDS image from a lower mip. Levels that can't be reduced reuse the texture of the previous level.
+    std::vector<std::string> AppendTextureLODs(const GLTFResourceReader& reader, Document& doc, const Texture& texture, const std::string& outputDirectory, size_t levelCount)
+    {
+        std::vector<std::string> lodIds(levelCount, texture.id);
+
+        auto ddsExtension = texture.extensions.find(EXTENSION_MSFT_TEXTURE_DDS);
+        if (ddsExtension == texture.extensions.end())
+        {
+            return lodIds;
+        }
+
+        rapidjson::Document ddsJson;
+        ddsJson.Parse(ddsExtension->second.c_str());
+        if (!ddsJson.IsObject() || !ddsJson.HasMember("source"))
+        {
+            return lodIds;
+        }
+
+        auto ddsImageId = std::to_string(ddsJson["source"].GetInt());
+        Image ddsImage(doc.images.Get(ddsImageId));
+
+        std::vector<uint8_t> imageData = reader.ReadBinaryData(doc, ddsImage);
+
+        DirectX::TexMetadata metadata;
+        DirectX::ScratchImage image;
+        if (FAILED(DirectX::LoadFromDDSMemory(imageData.data(), imageData.size(), DirectX::DDS_FLAGS_NONE, &metadata, image)))
+        {
+            throw GLTFException("Failed to load DDS image.");
+        }
+
+        if (metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1)
+        {
+            return lodIds;
+        }
+
+        for (size_t level = 1; level <= levelCount; level++)
+        {
+            auto width = std::max<size_t>(1, metadata.width >> level);
+            auto height = std::max<size_t>(1, metadata.height >> level);
+
+            // Block compressed textures need a top level whose size is a multiple of 4; the remaining levels keep the previous texture
+            if (level >= metadata.mipLevels || (DirectX::IsCompressed(metadata.format) && (width % 4 != 0 || height % 4 != 0)))
+            {
+                if (level > 1)
+                {
+                    std::fill(lodIds.begin() + level - 1, lodIds.end(), lodIds[level - 2]);
+                }
+                break;
+            }
+
+            // The images of a single 2D texture are stored from the largest mip to the smallest, so the reduced texture is a suffix of them
+            DirectX::TexMetadata lodMetadata(metadata);
+            lodMetadata.width = width;
+            lodMetadata.height = height;
+            lodMetadata.mipLevels = metadata.mipLevels - level;
+
+            Image lodImage(ddsImage);
+            lodImage.id.clear();
+            lodImage.uri = SaveDDS(image.GetImages() + level, lodMetadata.mipLevels, lodMetadata, outputDirectory, "texture_" + texture.id + "_lod" + std::to_string(level) + ".dds");
+            auto lodImageId = doc.images.Append(std::move(lodImage), AppendIdPolicy::GenerateOnEmpty).id;
+
+            Texture lodTexture(texture);
+            lodTexture.id.clear();
+
+            // When the DDS image replaced the original image, the core source is reduced too
+            if (lodTexture.imageId == ddsImageId)
+            {
+                lodTexture.imageId = lodImageId;
+            }
+
+            lodTexture.extensions[EXTENSION_MSFT_TEXTURE_DDS] = SerializeExtensionMSFTTextureDDS(doc, lodImageId);
+
+            lodIds[level - 1] = doc.textures.Append(std::move(lodTexture), AppendIdPolicy::GenerateOnEmpty).id;
+        }
+
+        return lodIds;
+    }
+}
+
 Document GLTFTextureCompressionUtils::CompressTextureAsDDS(std::shared_ptr<IStreamReader> streamReader, const Document & doc, const Texture & texture, TextureCompression compression, const std::string& outputDirectory, size_t maxTextureSize, bool generateMipMaps, bool retainOriginalImage, bool treatAsLinear)
 {
     Document outputDoc(doc);
@@ -113,24 +233,8 @@ Document GLTFTextureCompressionUtils::CompressTextureAsDDS(std::shared_ptr<IStre
     }
 
     outputImagePath += ".dds";
-    std::wstring outputImagePathW(outputImagePath.begin(), outputImagePath.end());
 
-    wchar_t outputImageFullPath[MAX_PATH];
-
-    std::wstring outputDirectoryW(outputDirectory.begin(), outputDirectory.end());
-
-    if (FAILED(::PathCchCombine(outputImageFullPath, ARRAYSIZE(outputImageFullPath), outputDirectoryW.c_str(), outputImagePathW.c_str())))
-    {
-        throw GLTFException("Failed to compose output file path.");
-    }
-
-    if (FAILED(SaveToDDSFile(image->GetImages(), image->GetImageCount(), image->GetMetadata(), DirectX::DDS_FLAGS::DDS_FLAGS_NONE, outputImageFullPath)))
-    {
-        throw GLTFException("Failed to save image as DDS.");
-    }
-
-    std::wstring outputImageFullPathW(outputImageFullPath);
-    std::string outputImageFullPathA(outputImageFullPathW.begin(), outputImageFullPathW.end());
+    std::string outputImageFullPathA = SaveDDS(image->GetImages(), image->GetImageCount(), image->GetMetadata(), outputDirectory, outputImagePath);
 
     // Add back to GLTF
     std::string ddsImageId(texture.imageId);
@@ -138,6 +242,8 @@ Document GLTFTextureCompressionUtils::CompressTextureAsDDS(std::shared_ptr<IStre
     Image ddsImage(doc.images.Get(texture.imageId));
     ddsImage.mimeType = "image/vnd-ms.dds";
     ddsImage.uri = outputImageFullPathA;
+    // The source image may have been embedded in a GLB buffer
+    ddsImage.bufferViewId.clear();
 
     if (retainOriginalImage)
     {
@@ -151,17 +257,7 @@ Document GLTFTextureCompressionUtils::CompressTextureAsDDS(std::shared_ptr<IStre
 
     Texture ddsTexture(texture);
 
-    // Create the JSON for the DDS extension element
-    rapidjson::Document ddsExtensionJson;
-    ddsExtensionJson.SetObject();
-
-    ddsExtensionJson.AddMember("source", rapidjson::Value(outputDoc.images.GetIndex(ddsImageId)), ddsExtensionJson.GetAllocator());
-
-    rapidjson::StringBuffer buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-    ddsExtensionJson.Accept(writer);
-
-    ddsTexture.extensions.insert(std::pair<std::string, std::string>(EXTENSION_MSFT_TEXTURE_DDS, buffer.GetString()));
+    ddsTexture.extensions.insert(std::pair<std::string, std::string>(EXTENSION_MSFT_TEXTURE_DDS, SerializeExtensionMSFTTextureDDS(outputDoc, ddsImageId)));
 
     outputDoc.textures.Replace(ddsTexture);
 
@@ -238,6 +334,127 @@ Document GLTFTextureCompressionUtils::CompressAllTexturesForWindowsMR(std::share
     return outputDoc;
 }
 
+Document GLTFTextureCompressionUtils::GenerateMaterialLODs(std::shared_ptr<IStreamReader> streamReader, const Document & doc, const std::string& outputDirectory, size_t levelCount)
+{
+    Document outputDoc(doc);
+
+    if (levelCount == 0)
+    {
+        return outputDoc;
+    }
+
+    GLTFResourceReader reader(streamReader);
+
+    // Textures shared by several materials are only reduced once
+    std::unordered_map<std::string, std::vector<std::string>> textureLods;
+
+    // Returns the texture to use at a level, and flags whether it differs from the one of the previous level
+    auto getTextureLod = [&](const std::string& textureId, size_t level, bool& reduced)
+    {
+        if (textureId.empty())
+        {
+            return textureId;
+        }
+
+        auto textureLod = textureLods.find(textureId);
+        if (textureLod == textureLods.end())
+        {
+            auto lodIds = AppendTextureLODs(reader, outputDoc, outputDoc.textures.Get(textureId), outputDirectory, levelCount);
+            textureLod = textureLods.emplace(textureId, std::move(lodIds)).first;
+        }
+
+        const auto& lodId = textureLod->second[level - 1];
+        reduced = reduced || lodId != (level == 1 ? textureId : textureLod->second[level - 2]);
+        return lodId;
+    };
+
+    auto patchPackedTexture = [&](rapidjson::Document& packingContents, const char* textureKey, size_t level, bool& reduced)
+    {
+        if (packingContents.HasMember(textureKey))
+        {
+            auto& index = packingContents[textureKey][MSFT_PACKING_INDEX_KEY];
+            auto lodId = getTextureLod(std::to_string(index.GetInt()), level, reduced);
+            index.SetInt(static_cast<int>(outputDoc.textures.GetIndex(lodId)));
+        }
+    };
+
+    LODMap materialLods;
+
+    for (const auto& material : doc.materials.Elements())
+    {
+        // Materials that already have LODs are left as they are
+        if (material.extensions.find(EXTENSION_MSFT_LOD) != material.extensions.end())
+        {
+            continue;
+        }
+
+        auto lodIds = std::make_shared<std::vector<std::string>>();
+
+        for (size_t level = 1; level <= levelCount; level++)
+        {
+            bool reduced = false;
+
+            Material lodMaterial(material);
+            lodMaterial.metallicRoughness.baseColorTexture.textureId = getTextureLod(material.metallicRoughness.baseColorTexture.textureId, level, reduced);
+            lodMaterial.metallicRoughness.metallicRoughnessTexture.textureId = getTextureLod(material.metallicRoughness.metallicRoughnessTexture.textureId, level, reduced);
+            lodMaterial.normalTexture.textureId = getTextureLod(material.normalTexture.textureId, level, reduced);
+            lodMaterial.occlusionTexture.textureId = getTextureLod(material.occlusionTexture.textureId, level, reduced);
+            lodMaterial.emissiveTexture.textureId = getTextureLod(material.emissiveTexture.textureId, level, reduced);
+
+            auto packingOrm = lodMaterial.extensions.find(EXTENSION_MSFT_PACKING_ORM);
+            if (packingOrm != lodMaterial.extensions.end())
+            {
+                rapidjson::Document packingOrmContents;
+                packingOrmContents.Parse(packingOrm->second.c_str());
+
+                patchPackedTexture(packingOrmContents, MSFT_PACKING_ORM_RMOTEXTURE_KEY, level, reduced);
+                patchPackedTexture(packingOrmContents, MSFT_PACKING_ORM_ORMTEXTURE_KEY, level, reduced);
+                patchPackedTexture(packingOrmContents, MSFT_PACKING_ORM_NORMALTEXTURE_KEY, level, reduced);
+
+                rapidjson::StringBuffer buffer;
+                rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+                packingOrmContents.Accept(writer);
+                packingOrm->second = buffer.GetString();
+            }
+
+            auto packingNrm = lodMaterial.extensions.find(EXTENSION_MSFT_PACKING_NRM);
+            if (packingNrm != lodMaterial.extensions.end())
+            {
+                rapidjson::Document packingNrmContents;
+                packingNrmContents.Parse(packingNrm->second.c_str());
+
+                patchPackedTexture(packingNrmContents, MSFT_PACKING_NRM_KEY, level, reduced);
+
+                rapidjson::StringBuffer buffer;
+                rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+                packingNrmContents.Accept(writer);
+                packingNrm->second = buffer.GetString();
+            }
+
+            // Stop when no texture could be reduced any further
+            if (!reduced)
+            {
+                break;
+            }
+
+            lodMaterial.id.clear();
+            if (!lodMaterial.name.empty())
+            {
+                lodMaterial.name += "_lod" + std::to_string(level);
+            }
+
+            lodIds->push_back(outputDoc.materials.Append(std::move(lodMaterial), AppendIdPolicy::GenerateOnEmpty).id);
+        }
+
+        if (!lodIds->empty())
+        {
+            materialLods.emplace(material.id, std::move(lodIds));
+        }
+    }
+
+    return GLTFLODUtils::AddMaterialLODs(outputDoc, materialLods);
+}
+
 void GLTFTextureCompressionUtils::CompressImage(DirectX::ScratchImage& image, TextureCompression compression)
 {
     if (compression == TextureCompression::None)
@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "HashUtils.h"
+
+#include <cstring>
+
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    // XXH64, as specified in https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+    const uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t Prime3 = 0x165667B19E3779F9ULL;
+    const uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+    uint64_t RotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // The specification reads little-endian values; every platform the toolkit targets is little-endian.
+    uint64_t Read64(const uint8_t* data)
+    {
+        uint64_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t Read32(const uint8_t* data)
+    {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint64_t Round(uint64_t accumulator, uint64_t input)
+    {
+        accumulator += input * Prime2;
+        accumulator = RotateLeft(accumulator, 31);
+        return accumulator * Prime1;
+    }
+
+    uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+    {
+        accumulator ^= Round(0, value);
+        return accumulator * Prime1 + Prime4;
+    }
+}
+
+uint64_t HashUtils::Hash64(const void* data, size_t byteLength, uint64_t seed)
+{
+    auto current = static_cast<const uint8_t*>(data);
+    auto end = current + byteLength;
+    uint64_t hash;
+
+    if (byteLength >= 32)
+    {
+        // Four independent lanes over 32-byte stripes
+        uint64_t v1 = seed + Prime1 + Prime2;
+        uint64_t v2 = seed + Prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - Prime1;
+
+        auto limit = end - 32;
+        do
+        {
+            v1 = Round(v1, Read64(current));
+            v2 = Round(v2, Read64(current + 8));
+            v3 = Round(v3, Read64(current + 16));
+            v4 = Round(v4, Read64(current + 24));
+            current += 32;
+        } while (current <= limit);
+
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        hash = MergeRound(hash, v1);
+        hash = MergeRound(hash, v2);
+        hash = MergeRound(hash, v3);
+        hash = MergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + Prime5;
+    }
+
+    hash += static_cast<uint64_t>(byteLength);
+
+    for (; current + 8 <= end; current += 8)
+    {
+        hash ^= Round(0, Read64(current));
+        hash = RotateLeft(hash, 27) * Prime1 + Prime4;
+    }
+
+    if (current + 4 <= end)
+    {
+        hash ^= static_cast<uint64_t>(Read32(current)) * Prime1;
+        hash = RotateLeft(hash, 23) * Prime2 + Prime3;
+        current += 4;
+    }
+
+    for (; current < end; current++)
+    {
+        hash ^= static_cast<uint64_t>(*current) * Prime5;
+        hash = RotateLeft(hash, 11) * Prime1;
+    }
+
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
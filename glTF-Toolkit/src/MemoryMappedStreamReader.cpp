@@ -0,0 +1,281 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "MemoryMappedStreamReader.h"
+#include "MemoryStream.h"
+
+#include "GLTFSDK/ExtensionsKHR.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <limits>
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+const char* Microsoft::glTF::Toolkit::GLB_BINARY_CHUNK_FRAGMENT = "#bin";
+
+namespace
+{
+    const uint32_t GLB_MAGIC = 0x46546C67;
+    const uint32_t GLB_VERSION = 2;
+    const uint32_t GLB_CHUNK_TYPE_JSON = 0x4E4F534A;
+    const uint32_t GLB_CHUNK_TYPE_BIN = 0x004E4942;
+
+    // Magic, version and length, followed by chunks of a length, a type and the chunk data
+    const size_t GLB_HEADER_BYTE_SIZE = 3 * sizeof(uint32_t);
+    const size_t GLB_CHUNK_HEADER_BYTE_SIZE = 2 * sizeof(uint32_t);
+
+    // GLB integers are little-endian
+    uint32_t ReadUInt32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    bool EndsWith(const std::string& value, const std::string& suffix)
+    {
+        return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    GLTFException GLBException(const std::string& uri, const std::string& reason)
+    {
+        return GLTFException("Could not read GLB file " + uri + ": " + reason);
+    }
+}
+
+MemoryMappedFile::MemoryMappedFile(std::shared_ptr<const NativeFile> file, const uint8_t* data, size_t size) : m_file(std::move(file)), m_data(data), m_size(size), m_fileOffset(0)
+{
+}
+
+std::shared_ptr<const MemoryMappedFile> MemoryMappedFile::View(std::shared_ptr<const MemoryMappedFile> file, size_t byteOffset, size_t byteLength)
+{
+    if (byteOffset > file->m_size || byteLength > file->m_size - byteOffset)
+    {
+        throw GLTFException("The view lies outside of the mapped file.");
+    }
+
+    std::shared_ptr<MemoryMappedFile> view(new MemoryMappedFile(file->m_file, file->m_data + byteOffset, byteLength));
+    view->m_fileOffset = file->m_fileOffset + byteOffset;
+    view->m_base = file->m_base != nullptr ? file->m_base : std::move(file);
+    return view;
+}
+
+#ifdef _WIN32
+
+std::shared_ptr<const MemoryMappedFile> MemoryMappedFile::Open(const std::experimental::filesystem::path& path)
+{
+    auto file = NativeFile::OpenRead(path);
+    if (file == nullptr)
+    {
+        return nullptr;
+    }
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file->GetHandle(), &size) || size.QuadPart <= 0 || static_cast<uint64_t>(size.QuadPart) > std::numeric_limits<size_t>::max())
+    {
+        return nullptr;
+    }
+
+    // The view keeps the file mapped after the mapping handle is closed
+    auto mapping = ::CreateFileMappingW(file->GetHandle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    ::CloseHandle(mapping);
+    if (data == nullptr)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<const MemoryMappedFile>(new MemoryMappedFile(std::move(file), static_cast<const uint8_t*>(data), static_cast<size_t>(size.QuadPart)));
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    if (m_base == nullptr)
+    {
+        ::UnmapViewOfFile(m_data);
+    }
+}
+
+#else
+
+std::shared_ptr<const MemoryMappedFile> MemoryMappedFile::Open(const std::experimental::filesystem::path& path)
+{
+    auto file = NativeFile::OpenRead(path);
+    if (file == nullptr)
+    {
+        return nullptr;
+    }
+
+    struct stat status;
+    if (::fstat(file->GetHandle(), &status) != 0 || status.st_size <= 0 || static_cast<uint64_t>(status.st_size) > std::numeric_limits<size_t>::max())
+    {
+        return nullptr;
+    }
+
+    auto size = static_cast<size_t>(status.st_size);
+    auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file->GetHandle(), 0);
+    if (data == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<const MemoryMappedFile>(new MemoryMappedFile(std::move(file), static_cast<const uint8_t*>(data), size));
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    if (m_base == nullptr)
+    {
+        ::munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+#endif
+
+MemoryMappedStreamReader::MemoryMappedStreamReader(std::experimental::filesystem::path baseDirectory) : m_baseDirectory(std::move(baseDirectory))
+{
+}
+
+std::shared_ptr<std::istream> MemoryMappedStreamReader::GetInputStream(const std::string& uri) const
+{
+    auto mapping = GetMapping(uri);
+    if (mapping != nullptr)
+    {
+        auto data = mapping->Data();
+        auto size = mapping->Size();
+        return std::make_shared<MemoryStream>(std::move(mapping), data, size);
+    }
+
+    return std::make_shared<std::ifstream>(GetPath(uri), std::ios::binary);
+}
+
+std::shared_ptr<const MemoryMappedFile> MemoryMappedStreamReader::GetMapping(const std::string& uri) const
+{
+    std::lock_guard<std::mutex> lock(m_mappingsMutex);
+
+    auto it = m_mappings.find(uri);
+    if (it == m_mappings.end())
+    {
+        std::string fragment(GLB_BINARY_CHUNK_FRAGMENT);
+        if (EndsWith(uri, fragment))
+        {
+            // Usually already cached by DeserializeGLB, unless the buffer was merged from another document
+            it = m_mappings.emplace(uri, MapGLBChunks(uri.substr(0, uri.size() - fragment.size())).binary).first;
+        }
+        else
+        {
+            it = m_mappings.emplace(uri, MemoryMappedFile::Open(GetPath(uri))).first;
+        }
+    }
+
+    return it->second;
+}
+
+Document MemoryMappedStreamReader::DeserializeGLB(const std::string& uri) const
+{
+    GLBChunks chunks;
+    {
+        std::lock_guard<std::mutex> lock(m_mappingsMutex);
+
+        // The chunk headers are only parsed here: later reads of the buffer go straight to the view of the binary chunk
+        chunks = MapGLBChunks(uri);
+        m_mappings[uri + GLB_BINARY_CHUNK_FRAGMENT] = chunks.binary;
+    }
+
+    auto document = Deserialize(std::string(reinterpret_cast<const char*>(chunks.json->Data()), chunks.json->Size()), KHR::GetKHRExtensionDeserializer());
+
+    // The GLB buffer is the first one, and has no URI
+    if (chunks.binary != nullptr && document.buffers.Size() > 0 && document.buffers[0].uri.empty())
+    {
+        Buffer buffer(document.buffers[0]);
+        buffer.uri = uri + GLB_BINARY_CHUNK_FRAGMENT;
+        document.buffers.Replace(buffer);
+    }
+
+    return document;
+}
+
+MemoryMappedStreamReader::GLBChunks MemoryMappedStreamReader::MapGLBChunks(const std::string& uri) const
+{
+    auto it = m_mappings.find(uri);
+    if (it == m_mappings.end())
+    {
+        it = m_mappings.emplace(uri, MemoryMappedFile::Open(GetPath(uri))).first;
+    }
+
+    auto file = it->second;
+    if (file == nullptr)
+    {
+        throw GLBException(uri, "the file could not be mapped.");
+    }
+
+    auto data = file->Data();
+    if (file->Size() < GLB_HEADER_BYTE_SIZE + GLB_CHUNK_HEADER_BYTE_SIZE || ReadUInt32(data) != GLB_MAGIC)
+    {
+        throw GLBException(uri, "the file is not a GLB file.");
+    }
+
+    if (ReadUInt32(data + sizeof(uint32_t)) != GLB_VERSION)
+    {
+        throw GLBException(uri, "only version 2 is supported.");
+    }
+
+    size_t length = ReadUInt32(data + 2 * sizeof(uint32_t));
+    if (length < GLB_HEADER_BYTE_SIZE || length > file->Size())
+    {
+        throw GLBException(uri, "the length in its header doesn't match the file.");
+    }
+
+    // The JSON chunk comes first, followed by the binary chunk if there is one; other chunks are ignored
+    GLBChunks chunks;
+    for (size_t offset = GLB_HEADER_BYTE_SIZE; length - offset >= GLB_CHUNK_HEADER_BYTE_SIZE;)
+    {
+        size_t chunkLength = ReadUInt32(data + offset);
+        auto chunkType = ReadUInt32(data + offset + sizeof(uint32_t));
+        offset += GLB_CHUNK_HEADER_BYTE_SIZE;
+
+        if (chunkLength > length - offset)
+        {
+            throw GLBException(uri, "a chunk extends beyond the end of the file.");
+        }
+
+        if (chunks.json == nullptr)
+        {
+            if (chunkType != GLB_CHUNK_TYPE_JSON)
+            {
+                throw GLBException(uri, "the first chunk is not a JSON chunk.");
+            }
+
+            chunks.json = MemoryMappedFile::View(file, offset, chunkLength);
+        }
+        else if (chunkType == GLB_CHUNK_TYPE_BIN && chunks.binary == nullptr)
+        {
+            chunks.binary = MemoryMappedFile::View(file, offset, chunkLength);
+        }
+
+        offset += chunkLength;
+    }
+
+    if (chunks.json == nullptr)
+    {
+        throw GLBException(uri, "the file has no JSON chunk.");
+    }
+
+    return chunks;
+}
+
+std::experimental::filesystem::path MemoryMappedStreamReader::GetPath(const std::string& uri) const
+{
+    // URIs are UTF-8; an absolute URI replaces the base directory
+    return m_baseDirectory / std::experimental::filesystem::u8path(uri);
+}
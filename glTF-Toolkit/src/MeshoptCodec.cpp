@@ -0,0 +1,658 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "MeshoptCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace Microsoft::glTF::Toolkit;
+
+const char* Microsoft::glTF::Toolkit::EXTENSION_EXT_MESHOPT_COMPRESSION = "EXT_meshopt_compression";
+
+namespace
+{
+    // Version 0 of the vertex codec and version 1 of the index codec, the ones EXT_meshopt_compression requires
+    const uint8_t VERTEX_HEADER = 0xA0;
+    const uint8_t INDEX_HEADER = 0xD1;
+
+    // Vertex data is encoded in blocks of up to 256 elements, which fit in 8 KB, with each byte of the elements stored as groups of 16 deltas
+    const size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+    const size_t VERTEX_BLOCK_MAX_SIZE = 256;
+    const size_t BYTE_GROUP_SIZE = 16;
+
+    // The encoded vertex data ends with the first element, padded to this size so that decoders can read whole groups past the last block
+    const size_t VERTEX_TAIL_MAX_SIZE = 32;
+
+    // The encoded index data ends with 4 bytes of padding
+    const size_t INDEX_TAIL_SIZE = 4;
+
+    // An index sequence switches to its second baseline when the delta from the current one reaches this value
+    const int INDEX_BASELINE_THRESHOLD = 30;
+
+    size_t GetVertexBlockSize(size_t byteStride)
+    {
+        auto result = (VERTEX_BLOCK_SIZE_BYTES / byteStride) & ~(BYTE_GROUP_SIZE - 1);
+        return std::min(result, VERTEX_BLOCK_MAX_SIZE);
+    }
+
+    void ValidateVertexStride(size_t byteStride)
+    {
+        if (byteStride == 0 || byteStride % 4 != 0 || byteStride > 256)
+        {
+            throw std::invalid_argument("The vertex stride must be a multiple of 4 that is at most 256.");
+        }
+    }
+
+    uint8_t ZigZag8(uint8_t value)
+    {
+        return static_cast<uint8_t>((value << 1) ^ static_cast<uint8_t>(static_cast<int8_t>(value) >> 7));
+    }
+
+    uint8_t UnZigZag8(uint8_t value)
+    {
+        return static_cast<uint8_t>(-(value & 1) ^ (value >> 1));
+    }
+
+    // The size of a group of 16 bytes stored with the given number of bits per byte, plus the bytes that don't fit
+    size_t MeasureByteGroup(const uint8_t* group, int bits)
+    {
+        if (bits == 1)
+        {
+            // Groups of zeros take no space
+            return std::all_of(group, group + BYTE_GROUP_SIZE, [](uint8_t value) { return value == 0; }) ? 0 : SIZE_MAX;
+        }
+
+        if (bits == 8)
+        {
+            return BYTE_GROUP_SIZE;
+        }
+
+        size_t result = BYTE_GROUP_SIZE * bits / 8;
+        unsigned int sentinel = (1u << bits) - 1;
+        for (size_t i = 0; i < BYTE_GROUP_SIZE; i++)
+        {
+            result += group[i] >= sentinel ? 1 : 0;
+        }
+        return result;
+    }
+
+    void EncodeByteGroup(std::vector<uint8_t>& output, const uint8_t* group, int bits)
+    {
+        if (bits == 1)
+        {
+            return;
+        }
+
+        if (bits == 8)
+        {
+            output.insert(output.end(), group, group + BYTE_GROUP_SIZE);
+            return;
+        }
+
+        // Values that don't fit are stored as the sentinel, followed by the actual values once the group is packed
+        size_t valuesPerByte = 8 / bits;
+        unsigned int sentinel = (1u << bits) - 1;
+        for (size_t i = 0; i < BYTE_GROUP_SIZE; i += valuesPerByte)
+        {
+            unsigned int packed = 0;
+            for (size_t k = 0; k < valuesPerByte; k++)
+            {
+                packed = (packed << bits) | std::min<unsigned int>(group[i + k], sentinel);
+            }
+            output.push_back(static_cast<uint8_t>(packed));
+        }
+
+        for (size_t i = 0; i < BYTE_GROUP_SIZE; i++)
+        {
+            if (group[i] >= sentinel)
+            {
+                output.push_back(group[i]);
+            }
+        }
+    }
+
+    // Encodes a multiple of 16 bytes as a header of 2 bits per group, which selects how the group is stored, followed by the groups
+    void EncodeBytes(std::vector<uint8_t>& output, const uint8_t* bytes, size_t size)
+    {
+        auto groupCount = size / BYTE_GROUP_SIZE;
+        auto headerOffset = output.size();
+        output.resize(output.size() + (groupCount + 3) / 4, 0);
+
+        for (size_t group = 0; group < groupCount; group++)
+        {
+            const uint8_t* values = bytes + group * BYTE_GROUP_SIZE;
+
+            int bestBits = 8;
+            size_t bestSize = MeasureByteGroup(values, 8);
+            for (int bits : { 1, 2, 4 })
+            {
+                auto groupSize = MeasureByteGroup(values, bits);
+                if (groupSize < bestSize)
+                {
+                    bestBits = bits;
+                    bestSize = groupSize;
+                }
+            }
+
+            uint8_t bitsLog2 = bestBits == 1 ? 0 : bestBits == 2 ? 1 : bestBits == 4 ? 2 : 3;
+            output[headerOffset + group / 4] |= static_cast<uint8_t>(bitsLog2 << ((group % 4) * 2));
+
+            EncodeByteGroup(output, values, bestBits);
+        }
+    }
+
+    const uint8_t* DecodeBytes(const uint8_t* data, const uint8_t* dataEnd, uint8_t* bytes, size_t size)
+    {
+        auto groupCount = size / BYTE_GROUP_SIZE;
+        auto headerSize = (groupCount + 3) / 4;
+        if (static_cast<size_t>(dataEnd - data) < headerSize)
+        {
+            throw std::invalid_argument("The encoded vertex data is truncated.");
+        }
+
+        const uint8_t* header = data;
+        data += headerSize;
+
+        for (size_t group = 0; group < groupCount; group++)
+        {
+            uint8_t* values = bytes + group * BYTE_GROUP_SIZE;
+            int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+
+            if (bitsLog2 == 0)
+            {
+                std::fill(values, values + BYTE_GROUP_SIZE, static_cast<uint8_t>(0));
+                continue;
+            }
+
+            int bits = 1 << bitsLog2;
+            size_t packedSize = BYTE_GROUP_SIZE * bits / 8;
+            if (static_cast<size_t>(dataEnd - data) < packedSize)
+            {
+                throw std::invalid_argument("The encoded vertex data is truncated.");
+            }
+
+            if (bits == 8)
+            {
+                std::copy(data, data + BYTE_GROUP_SIZE, values);
+                data += BYTE_GROUP_SIZE;
+                continue;
+            }
+
+            size_t valuesPerByte = 8 / bits;
+            unsigned int sentinel = (1u << bits) - 1;
+            const uint8_t* outliers = data + packedSize;
+            for (size_t i = 0; i < BYTE_GROUP_SIZE; i++)
+            {
+                auto shift = (valuesPerByte - 1 - i % valuesPerByte) * bits;
+                auto value = (data[i / valuesPerByte] >> shift) & sentinel;
+                if (value == sentinel)
+                {
+                    if (outliers == dataEnd)
+                    {
+                        throw std::invalid_argument("The encoded vertex data is truncated.");
+                    }
+                    value = *outliers++;
+                }
+                values[i] = static_cast<uint8_t>(value);
+            }
+            data = outliers;
+        }
+
+        return data;
+    }
+
+    void EncodeVByte(std::vector<uint8_t>& output, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            output.push_back(static_cast<uint8_t>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint32_t DecodeVByte(const uint8_t*& data, const uint8_t* dataEnd)
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (data == dataEnd)
+            {
+                throw std::invalid_argument("The encoded index data is truncated.");
+            }
+
+            uint8_t byte = *data++;
+            result |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return result;
+            }
+        }
+
+        throw std::invalid_argument("The encoded index data holds an invalid value.");
+    }
+
+    // Rounds a value in [-1, 1] to a signed integer of the given number of bits
+    int QuantizeSnorm(float value, int bits)
+    {
+        float scale = static_cast<float>((1 << (bits - 1)) - 1);
+        float clamped = std::min(std::max(value, -1.0f), 1.0f);
+        return static_cast<int>(clamped * scale + (clamped >= 0.0f ? 0.5f : -0.5f));
+    }
+
+    template<typename T>
+    void WriteComponent(uint8_t* destination, size_t index, int value)
+    {
+        T component = static_cast<T>(value);
+        memcpy(destination + index * sizeof(T), &component, sizeof(T));
+    }
+
+    template<typename T>
+    T ReadComponent(const uint8_t* source, size_t index)
+    {
+        T component;
+        memcpy(&component, source + index * sizeof(T), sizeof(T));
+        return component;
+    }
+
+    template<typename T>
+    void DecodeFilterOctahedral(uint8_t* data, size_t count)
+    {
+        const float max = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            uint8_t* element = data + i * 4 * sizeof(T);
+
+            // The third component holds the value of 1, which sets the scale of the octahedral coordinates
+            float x = static_cast<float>(ReadComponent<T>(element, 0));
+            float y = static_cast<float>(ReadComponent<T>(element, 1));
+            float z = static_cast<float>(ReadComponent<T>(element, 2)) - std::abs(x) - std::abs(y);
+
+            // Unfold the lower hemisphere
+            float t = std::min(z, 0.0f);
+            x += x >= 0.0f ? t : -t;
+            y += y >= 0.0f ? t : -t;
+
+            float length = std::sqrt(x * x + y * y + z * z);
+            float scale = length > 0.0f ? max / length : 0.0f;
+
+            WriteComponent<T>(element, 0, static_cast<int>(x * scale + (x >= 0.0f ? 0.5f : -0.5f)));
+            WriteComponent<T>(element, 1, static_cast<int>(y * scale + (y >= 0.0f ? 0.5f : -0.5f)));
+            WriteComponent<T>(element, 2, static_cast<int>(z * scale + (z >= 0.0f ? 0.5f : -0.5f)));
+        }
+    }
+
+    void DecodeFilterQuaternion(uint8_t* data, size_t count)
+    {
+        const float scale = 1.0f / std::sqrt(2.0f);
+        for (size_t i = 0; i < count; i++)
+        {
+            uint8_t* element = data + i * 8;
+
+            // The last component holds the index of the largest component in its 2 low bits, and the scale of the others in the remaining ones
+            auto last = ReadComponent<int16_t>(element, 3);
+            float componentScale = scale / static_cast<float>(last | 3);
+
+            float x = ReadComponent<int16_t>(element, 0) * componentScale;
+            float y = ReadComponent<int16_t>(element, 1) * componentScale;
+            float z = ReadComponent<int16_t>(element, 2) * componentScale;
+            float w = std::sqrt(std::max(1.0f - x * x - y * y - z * z, 0.0f));
+
+            int largest = last & 3;
+            WriteComponent<int16_t>(element, (largest + 1) & 3, static_cast<int>(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f)));
+            WriteComponent<int16_t>(element, (largest + 2) & 3, static_cast<int>(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f)));
+            WriteComponent<int16_t>(element, (largest + 3) & 3, static_cast<int>(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f)));
+            WriteComponent<int16_t>(element, largest, static_cast<int>(w * 32767.0f + 0.5f));
+        }
+    }
+
+    void DecodeFilterExponential(uint8_t* data, size_t componentCount)
+    {
+        for (size_t i = 0; i < componentCount; i++)
+        {
+            auto value = ReadComponent<uint32_t>(data, i);
+
+            // A signed 24-bit mantissa and a signed 8-bit exponent
+            auto mantissa = static_cast<int32_t>(value << 8) >> 8;
+            auto exponent = static_cast<int8_t>(value >> 24);
+
+            float result = static_cast<float>(std::ldexp(static_cast<double>(mantissa), exponent));
+            memcpy(data + i * sizeof(float), &result, sizeof(float));
+        }
+    }
+}
+
+std::vector<uint8_t> MeshoptCodec::EncodeVertexBuffer(const uint8_t* vertices, size_t count, size_t byteStride)
+{
+    ValidateVertexStride(byteStride);
+
+    std::vector<uint8_t> output;
+    output.push_back(VERTEX_HEADER);
+
+    std::vector<uint8_t> firstVertex(byteStride, 0);
+    if (count > 0)
+    {
+        std::copy(vertices, vertices + byteStride, firstVertex.begin());
+    }
+
+    // Each byte is delta encoded against the same byte of the previous element, starting from the first element
+    std::vector<uint8_t> lastVertex(firstVertex);
+    std::vector<uint8_t> deltas(VERTEX_BLOCK_MAX_SIZE);
+
+    auto blockSize = GetVertexBlockSize(byteStride);
+    for (size_t blockStart = 0; blockStart < count; blockStart += blockSize)
+    {
+        auto blockCount = std::min(blockSize, count - blockStart);
+        auto alignedCount = (blockCount + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+        const uint8_t* block = vertices + blockStart * byteStride;
+
+        for (size_t k = 0; k < byteStride; k++)
+        {
+            std::fill(deltas.begin(), deltas.end(), static_cast<uint8_t>(0));
+
+            uint8_t previous = lastVertex[k];
+            for (size_t i = 0; i < blockCount; i++)
+            {
+                uint8_t current = block[i * byteStride + k];
+                deltas[i] = ZigZag8(static_cast<uint8_t>(current - previous));
+                previous = current;
+            }
+
+            EncodeBytes(output, deltas.data(), alignedCount);
+        }
+
+        std::copy(block + (blockCount - 1) * byteStride, block + blockCount * byteStride, lastVertex.begin());
+    }
+
+    if (byteStride < VERTEX_TAIL_MAX_SIZE)
+    {
+        output.resize(output.size() + VERTEX_TAIL_MAX_SIZE - byteStride, 0);
+    }
+    output.insert(output.end(), firstVertex.begin(), firstVertex.end());
+
+    return output;
+}
+
+void MeshoptCodec::DecodeVertexBuffer(uint8_t* destination, size_t count, size_t byteStride, const uint8_t* buffer, size_t bufferSize)
+{
+    ValidateVertexStride(byteStride);
+
+    auto tailSize = std::max(byteStride, VERTEX_TAIL_MAX_SIZE);
+    if (bufferSize < 1 + tailSize)
+    {
+        throw std::invalid_argument("The encoded vertex data is truncated.");
+    }
+
+    if (buffer[0] != VERTEX_HEADER)
+    {
+        throw std::invalid_argument("The encoded vertex data uses an unsupported version.");
+    }
+
+    const uint8_t* data = buffer + 1;
+    const uint8_t* dataEnd = buffer + bufferSize - tailSize;
+
+    std::vector<uint8_t> lastVertex(buffer + bufferSize - byteStride, buffer + bufferSize);
+    std::vector<uint8_t> deltas(VERTEX_BLOCK_MAX_SIZE);
+
+    auto blockSize = GetVertexBlockSize(byteStride);
+    for (size_t blockStart = 0; blockStart < count; blockStart += blockSize)
+    {
+        auto blockCount = std::min(blockSize, count - blockStart);
+        auto alignedCount = (blockCount + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+        uint8_t* block = destination + blockStart * byteStride;
+
+        for (size_t k = 0; k < byteStride; k++)
+        {
+            data = DecodeBytes(data, dataEnd, deltas.data(), alignedCount);
+
+            uint8_t previous = lastVertex[k];
+            for (size_t i = 0; i < blockCount; i++)
+            {
+                previous = static_cast<uint8_t>(previous + UnZigZag8(deltas[i]));
+                block[i * byteStride + k] = previous;
+            }
+        }
+
+        std::copy(block + (blockCount - 1) * byteStride, block + blockCount * byteStride, lastVertex.begin());
+    }
+
+    if (data != dataEnd)
+    {
+        throw std::invalid_argument("The encoded vertex data doesn't match the number of elements.");
+    }
+}
+
+std::vector<uint8_t> MeshoptCodec::EncodeIndexSequence(const uint32_t* indices, size_t count)
+{
+    std::vector<uint8_t> output;
+    output.push_back(INDEX_HEADER);
+
+    // Indices are delta encoded against one of two baselines, so that sequences that alternate between two ranges stay small
+    uint32_t last[2] = { 0, 0 };
+    uint32_t current = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        auto index = indices[i];
+
+        auto delta = static_cast<int32_t>(index - last[current]);
+        if (std::abs(static_cast<int64_t>(delta)) >= INDEX_BASELINE_THRESHOLD)
+        {
+            current ^= 1;
+        }
+
+        auto d = index - last[current];
+        auto v = (d << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(d) >> 31);
+
+        EncodeVByte(output, (v << 1) | current);
+        last[current] = index;
+    }
+
+    output.resize(output.size() + INDEX_TAIL_SIZE, 0);
+
+    return output;
+}
+
+void MeshoptCodec::DecodeIndexSequence(uint8_t* destination, size_t count, size_t indexSize, const uint8_t* buffer, size_t bufferSize)
+{
+    if (indexSize != 2 && indexSize != 4)
+    {
+        throw std::invalid_argument("The index size must be 2 or 4 bytes.");
+    }
+
+    if (bufferSize < 1 + count + INDEX_TAIL_SIZE)
+    {
+        throw std::invalid_argument("The encoded index data is truncated.");
+    }
+
+    if (buffer[0] != INDEX_HEADER)
+    {
+        throw std::invalid_argument("The encoded index data uses an unsupported version.");
+    }
+
+    const uint8_t* data = buffer + 1;
+    const uint8_t* dataEnd = buffer + bufferSize - INDEX_TAIL_SIZE;
+
+    uint32_t last[2] = { 0, 0 };
+    for (size_t i = 0; i < count; i++)
+    {
+        auto v = DecodeVByte(data, dataEnd);
+
+        auto current = v & 1;
+        v >>= 1;
+
+        auto d = (v >> 1) ^ (0u - (v & 1));
+        auto index = last[current] + d;
+        last[current] = index;
+
+        if (indexSize == 2)
+        {
+            WriteComponent<uint16_t>(destination, i, static_cast<int>(index & 0xFFFF));
+        }
+        else
+        {
+            memcpy(destination + i * 4, &index, 4);
+        }
+    }
+
+    if (data != dataEnd)
+    {
+        throw std::invalid_argument("The encoded index data doesn't match the number of indices.");
+    }
+}
+
+void MeshoptCodec::EncodeFilterOctahedral(uint8_t* destination, size_t count, size_t byteStride, int bits, const float* data)
+{
+    if (byteStride != 4 && byteStride != 8)
+    {
+        throw std::invalid_argument("The octahedral filter requires a stride of 4 or 8 bytes.");
+    }
+
+    int componentBits = static_cast<int>(byteStride * 2);
+    if (bits < 1 || bits > componentBits)
+    {
+        throw std::invalid_argument("The octahedral filter supports between 1 and " + std::to_string(componentBits) + " bits for this stride.");
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* n = data + i * 4;
+        uint8_t* element = destination + i * byteStride;
+
+        // Project onto the octahedron, and fold the lower hemisphere over the upper one
+        float length = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+        float scale = length == 0.0f ? 0.0f : 1.0f / length;
+        float x = n[0] * scale;
+        float y = n[1] * scale;
+
+        float u = n[2] >= 0.0f ? x : (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float v = n[2] >= 0.0f ? y : (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+        int components[] = { QuantizeSnorm(u, bits), QuantizeSnorm(v, bits), QuantizeSnorm(1.0f, bits), QuantizeSnorm(n[3], componentBits) };
+        for (size_t j = 0; j < 4; j++)
+        {
+            if (byteStride == 4)
+            {
+                WriteComponent<int8_t>(element, j, components[j]);
+            }
+            else
+            {
+                WriteComponent<int16_t>(element, j, components[j]);
+            }
+        }
+    }
+}
+
+void MeshoptCodec::EncodeFilterQuaternion(uint8_t* destination, size_t count, int bits, const float* data)
+{
+    if (bits < 4 || bits > 16)
+    {
+        throw std::invalid_argument("The quaternion filter supports between 4 and 16 bits.");
+    }
+
+    const float scale = std::sqrt(2.0f);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* q = data + i * 4;
+        uint8_t* element = destination + i * 8;
+
+        // The largest component is recovered from the others; q and -q are the same rotation, so it's always made positive
+        int largest = 0;
+        for (int j = 1; j < 4; j++)
+        {
+            largest = std::abs(q[j]) > std::abs(q[largest]) ? j : largest;
+        }
+        float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+        // The other components are in [-1/sqrt(2), 1/sqrt(2)], and are stored in cyclic order so that the decoder can put them back
+        WriteComponent<int16_t>(element, 0, QuantizeSnorm(q[(largest + 1) & 3] * scale * sign, bits));
+        WriteComponent<int16_t>(element, 1, QuantizeSnorm(q[(largest + 2) & 3] * scale * sign, bits));
+        WriteComponent<int16_t>(element, 2, QuantizeSnorm(q[(largest + 3) & 3] * scale * sign, bits));
+        WriteComponent<int16_t>(element, 3, (QuantizeSnorm(1.0f, bits) & ~3) | largest);
+    }
+}
+
+void MeshoptCodec::EncodeFilterExponential(uint8_t* destination, size_t count, size_t byteStride, int bits, const float* data)
+{
+    ValidateVertexStride(byteStride);
+
+    if (bits < 1 || bits > 24)
+    {
+        throw std::invalid_argument("The exponential filter supports between 1 and 24 bits.");
+    }
+
+    auto componentCount = byteStride / sizeof(float);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* v = data + i * componentCount;
+
+        // The largest exponent keeps every mantissa in [-1, 1], which is then scaled to a signed integer of the given number of bits
+        int exponent = -100;
+        for (size_t j = 0; j < componentCount; j++)
+        {
+            int componentExponent;
+            std::frexp(v[j], &componentExponent);
+            exponent = std::max(exponent, componentExponent);
+        }
+        exponent -= bits - 1;
+
+        for (size_t j = 0; j < componentCount; j++)
+        {
+            auto mantissa = static_cast<int>(std::ldexp(v[j], -exponent) + (v[j] >= 0.0f ? 0.5f : -0.5f));
+            auto value = (static_cast<uint32_t>(mantissa) & 0xFFFFFF) | (static_cast<uint32_t>(exponent) << 24);
+            memcpy(destination + (i * componentCount + j) * sizeof(uint32_t), &value, sizeof(uint32_t));
+        }
+    }
+}
+
+void MeshoptCodec::DecodeFilter(MeshoptFilter filter, uint8_t* data, size_t count, size_t byteStride)
+{
+    switch (filter)
+    {
+    case MeshoptFilter::None:
+        break;
+    case MeshoptFilter::Octahedral:
+        if (byteStride == 4)
+        {
+            DecodeFilterOctahedral<int8_t>(data, count);
+        }
+        else if (byteStride == 8)
+        {
+            DecodeFilterOctahedral<int16_t>(data, count);
+        }
+        else
+        {
+            throw std::invalid_argument("The octahedral filter requires a stride of 4 or 8 bytes.");
+        }
+        break;
+    case MeshoptFilter::Quaternion:
+        if (byteStride != 8)
+        {
+            throw std::invalid_argument("The quaternion filter requires a stride of 8 bytes.");
+        }
+        DecodeFilterQuaternion(data, count);
+        break;
+    case MeshoptFilter::Exponential:
+        ValidateVertexStride(byteStride);
+        DecodeFilterExponential(data, count * byteStride / sizeof(float));
+        break;
+    default:
+        throw std::invalid_argument("Unknown filter.");
+    }
+}
+
+const char* MeshoptCodec::GetFilterName(MeshoptFilter filter)
+{
+    switch (filter)
+    {
+    case MeshoptFilter::Octahedral: return "OCTAHEDRAL";
+    case MeshoptFilter::Quaternion: return "QUATERNION";
+    case MeshoptFilter::Exponential: return "EXPONENTIAL";
+    default: return nullptr;
+    }
+}
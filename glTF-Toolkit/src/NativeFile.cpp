@@ -0,0 +1,335 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "NativeFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#endif
+
+#include <limits>
+#include <vector>
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    // Size of the buffer used when the bytes have to go through user space
+    const size_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+    // Largest length passed to a single read, write or copy call; Linux never transfers more than this at once
+    const size_t MAX_TRANSFER_SIZE = 0x7FFFF000;
+
+    size_t GetTransferSize(uint64_t byteLength, size_t maxSize)
+    {
+        return static_cast<size_t>(std::min<uint64_t>(byteLength, maxSize));
+    }
+
+    GLTFException CopyException(const std::string& reason)
+    {
+        return GLTFException("Could not copy a byte range between files: " + reason);
+    }
+
+#ifdef __linux__
+    // Reflinks share whole blocks, so both offsets must be block-aligned, and so must the length unless the range
+    // ends at the end of the source file.
+    bool TryReflink(int source, uint64_t sourceOffset, int destination, uint64_t destinationOffset, uint64_t byteLength)
+    {
+#ifdef FICLONERANGE
+        struct stat sourceStatus;
+        struct stat destinationStatus;
+        if (::fstat(source, &sourceStatus) != 0 || ::fstat(destination, &destinationStatus) != 0 || destinationStatus.st_blksize <= 0)
+        {
+            return false;
+        }
+
+        auto blockSize = static_cast<uint64_t>(destinationStatus.st_blksize);
+        if (sourceOffset % blockSize != 0 || destinationOffset % blockSize != 0 ||
+            (byteLength % blockSize != 0 && sourceOffset + byteLength != static_cast<uint64_t>(sourceStatus.st_size)))
+        {
+            return false;
+        }
+
+        file_clone_range range = {};
+        range.src_fd = source;
+        range.src_offset = sourceOffset;
+        range.src_length = byteLength;
+        range.dest_offset = destinationOffset;
+
+        return ::ioctl(destination, FICLONERANGE, &range) == 0;
+#else
+        return false;
+#endif
+    }
+#endif
+}
+
+NativeFile::NativeFile(Handle handle) : m_handle(handle)
+{
+}
+
+#ifdef _WIN32
+
+std::shared_ptr<NativeFile> NativeFile::OpenRead(const std::experimental::filesystem::path& path)
+{
+    auto file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<NativeFile>(new NativeFile(file));
+}
+
+std::shared_ptr<NativeFile> NativeFile::OpenWrite(const std::experimental::filesystem::path& path)
+{
+    // The file may also be open in an output stream
+    auto file = ::CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<NativeFile>(new NativeFile(file));
+}
+
+NativeFile::~NativeFile()
+{
+    ::CloseHandle(m_handle);
+}
+
+uint64_t NativeFile::GetSize() const
+{
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(m_handle, &size))
+    {
+        throw GLTFException("Could not get the size of a file.");
+    }
+
+    return static_cast<uint64_t>(size.QuadPart);
+}
+
+void NativeFile::Resize(uint64_t byteLength) const
+{
+    FILE_END_OF_FILE_INFO endOfFile;
+    endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(byteLength);
+    if (!::SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile)))
+    {
+        throw GLTFException("Could not resize a file.");
+    }
+}
+
+FileCopyMethod NativeFile::CopyRange(const NativeFile& source, uint64_t sourceOffset, const NativeFile& destination, uint64_t destinationOffset, uint64_t byteLength)
+{
+    std::vector<char> buffer(GetTransferSize(byteLength, COPY_BUFFER_SIZE));
+    while (byteLength > 0)
+    {
+        // Reads and writes at the offsets of the OVERLAPPED structures, which don't move the file pointers
+        OVERLAPPED readOverlapped = {};
+        readOverlapped.Offset = static_cast<DWORD>(sourceOffset);
+        readOverlapped.OffsetHigh = static_cast<DWORD>(sourceOffset >> 32);
+
+        DWORD bytesRead = 0;
+        if (!::ReadFile(source.m_handle, buffer.data(), static_cast<DWORD>(GetTransferSize(byteLength, buffer.size())), &bytesRead, &readOverlapped) || bytesRead == 0)
+        {
+            throw CopyException("the source range could not be read.");
+        }
+
+        OVERLAPPED writeOverlapped = {};
+        writeOverlapped.Offset = static_cast<DWORD>(destinationOffset);
+        writeOverlapped.OffsetHigh = static_cast<DWORD>(destinationOffset >> 32);
+
+        DWORD bytesWritten = 0;
+        if (!::WriteFile(destination.m_handle, buffer.data(), bytesRead, &bytesWritten, &writeOverlapped) || bytesWritten != bytesRead)
+        {
+            throw CopyException("the destination range could not be written.");
+        }
+
+        sourceOffset += bytesRead;
+        destinationOffset += bytesRead;
+        byteLength -= bytesRead;
+    }
+
+    return FileCopyMethod::ReadWrite;
+}
+
+#else
+
+std::shared_ptr<NativeFile> NativeFile::OpenRead(const std::experimental::filesystem::path& path)
+{
+    auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<NativeFile>(new NativeFile(file));
+}
+
+std::shared_ptr<NativeFile> NativeFile::OpenWrite(const std::experimental::filesystem::path& path)
+{
+    auto file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+    if (file < 0)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<NativeFile>(new NativeFile(file));
+}
+
+NativeFile::~NativeFile()
+{
+    ::close(m_handle);
+}
+
+uint64_t NativeFile::GetSize() const
+{
+    struct stat status;
+    if (::fstat(m_handle, &status) != 0)
+    {
+        throw GLTFException("Could not get the size of a file.");
+    }
+
+    return static_cast<uint64_t>(status.st_size);
+}
+
+void NativeFile::Resize(uint64_t byteLength) const
+{
+    if (::ftruncate(m_handle, static_cast<off_t>(byteLength)) != 0)
+    {
+        throw GLTFException("Could not resize a file.");
+    }
+}
+
+FileCopyMethod NativeFile::CopyRange(const NativeFile& source, uint64_t sourceOffset, const NativeFile& destination, uint64_t destinationOffset, uint64_t byteLength)
+{
+    if (byteLength == 0)
+    {
+        return FileCopyMethod::ReadWrite;
+    }
+
+#ifdef __linux__
+    if (TryReflink(source.m_handle, sourceOffset, destination.m_handle, destinationOffset, byteLength))
+    {
+        return FileCopyMethod::Reflink;
+    }
+
+    // Both calls may copy less than asked for. Whatever is left when one of them fails (e.g. copy_file_range across
+    // file systems on older kernels) is copied by the next method.
+    while (byteLength > 0)
+    {
+        auto input = static_cast<loff_t>(sourceOffset);
+        auto output = static_cast<loff_t>(destinationOffset);
+        auto copied = ::copy_file_range(source.m_handle, &input, destination.m_handle, &output, GetTransferSize(byteLength, MAX_TRANSFER_SIZE), 0);
+        if (copied == 0)
+        {
+            throw CopyException("the source range extends beyond the end of its file.");
+        }
+        if (copied < 0)
+        {
+            break;
+        }
+
+        sourceOffset += copied;
+        destinationOffset += copied;
+        byteLength -= copied;
+    }
+
+    if (byteLength == 0)
+    {
+        return FileCopyMethod::CopyFileRange;
+    }
+
+    // sendfile writes at the file offset of the destination
+    if (::lseek(destination.m_handle, static_cast<off_t>(destinationOffset), SEEK_SET) >= 0)
+    {
+        while (byteLength > 0)
+        {
+            auto input = static_cast<off_t>(sourceOffset);
+            auto copied = ::sendfile(destination.m_handle, source.m_handle, &input, GetTransferSize(byteLength, MAX_TRANSFER_SIZE));
+            if (copied == 0)
+            {
+                throw CopyException("the source range extends beyond the end of its file.");
+            }
+            if (copied < 0)
+            {
+                break;
+            }
+
+            sourceOffset += copied;
+            destinationOffset += copied;
+            byteLength -= copied;
+        }
+
+        if (byteLength == 0)
+        {
+            return FileCopyMethod::SendFile;
+        }
+    }
+#endif
+
+    std::vector<char> buffer(GetTransferSize(byteLength, COPY_BUFFER_SIZE));
+    while (byteLength > 0)
+    {
+        auto bytesRead = ::pread(source.m_handle, buffer.data(), GetTransferSize(byteLength, buffer.size()), static_cast<off_t>(sourceOffset));
+        if (bytesRead <= 0)
+        {
+            throw CopyException("the source range could not be read.");
+        }
+
+        for (ssize_t written = 0; written < bytesRead;)
+        {
+            auto bytesWritten = ::pwrite(destination.m_handle, buffer.data() + written, bytesRead - written, static_cast<off_t>(destinationOffset + written));
+            if (bytesWritten <= 0)
+            {
+                throw CopyException("the destination range could not be written.");
+            }
+            written += bytesWritten;
+        }
+
+        sourceOffset += bytesRead;
+        destinationOffset += bytesRead;
+        byteLength -= bytesRead;
+    }
+
+    return FileCopyMethod::ReadWrite;
+}
+
+#endif
+
+FileStreamWriter::FileStreamWriter(std::experimental::filesystem::path baseDirectory) : m_baseDirectory(std::move(baseDirectory))
+{
+}
+
+std::shared_ptr<std::ostream> FileStreamWriter::GetOutputStream(const std::string& uri) const
+{
+    return std::make_shared<std::ofstream>(GetPath(uri), std::ios::binary);
+}
+
+std::shared_ptr<NativeFile> FileStreamWriter::GetOutputFile(const std::string& uri) const
+{
+    return NativeFile::OpenWrite(GetPath(uri));
+}
+
+std::experimental::filesystem::path FileStreamWriter::GetPath(const std::string& uri) const
+{
+    // An empty URI would resolve to the base directory itself, e.g. for the single output of a GLB writer
+    if (uri.empty())
+    {
+        throw GLTFException("Output files need a non-empty URI.");
+    }
+
+    // URIs are UTF-8; an absolute URI replaces the base directory
+    return m_baseDirectory / std::experimental::filesystem::u8path(uri);
+}
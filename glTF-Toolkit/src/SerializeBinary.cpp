@@ -4,16 +4,26 @@
 #include "pch.h"
 
 #include "AccessorUtils.h"
+#include "CachingStreamReader.h"
+#include "HashUtils.h"
+#include "MemoryMappedStreamReader.h"
+#include "MeshoptCodec.h"
+#include "ParallelUtils.h"
 #include "SerializeBinary.h"
+#include "StreamingGLBWriter.h"
 
 #include "GLTFSDK/GLTF.h"
 #include "GLTFSDK/Document.h"
 #include "GLTFSDK/GLBResourceReader.h"
-#include "GLTFSDK/GLBResourceWriter.h"
 #include "GLTFSDK/Serialize.h"
-#include "GLTFSDK/BufferBuilder.h"
 #include "GLTFSDK/ExtensionsKHR.h"
 
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
 using namespace Microsoft::glTF;
 using namespace Microsoft::glTF::Toolkit;
 
@@ -42,321 +52,1425 @@ namespace
         return "text/plain";
     }
 
+    // Keeps count of the resource bytes held in memory during serialization, and of the peak of that count.
+    class PayloadMemoryTracker
+    {
+    public:
+        PayloadMemoryTracker() : m_current(0), m_peak(0) {}
+
+        void Acquire(size_t byteLength)
+        {
+            auto current = m_current.fetch_add(byteLength) + byteLength;
+            auto peak = m_peak.load();
+            while (current > peak && !m_peak.compare_exchange_weak(peak, current)) {}
+        }
+
+        void Release(size_t byteLength)
+        {
+            m_current.fetch_sub(byteLength);
+        }
+
+        size_t GetPeak() const
+        {
+            return m_peak.load();
+        }
+
+    private:
+        std::atomic<size_t> m_current;
+        std::atomic<size_t> m_peak;
+    };
+
+    // Reports a temporary buffer to the tracker for as long as it is in scope.
+    class ScopedAllocation
+    {
+    public:
+        ScopedAllocation(PayloadMemoryTracker& tracker, size_t byteLength) : m_tracker(tracker), m_byteLength(byteLength)
+        {
+            m_tracker.Acquire(m_byteLength);
+        }
+
+        ~ScopedAllocation()
+        {
+            m_tracker.Release(m_byteLength);
+        }
+
+        ScopedAllocation(const ScopedAllocation&) = delete;
+        ScopedAllocation& operator=(const ScopedAllocation&) = delete;
+
+    private:
+        PayloadMemoryTracker& m_tracker;
+        size_t m_byteLength;
+    };
+
+    // Owns the contents of one bufferView in the output binary chunk, whatever its element type,
+    // without copying them into a byte vector. A payload can also be a view into memory owned elsewhere,
+    // such as a mapped input file; views are not counted by the tracker, since they don't hold heap memory.
+    // Views of a mapped file also know their range in that file, so that they can be copied by the operating system.
+    class Payload
+    {
+    public:
+        Payload() : m_data(nullptr), m_byteLength(0), m_tracker(nullptr), m_file(nullptr), m_fileOffset(0) {}
+
+        template <typename T>
+        Payload(std::vector<T>&& contents, PayloadMemoryTracker& tracker) : m_tracker(&tracker), m_file(nullptr), m_fileOffset(0)
+        {
+            auto owner = std::make_shared<std::vector<T>>(std::move(contents));
+            m_data = owner->data();
+            m_byteLength = owner->size() * sizeof(T);
+            m_owner = std::move(owner);
+            m_tracker->Acquire(m_byteLength);
+        }
+
+        Payload(std::shared_ptr<const void> owner, const void* data, size_t byteLength, const NativeFile* file = nullptr, uint64_t fileOffset = 0) :
+            m_owner(std::move(owner)), m_data(data), m_byteLength(byteLength), m_tracker(nullptr), m_file(file), m_fileOffset(fileOffset)
+        {
+        }
+
+        Payload(Payload&& other) noexcept : Payload()
+        {
+            *this = std::move(other);
+        }
+
+        Payload& operator=(Payload&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                m_owner = std::move(other.m_owner);
+                m_data = other.m_data;
+                m_byteLength = other.m_byteLength;
+                m_tracker = other.m_tracker;
+                m_file = other.m_file;
+                m_fileOffset = other.m_fileOffset;
+                other.m_data = nullptr;
+                other.m_byteLength = 0;
+            }
+            return *this;
+        }
+
+        ~Payload()
+        {
+            Reset();
+        }
+
+        Payload(const Payload&) = delete;
+        Payload& operator=(const Payload&) = delete;
+
+        const void* Data() const { return m_data; }
+        size_t ByteLength() const { return m_byteLength; }
+        bool HasContents() const { return m_owner != nullptr; }
+
+        // The file these contents are a range of, kept open by the owner, or null
+        const NativeFile* File() const { return m_file; }
+        uint64_t FileOffset() const { return m_fileOffset; }
+
+        // Returns a view of a range of these contents, which keeps them alive but isn't counted by the tracker
+        Payload View(size_t byteOffset, size_t byteLength) const
+        {
+            return Payload(m_owner, static_cast<const uint8_t*>(m_data) + byteOffset, byteLength, m_file, m_fileOffset + byteOffset);
+        }
+
+    private:
+        void Reset()
+        {
+            if (m_owner != nullptr)
+            {
+                if (m_tracker != nullptr)
+                {
+                    m_tracker->Release(m_byteLength);
+                }
+                m_owner.reset();
+            }
+        }
+
+        std::shared_ptr<const void> m_owner;
+        const void* m_data;
+        size_t m_byteLength;
+        PayloadMemoryTracker* m_tracker;
+        const NativeFile* m_file;
+        uint64_t m_fileOffset;
+    };
+
+    // Gives worker threads access to the resources of the input asset.
+    // A stream reader can be shared, since every read opens its own stream; a resource reader may be backed by
+    // a single stream (e.g. a GLBResourceReader), so reads from it are made one at a time.
+    class ResourceReaderAccess
+    {
+    public:
+        ResourceReaderAccess(std::shared_ptr<const IStreamReader> streamReader) : m_resourceReader(nullptr), m_streamReader(std::move(streamReader)) {}
+        ResourceReaderAccess(const GLTFResourceReader& resourceReader) : m_resourceReader(&resourceReader) {}
+
+        template <typename ReadFunction>
+        auto Read(ReadFunction read) const -> decltype(read(std::declval<const GLTFResourceReader&>()))
+        {
+            if (m_resourceReader == nullptr)
+            {
+                GLTFResourceReader resourceReader(m_streamReader);
+                return read(resourceReader);
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return read(*m_resourceReader);
+        }
+
+        const IStreamReader* GetStreamReader() const
+        {
+            return m_streamReader.get();
+        }
+
+        // Gets the whole contents of a resource, if the stream reader already holds them in memory: either mapped
+        // by a MemoryMappedStreamReader or already cached by a CachingStreamReader. Otherwise, returns an empty payload,
+        // and the resource is read by range.
+        Payload GetResidentResource(const std::string& uri) const
+        {
+            if (auto mappedStreamReader = dynamic_cast<const MemoryMappedStreamReader*>(m_streamReader.get()))
+            {
+                if (auto mapping = mappedStreamReader->GetMapping(uri))
+                {
+                    auto data = mapping->Data();
+                    auto byteLength = mapping->Size();
+                    auto file = &mapping->File();
+                    auto fileOffset = mapping->FileOffset();
+                    return Payload(std::move(mapping), data, byteLength, file, fileOffset);
+                }
+            }
+            else if (auto cachingStreamReader = dynamic_cast<const CachingStreamReader*>(m_streamReader.get()))
+            {
+                if (auto contents = cachingStreamReader->TryGetCached(uri))
+                {
+                    auto data = contents->data();
+                    auto byteLength = contents->size();
+                    return Payload(std::move(contents), data, byteLength);
+                }
+            }
+
+            return Payload();
+        }
+
+    private:
+        const GLTFResourceReader* m_resourceReader;
+        std::shared_ptr<const IStreamReader> m_streamReader;
+        mutable std::mutex m_mutex;
+    };
+
+    // A range of the output binary chunk and the function that produces its contents.
+    struct PlannedPayload
+    {
+        size_t byteOffset;
+        size_t byteLength;
+        std::function<Payload()> read;
+    };
+
+    // The contents of an accessor after conversion, and its bounds if they were requested.
+    struct SerializedAccessor
+    {
+        Payload payload;
+        std::vector<float> min;
+        std::vector<float> max;
+    };
+
     template <typename T>
-    void SaveAccessor(const Accessor& accessor, const std::vector<T> accessorContents, BufferBuilder& builder)
+    void SaveAccessor(const Accessor& accessor, std::vector<T>&& accessorContents, bool calculateMinMax, PayloadMemoryTracker& tracker, SerializedAccessor& result)
     {
-        auto min = accessor.min;
-        auto max = accessor.max;
-        if ((min.empty() || max.empty()) && !accessorContents.empty())
+        if (calculateMinMax && !accessorContents.empty())
         {
             auto minmax = AccessorUtils::CalculateMinMax(accessor, accessorContents);
-            min = minmax.first;
-            max = minmax.second;
+            result.min = std::move(minmax.first);
+            result.max = std::move(minmax.second);
         }
 
-        builder.AddAccessor(accessorContents, AccessorDesc(accessor.type, accessor.componentType, accessor.normalized, min, max));
+        result.payload = Payload(std::move(accessorContents), tracker);
     }
 
-    template <typename OriginalType, typename NewType>
-    static std::vector<NewType> vector_static_cast(const std::vector<OriginalType>& original)
+    // Converts the contents of an accessor and calculates the bounds of the converted values in a single pass,
+    // writing straight into the payload.
+    template <typename T>
+    void ConvertAndSaveAccessor(const Accessor& accessor, ComponentType outputComponentType, const std::vector<T>& accessorContents, bool calculateMinMax, PayloadMemoryTracker& tracker, SerializedAccessor& result)
     {
-        auto newData = std::vector<NewType>(original.size());
+        auto typeCount = Accessor::GetTypeCount(accessor.type);
+        auto elementCount = accessorContents.size() / typeCount;
+        std::vector<uint8_t> converted(elementCount * typeCount * Accessor::GetComponentTypeSize(outputComponentType));
 
-        std::transform(original.begin(), original.end(), newData.begin(),
-            [](const OriginalType& element)
+        calculateMinMax = calculateMinMax && elementCount > 0;
+        if (calculateMinMax)
         {
-            return static_cast<NewType>(element);
-        });
+            result.min.resize(typeCount);
+            result.max.resize(typeCount);
+        }
 
-        return newData;
+        AccessorUtils::ConvertComponents(accessor.componentType, accessorContents.data(), outputComponentType, converted.data(), elementCount, typeCount, accessor.normalized,
+                                         calculateMinMax ? result.min.data() : nullptr, calculateMinMax ? result.max.data() : nullptr);
+
+        result.payload = Payload(std::move(converted), tracker);
     }
 
     template <typename T>
-    void ConvertAndSaveAccessor(const Accessor& accessor, const std::vector<T> accessorContents, BufferBuilder& builder)
+    SerializedAccessor SerializeAccessor(const Accessor& accessor, ComponentType outputComponentType, const Document& doc, const ResourceReaderAccess& reader, bool calculateMinMax, PayloadMemoryTracker& tracker)
+    {
+        SerializedAccessor result;
+        auto accessorContents = reader.Read([&doc, &accessor](const GLTFResourceReader& resourceReader)
+        {
+            return resourceReader.ReadBinaryData<T>(doc, accessor);
+        });
+
+        if (outputComponentType != accessor.componentType)
+        {
+            ScopedAllocation originalContents(tracker, accessorContents.size() * sizeof(T));
+            ConvertAndSaveAccessor(accessor, outputComponentType, accessorContents, calculateMinMax, tracker, result);
+        }
+        else
+        {
+            SaveAccessor(accessor, std::move(accessorContents), calculateMinMax, tracker, result);
+        }
+
+        return result;
+    }
+
+    SerializedAccessor SerializeAccessor(const Accessor& accessor, ComponentType outputComponentType, const Document& doc, const ResourceReaderAccess& reader, bool calculateMinMax, PayloadMemoryTracker& tracker)
     {
         switch (accessor.componentType)
         {
         case COMPONENT_BYTE:
-            SaveAccessor(accessor, vector_static_cast<T, int8_t>(accessorContents), builder);
-            break;
+            return SerializeAccessor<int8_t>(accessor, outputComponentType, doc, reader, calculateMinMax, tracker);
         case COMPONENT_UNSIGNED_BYTE:
-            SaveAccessor(accessor, vector_static_cast<T, uint8_t>(accessorContents), builder);
-            break;
+            return SerializeAccessor<uint8_t>(accessor, outputComponentType, doc, reader, calculateMinMax, tracker);
         case COMPONENT_SHORT:
-            SaveAccessor(accessor, vector_static_cast<T, int16_t>(accessorContents), builder);
-            break;
+            return SerializeAccessor<int16_t>(accessor, outputComponentType, doc, reader, calculateMinMax, tracker);
         case COMPONENT_UNSIGNED_SHORT:
-            SaveAccessor(accessor, vector_static_cast<T, uint16_t>(accessorContents), builder);
-            break;
+            return SerializeAccessor<uint16_t>(accessor, outputComponentType, doc, reader, calculateMinMax, tracker);
         case COMPONENT_UNSIGNED_INT:
-            SaveAccessor(accessor, vector_static_cast<T, uint32_t>(accessorContents), builder);
-            break;
+            return SerializeAccessor<uint32_t>(accessor, outputComponentType, doc, reader, calculateMinMax, tracker);
         case COMPONENT_FLOAT:
-            SaveAccessor(accessor, vector_static_cast<T, float>(accessorContents), builder);
-            break;
+            return SerializeAccessor<float>(accessor, outputComponentType, doc, reader, calculateMinMax, tracker);
         default:
             throw GLTFException("Unsupported accessor ComponentType");
         }
     }
 
-    template <typename T>
-    void SerializeAccessor(const Accessor& accessor, const Document& doc, const GLTFResourceReader& reader, BufferBuilder& builder, const AccessorConversionStrategy& accessorConversion)
+    bool IsDataUri(const std::string& uri)
+    {
+        static const std::string dataUriPrefix = "data:";
+        return uri.compare(0, dataUriPrefix.length(), dataUriPrefix) == 0;
+    }
+
+    // Whether the bytes of an accessor can be copied to the output as they are: it must keep its component type,
+    // must not be sparse, and its elements must not have column padding (matrices of 1 or 2-byte components are padded to 4-byte columns).
+    bool CanPassthroughAccessor(const Accessor& accessor, ComponentType outputComponentType)
+    {
+        if (outputComponentType != accessor.componentType || accessor.sparse.count > 0)
+        {
+            return false;
+        }
+
+        auto componentSize = Accessor::GetComponentTypeSize(accessor.componentType);
+        return !(accessor.type == TYPE_MAT2 && componentSize == 1) && !(accessor.type == TYPE_MAT3 && componentSize < 4);
+    }
+
+    // Gets the contents of the resource a URI refers to, if the reader holds them in memory.
+    Payload GetResidentResource(const std::string& uri, const ResourceReaderAccess& reader)
+    {
+        if (uri.empty() || IsDataUri(uri))
+        {
+            return Payload();
+        }
+
+        return reader.GetResidentResource(uri);
+    }
+
+    // Returns a view of a range of a resident resource, after checking that the range lies within the resource.
+    Payload ViewResource(const Payload& resource, size_t byteOffset, size_t byteLength, const std::string& description)
     {
-        builder.AddBufferView(doc.bufferViews.Get(accessor.bufferViewId).target);
-        const std::vector<T>& accessorContents = reader.ReadBinaryData<T>(doc, accessor);
+        if (byteOffset > resource.ByteLength() || byteLength > resource.ByteLength() - byteOffset)
+        {
+            throw GLTFException("The contents of " + description + " lie outside of its buffer.");
+        }
+
+        return resource.View(byteOffset, byteLength);
+    }
 
-        if (accessorConversion != nullptr && accessorConversion(accessor) != accessor.componentType)
+    // Reads the raw bytes of an accessor, tightly packed, without decoding them into typed elements.
+    // When the buffer is accessible by URI, only the range covered by the accessor is read from its stream;
+    // when it is held in memory by the reader, tightly packed accessors aren't copied at all.
+    Payload ReadAccessorBytes(const Document& document, const Accessor& accessor, const ResourceReaderAccess& reader, PayloadMemoryTracker& tracker)
+    {
+        const auto& bufferView = document.bufferViews.Get(accessor.bufferViewId);
+        const auto& buffer = document.buffers.Get(bufferView.bufferId);
+
+        const size_t elementSize = Accessor::GetTypeCount(accessor.type) * Accessor::GetComponentTypeSize(accessor.componentType);
+        const size_t stride = bufferView.byteStride.HasValue() ? std::max(bufferView.byteStride.Get(), elementSize) : elementSize;
+        const size_t spanLength = (accessor.count - 1) * stride + elementSize;
+
+        std::vector<uint8_t> bytes;
+        size_t spanOffset = 0;
+
+        auto streamReader = reader.GetStreamReader();
+        auto resource = GetResidentResource(buffer.uri, reader);
+        if (resource.HasContents())
         {
-            Accessor updatedAccessor(accessor);
-            updatedAccessor.componentType = accessorConversion(accessor);
+            auto span = ViewResource(resource, bufferView.byteOffset + accessor.byteOffset, spanLength, "accessor " + accessor.id);
+            if (stride == elementSize)
+            {
+                return span;
+            }
 
-            // Force recalculation of min and max
-            updatedAccessor.min.clear();
-            updatedAccessor.max.clear();
+            auto source = static_cast<const uint8_t*>(span.Data());
+            bytes.resize(accessor.count * elementSize);
+            for (size_t i = 0; i < accessor.count; i++)
+            {
+                memcpy(bytes.data() + i * elementSize, source + i * stride, elementSize);
+            }
 
-            ConvertAndSaveAccessor(updatedAccessor, accessorContents, builder);
+            return Payload(std::move(bytes), tracker);
+        }
+        else if (streamReader != nullptr && !buffer.uri.empty() && !IsDataUri(buffer.uri))
+        {
+            auto stream = streamReader->GetInputStream(buffer.uri);
+            bytes.resize(spanLength);
+            if (stream == nullptr ||
+                !stream->seekg(static_cast<std::streamoff>(bufferView.byteOffset + accessor.byteOffset)) ||
+                !stream->read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(spanLength)))
+            {
+                throw GLTFException("Could not read the contents of accessor " + accessor.id + ".");
+            }
         }
         else
         {
-            SaveAccessor(accessor, accessorContents, builder);
+            bytes = reader.Read([&document, &bufferView](const GLTFResourceReader& resourceReader)
+            {
+                return resourceReader.ReadBinaryData<uint8_t>(document, bufferView);
+            });
+            spanOffset = accessor.byteOffset;
         }
+
+        if (spanOffset + spanLength > bytes.size())
+        {
+            throw GLTFException("Accessor " + accessor.id + " does not fit in its bufferView.");
+        }
+
+        // De-stride in place, moving every element to the front of the vector
+        if (spanOffset != 0 || stride != elementSize)
+        {
+            for (size_t i = 0; i < accessor.count; i++)
+            {
+                memmove(bytes.data() + i * elementSize, bytes.data() + spanOffset + i * stride, elementSize);
+            }
+        }
+        bytes.resize(accessor.count * elementSize);
+
+        return Payload(std::move(bytes), tracker);
     }
 
-    void SerializeAccessor(const Accessor& accessor, const Document& doc, const GLTFResourceReader& reader, BufferBuilder& builder, const AccessorConversionStrategy& accessorConversion)
+    // Reads a range of a buffer, straight from memory when the reader holds the buffer there.
+    Payload ReadBufferRange(const Document& document, const Buffer& buffer, size_t byteOffset, size_t byteLength, const ResourceReaderAccess& reader, PayloadMemoryTracker& tracker)
     {
-        switch (accessor.componentType)
+        auto resource = GetResidentResource(buffer.uri, reader);
+        if (resource.HasContents())
         {
-        case COMPONENT_BYTE:
-            SerializeAccessor<int8_t>(accessor, doc, reader, builder, accessorConversion);
-            break;
-        case COMPONENT_UNSIGNED_BYTE:
-            SerializeAccessor<uint8_t>(accessor, doc, reader, builder, accessorConversion);
-            break;
-        case COMPONENT_SHORT:
-            SerializeAccessor<int16_t>(accessor, doc, reader, builder, accessorConversion);
-            break;
-        case COMPONENT_UNSIGNED_SHORT:
-            SerializeAccessor<uint16_t>(accessor, doc, reader, builder, accessorConversion);
-            break;
-        case COMPONENT_UNSIGNED_INT:
-            SerializeAccessor<uint32_t>(accessor, doc, reader, builder, accessorConversion);
-            break;
-        case COMPONENT_FLOAT:
-            SerializeAccessor<float>(accessor, doc, reader, builder, accessorConversion);
-            break;
-        default:
-            throw GLTFException("Unsupported accessor ComponentType");
+            return ViewResource(resource, byteOffset, byteLength, "buffer " + buffer.id);
         }
+
+        BufferView range;
+        range.bufferId = buffer.id;
+        range.byteOffset = byteOffset;
+        range.byteLength = byteLength;
+
+        return Payload(reader.Read([&document, &range](const GLTFResourceReader& resourceReader)
+        {
+            return resourceReader.ReadBinaryData<uint8_t>(document, range);
+        }), tracker);
     }
-}
 
-void Microsoft::glTF::Toolkit::SerializeBinary(const Document& document,
-                                               const GLTFResourceReader& resourceReader,
-                                               std::shared_ptr<const IStreamWriter> outputStreamWriter,
-                                               const AccessorConversionStrategy& accessorConversion)
-{
-    auto writer = std::make_unique<GLBResourceWriter>(std::move(outputStreamWriter));
+    Payload ReadImage(const Document& document, const Image& image, const ResourceReaderAccess& reader, PayloadMemoryTracker& tracker)
+    {
+        // Images held in memory by the reader are written straight from there
+        auto resource = GetResidentResource(image.uri, reader);
+        if (resource.HasContents())
+        {
+            return resource;
+        }
 
-    Document outputDoc(document);
+        if (!image.bufferViewId.empty())
+        {
+            const auto& bufferView = document.bufferViews.Get(image.bufferViewId);
+            resource = GetResidentResource(document.buffers.Get(bufferView.bufferId).uri, reader);
+            if (resource.HasContents())
+            {
+                return ViewResource(resource, bufferView.byteOffset, bufferView.byteLength, "image " + image.id);
+            }
+        }
 
-    outputDoc.buffers.Clear();
-    outputDoc.bufferViews.Clear();
-    outputDoc.accessors.Clear();
+        return Payload(reader.Read([&document, &image](const GLTFResourceReader& resourceReader)
+        {
+            return resourceReader.ReadBinaryData(document, image);
+        }), tracker);
+    }
 
-    // Get the collection of bufferViews we won't move around
-    IndexedContainer<const BufferView> staticBufferViews = document.bufferViews;
-    for (const auto& accessor : document.accessors.Elements())
+    // Gets the length of an image (or any other resource referenced by URI) without holding its contents, when the stream allows it.
+    size_t GetResourceByteLength(const Document& document, const Image& image, const ResourceReaderAccess& reader, PayloadMemoryTracker& tracker)
     {
-        if (!accessor.bufferViewId.empty() && staticBufferViews.Has(accessor.bufferViewId))
+        if (!image.bufferViewId.empty())
         {
-            staticBufferViews.Remove(accessor.bufferViewId);
+            return document.bufferViews.Get(image.bufferViewId).byteLength;
         }
+
+        auto streamReader = reader.GetStreamReader();
+        if (streamReader != nullptr && !IsDataUri(image.uri))
+        {
+            auto stream = streamReader->GetInputStream(image.uri);
+            if (stream != nullptr && stream->seekg(0, std::ios::end))
+            {
+                auto length = static_cast<std::streamoff>(stream->tellg());
+                if (length >= 0)
+                {
+                    return static_cast<size_t>(length);
+                }
+            }
+        }
+
+        // The stream can't be measured: read the resource, it will be read again when it's written
+        Payload contents(ReadImage(document, image, reader, tracker));
+        return contents.ByteLength();
     }
 
-    for (const auto& image : outputDoc.images.Elements())
+    Payload ReadAccessorPayload(const Document& document, const Accessor& accessor, ComponentType outputComponentType, const ResourceReaderAccess& reader, PayloadMemoryTracker& tracker)
     {
-        if (!image.bufferViewId.empty() && staticBufferViews.Has(image.bufferViewId))
+        // Accessors that keep their type are copied byte for byte, without decoding their elements
+        if (CanPassthroughAccessor(accessor, outputComponentType))
         {
-            staticBufferViews.Remove(image.bufferViewId);
+            return ReadAccessorBytes(document, accessor, reader, tracker);
         }
+
+        return std::move(SerializeAccessor(accessor, outputComponentType, document, reader, false, tracker).payload);
     }
 
-    size_t currentAccessorId = 0;
-    std::string currentAccessorIdStr = std::to_string(currentAccessorId);
-    size_t currentBufferViewId = 0;
-    std::string currentBufferViewIdStr = std::to_string(currentBufferViewId);
-    auto AdvanceAccessorId = [&currentAccessorId, &currentAccessorIdStr]()
+    // Identifies the contents of a bufferView when deduplicating. Views with different targets are never merged,
+    // since index and vertex data can't share a bufferView.
+    struct ContentKey
     {
-        currentAccessorId++;
-        currentAccessorIdStr = std::to_string(currentAccessorId);
+        uint64_t hash;
+        size_t byteLength;
+        int target;
+
+        bool operator==(const ContentKey& other) const
+        {
+            return hash == other.hash && byteLength == other.byteLength && target == other.target;
+        }
     };
-    auto AdvanceBufferViewId = [&currentBufferViewId, &currentBufferViewIdStr, &staticBufferViews]()
+
+    struct ContentKeyHash
     {
-        do
+        size_t operator()(const ContentKey& key) const
         {
-            currentBufferViewId++;
-            currentBufferViewIdStr = std::to_string(currentBufferViewId);
-        } while (staticBufferViews.Has(currentBufferViewIdStr));
+            return static_cast<size_t>(key.hash);
+        }
     };
-    std::unique_ptr<BufferBuilder> builder = std::make_unique<BufferBuilder>(std::move(writer),
-        [](const BufferBuilder&) { return GLB_BUFFER_ID; },
-        [&currentBufferViewIdStr](const BufferBuilder&) { return currentBufferViewIdStr; },
-        [&currentAccessorIdStr](const BufferBuilder&) { return currentAccessorIdStr; });
-
-    // GLB buffer
-    builder->AddBuffer(GLB_BUFFER_ID);
 
-    // Add those bufferView to the builder.
-    for (const auto& bufferView : staticBufferViews.Elements())
+    ContentKey GetContentKey(const Payload& payload, const Optional<BufferViewTarget>& target)
     {
-        currentBufferViewIdStr = bufferView.id;
-        auto data = resourceReader.ReadBinaryData<uint8_t>(document, bufferView);
-        builder->AddBufferView(data);
+        return { HashUtils::Hash64(payload.Data(), payload.ByteLength()), payload.ByteLength(), target.HasValue() ? static_cast<int>(target.Get()) : -1 };
     }
-    // Return value to tracked state
-    currentBufferViewIdStr = std::to_string(currentBufferViewId);
-    if (staticBufferViews.Has(currentBufferViewIdStr))
+
+    // Payloads shorter than this are written from memory even when they are ranges of a file, since copying them
+    // between files would cost a flush of the output stream and a system call each
+    const size_t MIN_FILE_COPY_BYTE_LENGTH = 64 * 1024;
+
+    // The buffer that bufferViews compressed with EXT_meshopt_compression fall back to. It has no data: loaders that support the
+    // extension decode the compressed data, which is stored in the binary chunk, and the others can't load the asset.
+    const char* MESHOPT_FALLBACK_BUFFER_ID = "meshopt_fallback";
+
+    bool IsMeshoptCompressed(const BufferView& bufferView)
     {
-        AdvanceBufferViewId();
+        return bufferView.extensions.count(EXTENSION_EXT_MESHOPT_COMPRESSION) > 0;
     }
 
-    // Serialize accessors
-    for (const auto& accessor : document.accessors.Elements())
+    // An accessor whose bounds have to be calculated before the manifest can be written.
+    struct PendingBounds
     {
-        if (!accessor.bufferViewId.empty() && accessor.count > 0)
+        std::string outputAccessorId;
+        size_t accessorWithDataIndex;
+    };
+
+    // The number of payloads that are read ahead of the one being written, per thread
+    const size_t PAYLOADS_IN_FLIGHT_PER_THREAD = 2;
+
+    // The most converted accessor bytes kept from before the manifest is written until they are written
+    const size_t MAX_RETAINED_BYTE_LENGTH = 64 * 1024 * 1024;
+
+    // Converted accessor contents produced while hashing accessors and calculating their bounds, before the manifest is written,
+    // and kept until they are written so that they aren't read and converted again. Payloads that don't fit in the budget are
+    // dropped, and converted again when they are written.
+    class RetainedPayloads
+    {
+    public:
+        RetainedPayloads(size_t count) : m_payloads(count), m_byteLength(0) {}
+
+        void Retain(size_t index, Payload&& payload)
         {
-            SerializeAccessor(accessor, document, resourceReader, *builder, accessorConversion);
-            AdvanceBufferViewId();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_payloads[index].HasContents() && m_byteLength + payload.ByteLength() <= MAX_RETAINED_BYTE_LENGTH)
+            {
+                m_byteLength += payload.ByteLength();
+                m_payloads[index] = std::move(payload);
+            }
         }
-        else
+
+        // Returns a view of a retained payload, which keeps it retained, or an empty payload
+        Payload Peek(size_t index)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_payloads[index].HasContents() ? m_payloads[index].View(0, m_payloads[index].ByteLength()) : Payload();
+        }
+
+        // Takes back a retained payload, or returns an empty one
+        Payload Take(size_t index)
         {
-            outputDoc.accessors.Append(accessor);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_byteLength -= m_payloads[index].ByteLength();
+            return std::move(m_payloads[index]);
         }
-        AdvanceAccessorId();
+
+    private:
+        std::vector<Payload> m_payloads;
+        size_t m_byteLength;
+        std::mutex m_mutex;
+    };
+
+    // The vertex attributes of a primitive that are written to a single bufferView, one vertex after the other.
+    // glTF requires each element of a vertex attribute to be aligned to 4 bytes, and limits the stride to 252 bytes.
+    const size_t VERTEX_ATTRIBUTE_ALIGNMENT = 4;
+    const size_t MAX_VERTEX_STRIDE = 252;
+
+    struct InterleavedGroup
+    {
+        std::vector<size_t> members;
+        std::vector<size_t> byteOffsets;
+        size_t byteStride = 0;
+        size_t count = 0;
+        std::string bufferViewId;
+    };
+
+    size_t AlignVertexAttribute(size_t byteLength)
+    {
+        auto remainder = byteLength % VERTEX_ATTRIBUTE_ALIGNMENT;
+        return remainder == 0 ? byteLength : byteLength + (VERTEX_ATTRIBUTE_ALIGNMENT - remainder);
     }
 
-    // Serialize images
-    for (const auto& image : outputDoc.images.Elements())
+    // Gets the accessors that hold vertex attributes, including morph targets.
+    std::unordered_set<std::string> GetVertexAttributeAccessorIds(const Document& document)
     {
-        Image newImage(image);
+        std::unordered_set<std::string> accessorIds;
+        for (const auto& mesh : document.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                for (const auto& attribute : primitive.attributes)
+                {
+                    accessorIds.insert(attribute.second);
+                }
+                for (const auto& target : primitive.targets)
+                {
+                    accessorIds.insert(target.positionsAccessorId);
+                    accessorIds.insert(target.normalsAccessorId);
+                    accessorIds.insert(target.tangentsAccessorId);
+                }
+            }
+        }
 
-        auto data = resourceReader.ReadBinaryData(document, image);
+        return accessorIds;
+    }
 
-        auto imageBufferView = builder->AddBufferView(data);
-        AdvanceBufferViewId();
+    // Copies tightly packed elements to a buffer where each of them starts byteStride bytes after the previous one.
+    Payload PadElements(const Payload& payload, size_t count, size_t byteStride, PayloadMemoryTracker& tracker)
+    {
+        auto elementByteLength = payload.ByteLength() / count;
+        auto source = static_cast<const uint8_t*>(payload.Data());
 
-        newImage.bufferViewId = imageBufferView.id;
-        if (image.mimeType.empty())
+        std::vector<uint8_t> padded(count * byteStride);
+        for (size_t i = 0; i < count; i++)
         {
-            newImage.mimeType = MimeTypeFromUri(image.uri);
+            std::memcpy(&padded[i * byteStride], source + i * elementByteLength, elementByteLength);
         }
 
-        newImage.uri.clear();
-
-        outputDoc.images.Replace(newImage);
+        return Payload(std::move(padded), tracker);
     }
 
-    // Collect anything in extensions that looks like it should to be packed for the GLB.
-    for (auto& extension : outputDoc.extensions)
+    // Groups the vertex attributes of each primitive that can share an interleaved bufferView. members holds indices into
+    // accessorsWithData, in document order. An accessor is only interleaved with the attributes of the first primitive that
+    // uses it, and accessors that are also used as indices or morph targets keep a bufferView of their own.
+    std::vector<InterleavedGroup> PlanInterleavedGroups(const Document& document,
+                                                        const std::vector<const Accessor*>& accessorsWithData,
+                                                        const std::vector<ComponentType>& outputComponentTypes,
+                                                        std::vector<size_t>& groupOfAccessor)
     {
-        rapidjson::Document extensionJson;
-        extensionJson.Parse(extension.second.c_str());
-        if (!extensionJson.IsObject())
+        const auto ungrouped = std::numeric_limits<size_t>::max();
+        groupOfAccessor.assign(accessorsWithData.size(), ungrouped);
+
+        std::unordered_map<std::string, size_t> accessorIndices;
+        for (size_t i = 0; i < accessorsWithData.size(); i++)
         {
-            continue;
+            accessorIndices.emplace(accessorsWithData[i]->id, i);
         }
-        for (auto& member : extensionJson.GetObject())
+
+        std::unordered_set<std::string> excludedAccessorIds;
+        for (const auto& mesh : document.meshes.Elements())
         {
-            if (!member.value.IsArray())
+            for (const auto& primitive : mesh.primitives)
             {
-                continue;
+                excludedAccessorIds.insert(primitive.indicesAccessorId);
+                for (const auto& target : primitive.targets)
+                {
+                    excludedAccessorIds.insert(target.positionsAccessorId);
+                    excludedAccessorIds.insert(target.normalsAccessorId);
+                    excludedAccessorIds.insert(target.tangentsAccessorId);
+                }
             }
-            for (auto& possibleBuffer : member.value.GetArray())
+        }
+
+        std::vector<InterleavedGroup> groups;
+        for (const auto& mesh : document.meshes.Elements())
+        {
+            for (const auto& primitive : mesh.primitives)
             {
-                if (!possibleBuffer.IsObject())
+                std::vector<size_t> candidates;
+                for (const auto& attribute : primitive.attributes)
+                {
+                    auto it = accessorIndices.find(attribute.second);
+                    if (it == accessorIndices.end() || groupOfAccessor[it->second] != ungrouped || excludedAccessorIds.count(attribute.second) > 0)
+                    {
+                        continue;
+                    }
+
+                    // Matrices may need column padding, which doesn't fit the packed element size used below
+                    auto type = accessorsWithData[it->second]->type;
+                    if (type == TYPE_MAT2 || type == TYPE_MAT3 || type == TYPE_MAT4)
+                    {
+                        continue;
+                    }
+
+                    candidates.push_back(it->second);
+                }
+
+                std::sort(candidates.begin(), candidates.end());
+                candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+                if (candidates.size() < 2)
                 {
                     continue;
                 }
-                // Build an Image to object to use to load the data from.
-                Image tmpImg;
-                if (possibleBuffer.HasMember("uri"))
+
+                InterleavedGroup group;
+                group.count = accessorsWithData[candidates.front()]->count;
+                for (auto candidate : candidates)
                 {
-                    tmpImg.uri = possibleBuffer["uri"].GetString();
+                    const auto& accessor = *accessorsWithData[candidate];
+                    if (accessor.count != group.count)
+                    {
+                        continue;
+                    }
+
+                    group.members.push_back(candidate);
+                    group.byteOffsets.push_back(group.byteStride);
+                    group.byteStride += AlignVertexAttribute(Accessor::GetTypeCount(accessor.type) * Accessor::GetComponentTypeSize(outputComponentTypes[candidate]));
                 }
-                else
+
+                if (group.members.size() < 2 || group.byteStride > MAX_VERTEX_STRIDE)
                 {
                     continue;
                 }
-                try
+
+                for (auto member : group.members)
                 {
-                    auto data = resourceReader.ReadBinaryData(document, tmpImg);
-                    auto bufferView = builder->AddBufferView(data);
-                    AdvanceBufferViewId();
+                    groupOfAccessor[member] = groups.size();
+                }
+                groups.push_back(std::move(group));
+            }
+        }
+
+        return groups;
+    }
+
+    void SerializeBinaryStreaming(const Document& document,
+                                  const ResourceReaderAccess& reader,
+                                  std::shared_ptr<const IStreamWriter> outputStreamWriter,
+                                  const SerializeBinaryOptions& options,
+                                  SerializeBinaryStatistics* statistics)
+    {
+        StreamingGLBWriter writer(std::move(outputStreamWriter));
+        PayloadMemoryTracker tracker;
+        std::vector<PlannedPayload> payloads;
+        std::vector<PendingBounds> pendingBounds;
+        auto threadCount = ParallelUtils::GetThreadCount(options.ThreadCount);
+        size_t passthroughAccessorCount = 0;
+        size_t deduplicatedBufferViewCount = 0;
+        size_t deduplicatedByteLength = 0;
+        size_t interleavedBufferViewCount = 0;
+
+        Document outputDoc(document);
+
+        outputDoc.buffers.Clear();
+        outputDoc.bufferViews.Clear();
+        outputDoc.accessors.Clear();
+
+        // Get the collection of bufferViews we won't move around
+        IndexedContainer<const BufferView> staticBufferViews = document.bufferViews;
+        for (const auto& accessor : document.accessors.Elements())
+        {
+            if (!accessor.bufferViewId.empty() && staticBufferViews.Has(accessor.bufferViewId))
+            {
+                staticBufferViews.Remove(accessor.bufferViewId);
+            }
+        }
+
+        for (const auto& image : outputDoc.images.Elements())
+        {
+            if (!image.bufferViewId.empty() && staticBufferViews.Has(image.bufferViewId))
+            {
+                staticBufferViews.Remove(image.bufferViewId);
+            }
+        }
+
+        size_t currentAccessorId = 0;
+        std::string currentAccessorIdStr = std::to_string(currentAccessorId);
+        size_t currentBufferViewId = 0;
+        std::string currentBufferViewIdStr = std::to_string(currentBufferViewId);
+        auto AdvanceAccessorId = [&currentAccessorId, &currentAccessorIdStr]()
+        {
+            currentAccessorId++;
+            currentAccessorIdStr = std::to_string(currentAccessorId);
+        };
+        auto AdvanceBufferViewId = [&currentBufferViewId, &currentBufferViewIdStr, &staticBufferViews]()
+        {
+            do
+            {
+                currentBufferViewId++;
+                currentBufferViewIdStr = std::to_string(currentBufferViewId);
+            } while (staticBufferViews.Has(currentBufferViewIdStr));
+        };
+
+        // Phase 1: plan the binary chunk. Each bufferView gets its final offset now, and the function
+        // that will produce its contents is kept to be called once the manifest has been written.
+        auto PlanBufferView = [&writer, &payloads, &currentBufferViewIdStr](size_t byteLength, std::function<Payload()> read)
+        {
+            BufferView bufferView;
+            bufferView.id = currentBufferViewIdStr;
+            bufferView.bufferId = GLB_BUFFER_ID;
+            bufferView.byteOffset = writer.Reserve(byteLength);
+            bufferView.byteLength = byteLength;
+
+            payloads.push_back({ bufferView.byteOffset, byteLength, std::move(read) });
+
+            return bufferView;
+        };
+
+        // Add those bufferView to the output.
+        for (const auto& bufferView : staticBufferViews.Elements())
+        {
+            currentBufferViewIdStr = bufferView.id;
+            outputDoc.bufferViews.Append(PlanBufferView(bufferView.byteLength, [&document, &reader, &tracker, bufferView]()
+            {
+                return Payload(reader.Read([&document, &bufferView](const GLTFResourceReader& resourceReader)
+                {
+                    return resourceReader.ReadBinaryData<uint8_t>(document, bufferView);
+                }), tracker);
+            }));
+        }
+        // Return value to tracked state
+        currentBufferViewIdStr = std::to_string(currentBufferViewId);
+        if (staticBufferViews.Has(currentBufferViewIdStr))
+        {
+            AdvanceBufferViewId();
+        }
+
+        // Only accessors with data get a bufferView of their own. Accessors compressed with EXT_meshopt_compression
+        // are copied as they are, since their data can't be read without decoding it.
+        auto IsMeshoptAccessor = [&document](const Accessor& accessor)
+        {
+            return !accessor.bufferViewId.empty() && IsMeshoptCompressed(document.bufferViews.Get(accessor.bufferViewId));
+        };
+
+        std::vector<const Accessor*> accessorsWithData;
+        std::vector<ComponentType> outputComponentTypes;
+        for (const auto& accessor : document.accessors.Elements())
+        {
+            if (!accessor.bufferViewId.empty() && accessor.count > 0 && !IsMeshoptAccessor(accessor))
+            {
+                accessorsWithData.push_back(&accessor);
+                outputComponentTypes.push_back(options.AccessorConversion != nullptr ? options.AccessorConversion(accessor) : accessor.componentType);
+            }
+        }
+
+        std::vector<InterleavedGroup> interleavedGroups;
+        std::vector<size_t> groupOfAccessor;
+        if (options.InterleaveVertexAttributes)
+        {
+            interleavedGroups = PlanInterleavedGroups(document, accessorsWithData, outputComponentTypes, groupOfAccessor);
+        }
+
+        // Vertex attributes whose elements aren't a multiple of 4 bytes long (such as quantized positions) are padded to 4 bytes.
+        // Matrices are left alone: their columns are padded instead.
+        auto vertexAttributeAccessorIds = GetVertexAttributeAccessorIds(document);
+        std::vector<size_t> accessorByteStrides(accessorsWithData.size());
+        for (size_t i = 0; i < accessorsWithData.size(); i++)
+        {
+            const auto& accessor = *accessorsWithData[i];
+            auto elementByteLength = Accessor::GetTypeCount(accessor.type) * Accessor::GetComponentTypeSize(outputComponentTypes[i]);
+            bool isVector = accessor.type == TYPE_SCALAR || accessor.type == TYPE_VEC2 || accessor.type == TYPE_VEC3 || accessor.type == TYPE_VEC4;
+            accessorByteStrides[i] = isVector && vertexAttributeAccessorIds.count(accessor.id) > 0 ? AlignVertexAttribute(elementByteLength) : elementByteLength;
+        }
+        auto IsPadded = [&](size_t index)
+        {
+            const auto& accessor = *accessorsWithData[index];
+            return accessorByteStrides[index] != Accessor::GetTypeCount(accessor.type) * Accessor::GetComponentTypeSize(outputComponentTypes[index]);
+        };
+
+        // Converted accessors are read, converted and bounded in a single pass, whose result is kept to be written
+        RetainedPayloads retainedPayloads(accessorsWithData.size());
+        std::vector<std::pair<std::vector<float>, std::vector<float>>> accessorBounds(accessorsWithData.size());
+        std::vector<char> hasAccessorBounds(accessorsWithData.size(), 0);
+        auto NeedsBounds = [&](size_t index)
+        {
+            const auto& accessor = *accessorsWithData[index];
+            return outputComponentTypes[index] != accessor.componentType || accessor.min.empty() || accessor.max.empty();
+        };
+        auto ReadAccessorWithBounds = [&](size_t index)
+        {
+            const auto& accessor = *accessorsWithData[index];
+            auto serializedAccessor = SerializeAccessor(accessor, outputComponentTypes[index], document, reader, true, tracker);
+            accessorBounds[index] = std::make_pair(std::move(serializedAccessor.min), std::move(serializedAccessor.max));
+            hasAccessorBounds[index] = 1;
+
+            // Accessors that are copied as they are don't need converting, and may be views of mapped files
+            if (!CanPassthroughAccessor(accessor, outputComponentTypes[index]))
+            {
+                retainedPayloads.Retain(index, std::move(serializedAccessor.payload));
+                return Payload();
+            }
+
+            return std::move(serializedAccessor.payload);
+        };
+        // Gets the contents of an accessor without taking them back from the retained payloads
+        auto PeekAccessorPayload = [&](size_t index)
+        {
+            auto payload = retainedPayloads.Peek(index);
+            if (payload.HasContents())
+            {
+                return payload;
+            }
+
+            return ReadAccessorPayload(document, *accessorsWithData[index], outputComponentTypes[index], reader, tracker);
+        };
+        auto TakeAccessorPayload = [&document, &reader, &tracker, &retainedPayloads](size_t index, const Accessor& accessor, ComponentType outputComponentType)
+        {
+            auto payload = retainedPayloads.Take(index);
+            if (payload.HasContents())
+            {
+                return payload;
+            }
+
+            return ReadAccessorPayload(document, accessor, outputComponentType, reader, tracker);
+        };
+
+        // When deduplicating, hash the contents of every accessor and image up front, so that duplicates can share
+        // the bufferView of the first occurrence and bufferView ids stay contiguous.
+        std::vector<ContentKey> accessorContentKeys;
+        std::vector<ContentKey> imageContentKeys;
+        std::unordered_map<ContentKey, std::pair<std::string, std::function<Payload()>>, ContentKeyHash> bufferViewsByContent;
+        if (options.DeduplicateBuffers)
+        {
+            accessorContentKeys.resize(accessorsWithData.size());
+            imageContentKeys.resize(outputDoc.images.Size());
+
+            ParallelUtils::For(accessorsWithData.size() + imageContentKeys.size(), threadCount, [&](size_t i)
+            {
+                if (i < accessorsWithData.size())
+                {
+                    // Interleaved accessors share the bufferView of their group, and padded ones need a bufferView with their
+                    // own stride, so they are never deduplicated
+                    if ((!groupOfAccessor.empty() && groupOfAccessor[i] != std::numeric_limits<size_t>::max()) || IsPadded(i))
+                    {
+                        return;
+                    }
+
+                    const auto& accessor = *accessorsWithData[i];
+                    auto payload = NeedsBounds(i) ? ReadAccessorWithBounds(i) : Payload();
+                    if (!payload.HasContents())
+                    {
+                        payload = TakeAccessorPayload(i, accessor, outputComponentTypes[i]);
+                    }
+
+                    accessorContentKeys[i] = GetContentKey(payload, document.bufferViews.Get(accessor.bufferViewId).target);
+                    if (!CanPassthroughAccessor(accessor, outputComponentTypes[i]))
+                    {
+                        retainedPayloads.Retain(i, std::move(payload));
+                    }
+                }
+                else
+                {
+                    auto payload = ReadImage(document, outputDoc.images.Elements()[i - accessorsWithData.size()], reader, tracker);
+                    imageContentKeys[i - accessorsWithData.size()] = GetContentKey(payload, {});
+                }
+            });
+        }
+
+        // Returns the id of a bufferView that already holds the same contents, if any; otherwise, registers the current bufferView as holding them
+        auto FindDuplicateBufferView = [&](const std::vector<ContentKey>& contentKeys, size_t index, std::function<Payload()> read, std::string& bufferViewId)
+        {
+            if (!options.DeduplicateBuffers)
+            {
+                return false;
+            }
+
+            auto inserted = bufferViewsByContent.emplace(contentKeys[index], std::make_pair(currentBufferViewIdStr, read));
+            if (inserted.second)
+            {
+                return false;
+            }
+
+            // Equal hashes are only trusted once the contents have been compared, so that a collision can't make the
+            // candidate point at the wrong data
+            auto first = inserted.first->second.second();
+            auto candidate = read();
+            if (first.ByteLength() != candidate.ByteLength() || std::memcmp(first.Data(), candidate.Data(), candidate.ByteLength()) != 0)
+            {
+                return false;
+            }
+
+            bufferViewId = inserted.first->second.first;
+            deduplicatedBufferViewCount++;
+            deduplicatedByteLength += contentKeys[index].byteLength;
+            return true;
+        };
+
+        // The compressed data of each EXT_meshopt_compression bufferView is moved to the binary chunk, and the bufferView
+        // itself to the fallback buffer
+        std::unordered_map<std::string, std::string> meshoptBufferViewIds;
+        size_t meshoptFallbackByteLength = 0;
+        auto PlanMeshoptBufferView = [&](const BufferView& bufferView)
+        {
+            auto extensionJson = RapidJsonUtils::CreateDocumentFromString(bufferView.extensions.at(EXTENSION_EXT_MESHOPT_COMPRESSION));
+            if (!extensionJson.IsObject() || !extensionJson.HasMember("buffer") || !extensionJson.HasMember("byteLength"))
+            {
+                throw GLTFException("The EXT_meshopt_compression extension of bufferView " + bufferView.id + " is invalid.");
+            }
+
+            const auto& buffer = document.buffers.Get(extensionJson["buffer"].GetUint());
+            auto byteOffset = extensionJson.HasMember("byteOffset") ? static_cast<size_t>(extensionJson["byteOffset"].GetUint64()) : 0;
+            auto byteLength = static_cast<size_t>(extensionJson["byteLength"].GetUint64());
+
+            auto outputByteOffset = writer.Reserve(byteLength);
+            payloads.push_back({ outputByteOffset, byteLength, [&document, &reader, &tracker, buffer, byteOffset, byteLength]()
+            {
+                return ReadBufferRange(document, buffer, byteOffset, byteLength, reader, tracker);
+            } });
+
+            extensionJson.RemoveMember("buffer");
+            extensionJson.RemoveMember("byteOffset");
+            extensionJson.AddMember("buffer", rapidjson::Value(0), extensionJson.GetAllocator());
+            extensionJson.AddMember("byteOffset", rapidjson::Value(static_cast<uint64_t>(outputByteOffset)), extensionJson.GetAllocator());
+
+            rapidjson::StringBuffer extensionBuffer;
+            rapidjson::Writer<rapidjson::StringBuffer> extensionWriter(extensionBuffer);
+            extensionJson.Accept(extensionWriter);
+
+            BufferView outputBufferView(bufferView);
+            outputBufferView.id = currentBufferViewIdStr;
+            outputBufferView.bufferId = MESHOPT_FALLBACK_BUFFER_ID;
+            outputBufferView.byteOffset = AlignVertexAttribute(meshoptFallbackByteLength);
+            outputBufferView.extensions[EXTENSION_EXT_MESHOPT_COMPRESSION] = extensionBuffer.GetString();
+            meshoptFallbackByteLength = outputBufferView.byteOffset + outputBufferView.byteLength;
+
+            meshoptBufferViewIds.emplace(bufferView.id, outputBufferView.id);
+            outputDoc.bufferViews.Append(std::move(outputBufferView));
+            AdvanceBufferViewId();
+        };
+
+        // Serialize accessors
+        size_t accessorWithDataIndex = 0;
+        for (const auto& accessor : document.accessors.Elements())
+        {
+            if (accessor.count > 0 && IsMeshoptAccessor(accessor))
+            {
+                if (meshoptBufferViewIds.count(accessor.bufferViewId) == 0)
+                {
+                    PlanMeshoptBufferView(document.bufferViews.Get(accessor.bufferViewId));
+                }
+
+                Accessor outputAccessor(accessor);
+                outputAccessor.id = currentAccessorIdStr;
+                outputAccessor.bufferViewId = meshoptBufferViewIds.at(accessor.bufferViewId);
+                outputDoc.accessors.Append(std::move(outputAccessor));
+                passthroughAccessorCount++;
+            }
+            else if (!accessor.bufferViewId.empty() && accessor.count > 0)
+            {
+                auto outputComponentType = outputComponentTypes[accessorWithDataIndex];
+
+                Accessor outputAccessor;
+                outputAccessor.id = currentAccessorIdStr;
+                outputAccessor.bufferViewId = currentBufferViewIdStr;
+                outputAccessor.byteOffset = 0;
+                outputAccessor.componentType = outputComponentType;
+                // Normalized components converted to float are stored as their normalized value
+                outputAccessor.normalized = accessor.normalized && outputComponentType != COMPONENT_FLOAT;
+                outputAccessor.count = accessor.count;
+                outputAccessor.type = accessor.type;
 
-                    possibleBuffer.RemoveMember("uri");
-                    possibleBuffer.RemoveMember("bufferView");
-                    possibleBuffer.AddMember("bufferView", rapidjson::Value(std::stoi(bufferView.id)), extensionJson.GetAllocator());
+                // Converted accessors always get their min and max recalculated
+                if (outputComponentType == accessor.componentType)
+                {
+                    outputAccessor.min = accessor.min;
+                    outputAccessor.max = accessor.max;
+                }
+
+                // The bounds are part of the manifest, so they have to be known before any data is written
+                if (outputAccessor.min.empty() || outputAccessor.max.empty())
+                {
+                    pendingBounds.push_back({ outputAccessor.id, accessorWithDataIndex });
+                }
+
+                if (!groupOfAccessor.empty() && groupOfAccessor[accessorWithDataIndex] != std::numeric_limits<size_t>::max())
+                {
+                    auto& group = interleavedGroups[groupOfAccessor[accessorWithDataIndex]];
+
+                    if (CanPassthroughAccessor(accessor, outputComponentType))
+                    {
+                        passthroughAccessorCount++;
+                    }
+
+                    // The first member of the group plans the bufferView shared by all of its members
+                    if (group.bufferViewId.empty())
+                    {
+                        std::vector<std::pair<Accessor, ComponentType>> members;
+                        for (auto member : group.members)
+                        {
+                            members.emplace_back(*accessorsWithData[member], outputComponentTypes[member]);
+                        }
+
+                        auto bufferView = PlanBufferView(group.count * group.byteStride, [&tracker, TakeAccessorPayload, members, group]()
+                        {
+                            std::vector<uint8_t> vertices(group.count * group.byteStride);
+                            {
+                                ScopedAllocation verticesAllocation(tracker, vertices.size());
+
+                                // Members are read one at a time, so at most one of them is held next to the interleaved vertices
+                                for (size_t m = 0; m < members.size(); m++)
+                                {
+                                    auto payload = TakeAccessorPayload(group.members[m], members[m].first, members[m].second);
+                                    auto elementByteLength = payload.ByteLength() / group.count;
+                                    auto source = static_cast<const uint8_t*>(payload.Data());
+                                    for (size_t v = 0; v < group.count; v++)
+                                    {
+                                        std::memcpy(&vertices[v * group.byteStride + group.byteOffsets[m]], source + v * elementByteLength, elementByteLength);
+                                    }
+                                }
+                            }
+
+                            return Payload(std::move(vertices), tracker);
+                        });
+                        bufferView.byteStride = group.byteStride;
+                        bufferView.target = BufferViewTarget::ARRAY_BUFFER;
+
+                        group.bufferViewId = bufferView.id;
+                        outputDoc.bufferViews.Append(std::move(bufferView));
+                        interleavedBufferViewCount++;
+                        AdvanceBufferViewId();
+                    }
+
+                    auto member = std::find(group.members.begin(), group.members.end(), accessorWithDataIndex) - group.members.begin();
+                    outputAccessor.bufferViewId = group.bufferViewId;
+                    outputAccessor.byteOffset = group.byteOffsets[member];
+                    outputDoc.accessors.Append(std::move(outputAccessor));
+                }
+                else if (!IsPadded(accessorWithDataIndex) && FindDuplicateBufferView(accessorContentKeys, accessorWithDataIndex, [&PeekAccessorPayload, accessorWithDataIndex]()
+                    {
+                        return PeekAccessorPayload(accessorWithDataIndex);
+                    }, outputAccessor.bufferViewId))
+                {
+                    // Written by the first occurrence
+                    retainedPayloads.Take(accessorWithDataIndex);
+                    outputDoc.accessors.Append(std::move(outputAccessor));
                 }
-                catch (...) 
+                else
+                {
+                    if (CanPassthroughAccessor(accessor, outputComponentType))
+                    {
+                        passthroughAccessorCount++;
+                    }
+
+                    auto byteStride = accessorByteStrides[accessorWithDataIndex];
+                    auto padded = IsPadded(accessorWithDataIndex);
+                    auto bufferView = PlanBufferView(accessor.count * byteStride, [&tracker, TakeAccessorPayload, accessorWithDataIndex, accessor, outputComponentType, byteStride, padded]()
+                    {
+                        if (padded)
+                        {
+                            return PadElements(TakeAccessorPayload(accessorWithDataIndex, accessor, outputComponentType), accessor.count, byteStride, tracker);
+                        }
+
+                        return TakeAccessorPayload(accessorWithDataIndex, accessor, outputComponentType);
+                    });
+                    bufferView.target = document.bufferViews.Get(accessor.bufferViewId).target;
+                    if (padded)
+                    {
+                        bufferView.byteStride = byteStride;
+                    }
+
+                    outputDoc.bufferViews.Append(std::move(bufferView));
+                    outputDoc.accessors.Append(std::move(outputAccessor));
+                    AdvanceBufferViewId();
+                }
+
+                accessorWithDataIndex++;
+            }
+            else
+            {
+                outputDoc.accessors.Append(accessor);
+            }
+            AdvanceAccessorId();
+        }
+
+        // Serialize images
+        size_t imageIndex = 0;
+        for (const auto& image : outputDoc.images.Elements())
+        {
+            Image newImage(image);
+
+            if (!FindDuplicateBufferView(imageContentKeys, imageIndex++, [&document, &reader, &tracker, image]()
+                {
+                    return ReadImage(document, image, reader, tracker);
+                }, newImage.bufferViewId))
+            {
+                auto byteLength = GetResourceByteLength(document, image, reader, tracker);
+                auto imageBufferView = PlanBufferView(byteLength, [&document, &reader, &tracker, image]()
+                {
+                    return ReadImage(document, image, reader, tracker);
+                });
+                outputDoc.bufferViews.Append(imageBufferView);
+                AdvanceBufferViewId();
+
+                newImage.bufferViewId = imageBufferView.id;
+            }
+
+            if (image.mimeType.empty())
+            {
+                newImage.mimeType = MimeTypeFromUri(image.uri);
+            }
+
+            newImage.uri.clear();
+
+            outputDoc.images.Replace(newImage);
+        }
+
+        // Collect anything in extensions that looks like it should to be packed for the GLB.
+        for (auto& extension : outputDoc.extensions)
+        {
+            rapidjson::Document extensionJson;
+            extensionJson.Parse(extension.second.c_str());
+            if (!extensionJson.IsObject())
+            {
+                continue;
+            }
+            for (auto& member : extensionJson.GetObject())
+            {
+                if (!member.value.IsArray())
                 {
-                    // Didn't work out.
                     continue;
                 }
+                for (auto& possibleBuffer : member.value.GetArray())
+                {
+                    if (!possibleBuffer.IsObject())
+                    {
+                        continue;
+                    }
+                    // Build an Image to object to use to load the data from.
+                    Image tmpImg;
+                    if (possibleBuffer.HasMember("uri"))
+                    {
+                        tmpImg.uri = possibleBuffer["uri"].GetString();
+                    }
+                    else
+                    {
+                        continue;
+                    }
+                    try
+                    {
+                        // Read once before planning, so that a resource that can't be read is left as it is, instead of
+                        // failing after the manifest has been written
+                        auto byteLength = ReadImage(document, tmpImg, reader, tracker).ByteLength();
+                        auto bufferView = PlanBufferView(byteLength, [&document, &reader, &tracker, tmpImg]()
+                        {
+                            return ReadImage(document, tmpImg, reader, tracker);
+                        });
+                        outputDoc.bufferViews.Append(bufferView);
+                        AdvanceBufferViewId();
+
+                        possibleBuffer.RemoveMember("uri");
+                        possibleBuffer.RemoveMember("bufferView");
+                        possibleBuffer.AddMember("bufferView", rapidjson::Value(std::stoi(bufferView.id)), extensionJson.GetAllocator());
+                    }
+                    catch (...)
+                    {
+                        // Didn't work out.
+                        continue;
+                    }
+                }
             }
+
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> jsonWriter(buffer);
+            extensionJson.Accept(jsonWriter);
+
+            extension.second = buffer.GetString();
         }
 
-        rapidjson::StringBuffer buffer;
-        rapidjson::Writer<rapidjson::StringBuffer> jsonWriter(buffer);
-        extensionJson.Accept(jsonWriter);
+        // Fill in any gaps in the bufferViewList.
+        for (const auto& bufferView : staticBufferViews.Elements())
+        {
+            auto bufferViewId = std::stoul(bufferView.id);
+            while (bufferViewId > currentBufferViewId)
+            {
+                outputDoc.bufferViews.Append(PlanBufferView(4, [&tracker]()
+                {
+                    return Payload(std::vector<uint8_t>(4), tracker);
+                }));
+                AdvanceBufferViewId();
+            }
+        }
 
-        extension.second = buffer.GetString();
-    }
+        // GLB buffer
+        if (writer.GetBinaryChunkByteLength() > 0)
+        {
+            Buffer glbBuffer;
+            glbBuffer.id = GLB_BUFFER_ID;
+            glbBuffer.byteLength = writer.GetBinaryChunkByteLength();
+            outputDoc.buffers.Append(std::move(glbBuffer));
+        }
 
-    // Fill in any gaps in the bufferViewList.
-    for (const auto& bufferView : staticBufferViews.Elements())
-    {
-        auto bufferViewId = std::stoul(bufferView.id);
-        while (bufferViewId > currentBufferViewId)
+        if (!meshoptBufferViewIds.empty())
         {
-            std::vector<uint8_t> data;
-            data.resize(4);
-            builder->AddBufferView(data);
-            AdvanceBufferViewId();
+            Buffer fallbackBuffer;
+            fallbackBuffer.id = MESHOPT_FALLBACK_BUFFER_ID;
+            fallbackBuffer.byteLength = meshoptFallbackByteLength;
+            fallbackBuffer.extensions[EXTENSION_EXT_MESHOPT_COMPRESSION] = "{\"fallback\":true}";
+            outputDoc.buffers.Append(std::move(fallbackBuffer));
         }
-    }
 
-    builder->Output(outputDoc);
+        // Add extensions and extras to the bufferViews that kept their id, if any
+        for (auto bufferView : staticBufferViews.Elements())
+        {
+            if (!outputDoc.bufferViews.Has(bufferView.id))
+            {
+                continue;
+            }
 
-    // Add extensions and extras to bufferViews, if any
-    for (auto bufferView : document.bufferViews.Elements())
-    {
-        auto fixedBufferView = outputDoc.bufferViews.Get(bufferView.id);
-        fixedBufferView.extensions = bufferView.extensions;
-        fixedBufferView.extras = bufferView.extras;
+            auto fixedBufferView = outputDoc.bufferViews.Get(bufferView.id);
+            fixedBufferView.extensions = bufferView.extensions;
+            fixedBufferView.extras = bufferView.extras;
 
-        outputDoc.bufferViews.Replace(fixedBufferView);
-    }
+            outputDoc.bufferViews.Replace(fixedBufferView);
+        }
 
-    // We may have put the bufferViews in the IndexedContainer out of order sort them now.
-    auto finalBufferViewList = outputDoc.bufferViews;
-    outputDoc.bufferViews.Clear();
-    for (size_t i = 0; i < finalBufferViewList.Size(); i++)
-    {
-        outputDoc.bufferViews.Append(finalBufferViewList[std::to_string(i)]);
-    }
+        // We may have put the bufferViews in the IndexedContainer out of order sort them now.
+        auto finalBufferViewList = outputDoc.bufferViews;
+        outputDoc.bufferViews.Clear();
+        for (size_t i = 0; i < finalBufferViewList.Size(); i++)
+        {
+            outputDoc.bufferViews.Append(finalBufferViewList[std::to_string(i)]);
+        }
 
-    auto manifest = Serialize(outputDoc, KHR::GetKHRExtensionSerializer());
+        // Calculate the bounds that weren't calculated while hashing. Each worker holds the contents of one accessor at a time,
+        // and converted contents are retained for the write.
+        ParallelUtils::For(pendingBounds.size(), threadCount, [&](size_t i)
+        {
+            if (!hasAccessorBounds[pendingBounds[i].accessorWithDataIndex])
+            {
+                ReadAccessorWithBounds(pendingBounds[i].accessorWithDataIndex);
+            }
+        });
 
-    auto outputWriter = dynamic_cast<GLBResourceWriter*>(&builder->GetResourceWriter());
-    if (outputWriter != nullptr)
-    {
-        outputWriter->Flush(manifest, std::string());
+        for (const auto& pending : pendingBounds)
+        {
+            auto outputAccessor = outputDoc.accessors.Get(pending.outputAccessorId);
+            outputAccessor.min = std::move(accessorBounds[pending.accessorWithDataIndex].first);
+            outputAccessor.max = std::move(accessorBounds[pending.accessorWithDataIndex].second);
+            outputDoc.accessors.Replace(outputAccessor);
+        }
+
+        // Phase 2: write the manifest, then stream every payload to its planned range. Worker threads read ahead of
+        // the payload being written, within a bounded window, and the payloads are always written in the planned order.
+        writer.WriteManifest(Serialize(outputDoc, KHR::GetKHRExtensionSerializer()));
+
+        ParallelUtils::ForOrdered<Payload>(payloads.size(), threadCount, threadCount * PAYLOADS_IN_FLIGHT_PER_THREAD, [&payloads](size_t i)
+        {
+            return payloads[i].read();
+        },
+        [&writer, &payloads](size_t i, Payload&& payload)
+        {
+            const auto& plannedPayload = payloads[i];
+            if (payload.ByteLength() != plannedPayload.byteLength)
+            {
+                throw GLTFException("The size of a resource changed while it was being serialized.");
+            }
+
+            // Large ranges of mapped files, such as images that are embedded unchanged, are copied from file to file
+            if (payload.File() != nullptr && payload.ByteLength() >= MIN_FILE_COPY_BYTE_LENGTH)
+            {
+                writer.WriteFilePayload(plannedPayload.byteOffset, payload.Data(), payload.ByteLength(), *payload.File(), payload.FileOffset());
+            }
+            else
+            {
+                writer.WritePayload(plannedPayload.byteOffset, payload.Data(), payload.ByteLength());
+            }
+        });
+
+        writer.Finish();
+
+        if (statistics != nullptr)
+        {
+            statistics->BinaryChunkByteLength = writer.GetBinaryChunkByteLength();
+            statistics->PeakBytesHeld = tracker.GetPeak();
+            statistics->PassthroughAccessorCount = passthroughAccessorCount;
+            statistics->DeduplicatedBufferViewCount = deduplicatedBufferViewCount;
+            statistics->DeduplicatedByteLength = deduplicatedByteLength;
+            statistics->InterleavedBufferViewCount = interleavedBufferViewCount;
+        }
     }
 }
 
+void Microsoft::glTF::Toolkit::SerializeBinary(const Document& document,
+                                               const GLTFResourceReader& resourceReader,
+                                               std::shared_ptr<const IStreamWriter> outputStreamWriter,
+                                               const AccessorConversionStrategy& accessorConversion,
+                                               SerializeBinaryStatistics* statistics)
+{
+    SerializeBinaryOptions options;
+    options.AccessorConversion = accessorConversion;
+
+    SerializeBinary(document, resourceReader, std::move(outputStreamWriter), options, statistics);
+}
+
+void Microsoft::glTF::Toolkit::SerializeBinary(const Document& document, std::shared_ptr<const IStreamReader> inputStreamReader,
+                                               std::shared_ptr<const IStreamWriter> outputStreamWriter,
+                                               const AccessorConversionStrategy& accessorConversion,
+                                               SerializeBinaryStatistics* statistics)
+{
+    SerializeBinaryOptions options;
+    options.AccessorConversion = accessorConversion;
+
+    SerializeBinary(document, std::move(inputStreamReader), std::move(outputStreamWriter), options, statistics);
+}
+
+void Microsoft::glTF::Toolkit::SerializeBinary(const Document& document,
+                                               const GLTFResourceReader& resourceReader,
+                                               std::shared_ptr<const IStreamWriter> outputStreamWriter,
+                                               const SerializeBinaryOptions& options,
+                                               SerializeBinaryStatistics* statistics)
+{
+    SerializeBinaryStreaming(document, ResourceReaderAccess(resourceReader), std::move(outputStreamWriter), options, statistics);
+}
+
 void Microsoft::glTF::Toolkit::SerializeBinary(const Document& document, std::shared_ptr<const IStreamReader> inputStreamReader,
                                                std::shared_ptr<const IStreamWriter> outputStreamWriter,
-                                               const AccessorConversionStrategy& accessorConversion)
+                                               const SerializeBinaryOptions& options,
+                                               SerializeBinaryStatistics* statistics)
 {
-    SerializeBinary(document, GLTFResourceReader{inputStreamReader}, std::move(outputStreamWriter), accessorConversion);
+    SerializeBinaryStreaming(document, ResourceReaderAccess(std::move(inputStreamReader)), std::move(outputStreamWriter), options, statistics);
 }
@@ -0,0 +1,213 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "StreamingGLBWriter.h"
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+namespace
+{
+    // Magic and chunk types, as little-endian ASCII: "glTF", "JSON" and "BIN\0"
+    const uint32_t GLB_MAGIC = 0x46546C67;
+    const uint32_t GLB_VERSION = 2;
+    const uint32_t GLB_CHUNK_TYPE_JSON = 0x4E4F534A;
+    const uint32_t GLB_CHUNK_TYPE_BIN = 0x004E4942;
+
+    // The size of a chunk header: chunk length followed by the chunk type
+    const size_t GLB_CHUNK_HEADER_BYTE_SIZE = 2 * sizeof(uint32_t);
+
+    // Size of the scratch buffer used to write padding
+    const size_t PADDING_BUFFER_SIZE = 4096;
+
+    size_t AlignToGLBChunk(size_t byteLength)
+    {
+        auto remainder = byteLength % GLB_BUFFER_OFFSET_ALIGNMENT;
+        return remainder == 0 ? byteLength : byteLength + (GLB_BUFFER_OFFSET_ALIGNMENT - remainder);
+    }
+
+    void WriteUInt32(std::ostream& stream, uint32_t value)
+    {
+        char bytes[sizeof(uint32_t)];
+        for (size_t i = 0; i < sizeof(uint32_t); i++)
+        {
+            bytes[i] = static_cast<char>((value >> (i * CHAR_BIT)) & 0xFF);
+        }
+
+        stream.write(bytes, sizeof(bytes));
+    }
+}
+
+StreamingGLBWriter::StreamingGLBWriter(std::shared_ptr<const IStreamWriter> streamWriter) :
+    m_streamWriter(std::move(streamWriter)),
+    m_binaryChunkStart(0),
+    m_binaryChunkByteLength(0),
+    m_binaryChunkPosition(0)
+{
+    if (m_streamWriter == nullptr)
+    {
+        throw std::invalid_argument("A stream writer is required to write a GLB file.");
+    }
+}
+
+size_t StreamingGLBWriter::Reserve(size_t byteLength)
+{
+    if (m_stream != nullptr)
+    {
+        throw GLTFException("Payloads cannot be reserved after the GLB manifest has been written.");
+    }
+
+    auto byteOffset = AlignToGLBChunk(m_binaryChunkByteLength);
+    m_binaryChunkByteLength = byteOffset + byteLength;
+
+    return byteOffset;
+}
+
+size_t StreamingGLBWriter::GetBinaryChunkByteLength() const
+{
+    return m_binaryChunkByteLength;
+}
+
+void StreamingGLBWriter::WriteManifest(const std::string& manifest)
+{
+    if (m_stream != nullptr)
+    {
+        throw GLTFException("The GLB manifest has already been written.");
+    }
+
+    auto jsonChunkLength = AlignToGLBChunk(manifest.length());
+    auto binaryChunkLength = AlignToGLBChunk(m_binaryChunkByteLength);
+
+    size_t totalLength = GLB2_HEADER_BYTE_SIZE + GLB_CHUNK_HEADER_BYTE_SIZE + jsonChunkLength;
+    if (binaryChunkLength > 0)
+    {
+        totalLength += GLB_CHUNK_HEADER_BYTE_SIZE + binaryChunkLength;
+    }
+
+    if (totalLength > std::numeric_limits<uint32_t>::max())
+    {
+        throw GLTFException("The asset is too large to be saved as GLB.");
+    }
+
+    m_stream = m_streamWriter->GetOutputStream(std::string());
+    if (m_stream == nullptr || m_stream->fail())
+    {
+        throw GLTFException("Could not open the output stream for the GLB file.");
+    }
+
+    // GLB header
+    WriteUInt32(*m_stream, GLB_MAGIC);
+    WriteUInt32(*m_stream, GLB_VERSION);
+    WriteUInt32(*m_stream, static_cast<uint32_t>(totalLength));
+
+    // JSON chunk, padded with spaces as required by the GLB specification
+    WriteUInt32(*m_stream, static_cast<uint32_t>(jsonChunkLength));
+    WriteUInt32(*m_stream, GLB_CHUNK_TYPE_JSON);
+    m_stream->write(manifest.c_str(), manifest.length());
+    for (size_t i = manifest.length(); i < jsonChunkLength; i++)
+    {
+        m_stream->put(' ');
+    }
+
+    // Binary chunk header; the payloads follow
+    if (binaryChunkLength > 0)
+    {
+        WriteUInt32(*m_stream, static_cast<uint32_t>(binaryChunkLength));
+        WriteUInt32(*m_stream, GLB_CHUNK_TYPE_BIN);
+    }
+
+    if (m_stream->fail())
+    {
+        throw GLTFException("Failed to write the GLB manifest.");
+    }
+
+    m_binaryChunkStart = GLB2_HEADER_BYTE_SIZE + GLB_CHUNK_HEADER_BYTE_SIZE + jsonChunkLength + GLB_CHUNK_HEADER_BYTE_SIZE;
+    if (auto fileStreamWriter = dynamic_cast<const IFileStreamWriter*>(m_streamWriter.get()))
+    {
+        m_outputFile = fileStreamWriter->GetOutputFile(std::string());
+    }
+}
+
+void StreamingGLBWriter::WritePayload(size_t byteOffset, const void* data, size_t byteLength)
+{
+    CheckPayloadRange(byteOffset, byteLength);
+    WritePadding(byteOffset - m_binaryChunkPosition);
+
+    if (byteLength > 0)
+    {
+        m_stream->write(static_cast<const char*>(data), byteLength);
+        m_binaryChunkPosition += byteLength;
+    }
+
+    if (m_stream->fail())
+    {
+        throw GLTFException("Failed to write to the GLB output stream.");
+    }
+}
+
+void StreamingGLBWriter::WriteFilePayload(size_t byteOffset, const void* data, size_t byteLength, const NativeFile& source, uint64_t sourceOffset)
+{
+    if (m_outputFile == nullptr)
+    {
+        WritePayload(byteOffset, data, byteLength);
+        return;
+    }
+
+    CheckPayloadRange(byteOffset, byteLength);
+    WritePadding(byteOffset - m_binaryChunkPosition);
+
+    // Everything buffered by the stream has to reach the file before the copy, and the stream then skips the copied range
+    m_stream->flush();
+    NativeFile::CopyRange(source, sourceOffset, *m_outputFile, m_binaryChunkStart + m_binaryChunkPosition, byteLength);
+    m_stream->seekp(static_cast<std::streamoff>(byteLength), std::ios::cur);
+    m_binaryChunkPosition += byteLength;
+
+    if (m_stream->fail())
+    {
+        throw GLTFException("Failed to write to the GLB output stream.");
+    }
+}
+
+void StreamingGLBWriter::Finish()
+{
+    if (m_stream == nullptr)
+    {
+        throw GLTFException("The GLB manifest must be written before finishing the GLB file.");
+    }
+
+    WritePadding(AlignToGLBChunk(m_binaryChunkByteLength) - m_binaryChunkPosition);
+    m_stream->flush();
+
+    if (m_stream->fail())
+    {
+        throw GLTFException("Failed to write to the GLB output stream.");
+    }
+}
+
+void StreamingGLBWriter::CheckPayloadRange(size_t byteOffset, size_t byteLength) const
+{
+    if (m_stream == nullptr)
+    {
+        throw GLTFException("The GLB manifest must be written before any payload.");
+    }
+
+    if (byteOffset < m_binaryChunkPosition || byteOffset + byteLength > m_binaryChunkByteLength)
+    {
+        throw GLTFException("Payloads must be written in order and within their reserved range.");
+    }
+}
+
+void StreamingGLBWriter::WritePadding(size_t byteLength)
+{
+    static const char zeros[PADDING_BUFFER_SIZE] = {};
+
+    while (byteLength > 0)
+    {
+        auto chunk = std::min(byteLength, PADDING_BUFFER_SIZE);
+        m_stream->write(zeros, chunk);
+        m_binaryChunkPosition += chunk;
+        byteLength -= chunk;
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include "TransformUtils.h"
+
+using namespace Microsoft::glTF;
+using namespace Microsoft::glTF::Toolkit;
+
+const TransformUtils::Transform TransformUtils::Identity = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+TransformUtils::Transform TransformUtils::Multiply(const Transform& a, const Transform& b)
+{
+    Transform result = {};
+    for (size_t column = 0; column < 4; column++)
+    {
+        for (size_t row = 0; row < 4; row++)
+        {
+            for (size_t k = 0; k < 4; k++)
+            {
+                result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+            }
+        }
+    }
+    return result;
+}
+
+TransformUtils::Transform TransformUtils::GetLocalTransform(const Node& node)
+{
+    switch (node.GetTransformationType())
+    {
+    case TRANSFORMATION_MATRIX:
+    {
+        Transform transform;
+        std::copy(node.matrix.values.begin(), node.matrix.values.end(), transform.begin());
+        return transform;
+    }
+    case TRANSFORMATION_TRS:
+    {
+        double x = node.rotation.x, y = node.rotation.y, z = node.rotation.z, w = node.rotation.w;
+        double rotation[9] = {
+            1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w),
+            2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w),
+            2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y)
+        };
+        double scale[3] = { node.scale.x, node.scale.y, node.scale.z };
+
+        // T * R * S
+        Transform transform = {};
+        for (size_t column = 0; column < 3; column++)
+        {
+            for (size_t row = 0; row < 3; row++)
+            {
+                transform[column * 4 + row] = rotation[column * 3 + row] * scale[column];
+            }
+        }
+        transform[12] = node.translation.x;
+        transform[13] = node.translation.y;
+        transform[14] = node.translation.z;
+        transform[15] = 1;
+        return transform;
+    }
+    default:
+        return Identity;
+    }
+}
+
+std::array<double, 3> TransformUtils::TransformPoint(const Transform& transform, const std::array<double, 3>& point)
+{
+    std::array<double, 3> result;
+    for (size_t row = 0; row < 3; row++)
+    {
+        result[row] = transform[row] * point[0] + transform[4 + row] * point[1] + transform[8 + row] * point[2] + transform[12 + row];
+    }
+    return result;
+}
+
+std::array<double, 9> TransformUtils::GetCofactors(const Transform& transform)
+{
+    auto A = [&transform](size_t row, size_t column) { return transform[column * 4 + row]; };
+
+    std::array<double, 9> cofactors;
+    for (size_t row = 0; row < 3; row++)
+    {
+        for (size_t column = 0; column < 3; column++)
+        {
+            cofactors[row * 3 + column] =
+                A((row + 1) % 3, (column + 1) % 3) * A((row + 2) % 3, (column + 2) % 3) -
+                A((row + 1) % 3, (column + 2) % 3) * A((row + 2) % 3, (column + 1) % 3);
+        }
+    }
+    return cofactors;
+}
+
+double TransformUtils::GetDeterminant(const Transform& transform)
+{
+    auto cofactors = GetCofactors(transform);
+    return transform[0] * cofactors[0] + transform[4] * cofactors[1] + transform[8] * cofactors[2];
+}